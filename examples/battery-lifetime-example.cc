@@ -0,0 +1,191 @@
+/*
+ * This script shows how to project the battery lifetime of a set of end
+ * devices with the LoraLifetimeEstimator: the network is only simulated for a
+ * warm-up period, and the depletion time of each battery is extrapolated from
+ * the energy consumption observed in it.
+ */
+
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/end-device-lora-mac.h"
+#include "ns3/gateway-lora-mac.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/lora-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/position-allocator.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/command-line.h"
+#include "ns3/basic-energy-source-helper.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/lora-lifetime-estimator.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("BatteryLifetimeExample");
+
+int main (int argc, char *argv[])
+{
+  int nDevices = 100;
+  double radius = 3000;
+  int appPeriodSeconds = 600;
+  double warmupHours = 24;
+  int nWindows = 24;
+  double initialEnergyJ = 10000;
+  bool lazyAccounting = true;
+  std::string reportFile = "lifetime-report.txt";
+
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Number of end devices", nDevices);
+  cmd.AddValue ("radius", "The radius of the area to simulate", radius);
+  cmd.AddValue ("appPeriod",
+                "The period in seconds of the periodic senders",
+                appPeriodSeconds);
+  cmd.AddValue ("warmup", "The duration of the simulated warm-up in hours",
+                warmupHours);
+  cmd.AddValue ("windows", "The number of windows the warm-up is divided into",
+                nWindows);
+  cmd.AddValue ("initialEnergy", "The initial battery energy in J",
+                initialEnergyJ);
+  cmd.AddValue ("lazyAccounting",
+                "Whether to use lazy accounting in the radio energy models",
+                lazyAccounting);
+  cmd.AddValue ("report", "The file the lifetime report is written to",
+                reportFile);
+  cmd.Parse (argc, argv);
+
+  LogComponentEnable ("BatteryLifetimeExample", LOG_LEVEL_ALL);
+  // LogComponentEnable ("LoraLifetimeEstimator", LOG_LEVEL_ALL);
+  LogComponentEnableAll (LOG_PREFIX_FUNC);
+  LogComponentEnableAll (LOG_PREFIX_TIME);
+
+  /************************
+  *  Create the channel  *
+  ************************/
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  /************************
+  *  Create the helpers  *
+  ************************/
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                 "rho", DoubleValue (radius),
+                                 "X", DoubleValue (0.0),
+                                 "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+
+  LoraMacHelper macHelper = LoraMacHelper ();
+
+  LoraHelper helper = LoraHelper ();
+
+  /************************
+  *  Create End Devices  *
+  ************************/
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  mobility.Install (endDevices);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LoraMacHelper::ED);
+  NetDeviceContainer endDevicesNetDevices = helper.Install (phyHelper, macHelper, endDevices);
+
+  /*********************
+   *  Create Gateways  *
+   *********************/
+
+  NodeContainer gateways;
+  gateways.Create (1);
+
+  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+  allocator->Add (Vector (0,0,15));
+  mobility.SetPositionAllocator (allocator);
+  mobility.Install (gateways);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LoraMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
+
+  /*********************************************
+   *  Install applications on the end devices  *
+   *********************************************/
+
+  PeriodicSenderHelper periodicSenderHelper;
+  periodicSenderHelper.SetPeriod (Seconds (appPeriodSeconds));
+  periodicSenderHelper.Install (endDevices);
+
+  /************************
+   * Install Energy Model *
+   ************************/
+
+  BasicEnergySourceHelper basicSourceHelper;
+  LoraRadioEnergyModelHelper radioEnergyHelper;
+
+  basicSourceHelper.Set ("BasicEnergySourceInitialEnergyJ", DoubleValue (initialEnergyJ));
+  basicSourceHelper.Set ("BasicEnergySupplyVoltageV", DoubleValue (3.3));
+
+  radioEnergyHelper.Set ("StandbyCurrentA", DoubleValue (0.0014));
+  radioEnergyHelper.Set ("TxCurrentA", DoubleValue (0.028));
+  radioEnergyHelper.Set ("SleepCurrentA", DoubleValue (0.0000015));
+  radioEnergyHelper.Set ("RxCurrentA", DoubleValue (0.0112));
+  radioEnergyHelper.Set ("LazyAccounting", BooleanValue (lazyAccounting));
+
+  radioEnergyHelper.SetTxCurrentModel ("ns3::ConstantLoraTxCurrentModel",
+                                       "TxCurrent", DoubleValue (0.028));
+
+  EnergySourceContainer sources = basicSourceHelper.Install (endDevices);
+  DeviceEnergyModelContainer deviceModels = radioEnergyHelper.Install
+      (endDevicesNetDevices, sources);
+
+  /*************************
+   * Set up the estimator *
+   *************************/
+
+  // Skip the first application period, in which devices start sending
+  Time warmupStart = Seconds (appPeriodSeconds);
+  Time warmupStop = warmupStart + Hours (warmupHours);
+
+  LoraLifetimeEstimator estimator;
+  estimator.Install (deviceModels);
+  estimator.Start (warmupStart, warmupStop, nWindows);
+
+  /****************
+  *  Simulation  *
+  ****************/
+
+  Simulator::Stop (warmupStop);
+
+  Simulator::Run ();
+
+  std::vector<LoraLifetimeEstimator::DeviceLifetime> estimates = estimator.Estimate ();
+  double meanDays = 0;
+  for (uint32_t i = 0; i < estimates.size (); i++)
+    {
+      meanDays += estimates[i].depletion.GetDays () / estimates.size ();
+    }
+  NS_LOG_INFO ("Average projected lifetime: " << meanDays << " days");
+
+  estimator.PrintReport (reportFile);
+
+  Simulator::Destroy ();
+
+  return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * This program measures the time it takes LoraHelper to install the LoRa
+ * stack on a large number of end devices and gateways, and reports it per
+ * 100k devices.
+ */
+
+#include "ns3/lora-helper.h"
+#include "ns3/lora-device-address-generator.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/position-allocator.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include <chrono>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("InstallBenchmark");
+
+int main (int argc, char *argv[])
+{
+  uint32_t nDevices = 100000;
+  uint32_t nGateways = 10;
+  bool tracking = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Number of end devices to install", nDevices);
+  cmd.AddValue ("nGateways", "Number of gateways to install", nGateways);
+  cmd.AddValue ("tracking", "Whether to enable packet tracking", tracking);
+  cmd.Parse (argc, argv);
+
+  LogComponentEnable ("InstallBenchmark", LOG_LEVEL_ALL);
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                 "rho", DoubleValue (10000),
+                                 "X", DoubleValue (0.0),
+                                 "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  mobility.Install (endDevices);
+
+  NodeContainer gateways;
+  gateways.Create (nGateways);
+  mobility.Install (gateways);
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LoraMacHelper macHelper = LoraMacHelper ();
+  macHelper.SetAddressGenerator (CreateObject<LoraDeviceAddressGenerator> (54, 1864));
+  LoraHelper helper = LoraHelper ();
+  if (tracking)
+    {
+      helper.EnablePacketTracking ("install-benchmark-tracker.txt");
+    }
+
+  auto start = std::chrono::steady_clock::now ();
+
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LoraMacHelper::ED);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  auto middle = std::chrono::steady_clock::now ();
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LoraMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  auto stop = std::chrono::steady_clock::now ();
+
+  double edSeconds = std::chrono::duration<double> (middle - start).count ();
+  double gwSeconds = std::chrono::duration<double> (stop - middle).count ();
+
+  NS_LOG_INFO ("End devices: " << nDevices << " installed in " << edSeconds <<
+               " s (" << edSeconds * 100000 / nDevices << " s per 100k devices)");
+  NS_LOG_INFO ("Gateways: " << nGateways << " installed in " << gwSeconds << " s");
+
+  Simulator::Destroy ();
+
+  return 0;
+}
@@ -0,0 +1,404 @@
+/*
+ * This program times the functions that dominate the profiles of large
+ * LoRaWAN simulations, in isolation:
+ * - LoraInterferenceHelper::IsDestroyedByInterference, with a varying number
+ *   of events in the helper;
+ * - LoraPhy::GetOnAirTime, and the LoraAirtimeTable computation it replaces;
+ * - LoraFrameHeader::Serialize and Deserialize, with different FOpts;
+ * - CorrelatedShadowingPropagationLossModel::CalcRxPower, on cold maps (each
+ *   query creates the shadowing map of a new square) and warm ones (all
+ *   queries hit values that were already computed);
+ * - RYLRLoraPropagationLossModel::CalcRxPower;
+ * - EndDeviceStatus::InsertReceivedPacket, with a varying number of packets
+ *   in the history of the device.
+ *
+ * Each benchmark is run for a number of warm-up samples, which are discarded,
+ * and then for a number of measured samples. A sample times a batch of calls,
+ * so that the resolution of the clock is not an issue. The median, 99th
+ * percentile, mean and minimum time per call over the samples are printed as
+ * CSV rows.
+ *
+ * All synthetic inputs are drawn from the ns-3 random number generator, so
+ * that they only depend on the seed and run number:
+ * ./waf --run "lora-microbenchmarks --seed=3 --filter=Shadowing"
+ */
+
+#include "ns3/lora-interference-helper.h"
+#include "ns3/lora-phy.h"
+#include "ns3/lora-airtime-table.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-mac-header.h"
+#include "ns3/lora-tag.h"
+#include "ns3/end-device-status.h"
+#include "ns3/lora-propagation-loss-model.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/mac48-address.h"
+#include "ns3/packet.h"
+#include "ns3/buffer.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LoraMicrobenchmarks");
+
+// Prevent the compiler from optimizing away the results of the calls
+volatile double sink;
+
+/**
+ * Runs benchmarks and prints their statistics.
+ */
+class Benchmark
+{
+public:
+  Benchmark (uint32_t warmup, uint32_t samples, uint32_t batch,
+             std::string filter)
+    : m_warmup (warmup),
+      m_samples (samples),
+      m_batch (batch),
+      m_filter (filter)
+  {
+  }
+
+  /**
+   * Whether a benchmark was selected on the command line.
+   */
+  bool
+  IsSelected (std::string name) const
+  {
+    return m_filter.empty () || name.find (m_filter) != std::string::npos;
+  }
+
+  /**
+   * Time a function, calling setup before each sample without timing it.
+   */
+  template <typename S, typename F>
+  void
+  Run (std::string name, S setup, F function)
+  {
+    if (!IsSelected (name))
+      {
+        return;
+      }
+
+    std::vector<double> nsPerCall;
+    nsPerCall.reserve (m_samples);
+    for (uint32_t s = 0; s < m_warmup + m_samples; s++)
+      {
+        setup ();
+        auto start = std::chrono::steady_clock::now ();
+        for (uint32_t i = 0; i < m_batch; i++)
+          {
+            function ();
+          }
+        auto stop = std::chrono::steady_clock::now ();
+        if (s >= m_warmup)
+          {
+            nsPerCall.push_back (std::chrono::duration<double, std::nano>
+                                   (stop - start).count () / m_batch);
+          }
+      }
+
+    std::sort (nsPerCall.begin (), nsPerCall.end ());
+    double sum = 0;
+    for (double value : nsPerCall)
+      {
+        sum += value;
+      }
+    uint32_t p99 = std::max<uint32_t> (uint32_t (std::ceil (0.99 * m_samples)), 1) - 1;
+
+    std::cout << name << "," << m_samples << "," << m_batch << "," <<
+      nsPerCall[m_samples / 2] << "," << nsPerCall[p99] << "," <<
+      sum / m_samples << "," << nsPerCall[0] << std::endl;
+  }
+
+  /**
+   * Time a function that needs no setup.
+   */
+  template <typename F>
+  void
+  Run (std::string name, F function)
+  {
+    Run (name, [] () {}, function);
+  }
+
+  static void
+  PrintHeader (void)
+  {
+    std::cout << "benchmark,samples,batch,medianNs,p99Ns,meanNs,minNs" << std::endl;
+  }
+
+private:
+  uint32_t m_warmup;
+  uint32_t m_samples;
+  uint32_t m_batch;
+  std::string m_filter;
+};
+
+Ptr<MobilityModel>
+CreatePosition (double x, double y)
+{
+  Ptr<ConstantPositionMobilityModel> mobility =
+    CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (Vector (x, y, 0));
+  return mobility;
+}
+
+Ptr<Packet>
+CreateUplink (uint16_t fCnt, uint8_t sf)
+{
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (1, 1234));
+  frameHdr.SetFCnt (fCnt);
+  LoraMacHeader macHdr;
+  macHdr.SetMType (LoraMacHeader::UNCONFIRMED_DATA_UP);
+  macHdr.SetMajor (1);
+
+  Ptr<Packet> packet = Create<Packet> (20);
+  packet->AddHeader (frameHdr);
+  packet->AddHeader (macHdr);
+
+  LoraTag tag (sf);
+  tag.SetFrequency (868.1);
+  tag.SetReceivePower (-110);
+  packet->AddPacketTag (tag);
+  return packet;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t warmup = 10;
+  uint32_t samples = 200;
+  uint32_t batch = 1000;
+  uint32_t seed = 1;
+  uint32_t run = 1;
+  std::string filter = "";
+
+  CommandLine cmd;
+  cmd.AddValue ("warmup", "Number of samples to discard", warmup);
+  cmd.AddValue ("samples", "Number of samples to measure", samples);
+  cmd.AddValue ("batch", "Number of calls timed by each sample", batch);
+  cmd.AddValue ("seed", "The seed of the synthetic inputs", seed);
+  cmd.AddValue ("run", "The run number of the synthetic inputs", run);
+  cmd.AddValue ("filter", "Only run benchmarks whose name contains this string",
+                filter);
+  cmd.Parse (argc, argv);
+
+  NS_ASSERT_MSG (samples > 0 && batch > 0, "At least one call must be timed");
+
+  RngSeedManager::SetSeed (seed);
+  RngSeedManager::SetRun (run);
+
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  uniform->SetStream (0);
+
+  Benchmark benchmark (warmup, samples, batch, filter);
+  Benchmark::PrintHeader ();
+
+  /////////////////////////////////////////
+  // LoraInterferenceHelper interference //
+  /////////////////////////////////////////
+
+  // All events start at the same time, so that each of them overlaps with the
+  // one under test and none of them is cleaned as old
+  const double frequencies[] = {868.1, 868.3, 868.5};
+  for (uint32_t nEvents : {1, 10, 100, 1000})
+    {
+      LoraInterferenceHelper interference;
+      Ptr<Packet> packet = Create<Packet> (20);
+      Ptr<LoraInterferenceHelper::Event> event;
+      for (uint32_t i = 0; i < nEvents; i++)
+        {
+          event = interference.Add (Seconds (uniform->GetValue (0.05, 1.5)),
+                                    uniform->GetValue (-130, -90),
+                                    uniform->GetInteger (7, 12), packet,
+                                    frequencies[uniform->GetInteger (0, 2)]);
+        }
+      std::stringstream name;
+      name << "IsDestroyedByInterference/" << nEvents;
+      benchmark.Run (name.str (), [&] ()
+        {
+          sink = interference.IsDestroyedByInterference (event);
+        });
+    }
+
+  ///////////////////
+  // Time on air   //
+  ///////////////////
+
+  std::vector<Ptr<Packet> > packets;
+  std::vector<LoraTxParameters> txParams;
+  for (uint32_t i = 0; i < 64; i++)
+    {
+      packets.push_back (Create<Packet> (uniform->GetInteger (10, 60)));
+      LoraTxParameters params;
+      params.sf = uniform->GetInteger (7, 12);
+      params.lowDataRateOptimizationEnabled = params.sf >= 11;
+      txParams.push_back (params);
+    }
+  uint32_t index = 0;
+  benchmark.Run ("GetOnAirTime", [&] ()
+    {
+      index = (index + 1) % packets.size ();
+      sink = LoraPhy::GetOnAirTime (packets[index], txParams[index]).GetNanoSeconds ();
+    });
+  benchmark.Run ("ComputeOnAirTime", [&] ()
+    {
+      index = (index + 1) % packets.size ();
+      sink = LoraAirtimeTable::ComputeOnAirTime (packets[index]->GetSize (),
+                                                 txParams[index]).GetNanoSeconds ();
+    });
+
+  ///////////////////////
+  // LoraFrameHeader   //
+  ///////////////////////
+
+  std::vector<std::pair<std::string, LoraFrameHeader> > headers;
+  LoraFrameHeader header;
+  header.SetAsUplink ();
+  header.SetAddress (LoraDeviceAddress (1, 1234));
+  header.SetFCnt (42);
+  headers.push_back (std::make_pair ("NoFOpts", header));
+  header.AddLinkCheckReq ();
+  headers.push_back (std::make_pair ("LinkCheckReq", header));
+  header.AddLinkAdrAns (true, true, true);
+  header.AddDutyCycleAns ();
+  headers.push_back (std::make_pair ("ThreeCommands", header));
+  LoraFrameHeader downlink;
+  downlink.SetAsDownlink ();
+  downlink.SetAddress (LoraDeviceAddress (1, 1234));
+  downlink.SetFCnt (42);
+  downlink.SetAck (true);
+  downlink.AddLinkAdrReq (5, 1, std::list<int> (1, 0), 1);
+  downlink.AddRxParamSetupReq (0, 0, 869.525);
+  headers.push_back (std::make_pair ("DownlinkLinkAdrReq", downlink));
+
+  for (auto &entry : headers)
+    {
+      LoraFrameHeader &hdr = entry.second;
+      bool isUplink = entry.first != "DownlinkLinkAdrReq";
+      Buffer buffer;
+      buffer.AddAtStart (hdr.GetSerializedSize ());
+
+      benchmark.Run ("FrameHeaderSerialize/" + entry.first, [&] ()
+        {
+          hdr.Serialize (buffer.Begin ());
+          sink = buffer.Begin ().ReadU8 ();
+        });
+
+      hdr.Serialize (buffer.Begin ());
+      benchmark.Run ("FrameHeaderDeserialize/" + entry.first, [&] ()
+        {
+          LoraFrameHeader copy;
+          if (isUplink)
+            {
+              copy.SetAsUplink ();
+            }
+          else
+            {
+              copy.SetAsDownlink ();
+            }
+          sink = copy.Deserialize (buffer.Begin ());
+        });
+    }
+
+  /////////////////////////////
+  // Propagation loss models //
+  /////////////////////////////
+
+  // Cold maps: each sample uses a new model, and each call a new square
+  std::vector<std::pair<Ptr<MobilityModel>, Ptr<MobilityModel> > > coldLinks;
+  for (uint32_t i = 0; i < batch; i++)
+    {
+      double x = (i % 1000) * 1000.0;
+      double y = (i / 1000) * 1000.0;
+      coldLinks.push_back (std::make_pair
+                             (CreatePosition (x, y),
+                              CreatePosition (x + uniform->GetValue (-500, 500),
+                                              y + uniform->GetValue (-500, 500))));
+    }
+  Ptr<CorrelatedShadowingPropagationLossModel> shadowing;
+  benchmark.Run ("CorrelatedShadowing/Cold", [&] ()
+    {
+      shadowing = CreateObject<CorrelatedShadowingPropagationLossModel> ();
+      index = 0;
+    }, [&] ()
+    {
+      sink = shadowing->CalcRxPower (14, coldLinks[index].first,
+                                     coldLinks[index].second);
+      index++;
+    });
+
+  // Warm maps: all queries hit values that were computed during the warm-up
+  std::vector<std::pair<Ptr<MobilityModel>, Ptr<MobilityModel> > > warmLinks;
+  for (uint32_t i = 0; i < 1024; i++)
+    {
+      warmLinks.push_back (std::make_pair
+                             (CreatePosition (uniform->GetValue (-5000, 5000),
+                                              uniform->GetValue (-5000, 5000)),
+                              CreatePosition (uniform->GetValue (-5000, 5000),
+                                              uniform->GetValue (-5000, 5000))));
+    }
+  shadowing = CreateObject<CorrelatedShadowingPropagationLossModel> ();
+  for (auto &link : warmLinks)
+    {
+      shadowing->CalcRxPower (14, link.first, link.second);
+    }
+  index = 0;
+  benchmark.Run ("CorrelatedShadowing/Warm", [&] ()
+    {
+      index = (index + 1) % warmLinks.size ();
+      sink = shadowing->CalcRxPower (14, warmLinks[index].first,
+                                     warmLinks[index].second);
+    });
+
+  Ptr<RYLRLoraPropagationLossModel> rylr = CreateObject<RYLRLoraPropagationLossModel> ();
+  std::vector<uint8_t> sfs;
+  for (uint32_t i = 0; i < warmLinks.size (); i++)
+    {
+      sfs.push_back (uniform->GetInteger (7, 12));
+    }
+  benchmark.Run ("RYLR", [&] ()
+    {
+      index = (index + 1) % warmLinks.size ();
+      rylr->SetTxSF (sfs[index]);
+      sink = rylr->CalcRxPower (14, warmLinks[index].first,
+                                warmLinks[index].second);
+    });
+
+  //////////////////////////////////////
+  // EndDeviceStatus packet history   //
+  //////////////////////////////////////
+
+  // Each call inserts a copy of the oldest packet, as received by another
+  // gateway, so that the whole history is searched and its length is constant
+  Address gwAddress = Mac48Address ("00:00:00:00:00:01");
+  for (uint32_t depth : {1, 10, 100, 1000})
+    {
+      Ptr<EndDeviceStatus> status = CreateObject<EndDeviceStatus> ();
+      for (uint32_t i = 0; i < depth; i++)
+        {
+          status->InsertReceivedPacket (CreateUplink (i, 7), gwAddress);
+        }
+      Ptr<Packet> oldest = CreateUplink (0, 7);
+      std::stringstream name;
+      name << "InsertReceivedPacket/" << depth;
+      benchmark.Run (name.str (), [&] ()
+        {
+          status->InsertReceivedPacket (oldest, gwAddress);
+        });
+    }
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * This program fits the coefficients of the RYLRLoraPropagationLossModel to
+ * field measurements, and writes a calibration file that can be loaded
+ * through the model's CalibrationFile attribute.
+ *
+ * The measurements are read from a file with a distance,sf,rssi[,txPower]
+ * line for each of them, and each SF is fitted with a linear, log-distance or
+ * piecewise linear curve:
+ * ./waf --run "rylr-calibration-fit --samples=rssi.csv --curve=piecewise
+ *              --output=rylr-calibration.txt"
+ */
+
+#include "ns3/lora-calibration-fitter.h"
+#include "ns3/lora-propagation-loss-model.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("RylrCalibrationFit");
+
+int main (int argc, char *argv[])
+{
+  std::string samples = "";
+  std::string output = "rylr-calibration.txt";
+  std::string curveName = "linear";
+
+  CommandLine cmd;
+  cmd.AddValue ("samples", "File with the distance,sf,rssi[,txPower] measurements", samples);
+  cmd.AddValue ("output", "The calibration file to write", output);
+  cmd.AddValue ("curve", "The curve to fit: linear, log or piecewise", curveName);
+  cmd.Parse (argc, argv);
+
+  LoraCalibrationFitter::Curve curve;
+  if (curveName == "linear")
+    {
+      curve = LoraCalibrationFitter::LINEAR;
+    }
+  else if (curveName == "log")
+    {
+      curve = LoraCalibrationFitter::LOG_DISTANCE;
+    }
+  else if (curveName == "piecewise")
+    {
+      curve = LoraCalibrationFitter::PIECEWISE_LINEAR;
+    }
+  else
+    {
+      std::cerr << "Unknown curve " << curveName << std::endl;
+      return 1;
+    }
+
+  LoraCalibrationFitter fitter;
+  if (samples.empty () || !fitter.ReadSamples (samples))
+    {
+      std::cerr << "Unable to read the samples, specify them with --samples" << std::endl;
+      return 1;
+    }
+
+  std::cout << "sf,samples,constant,linear,logarithmic,breakpoint,piecewise,offset,rmse"
+            << std::endl;
+  for (uint8_t sf = RYLRLoraPropagationLossModel::MIN_SF;
+       sf <= RYLRLoraPropagationLossModel::MAX_SF; sf++)
+    {
+      RYLRLoraPropagationLossModel::Coefficients c = fitter.Fit (sf, curve);
+      std::cout << unsigned (sf) << "," << fitter.GetNSamples (sf) << "," <<
+        c.constant << "," << c.linear << "," << c.logarithmic << "," <<
+        c.breakpoint << "," << c.piecewise << "," << c.offset << "," <<
+        fitter.GetRmse (sf, c) << std::endl;
+    }
+
+  if (!fitter.WriteCalibration (output, curve))
+    {
+      std::cerr << "Unable to write " << output << std::endl;
+      return 1;
+    }
+  std::cout << "Calibration written to " << output << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * This program measures how the simulation of a LoRaWAN network scales with
+ * its size and load. It sweeps the number of end devices and gateways, the
+ * period of the applications and the fraction of devices that send confirmed
+ * packets, over a network deployed uniformly in a disc.
+ *
+ * For each point of the sweep it reports the setup and run wall-clock times,
+ * the scheduler events that were executed (and their rate), the peak resident
+ * set size of the process, and the time spent in the channel, interference,
+ * MAC and network server sections of the module. Cancelled events are not
+ * counted as executed. The section times are NaN if profiling is disabled,
+ * or if the module was built without counters, in which case they are not
+ * measured. Results are written as CSV rows, one per point, so that they can
+ * be compared across versions.
+ *
+ * Lists are given as comma-separated values, e.g.:
+ * ./waf --run "scalability-benchmark --nDevices=1000,10000 --nGateways=1,10"
+ *
+ * Note that the peak resident set size is a property of the process, so it
+ * is only meaningful for the first point of a sweep or when it grows with
+ * the sweep. Run one point per process for exact values.
+ */
+
+#include "ns3/end-device-lora-mac.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-counters.h"
+#include "ns3/counting-scheduler.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/position-allocator.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/forwarder-helper.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include <sys/resource.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("ScalabilityBenchmark");
+
+template <typename T>
+std::vector<T>
+ParseList (std::string list)
+{
+  std::vector<T> values;
+  std::stringstream ss (list);
+  std::string item;
+  while (std::getline (ss, item, ','))
+    {
+      std::stringstream itemStream (item);
+      T value;
+      itemStream >> value;
+      values.push_back (value);
+    }
+  return values;
+}
+
+long
+GetPeakRssKb (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+struct Result
+{
+  double setupSeconds;
+  double runSeconds;
+  uint64_t events;
+  long peakRssKb;
+  double sectionSeconds[LoraProfiler::N_SECTIONS];
+};
+
+Result
+RunPoint (uint32_t nDevices, uint32_t nGateways, double period,
+          double confirmedRatio, double radius, double simulationTime)
+{
+  Result result;
+
+  ObjectFactory scheduler;
+  scheduler.SetTypeId ("ns3::CountingScheduler");
+  Simulator::SetScheduler (scheduler);
+
+  auto setupStart = std::chrono::steady_clock::now ();
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                 "rho", DoubleValue (radius),
+                                 "X", DoubleValue (0.0),
+                                 "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LoraMacHelper macHelper = LoraMacHelper ();
+  LoraHelper helper = LoraHelper ();
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  mobility.Install (endDevices);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LoraMacHelper::ED);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  NodeContainer gateways;
+  gateways.Create (nGateways);
+  mobility.Install (gateways);
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LoraMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  LoraMacHelper::AssignSpreadingFactors (endDevices, gateways, channel);
+
+  // Spread confirmed devices evenly over the network
+  for (uint32_t i = 0; i < nDevices; i++)
+    {
+      if (uint32_t ((i + 1) * confirmedRatio) > uint32_t (i * confirmedRatio))
+        {
+          Ptr<EndDeviceLoraMac> mac = endDevices.Get (i)->GetDevice (0)->
+            GetObject<LoraNetDevice> ()->GetMac ()->GetObject<EndDeviceLoraMac> ();
+          mac->SetMType (LoraMacHeader::CONFIRMED_DATA_UP);
+        }
+    }
+
+  PeriodicSenderHelper appHelper = PeriodicSenderHelper ();
+  appHelper.SetPeriod (Seconds (period));
+  appHelper.SetPacketSize (23);
+  ApplicationContainer apps = appHelper.Install (endDevices);
+  apps.Start (Seconds (0));
+  apps.Stop (Seconds (simulationTime));
+
+  NodeContainer networkServer;
+  networkServer.Create (1);
+  NetworkServerHelper nsHelper = NetworkServerHelper ();
+  nsHelper.SetEndDevices (endDevices);
+  nsHelper.SetGateways (gateways);
+  nsHelper.Install (networkServer);
+
+  ForwarderHelper forHelper = ForwarderHelper ();
+  forHelper.Install (gateways);
+
+  auto runStart = std::chrono::steady_clock::now ();
+
+  LoraProfiler::Reset ();
+  uint64_t eventsBefore = CountingScheduler::GetExecutedEvents ();
+
+  Simulator::Stop (Seconds (simulationTime));
+  Simulator::Run ();
+
+  auto runStop = std::chrono::steady_clock::now ();
+
+  result.setupSeconds = std::chrono::duration<double> (runStart - setupStart).count ();
+  result.runSeconds = std::chrono::duration<double> (runStop - runStart).count ();
+  result.events = CountingScheduler::GetExecutedEvents () - eventsBefore;
+  result.peakRssKb = GetPeakRssKb ();
+  for (uint32_t s = 0; s < LoraProfiler::N_SECTIONS; s++)
+    {
+      result.sectionSeconds[s] = LoraProfiler::GetSeconds (LoraProfiler::Section (s));
+    }
+
+  Simulator::Destroy ();
+
+  return result;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string nDevicesList = "1000,10000";
+  std::string nGatewaysList = "1,10";
+  std::string periodList = "600";
+  std::string confirmedList = "0";
+  double radius = 6000;
+  double simulationTime = 3600;
+  bool profile = true;
+  uint32_t seed = 1;
+  std::string output = "-";
+
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Comma-separated numbers of end devices", nDevicesList);
+  cmd.AddValue ("nGateways", "Comma-separated numbers of gateways", nGatewaysList);
+  cmd.AddValue ("period", "Comma-separated application periods in seconds", periodList);
+  cmd.AddValue ("confirmed", "Comma-separated fractions of confirmed devices",
+                confirmedList);
+  cmd.AddValue ("radius", "The radius of the disc in meters", radius);
+  cmd.AddValue ("simulationTime", "The simulated time in seconds", simulationTime);
+  cmd.AddValue ("profile", "Whether to measure the time of each section", profile);
+  cmd.AddValue ("seed", "The seed of the random number generator", seed);
+  cmd.AddValue ("output", "The CSV file to write, or - for the standard output",
+                output);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (seed);
+
+  // The sections are only timed if the counters were compiled in
+  if (profile && !LoraCounters::IsEnabled ())
+    {
+      NS_LOG_WARN ("The module was built without counters, so the section "
+                   "times are not measured");
+      profile = false;
+    }
+  LoraProfiler::SetEnabled (profile);
+
+  std::ofstream file;
+  if (output != "-")
+    {
+      file.open (output.c_str ());
+    }
+  std::ostream &os = output != "-" ? file : std::cout;
+
+  os << "nDevices,nGateways,period,confirmedRatio,simulationTime,setupSeconds,"
+     << "runSeconds,events,eventsPerSecond,peakRssKb";
+  for (uint32_t s = 0; s < LoraProfiler::N_SECTIONS; s++)
+    {
+      os << "," << LoraProfiler::GetSectionName (LoraProfiler::Section (s)) << "Seconds";
+    }
+  os << std::endl;
+
+  std::vector<uint32_t> nDevicesValues = ParseList<uint32_t> (nDevicesList);
+  std::vector<uint32_t> nGatewaysValues = ParseList<uint32_t> (nGatewaysList);
+  std::vector<double> periodValues = ParseList<double> (periodList);
+  std::vector<double> confirmedValues = ParseList<double> (confirmedList);
+
+  for (uint32_t nDevices : nDevicesValues)
+    {
+      for (uint32_t nGateways : nGatewaysValues)
+        {
+          for (double period : periodValues)
+            {
+              for (double confirmedRatio : confirmedValues)
+                {
+                  NS_LOG_INFO ("Running " << nDevices << " devices, " <<
+                               nGateways << " gateways, period " << period <<
+                               " s, confirmed ratio " << confirmedRatio);
+
+                  Result result = RunPoint (nDevices, nGateways, period,
+                                            confirmedRatio, radius,
+                                            simulationTime);
+
+                  os << nDevices << "," << nGateways << "," << period << "," <<
+                    confirmedRatio << "," << simulationTime << "," <<
+                    result.setupSeconds << "," << result.runSeconds << "," <<
+                    result.events << "," << result.events / result.runSeconds <<
+                    "," << result.peakRssKb;
+                  for (uint32_t s = 0; s < LoraProfiler::N_SECTIONS; s++)
+                    {
+                      os << "," << (profile ? result.sectionSeconds[s] :
+                                    std::numeric_limits<double>::quiet_NaN ());
+                    }
+                  os << std::endl;
+                }
+            }
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * This program draws the correlated shadowing fields of a bounding box, and
+ * writes them to a raster that RasterShadowingPropagationLossModel can map:
+ * ./waf --run "shadowing-raster-generator --xMin=-5000 --xMax=5000
+ *              --yMin=-5000 --yMax=5000 --output=shadowing.raster"
+ *
+ * The raster only depends on the stream it is drawn from, so that the same
+ * file can be shared by all the runs and concurrent jobs that simulate the
+ * same area. It is then used by setting the RasterFile attribute:
+ * --ns3::RasterShadowingPropagationLossModel::RasterFile=shadowing.raster
+ */
+
+#include "ns3/shadowing-raster-helper.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("ShadowingRasterGenerator");
+
+int main (int argc, char *argv[])
+{
+  double xMin = -1000;
+  double xMax = 1000;
+  double yMin = -1000;
+  double yMax = 1000;
+  double correlationDistance = 110;
+  double variance = 16;
+  int64_t stream = 0;
+  std::string output = "shadowing.raster";
+
+  CommandLine cmd;
+  cmd.AddValue ("xMin", "The lower x bound of the area [m]", xMin);
+  cmd.AddValue ("xMax", "The upper x bound of the area [m]", xMax);
+  cmd.AddValue ("yMin", "The lower y bound of the area [m]", yMin);
+  cmd.AddValue ("yMax", "The upper y bound of the area [m]", yMax);
+  cmd.AddValue ("correlationDistance", "The correlation distance [m]", correlationDistance);
+  cmd.AddValue ("variance", "The variance of the shadowing [dB^2]", variance);
+  cmd.AddValue ("stream", "The random stream the raster is drawn from", stream);
+  cmd.AddValue ("output", "The raster file to write", output);
+  cmd.Parse (argc, argv);
+
+  if (!(xMin <= xMax && yMin <= yMax && correlationDistance > 0))
+    {
+      std::cerr << "Invalid area or correlation distance" << std::endl;
+      return 1;
+    }
+
+  ShadowingRasterHelper helper;
+  helper.SetBoundingBox (Box (xMin, xMax, yMin, yMax, 0, 0));
+  helper.SetCorrelationDistance (correlationDistance);
+  helper.SetVariance (variance);
+  helper.AssignStreams (stream);
+
+  RasterShadowingPropagationLossModel::RasterHeader header = helper.GetHeader ();
+  std::cout << "Writing " << header.nSquaresX << "x" << header.nSquaresY <<
+    " squares (" << helper.GetRasterSize () / 1e6 << " MB) to " << output <<
+    std::endl;
+
+  if (!helper.Write (output))
+    {
+      std::cerr << "Unable to write " << output << std::endl;
+      return 1;
+    }
+
+  return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * This program converts a digital elevation model in the ESRI ASCII grid
+ * format, which most GIS tools can export, to the elevation file that
+ * TerrainLoraPropagationLossModel maps:
+ * ./waf --run "terrain-elevation-converter --input=dem.asc
+ *              --output=terrain.dem"
+ *
+ * The coordinates of the grid must be in meters, in the same frame as the
+ * positions of the nodes, possibly shifted by --xOffset and --yOffset. Cells
+ * with no data are given the height of --noDataHeight. The file is then used
+ * by setting the ElevationFile attribute:
+ * --ns3::TerrainLoraPropagationLossModel::ElevationFile=terrain.dem
+ */
+
+#include "ns3/terrain-lora-propagation-loss-model.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("TerrainElevationConverter");
+
+int main (int argc, char *argv[])
+{
+  std::string input = "";
+  std::string output = "terrain.dem";
+  double xOffset = 0;
+  double yOffset = 0;
+  double noDataHeight = 0;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "The ESRI ASCII grid to convert", input);
+  cmd.AddValue ("output", "The elevation file to write", output);
+  cmd.AddValue ("xOffset", "The offset added to x coordinates [m]", xOffset);
+  cmd.AddValue ("yOffset", "The offset added to y coordinates [m]", yOffset);
+  cmd.AddValue ("noDataHeight", "The height of cells with no data [m]", noDataHeight);
+  cmd.Parse (argc, argv);
+
+  std::ifstream file (input.c_str ());
+  if (!file.is_open ())
+    {
+      std::cerr << "Unable to read the grid, specify it with --input" << std::endl;
+      return 1;
+    }
+
+  // Read the header, whose keys may come in any order and case
+  uint32_t nCols = 0;
+  uint32_t nRows = 0;
+  double x = 0;
+  double y = 0;
+  bool cellCenter = false;
+  double cellSize = 0;
+  double noData = -9999;
+  std::string key;
+  while (file >> key && !std::isdigit (key[0]) && key[0] != '-' && key[0] != '.')
+    {
+      std::transform (key.begin (), key.end (), key.begin (), ::tolower);
+      double value;
+      file >> value;
+      if (key == "ncols")
+        {
+          nCols = value;
+        }
+      else if (key == "nrows")
+        {
+          nRows = value;
+        }
+      else if (key == "xllcorner" || key == "xllcenter")
+        {
+          x = value;
+          cellCenter = key == "xllcenter";
+        }
+      else if (key == "yllcorner" || key == "yllcenter")
+        {
+          y = value;
+        }
+      else if (key == "cellsize")
+        {
+          cellSize = value;
+        }
+      else if (key == "nodata_value")
+        {
+          noData = value;
+        }
+    }
+  if (!file || nCols < 2 || nRows < 2 || !(cellSize > 0))
+    {
+      std::cerr << "Missing or invalid grid header in " << input << std::endl;
+      return 1;
+    }
+
+  // Rows are stored from north to south, and the first height was already
+  // read as the key that ended the header
+  std::vector<float> heights (uint64_t (nCols) * nRows);
+  for (uint64_t i = 0; i < heights.size (); i++)
+    {
+      double height;
+      if (i == 0)
+        {
+          height = std::atof (key.c_str ());
+        }
+      else if (!(file >> height))
+        {
+          std::cerr << "The grid in " << input << " is truncated" << std::endl;
+          return 1;
+        }
+      uint64_t row = nRows - 1 - i / nCols;
+      heights[row * nCols + i % nCols] = height == noData ? noDataHeight : height;
+    }
+
+  // Heights are given at the centers of the cells
+  if (!cellCenter)
+    {
+      x += cellSize / 2;
+      y += cellSize / 2;
+    }
+  if (!TerrainLoraPropagationLossModel::WriteElevation (output, x + xOffset, y + yOffset,
+                                                        cellSize, nCols, nRows, heights))
+    {
+      std::cerr << "Unable to write " << output << std::endl;
+      return 1;
+    }
+  std::cout << "Wrote a " << nCols << "x" << nRows << " grid with a resolution of " <<
+    cellSize << " m to " << output << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/fleet-sender-helper.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("FleetSenderHelper");
+
+FleetSenderHelper::FleetSenderHelper ()
+{
+  m_factory.SetTypeId ("ns3::FleetSender");
+
+  m_initialDelay = CreateObject<UniformRandomVariable> ();
+  m_initialDelay->SetAttribute ("Min", DoubleValue (0));
+
+  m_intervalProb = CreateObject<UniformRandomVariable> ();
+  m_intervalProb->SetAttribute ("Min", DoubleValue (0));
+  m_intervalProb->SetAttribute ("Max", DoubleValue (1));
+
+  m_pktSize = 10;
+  m_pktSizeRV = 0;
+  m_jitterRV = 0;
+}
+
+FleetSenderHelper::~FleetSenderHelper ()
+{
+}
+
+void
+FleetSenderHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+FleetSenderHelper::Install (NodeContainer c) const
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT (c.GetN () > 0);
+
+  Ptr<FleetSender> app = m_factory.Create<FleetSender> ();
+
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Time interval;
+      if (m_period == Seconds (0))
+        {
+          double intervalProb = m_intervalProb->GetValue ();
+          NS_LOG_DEBUG ("IntervalProb = " << intervalProb);
+
+          // Based on TR 45.820
+          if (intervalProb < 0.4)
+            {
+              interval = Days (1);
+            }
+          else if (0.4 <= intervalProb  && intervalProb < 0.8)
+            {
+              interval = Hours (2);
+            }
+          else if (0.8 <= intervalProb  && intervalProb < 0.95)
+            {
+              interval = Hours (1);
+            }
+          else
+            {
+              interval = Minutes (30);
+            }
+        }
+      else
+        {
+          interval = m_period;
+        }
+
+      Time initialDelay = Seconds (m_initialDelay->GetValue (0, interval.GetSeconds ()));
+      app->AddDevice (*i, interval, initialDelay);
+    }
+
+  NS_LOG_DEBUG ("Created a fleet application with " << app->GetNDevices () <<
+                " devices");
+
+  app->SetPacketSize (m_pktSize);
+  if (m_pktSizeRV)
+    {
+      app->SetPacketSizeRandomVariable (m_pktSizeRV);
+    }
+  if (m_jitterRV)
+    {
+      app->SetJitterRandomVariable (m_jitterRV);
+    }
+
+  Ptr<Node> host = c.Get (0);
+  app->SetNode (host);
+  host->AddApplication (app);
+
+  return ApplicationContainer (app);
+}
+
+void
+FleetSenderHelper::SetPeriod (Time period)
+{
+  m_period = period;
+}
+
+void
+FleetSenderHelper::SetPacketSizeRandomVariable (Ptr <RandomVariableStream> rv)
+{
+  m_pktSizeRV = rv;
+}
+
+void
+FleetSenderHelper::SetJitterRandomVariable (Ptr <RandomVariableStream> rv)
+{
+  m_jitterRV = rv;
+}
+
+void
+FleetSenderHelper::SetPacketSize (uint8_t size)
+{
+  m_pktSize = size;
+}
+
+int64_t
+FleetSenderHelper::AssignStreams (int64_t stream)
+{
+  m_initialDelay->SetStream (stream);
+  m_intervalProb->SetStream (stream + 1);
+  return 2;
+}
+
+}
+}
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLEET_SENDER_HELPER_H
+#define FLEET_SENDER_HELPER_H
+
+#include "ns3/object-factory.h"
+#include "ns3/attribute.h"
+#include "ns3/node-container.h"
+#include "ns3/application-container.h"
+#include "ns3/fleet-sender.h"
+#include <stdint.h>
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * This class can be used to install a single FleetSender application that
+ * generates the traffic of a set of end devices.
+ *
+ * Periods and initial delays are drawn exactly as in PeriodicSenderHelper,
+ * so that, when the two helpers use the same streams, the fleet generates
+ * the same traffic as a PeriodicSender on each device.
+ */
+class FleetSenderHelper
+{
+public:
+  FleetSenderHelper ();
+
+  ~FleetSenderHelper ();
+
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Install a FleetSender serving all the nodes in the container. The
+   * application is aggregated to the first node of the container.
+   *
+   * \param c The end device nodes.
+   * \return A container with the single FleetSender application.
+   */
+  ApplicationContainer Install (NodeContainer c) const;
+
+  /**
+   * Set the period to be used by the devices of the fleet.
+   *
+   * A value of Seconds (0) results in randomly generated periods according to
+   * the model contained in the TR 45.820 document.
+   *
+   * \param period The period to set
+   */
+  void SetPeriod (Time period);
+
+  void SetPacketSizeRandomVariable (Ptr <RandomVariableStream> rv);
+
+  /**
+   * Set the random variable, in seconds, that is added to each interval.
+   */
+  void SetJitterRandomVariable (Ptr <RandomVariableStream> rv);
+
+  void SetPacketSize (uint8_t size);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this helper.
+   *
+   * \param stream The first stream index to use.
+   * \return The number of stream indices assigned.
+   */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  ObjectFactory m_factory;
+
+  Ptr<UniformRandomVariable> m_initialDelay;
+
+  Ptr<UniformRandomVariable> m_intervalProb;
+
+  Time m_period; //!< The period with which the devices will send messages
+
+  Ptr<RandomVariableStream> m_pktSizeRV; // whether or not a random component is added to the packet size
+
+  Ptr<RandomVariableStream> m_jitterRV; // whether or not a random component is added to the period
+
+  uint8_t m_pktSize; // the packet size.
+};
+
+}
+
+}
+#endif /* FLEET_SENDER_HELPER_H */
@@ -0,0 +1,356 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-calibration-fitter.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraCalibrationFitter");
+
+typedef RYLRLoraPropagationLossModel::Coefficients Coefficients;
+
+LoraCalibrationFitter::LoraCalibrationFitter ()
+  : m_referenceDistance (1)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (uint8_t sf = 0; sf <= RYLRLoraPropagationLossModel::MAX_SF; sf++)
+    {
+      m_offsets[sf] = RYLRLoraPropagationLossModel::GetDefaultCoefficients (sf).offset;
+    }
+}
+
+LoraCalibrationFitter::~LoraCalibrationFitter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LoraCalibrationFitter::AddSample (double distance, uint8_t sf, double rssiDbm,
+                                  double txPowerDbm)
+{
+  NS_ASSERT_MSG (sf >= RYLRLoraPropagationLossModel::MIN_SF &&
+                 sf <= RYLRLoraPropagationLossModel::MAX_SF,
+                 "SF=" << unsigned (sf) << " can't be calibrated");
+
+  Sample sample;
+  sample.distance = distance;
+  sample.pathLossDb = txPowerDbm - rssiDbm;
+  m_samples[sf].push_back (sample);
+}
+
+bool
+LoraCalibrationFitter::ReadSamples (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::ifstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open sample file " << filename);
+      return false;
+    }
+
+  std::string line;
+  uint32_t lineNumber = 0;
+  while (std::getline (file, line))
+    {
+      lineNumber++;
+
+      // Skip empty lines and comments
+      std::size_t first = line.find_first_not_of (" \t\r");
+      if (first == std::string::npos || line[first] == '#')
+        {
+          continue;
+        }
+
+      std::replace (line.begin (), line.end (), ',', ' ');
+      std::istringstream is (line);
+      double distance;
+      int sf;
+      double rssi;
+      double txPower = 14;
+      if (!(is >> distance >> sf >> rssi)
+          || sf < RYLRLoraPropagationLossModel::MIN_SF
+          || sf > RYLRLoraPropagationLossModel::MAX_SF)
+        {
+          NS_LOG_ERROR ("Malformed line " << lineNumber << " in " << filename);
+          return false;
+        }
+      is >> txPower;
+
+      AddSample (distance, sf, rssi, txPower);
+    }
+
+  return true;
+}
+
+uint32_t
+LoraCalibrationFitter::GetNSamples (uint8_t sf) const
+{
+  return sf <= RYLRLoraPropagationLossModel::MAX_SF ? m_samples[sf].size () : 0;
+}
+
+void
+LoraCalibrationFitter::SetOffset (uint8_t sf, double offsetDb)
+{
+  NS_ASSERT (sf <= RYLRLoraPropagationLossModel::MAX_SF);
+
+  m_offsets[sf] = offsetDb;
+}
+
+void
+LoraCalibrationFitter::SetReferenceDistance (double distance)
+{
+  NS_ASSERT (distance > 0);
+
+  m_referenceDistance = distance;
+}
+
+Coefficients
+LoraCalibrationFitter::Fit (uint8_t sf, Curve curve) const
+{
+  NS_LOG_FUNCTION (this << unsigned (sf) << curve);
+
+  Coefficients c = RYLRLoraPropagationLossModel::GetDefaultCoefficients (sf);
+  c.offset = m_offsets[sf];
+
+  const std::vector<Sample> &samples = m_samples[sf];
+  uint32_t nParams = curve == PIECEWISE_LINEAR ? 3 : 2;
+  if (samples.size () <= nParams)
+    {
+      NS_LOG_WARN ("Only " << samples.size () << " samples for SF" << unsigned (sf) <<
+                   ", keeping the default coefficients");
+      return c;
+    }
+
+  std::vector<double> x;
+  std::vector<double> y;
+  for (const Sample &sample : samples)
+    {
+      y.push_back (sample.pathLossDb);
+    }
+
+  double beta[3];
+  switch (curve)
+    {
+    case LINEAR:
+      for (const Sample &sample : samples)
+        {
+          x.push_back (1);
+          x.push_back (sample.distance);
+        }
+      if (LeastSquares (x, y, 2, beta) >= 0)
+        {
+          c.constant = beta[0];
+          c.linear = beta[1];
+          c.logarithmic = 0;
+          c.breakpoint = 0;
+          c.piecewise = 0;
+        }
+      break;
+    case LOG_DISTANCE:
+      for (const Sample &sample : samples)
+        {
+          x.push_back (1);
+          x.push_back (std::log10 (std::max (sample.distance, m_referenceDistance)));
+        }
+      if (LeastSquares (x, y, 2, beta) >= 0)
+        {
+          c.constant = beta[0];
+          c.linear = 0;
+          c.logarithmic = beta[1];
+          c.referenceDistance = m_referenceDistance;
+          c.breakpoint = 0;
+          c.piecewise = 0;
+        }
+      break;
+    case PIECEWISE_LINEAR:
+      {
+        // Try breakpoints at the distances of the samples between the 10th
+        // and the 90th percentiles
+        std::vector<double> distances;
+        for (const Sample &sample : samples)
+          {
+            distances.push_back (sample.distance);
+          }
+        std::sort (distances.begin (), distances.end ());
+        const uint32_t nCandidates = 50;
+        uint32_t firstIndex = distances.size () / 10;
+        uint32_t lastIndex = distances.size () - 1 - distances.size () / 10;
+
+        double bestError = -1;
+        for (uint32_t i = 0; i < nCandidates; i++)
+          {
+            double breakpoint = distances[firstIndex + (lastIndex - firstIndex) * i /
+                                          (nCandidates - 1)];
+            x.clear ();
+            for (const Sample &sample : samples)
+              {
+                x.push_back (1);
+                x.push_back (sample.distance);
+                x.push_back (std::max (sample.distance - breakpoint, 0.0));
+              }
+            double error = LeastSquares (x, y, 3, beta);
+            if (error >= 0 && (bestError < 0 || error < bestError))
+              {
+                bestError = error;
+                c.constant = beta[0];
+                c.linear = beta[1];
+                c.logarithmic = 0;
+                c.breakpoint = breakpoint;
+                c.piecewise = beta[2];
+              }
+          }
+        break;
+      }
+    }
+
+  NS_LOG_DEBUG ("SF" << unsigned (sf) << ": constant=" << c.constant <<
+                ", linear=" << c.linear << ", logarithmic=" << c.logarithmic <<
+                ", breakpoint=" << c.breakpoint << ", piecewise=" << c.piecewise <<
+                ", rmse=" << GetRmse (sf, c));
+  return c;
+}
+
+double
+LoraCalibrationFitter::GetRmse (uint8_t sf, Coefficients coefficients) const
+{
+  const std::vector<Sample> &samples = m_samples[sf];
+  if (samples.empty ())
+    {
+      return 0;
+    }
+
+  double sum = 0;
+  for (const Sample &sample : samples)
+    {
+      double error = GetPathLoss (coefficients, sample.distance) - sample.pathLossDb;
+      sum += error * error;
+    }
+  return std::sqrt (sum / samples.size ());
+}
+
+bool
+LoraCalibrationFitter::WriteCalibration (std::string filename, Curve curve) const
+{
+  NS_LOG_FUNCTION (this << filename << curve);
+
+  Coefficients coefficients[RYLRLoraPropagationLossModel::MAX_SF + 1];
+  for (uint8_t sf = 0; sf <= RYLRLoraPropagationLossModel::MAX_SF; sf++)
+    {
+      coefficients[sf] = Fit (std::max (sf, RYLRLoraPropagationLossModel::MIN_SF), curve);
+    }
+
+  std::ofstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open calibration file " << filename);
+      return false;
+    }
+  RYLRLoraPropagationLossModel::WriteCalibration (file, coefficients);
+  return bool (file);
+}
+
+double
+LoraCalibrationFitter::LeastSquares (const std::vector<double> &x,
+                                     const std::vector<double> &y,
+                                     uint32_t nParams, double beta[3])
+{
+  NS_ASSERT (nParams <= 3 && x.size () == y.size () * nParams);
+
+  // Build the normal equations (X^T X) beta = X^T y, as an augmented matrix
+  double a[3][4] = {};
+  for (uint32_t s = 0; s < y.size (); s++)
+    {
+      const double *row = &x[s * nParams];
+      for (uint32_t i = 0; i < nParams; i++)
+        {
+          for (uint32_t j = 0; j < nParams; j++)
+            {
+              a[i][j] += row[i] * row[j];
+            }
+          a[i][nParams] += row[i] * y[s];
+        }
+    }
+
+  // Gaussian elimination with partial pivoting
+  for (uint32_t col = 0; col < nParams; col++)
+    {
+      uint32_t pivot = col;
+      for (uint32_t r = col + 1; r < nParams; r++)
+        {
+          if (std::fabs (a[r][col]) > std::fabs (a[pivot][col]))
+            {
+              pivot = r;
+            }
+        }
+      if (std::fabs (a[pivot][col]) < 1e-12)
+        {
+          return -1;
+        }
+      for (uint32_t k = 0; k <= nParams; k++)
+        {
+          std::swap (a[col][k], a[pivot][k]);
+        }
+      for (uint32_t r = 0; r < nParams; r++)
+        {
+          if (r != col)
+            {
+              double factor = a[r][col] / a[col][col];
+              for (uint32_t k = col; k <= nParams; k++)
+                {
+                  a[r][k] -= factor * a[col][k];
+                }
+            }
+        }
+    }
+  for (uint32_t i = 0; i < nParams; i++)
+    {
+      beta[i] = a[i][nParams] / a[i][i];
+    }
+
+  double sse = 0;
+  for (uint32_t s = 0; s < y.size (); s++)
+    {
+      double prediction = 0;
+      for (uint32_t i = 0; i < nParams; i++)
+        {
+          prediction += beta[i] * x[s * nParams + i];
+        }
+      sse += (prediction - y[s]) * (prediction - y[s]);
+    }
+  return sse;
+}
+
+double
+LoraCalibrationFitter::GetPathLoss (const Coefficients &c, double distance)
+{
+  return c.constant + c.linear * distance +
+         c.logarithmic * std::log10 (std::max (distance, c.referenceDistance)) +
+         c.piecewise * std::max (distance - c.breakpoint, 0.0);
+}
+
+}
+}
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_CALIBRATION_FITTER_H
+#define LORA_CALIBRATION_FITTER_H
+
+#include "ns3/lora-propagation-loss-model.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * This class fits the coefficients of a RYLRLoraPropagationLossModel to field
+ * measurements, and writes them to a calibration file.
+ *
+ * Each sample is made of the distance between transmitter and receiver, the
+ * SF and the measured RSSI. The path loss of each sample is the transmission
+ * power minus the RSSI, and the loss of each SF is fitted by least squares
+ * with one of the following curves:
+ * - LINEAR: constant + linear * d;
+ * - LOG_DISTANCE: constant + logarithmic * log10 (max (d, d0));
+ * - PIECEWISE_LINEAR: constant + linear * d + piecewise * max (d - b, 0),
+ *   where the breakpoint b is the one that minimizes the squared error among
+ *   a set of candidates taken from the sample distances.
+ *
+ * The offset of each SF is not fitted, since it depends on the receiver that
+ * is simulated: it defaults to the one of the default RYLR coefficients. SFs
+ * with too few samples keep their default coefficients.
+ */
+class LoraCalibrationFitter
+{
+public:
+  /**
+   * The curves that can be fitted.
+   */
+  enum Curve
+  {
+    LINEAR,
+    LOG_DISTANCE,
+    PIECEWISE_LINEAR
+  };
+
+  LoraCalibrationFitter ();
+  ~LoraCalibrationFitter ();
+
+  /**
+   * Add a measurement.
+   *
+   * \param distance The distance between transmitter and receiver [m].
+   * \param sf The spreading factor of the transmission.
+   * \param rssiDbm The measured RSSI [dBm].
+   * \param txPowerDbm The transmission power [dBm].
+   */
+  void AddSample (double distance, uint8_t sf, double rssiDbm,
+                  double txPowerDbm = 14);
+
+  /**
+   * Read measurements from a file with a distance,sf,rssi[,txPower] line for
+   * each of them. Empty lines and lines starting with '#' are ignored.
+   *
+   * \param filename The file to read.
+   * \return False if the file can't be read or is malformed.
+   */
+  bool ReadSamples (std::string filename);
+
+  /**
+   * Get the number of samples of a SF.
+   */
+  uint32_t GetNSamples (uint8_t sf) const;
+
+  /**
+   * Set the offset written for a SF.
+   */
+  void SetOffset (uint8_t sf, double offsetDb);
+
+  /**
+   * Set the reference distance of the LOG_DISTANCE curve.
+   */
+  void SetReferenceDistance (double distance);
+
+  /**
+   * Fit the samples of a SF.
+   *
+   * \param sf The spreading factor.
+   * \param curve The curve to fit.
+   * \return The fitted coefficients, or the default ones if the SF doesn't
+   * have enough samples for the curve.
+   */
+  RYLRLoraPropagationLossModel::Coefficients Fit (uint8_t sf, Curve curve) const;
+
+  /**
+   * Compute the root mean square error of the path loss of a SF's samples.
+   */
+  double GetRmse (uint8_t sf,
+                  RYLRLoraPropagationLossModel::Coefficients coefficients) const;
+
+  /**
+   * Fit all SFs and write a calibration file.
+   *
+   * \param filename The file to write.
+   * \param curve The curve to fit.
+   * \return Whether the file was written successfully.
+   */
+  bool WriteCalibration (std::string filename, Curve curve) const;
+
+private:
+  struct Sample
+  {
+    double distance;
+    double pathLossDb;
+  };
+
+  /**
+   * Solve a least squares problem with up to three unknowns.
+   *
+   * \param x The features of each sample, nParams for each of them.
+   * \param y The value of each sample.
+   * \param nParams The number of unknowns.
+   * \param beta Set to the solution.
+   * \return The sum of squared errors, or a negative value if the problem is
+   * singular.
+   */
+  static double LeastSquares (const std::vector<double> &x,
+                              const std::vector<double> &y,
+                              uint32_t nParams, double beta[3]);
+
+  /**
+   * Evaluate the path loss of a set of coefficients, without the offset.
+   */
+  static double GetPathLoss (const RYLRLoraPropagationLossModel::Coefficients &c,
+                             double distance);
+
+  std::vector<Sample> m_samples[RYLRLoraPropagationLossModel::MAX_SF + 1];
+  double m_offsets[RYLRLoraPropagationLossModel::MAX_SF + 1];
+  double m_referenceDistance;
+};
+
+}
+
+}
+#endif /* LORA_CALIBRATION_FITTER_H */
@@ -0,0 +1,963 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-checkpoint.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/end-device-lora-mac.h"
+#include "ns3/gateway-lora-mac.h"
+#include "ns3/periodic-sender.h"
+#include "ns3/fleet-sender.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/network-server.h"
+#include "ns3/network-status.h"
+#include "ns3/end-device-status.h"
+#include "ns3/gateway-status.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/node-list.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <fstream>
+#include <cstring>
+#include <limits>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraCheckpoint");
+
+static const char g_checkpointMagic[4] = {'L', 'R', 'C', 'P'};
+
+// Binary serialization of plain values and byte strings, in host byte order
+
+template <typename T>
+static void
+WriteValue (std::ostream &os, const T &value)
+{
+  os.write (reinterpret_cast<const char *> (&value), sizeof (T));
+}
+
+template <typename T>
+static void
+ReadValue (std::istream &is, T &value)
+{
+  is.read (reinterpret_cast<char *> (&value), sizeof (T));
+}
+
+template <typename T>
+static void
+WriteVector (std::ostream &os, const std::vector<T> &values)
+{
+  uint32_t size = values.size ();
+  WriteValue (os, size);
+  if (size > 0)
+    {
+      os.write (reinterpret_cast<const char *> (values.data ()), size * sizeof (T));
+    }
+}
+
+// Counts are read from a file that may be corrupt, so they are checked
+// before anything is allocated. A count that is out of bounds puts the
+// stream in a failed state, and is read as zero.
+
+static void
+ReadCount (std::istream &is, uint32_t &count, uint64_t maxCount)
+{
+  count = 0;
+  ReadValue (is, count);
+  if (!is || count > maxCount)
+    {
+      is.setstate (std::ios::failbit);
+      count = 0;
+    }
+}
+
+template <typename T>
+static void
+ReadVector (std::istream &is, std::vector<T> &values, uint64_t maxBytes)
+{
+  uint32_t size = 0;
+  ReadCount (is, size, maxBytes / sizeof (T));
+  values.resize (size);
+  if (size > 0)
+    {
+      is.read (reinterpret_cast<char *> (values.data ()), size * sizeof (T));
+    }
+}
+
+static std::vector<uint8_t>
+PacketToBytes (Ptr<const Packet> packet)
+{
+  std::vector<uint8_t> bytes (packet->GetSize ());
+  packet->CopyData (bytes.data (), bytes.size ());
+  return bytes;
+}
+
+static std::vector<uint8_t>
+AddressToBytes (const Address &address)
+{
+  std::vector<uint8_t> bytes (address.GetSerializedSize ());
+  address.CopyAllTo (bytes.data (), bytes.size ());
+  return bytes;
+}
+
+static Address
+BytesToAddress (const std::vector<uint8_t> &bytes)
+{
+  Address address;
+  address.CopyAllFrom (bytes.data (), bytes.size ());
+  return address;
+}
+
+static Ptr<EndDeviceLoraMac>
+GetEndDeviceMac (Ptr<Node> node)
+{
+  Ptr<LoraNetDevice> loraNetDevice = node->GetDevice (0)->GetObject<LoraNetDevice> ();
+  NS_ASSERT (loraNetDevice != 0);
+  Ptr<EndDeviceLoraMac> mac = loraNetDevice->GetMac ()->GetObject<EndDeviceLoraMac> ();
+  NS_ASSERT (mac != 0);
+  return mac;
+}
+
+static Ptr<LoraMac>
+GetGatewayMac (Ptr<Node> node)
+{
+  Ptr<LoraNetDevice> loraNetDevice = node->GetDevice (0)->GetObject<LoraNetDevice> ();
+  NS_ASSERT (loraNetDevice != 0);
+  return loraNetDevice->GetMac ();
+}
+
+static Ptr<NetworkStatus>
+GetNetworkStatus (Ptr<Node> node)
+{
+  for (uint32_t i = 0; i < node->GetNApplications (); i++)
+    {
+      Ptr<NetworkServer> server = DynamicCast<NetworkServer> (node->GetApplication (i));
+      if (server != 0)
+        {
+          return server->GetNetworkStatus ();
+        }
+    }
+  return 0;
+}
+
+LoraCheckpoint::LoraCheckpoint ()
+  : m_rngSeed (0),
+  m_rngRun (0)
+{
+}
+
+LoraCheckpoint::~LoraCheckpoint ()
+{
+}
+
+void
+LoraCheckpoint::SetEndDevices (NodeContainer endDevices)
+{
+  m_endDevices = endDevices;
+}
+
+void
+LoraCheckpoint::SetGateways (NodeContainer gateways)
+{
+  m_gateways = gateways;
+}
+
+void
+LoraCheckpoint::SetNetworkServer (Ptr<Node> networkServer)
+{
+  m_networkServer = networkServer;
+}
+
+void
+LoraCheckpoint::SetEnergyModels (DeviceEnergyModelContainer models)
+{
+  m_energyModels = models;
+}
+
+void
+LoraCheckpoint::ScheduleSave (Time time, std::string filename)
+{
+  NS_LOG_FUNCTION (this << time << filename);
+
+  Simulator::Schedule (time - Simulator::Now (),
+                       &LoraCheckpoint::DoScheduledSave, this, filename);
+}
+
+void
+LoraCheckpoint::DoScheduledSave (std::string filename)
+{
+  if (!Save (filename))
+    {
+      NS_LOG_WARN ("Unable to save the checkpoint to " << filename);
+    }
+}
+
+Time
+LoraCheckpoint::GetCheckpointTime (void) const
+{
+  return m_time;
+}
+
+bool
+LoraCheckpoint::Save (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Capture ();
+
+  std::ofstream out (filename.c_str (), std::ios::binary | std::ios::trunc);
+  if (!out.is_open ())
+    {
+      NS_LOG_WARN ("Unable to open " << filename << " for writing");
+      return false;
+    }
+  Write (out);
+  out.close ();
+
+  NS_LOG_INFO ("Saved checkpoint at " << m_time.GetSeconds () << " s to " <<
+               filename);
+
+  return !out.fail ();
+}
+
+bool
+LoraCheckpoint::Restore (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::ifstream in (filename.c_str (), std::ios::binary);
+  if (!in.is_open ())
+    {
+      NS_LOG_WARN ("Unable to open " << filename);
+      return false;
+    }
+  if (!Read (in))
+    {
+      NS_LOG_WARN ("Checkpoint " << filename << " is malformed");
+      return false;
+    }
+
+  if (m_endDeviceStates.size () != m_endDevices.GetN ()
+      || m_gatewayStates.size () != m_gateways.GetN ()
+      || m_energyStates.size () != m_energyModels.GetN ())
+    {
+      NS_LOG_WARN ("Checkpoint " << filename << " doesn't match the scenario");
+      return false;
+    }
+  for (std::vector<ApplicationState>::const_iterator it = m_applicationStates.begin ();
+       it != m_applicationStates.end (); ++it)
+    {
+      if (it->nodeId >= NodeList::GetNNodes ()
+          || it->index >= NodeList::GetNode (it->nodeId)->GetNApplications ()
+          || it->nextSend.empty ())
+        {
+          NS_LOG_WARN ("Checkpoint " << filename << " doesn't match the scenario");
+          return false;
+        }
+    }
+
+  NS_ASSERT (Simulator::Now () <= m_time);
+
+  if (m_rngRun == RngSeedManager::GetRun () && m_rngSeed == RngSeedManager::GetSeed ())
+    {
+      NS_LOG_INFO ("Restoring with the same seed and run of the saved simulation");
+    }
+
+  // Applications resume at the checkpoint time, from their saved schedule.
+  // Those with nothing scheduled either start after the checkpoint, and keep
+  // their start time, or had been stopped, and are kept silent.
+  for (std::vector<ApplicationState>::iterator it = m_applicationStates.begin ();
+       it != m_applicationStates.end (); ++it)
+    {
+      Ptr<Application> app = NodeList::GetNode (it->nodeId)->GetApplication (it->index);
+
+      Ptr<PeriodicSender> periodic = DynamicCast<PeriodicSender> (app);
+      if (periodic != 0)
+        {
+          if (it->nextSend[0] >= 0)
+            {
+              periodic->SetStartTime (m_time);
+              periodic->m_initialDelay = TimeStep (it->nextSend[0]) - m_time;
+            }
+          else if (periodic->m_startTime < m_time)
+            {
+              periodic->SetStartTime (m_time);
+              periodic->SetStopTime (m_time);
+            }
+        }
+
+      Ptr<FleetSender> fleet = DynamicCast<FleetSender> (app);
+      if (fleet != 0 && it->nextSend.size () == fleet->m_devices.size ())
+        {
+          bool running = false;
+          for (uint32_t i = 0; i < it->nextSend.size (); i++)
+            {
+              if (it->nextSend[i] >= 0)
+                {
+                  fleet->m_devices[i].initialDelay = TimeStep (it->nextSend[i]) - m_time;
+                  running = true;
+                }
+            }
+          if (running)
+            {
+              fleet->SetStartTime (m_time);
+            }
+          else if (fleet->m_startTime < m_time)
+            {
+              fleet->SetStartTime (m_time);
+              fleet->SetStopTime (m_time);
+            }
+        }
+    }
+
+  // Energy sources would otherwise be updated periodically while the
+  // simulation idles until the checkpoint
+  m_energyUpdateIntervals.clear ();
+  for (uint32_t i = 0; i < m_energyModels.GetN (); i++)
+    {
+      Ptr<LoraRadioEnergyModel> model =
+        DynamicCast<LoraRadioEnergyModel> (m_energyModels.Get (i));
+      Ptr<BasicEnergySource> source;
+      if (model != 0)
+        {
+          source = DynamicCast<BasicEnergySource> (model->GetEnergySource ());
+        }
+      if (source != 0)
+        {
+          m_energyUpdateIntervals.push_back (source->GetEnergyUpdateInterval ());
+          if (m_time.IsStrictlyPositive ())
+            {
+              source->SetEnergyUpdateInterval (m_time);
+            }
+        }
+      else
+        {
+          m_energyUpdateIntervals.push_back (Time (0));
+        }
+    }
+
+  Simulator::Schedule (m_time - Simulator::Now (), &LoraCheckpoint::Apply, this);
+
+  return true;
+}
+
+void
+LoraCheckpoint::CaptureChannels (LogicalLoraChannelHelper &helper,
+                                 ChannelState &state)
+{
+  state.nextAggregatedTransmission =
+    helper.m_nextAggregatedTransmissionTime.GetTimeStep ();
+  state.subBandNextTransmission.clear ();
+  for (std::list<Ptr<SubBand> >::iterator it = helper.m_subBandList.begin ();
+       it != helper.m_subBandList.end (); ++it)
+    {
+      state.subBandNextTransmission.push_back
+        ((*it)->GetNextTransmissionTime ().GetTimeStep ());
+    }
+  state.uplinkEnabled.clear ();
+  for (uint32_t i = 0; i < helper.m_channelList.size (); i++)
+    {
+      state.uplinkEnabled.push_back (helper.m_channelList[i]->IsEnabledForUplink ());
+    }
+}
+
+void
+LoraCheckpoint::ApplyChannels (const ChannelState &state,
+                               LogicalLoraChannelHelper &helper)
+{
+  NS_ASSERT (state.subBandNextTransmission.size () == helper.m_subBandList.size ());
+  NS_ASSERT (state.uplinkEnabled.size () == helper.m_channelList.size ());
+
+  helper.m_nextAggregatedTransmissionTime = TimeStep (state.nextAggregatedTransmission);
+  uint32_t i = 0;
+  for (std::list<Ptr<SubBand> >::iterator it = helper.m_subBandList.begin ();
+       it != helper.m_subBandList.end (); ++it)
+    {
+      (*it)->SetNextTransmissionTime (TimeStep (state.subBandNextTransmission[i++]));
+    }
+  for (i = 0; i < helper.m_channelList.size (); i++)
+    {
+      if (state.uplinkEnabled[i])
+        {
+          helper.m_channelList[i]->SetEnabledForUplink ();
+        }
+      else
+        {
+          helper.m_channelList[i]->DisableForUplink ();
+        }
+    }
+}
+
+void
+LoraCheckpoint::Capture (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_time = Simulator::Now ();
+  m_rngSeed = RngSeedManager::GetSeed ();
+  m_rngRun = RngSeedManager::GetRun ();
+
+  m_endDeviceStates.clear ();
+  m_applicationStates.clear ();
+  for (NodeContainer::Iterator it = m_endDevices.Begin (); it != m_endDevices.End (); ++it)
+    {
+      Ptr<EndDeviceLoraMac> mac = GetEndDeviceMac (*it);
+
+      EndDeviceState state;
+      state.nodeId = (*it)->GetId ();
+      state.address = mac->m_address.Get ();
+      state.dataRate = mac->m_dataRate;
+      state.txPower = mac->m_txPower;
+      state.fCnt = mac->m_currentFCnt;
+      state.mType = mac->m_mType;
+      state.rx1DrOffset = mac->m_rx1DrOffset;
+      state.rx2DataRate = mac->m_secondReceiveWindowDataRate;
+      state.rx2Frequency = mac->m_secondReceiveWindowFrequency;
+      state.aggregatedDutyCycle = mac->m_aggregatedDutyCycle;
+      state.lastKnownLinkMargin = mac->m_lastKnownLinkMargin;
+      state.lastKnownGatewayCount = mac->m_lastKnownGatewayCount;
+      state.waitingAck = mac->m_retxParams.waitingAck;
+      state.retxLeft = mac->m_retxParams.retxLeft;
+      state.firstAttempt = mac->m_retxParams.firstAttempt.GetTimeStep ();
+      if (mac->m_retxParams.packet != 0)
+        {
+          state.retxPacket = PacketToBytes (mac->m_retxParams.packet);
+        }
+      CaptureChannels (mac->m_channelHelper, state.channels);
+      m_endDeviceStates.push_back (state);
+
+      for (uint32_t i = 0; i < (*it)->GetNApplications (); i++)
+        {
+          Ptr<Application> app = (*it)->GetApplication (i);
+          ApplicationState appState;
+          appState.nodeId = (*it)->GetId ();
+          appState.index = i;
+
+          Ptr<PeriodicSender> periodic = DynamicCast<PeriodicSender> (app);
+          if (periodic != 0)
+            {
+              int64_t nextSend = -1;
+              if (periodic->m_sendEvent.IsRunning ())
+                {
+                  nextSend = periodic->m_sendEvent.GetTs ();
+                }
+              appState.nextSend.push_back (nextSend);
+              m_applicationStates.push_back (appState);
+              continue;
+            }
+
+          Ptr<FleetSender> fleet = DynamicCast<FleetSender> (app);
+          if (fleet != 0)
+            {
+              appState.nextSend.assign (fleet->m_devices.size (), -1);
+              for (uint32_t s = 0; s < fleet->m_wheel.size (); s++)
+                {
+                  for (uint32_t e = 0; e < fleet->m_wheel[s].size (); e++)
+                    {
+                      const FleetSender::Entry &entry = fleet->m_wheel[s][e];
+                      appState.nextSend[entry.device] = entry.ts;
+                    }
+                }
+              std::priority_queue<FleetSender::Entry, std::vector<FleetSender::Entry>,
+                                  std::greater<FleetSender::Entry> > overflow = fleet->m_overflow;
+              while (!overflow.empty ())
+                {
+                  appState.nextSend[overflow.top ().device] = overflow.top ().ts;
+                  overflow.pop ();
+                }
+              m_applicationStates.push_back (appState);
+            }
+        }
+    }
+
+  m_gatewayStates.clear ();
+  for (NodeContainer::Iterator it = m_gateways.Begin (); it != m_gateways.End (); ++it)
+    {
+      GatewayState state;
+      state.nodeId = (*it)->GetId ();
+      CaptureChannels (GetGatewayMac (*it)->m_channelHelper, state.channels);
+      m_gatewayStates.push_back (state);
+    }
+
+  m_energyStates.clear ();
+  for (uint32_t i = 0; i < m_energyModels.GetN (); i++)
+    {
+      Ptr<LoraRadioEnergyModel> model =
+        DynamicCast<LoraRadioEnergyModel> (m_energyModels.Get (i));
+      NS_ASSERT_MSG (model != 0, "Only LoraRadioEnergyModels can be saved");
+
+      EnergyState state;
+      state.nodeId = model->GetEnergySource ()->GetNode ()->GetId ();
+      state.totalEnergyConsumption = model->GetTotalEnergyConsumption ();
+      for (uint8_t s = 0; s < 4; s++)
+        {
+          state.stateTime[s] =
+            model->GetStateDuration (EndDeviceLoraPhy::State (s)).GetTimeStep ();
+        }
+      state.remainingEnergy = model->GetEnergySource ()->GetRemainingEnergy ();
+      m_energyStates.push_back (state);
+    }
+
+  m_deviceStatusStates.clear ();
+  m_gatewayStatusStates.clear ();
+  Ptr<NetworkStatus> status;
+  if (m_networkServer != 0)
+    {
+      status = GetNetworkStatus (m_networkServer);
+    }
+  if (status != 0)
+    {
+      std::map<LoraDeviceAddress, Ptr<EndDeviceStatus> >::iterator it;
+      for (it = status->m_endDeviceStatuses.begin ();
+           it != status->m_endDeviceStatuses.end (); ++it)
+        {
+          Ptr<EndDeviceStatus> eds = it->second;
+          DeviceStatusState state;
+          state.address = it->first.Get ();
+          state.rx1Sf = eds->m_firstReceiveWindowSpreadingFactor;
+          state.rx1Frequency = eds->m_firstReceiveWindowFrequency;
+          state.rx2Offset = eds->m_secondReceiveWindowOffset;
+          state.rx2Frequency = eds->m_secondReceiveWindowFrequency;
+
+          EndDeviceStatus::ReceivedPacketList::iterator p;
+          for (p = eds->m_receivedPacketList.begin ();
+               p != eds->m_receivedPacketList.end (); ++p)
+            {
+              ReceivedPacket packet;
+              packet.packet = PacketToBytes (p->first);
+              packet.sf = p->second.sf;
+              packet.frequency = p->second.frequency;
+              EndDeviceStatus::GatewayList::iterator gw;
+              for (gw = p->second.gwList.begin (); gw != p->second.gwList.end (); ++gw)
+                {
+                  GatewayReception reception;
+                  reception.gwAddress = AddressToBytes (gw->second.gwAddress);
+                  reception.receivedTime = gw->second.receivedTime.GetTimeStep ();
+                  reception.rxPower = gw->second.rxPower;
+                  packet.gateways.push_back (reception);
+                }
+              state.packets.push_back (packet);
+            }
+          m_deviceStatusStates.push_back (state);
+        }
+
+      std::map<Address, Ptr<GatewayStatus> >::iterator gw;
+      for (gw = status->m_gatewayStatuses.begin ();
+           gw != status->m_gatewayStatuses.end (); ++gw)
+        {
+          GatewayStatusState state;
+          state.address = AddressToBytes (gw->first);
+          state.nextTransmission = gw->second->m_nextTransmissionTime.GetTimeStep ();
+          m_gatewayStatusStates.push_back (state);
+        }
+    }
+}
+
+void
+LoraCheckpoint::Apply (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT (Simulator::Now () == m_time);
+
+  for (uint32_t i = 0; i < m_endDeviceStates.size (); i++)
+    {
+      const EndDeviceState &state = m_endDeviceStates[i];
+      NS_ASSERT (m_endDevices.Get (i)->GetId () == state.nodeId);
+      Ptr<EndDeviceLoraMac> mac = GetEndDeviceMac (m_endDevices.Get (i));
+
+      mac->m_address = LoraDeviceAddress (state.address);
+      mac->m_dataRate = state.dataRate;
+      mac->m_txPower = state.txPower;
+      mac->m_currentFCnt = state.fCnt;
+      mac->m_mType = LoraMacHeader::MType (state.mType);
+      mac->m_rx1DrOffset = state.rx1DrOffset;
+      mac->m_secondReceiveWindowDataRate = state.rx2DataRate;
+      mac->m_secondReceiveWindowFrequency = state.rx2Frequency;
+      mac->m_aggregatedDutyCycle = state.aggregatedDutyCycle;
+      mac->m_lastKnownLinkMargin = state.lastKnownLinkMargin;
+      mac->m_lastKnownGatewayCount = state.lastKnownGatewayCount;
+      ApplyChannels (state.channels, mac->m_channelHelper);
+
+      mac->m_retxParams.waitingAck = state.waitingAck;
+      mac->m_retxParams.retxLeft = state.retxLeft;
+      mac->m_retxParams.firstAttempt = TimeStep (state.firstAttempt);
+      mac->m_retxParams.packet = 0;
+      if (!state.retxPacket.empty ())
+        {
+          mac->m_retxParams.packet =
+            Create<Packet> (state.retxPacket.data (), state.retxPacket.size ());
+        }
+
+      // The receive windows of the last attempt were not saved: go on with
+      // the retransmission procedure
+      if (state.waitingAck && state.retxLeft > 0)
+        {
+          mac->Send (mac->m_retxParams.packet);
+        }
+    }
+
+  for (uint32_t i = 0; i < m_gatewayStates.size (); i++)
+    {
+      NS_ASSERT (m_gateways.Get (i)->GetId () == m_gatewayStates[i].nodeId);
+      ApplyChannels (m_gatewayStates[i].channels,
+                     GetGatewayMac (m_gateways.Get (i))->m_channelHelper);
+    }
+
+  for (uint32_t i = 0; i < m_energyStates.size (); i++)
+    {
+      const EnergyState &state = m_energyStates[i];
+      Ptr<LoraRadioEnergyModel> model =
+        DynamicCast<LoraRadioEnergyModel> (m_energyModels.Get (i));
+      NS_ASSERT (model != 0);
+      NS_ASSERT (model->GetEnergySource ()->GetNode ()->GetId () == state.nodeId);
+
+      Ptr<BasicEnergySource> source =
+        DynamicCast<BasicEnergySource> (model->GetEnergySource ());
+      if (source != 0)
+        {
+          // Settle the consumption of the idle run without letting it deplete
+          // the source, then start over from the saved energy
+          source->SetInitialEnergy (std::numeric_limits<double>::max ());
+          if (!m_energyUpdateIntervals[i].IsZero ())
+            {
+              source->SetEnergyUpdateInterval (m_energyUpdateIntervals[i]);
+            }
+          source->UpdateEnergySource ();
+          source->SetInitialEnergy (state.remainingEnergy);
+        }
+      else
+        {
+          NS_LOG_WARN ("Only the energy of BasicEnergySources can be restored");
+        }
+
+      model->m_totalEnergyConsumption = state.totalEnergyConsumption;
+      for (uint8_t s = 0; s < 4; s++)
+        {
+          model->m_totalStateTimeNs[s] = TimeStep (state.stateTime[s]).GetNanoSeconds ();
+          model->m_stateTimeNs[s] = 0;
+        }
+      model->m_frozenCharge = 0;
+      model->m_frozenTimeNs = 0;
+      model->m_lastUpdateTime = Simulator::Now ();
+    }
+
+  Ptr<NetworkStatus> status;
+  if (m_networkServer != 0)
+    {
+      status = GetNetworkStatus (m_networkServer);
+    }
+  if (status != 0)
+    {
+      for (uint32_t i = 0; i < m_deviceStatusStates.size (); i++)
+        {
+          const DeviceStatusState &state = m_deviceStatusStates[i];
+          std::map<LoraDeviceAddress, Ptr<EndDeviceStatus> >::iterator it =
+            status->m_endDeviceStatuses.find (LoraDeviceAddress (state.address));
+          if (it == status->m_endDeviceStatuses.end ())
+            {
+              NS_LOG_WARN ("Device " << LoraDeviceAddress (state.address) <<
+                           " is not known to the network server");
+              continue;
+            }
+
+          Ptr<EndDeviceStatus> eds = it->second;
+          eds->m_firstReceiveWindowSpreadingFactor = state.rx1Sf;
+          eds->m_firstReceiveWindowFrequency = state.rx1Frequency;
+          eds->m_secondReceiveWindowOffset = state.rx2Offset;
+          eds->m_secondReceiveWindowFrequency = state.rx2Frequency;
+
+          eds->m_receivedPacketList.clear ();
+          for (uint32_t p = 0; p < state.packets.size (); p++)
+            {
+              const ReceivedPacket &saved = state.packets[p];
+              Ptr<const Packet> packet =
+                Create<Packet> (saved.packet.data (), saved.packet.size ());
+
+              EndDeviceStatus::ReceivedPacketInfo info;
+              info.packet = packet;
+              info.sf = saved.sf;
+              info.frequency = saved.frequency;
+              for (uint32_t g = 0; g < saved.gateways.size (); g++)
+                {
+                  EndDeviceStatus::PacketInfoPerGw gwInfo;
+                  gwInfo.gwAddress = BytesToAddress (saved.gateways[g].gwAddress);
+                  gwInfo.receivedTime = TimeStep (saved.gateways[g].receivedTime);
+                  gwInfo.rxPower = saved.gateways[g].rxPower;
+                  info.gwList[gwInfo.gwAddress] = gwInfo;
+                }
+              eds->m_receivedPacketList.push_back (std::make_pair (packet, info));
+            }
+        }
+
+      for (uint32_t i = 0; i < m_gatewayStatusStates.size (); i++)
+        {
+          Address address = BytesToAddress (m_gatewayStatusStates[i].address);
+          std::map<Address, Ptr<GatewayStatus> >::iterator it =
+            status->m_gatewayStatuses.find (address);
+          if (it != status->m_gatewayStatuses.end ())
+            {
+              it->second->m_nextTransmissionTime =
+                TimeStep (m_gatewayStatusStates[i].nextTransmission);
+            }
+        }
+    }
+
+  NS_LOG_INFO ("Restored checkpoint at " << m_time.GetSeconds () << " s");
+}
+
+void
+LoraCheckpoint::WriteChannels (std::ostream &os, const ChannelState &state)
+{
+  WriteValue (os, state.nextAggregatedTransmission);
+  WriteVector (os, state.subBandNextTransmission);
+  WriteVector (os, state.uplinkEnabled);
+}
+
+void
+LoraCheckpoint::ReadChannels (std::istream &is, uint64_t maxBytes,
+                              ChannelState &state)
+{
+  ReadValue (is, state.nextAggregatedTransmission);
+  ReadVector (is, state.subBandNextTransmission, maxBytes);
+  ReadVector (is, state.uplinkEnabled, maxBytes);
+}
+
+void
+LoraCheckpoint::Write (std::ostream &os) const
+{
+  os.write (g_checkpointMagic, sizeof (g_checkpointMagic));
+  uint32_t version = VERSION;
+  WriteValue (os, version);
+  WriteValue (os, m_time.GetTimeStep ());
+  WriteValue (os, m_rngSeed);
+  WriteValue (os, m_rngRun);
+
+  WriteValue (os, uint32_t (m_endDeviceStates.size ()));
+  for (uint32_t i = 0; i < m_endDeviceStates.size (); i++)
+    {
+      const EndDeviceState &s = m_endDeviceStates[i];
+      WriteValue (os, s.nodeId);
+      WriteValue (os, s.address);
+      WriteValue (os, s.dataRate);
+      WriteValue (os, s.txPower);
+      WriteValue (os, s.fCnt);
+      WriteValue (os, s.mType);
+      WriteValue (os, s.rx1DrOffset);
+      WriteValue (os, s.rx2DataRate);
+      WriteValue (os, s.rx2Frequency);
+      WriteValue (os, s.aggregatedDutyCycle);
+      WriteValue (os, s.lastKnownLinkMargin);
+      WriteValue (os, s.lastKnownGatewayCount);
+      WriteValue (os, s.waitingAck);
+      WriteValue (os, s.retxLeft);
+      WriteValue (os, s.firstAttempt);
+      WriteVector (os, s.retxPacket);
+      WriteChannels (os, s.channels);
+    }
+
+  WriteValue (os, uint32_t (m_gatewayStates.size ()));
+  for (uint32_t i = 0; i < m_gatewayStates.size (); i++)
+    {
+      WriteValue (os, m_gatewayStates[i].nodeId);
+      WriteChannels (os, m_gatewayStates[i].channels);
+    }
+
+  WriteValue (os, uint32_t (m_applicationStates.size ()));
+  for (uint32_t i = 0; i < m_applicationStates.size (); i++)
+    {
+      WriteValue (os, m_applicationStates[i].nodeId);
+      WriteValue (os, m_applicationStates[i].index);
+      WriteVector (os, m_applicationStates[i].nextSend);
+    }
+
+  WriteValue (os, uint32_t (m_energyStates.size ()));
+  for (uint32_t i = 0; i < m_energyStates.size (); i++)
+    {
+      const EnergyState &s = m_energyStates[i];
+      WriteValue (os, s.nodeId);
+      WriteValue (os, s.totalEnergyConsumption);
+      for (uint8_t t = 0; t < 4; t++)
+        {
+          WriteValue (os, s.stateTime[t]);
+        }
+      WriteValue (os, s.remainingEnergy);
+    }
+
+  WriteValue (os, uint32_t (m_deviceStatusStates.size ()));
+  for (uint32_t i = 0; i < m_deviceStatusStates.size (); i++)
+    {
+      const DeviceStatusState &s = m_deviceStatusStates[i];
+      WriteValue (os, s.address);
+      WriteValue (os, s.rx1Sf);
+      WriteValue (os, s.rx1Frequency);
+      WriteValue (os, s.rx2Offset);
+      WriteValue (os, s.rx2Frequency);
+      WriteValue (os, uint32_t (s.packets.size ()));
+      for (uint32_t p = 0; p < s.packets.size (); p++)
+        {
+          WriteVector (os, s.packets[p].packet);
+          WriteValue (os, s.packets[p].sf);
+          WriteValue (os, s.packets[p].frequency);
+          WriteValue (os, uint32_t (s.packets[p].gateways.size ()));
+          for (uint32_t g = 0; g < s.packets[p].gateways.size (); g++)
+            {
+              WriteVector (os, s.packets[p].gateways[g].gwAddress);
+              WriteValue (os, s.packets[p].gateways[g].receivedTime);
+              WriteValue (os, s.packets[p].gateways[g].rxPower);
+            }
+        }
+    }
+
+  WriteValue (os, uint32_t (m_gatewayStatusStates.size ()));
+  for (uint32_t i = 0; i < m_gatewayStatusStates.size (); i++)
+    {
+      WriteVector (os, m_gatewayStatusStates[i].address);
+      WriteValue (os, m_gatewayStatusStates[i].nextTransmission);
+    }
+}
+
+bool
+LoraCheckpoint::Read (std::istream &is)
+{
+  // No vector can be larger than the file
+  is.seekg (0, std::ios::end);
+  std::streamoff fileSize = is.tellg ();
+  is.seekg (0, std::ios::beg);
+  if (!is || fileSize < 0)
+    {
+      return false;
+    }
+  uint64_t maxBytes = fileSize;
+
+  char magic[4];
+  is.read (magic, sizeof (magic));
+  uint32_t version = 0;
+  ReadValue (is, version);
+  if (!is || std::memcmp (magic, g_checkpointMagic, sizeof (magic)) != 0
+      || version != VERSION)
+    {
+      return false;
+    }
+
+  int64_t time;
+  ReadValue (is, time);
+  m_time = TimeStep (time);
+  ReadValue (is, m_rngSeed);
+  ReadValue (is, m_rngRun);
+
+  uint32_t n = 0;
+  ReadCount (is, n, m_endDevices.GetN ());
+  m_endDeviceStates.assign (n, EndDeviceState ());
+  for (uint32_t i = 0; i < n && is; i++)
+    {
+      EndDeviceState &s = m_endDeviceStates[i];
+      ReadValue (is, s.nodeId);
+      ReadValue (is, s.address);
+      ReadValue (is, s.dataRate);
+      ReadValue (is, s.txPower);
+      ReadValue (is, s.fCnt);
+      ReadValue (is, s.mType);
+      ReadValue (is, s.rx1DrOffset);
+      ReadValue (is, s.rx2DataRate);
+      ReadValue (is, s.rx2Frequency);
+      ReadValue (is, s.aggregatedDutyCycle);
+      ReadValue (is, s.lastKnownLinkMargin);
+      ReadValue (is, s.lastKnownGatewayCount);
+      ReadValue (is, s.waitingAck);
+      ReadValue (is, s.retxLeft);
+      ReadValue (is, s.firstAttempt);
+      ReadVector (is, s.retxPacket, maxBytes);
+      ReadChannels (is, maxBytes, s.channels);
+    }
+
+  ReadCount (is, n, m_gateways.GetN ());
+  m_gatewayStates.assign (n, GatewayState ());
+  for (uint32_t i = 0; i < n && is; i++)
+    {
+      ReadValue (is, m_gatewayStates[i].nodeId);
+      ReadChannels (is, maxBytes, m_gatewayStates[i].channels);
+    }
+
+  ReadCount (is, n, maxBytes);
+  m_applicationStates.assign (n, ApplicationState ());
+  for (uint32_t i = 0; i < n && is; i++)
+    {
+      ReadValue (is, m_applicationStates[i].nodeId);
+      ReadValue (is, m_applicationStates[i].index);
+      ReadVector (is, m_applicationStates[i].nextSend, maxBytes);
+    }
+
+  ReadCount (is, n, m_energyModels.GetN ());
+  m_energyStates.assign (n, EnergyState ());
+  for (uint32_t i = 0; i < n && is; i++)
+    {
+      EnergyState &s = m_energyStates[i];
+      ReadValue (is, s.nodeId);
+      ReadValue (is, s.totalEnergyConsumption);
+      for (uint8_t t = 0; t < 4; t++)
+        {
+          ReadValue (is, s.stateTime[t]);
+        }
+      ReadValue (is, s.remainingEnergy);
+    }
+
+  ReadCount (is, n, m_endDevices.GetN ());
+  m_deviceStatusStates.assign (n, DeviceStatusState ());
+  for (uint32_t i = 0; i < n && is; i++)
+    {
+      DeviceStatusState &s = m_deviceStatusStates[i];
+      ReadValue (is, s.address);
+      ReadValue (is, s.rx1Sf);
+      ReadValue (is, s.rx1Frequency);
+      ReadValue (is, s.rx2Offset);
+      ReadValue (is, s.rx2Frequency);
+      uint32_t nPackets = 0;
+      ReadCount (is, nPackets, maxBytes);
+      s.packets.assign (nPackets, ReceivedPacket ());
+      for (uint32_t p = 0; p < nPackets && is; p++)
+        {
+          ReadVector (is, s.packets[p].packet, maxBytes);
+          ReadValue (is, s.packets[p].sf);
+          ReadValue (is, s.packets[p].frequency);
+          uint32_t nGateways = 0;
+          ReadCount (is, nGateways, m_gateways.GetN ());
+          s.packets[p].gateways.assign (nGateways, GatewayReception ());
+          for (uint32_t g = 0; g < nGateways && is; g++)
+            {
+              ReadVector (is, s.packets[p].gateways[g].gwAddress, maxBytes);
+              ReadValue (is, s.packets[p].gateways[g].receivedTime);
+              ReadValue (is, s.packets[p].gateways[g].rxPower);
+            }
+        }
+    }
+
+  ReadCount (is, n, m_gateways.GetN ());
+  m_gatewayStatusStates.assign (n, GatewayStatusState ());
+  for (uint32_t i = 0; i < n && is; i++)
+    {
+      ReadVector (is, m_gatewayStatusStates[i].address, maxBytes);
+      ReadValue (is, m_gatewayStatusStates[i].nextTransmission);
+    }
+
+  return bool (is);
+}
+
+}
+}
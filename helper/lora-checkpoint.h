@@ -0,0 +1,309 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_CHECKPOINT_H
+#define LORA_CHECKPOINT_H
+
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "ns3/device-energy-model-container.h"
+#include "ns3/logical-lora-channel-helper.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+class LoraMac;
+
+/**
+ * This class saves the state of a LoRaWAN network at a given simulation
+ * time, and restores it in a later run, so that several experiments can
+ * branch from a common warm-up.
+ *
+ * The saved state includes:
+ * - for end devices, the MAC parameters (data rate, transmission power,
+ *   frame counter, message type, receive window parameters), the
+ *   retransmission procedure of confirmed packets and the duty cycle
+ *   limitations of each sub-band;
+ * - for gateways, the duty cycle limitations of each sub-band;
+ * - the next send time of PeriodicSender and FleetSender applications;
+ * - the energy consumed by each LoraRadioEnergyModel, the time it spent in
+ *   each state, and the energy left in its source;
+ * - the EndDeviceStatus and GatewayStatus kept by the NetworkServer.
+ *
+ * A checkpoint is restored on a scenario that was built exactly as the saved
+ * one (e.g., by means of a LoraScenarioCache), with nodes created in the same
+ * order. Restore must be called after all devices, applications and energy
+ * models are installed, and before Simulator::Run. The simulation then runs
+ * idle until the checkpoint time, at which the state is applied and
+ * applications resume. Applications that had no packet scheduled at the
+ * checkpoint keep their start time if it comes later, and stay stopped
+ * otherwise.
+ *
+ * Events in flight at the checkpoint time (i.e., ongoing transmissions and
+ * open receive windows) are not saved: confirmed packets that are waiting for
+ * an acknowledgment are retransmitted right after the restore. The position
+ * of the random number streams cannot be saved either; restored runs use the
+ * streams of the current run number, which lets each branch draw different
+ * realizations.
+ */
+class LoraCheckpoint
+{
+public:
+  static const uint32_t VERSION = 2; //!< Version of the file format
+
+  LoraCheckpoint ();
+  ~LoraCheckpoint ();
+
+  /**
+   * Set the end devices whose state is saved or restored.
+   */
+  void SetEndDevices (NodeContainer endDevices);
+
+  /**
+   * Set the gateways whose state is saved or restored.
+   */
+  void SetGateways (NodeContainer gateways);
+
+  /**
+   * Set the node that hosts the NetworkServer application.
+   */
+  void SetNetworkServer (Ptr<Node> networkServer);
+
+  /**
+   * Set the energy models whose state is saved or restored.
+   */
+  void SetEnergyModels (DeviceEnergyModelContainer models);
+
+  /**
+   * Save a checkpoint at a future simulation time.
+   *
+   * \param time The time at which the state is saved.
+   * \param filename The file to write.
+   */
+  void ScheduleSave (Time time, std::string filename);
+
+  /**
+   * Save the current state of the network.
+   *
+   * \param filename The file to write.
+   * \return Whether the file was written successfully.
+   */
+  bool Save (std::string filename);
+
+  /**
+   * Restore a checkpoint.
+   *
+   * The state is applied by an event at the checkpoint time, so this object
+   * must not be destroyed before then.
+   *
+   * \param filename The file to read.
+   * \return False if the file could not be read, is corrupt, or doesn't
+   * match the nodes this checkpoint was configured with.
+   */
+  bool Restore (std::string filename);
+
+  /**
+   * Get the time of the last saved or restored checkpoint.
+   */
+  Time GetCheckpointTime (void) const;
+
+private:
+  /**
+   * The duty cycle state of a LoraMac.
+   */
+  struct ChannelState
+  {
+    int64_t nextAggregatedTransmission; //!< As a TimeStep
+    std::vector<int64_t> subBandNextTransmission; //!< As TimeSteps, by sub-band
+    std::vector<uint8_t> uplinkEnabled; //!< Whether each channel is enabled
+  };
+
+  /**
+   * The MAC state of an end device.
+   */
+  struct EndDeviceState
+  {
+    uint32_t nodeId;
+    uint32_t address; //!< As returned by LoraDeviceAddress::Get
+    uint8_t dataRate;
+    double txPower; //!< [dBm]
+    uint8_t fCnt;
+    uint8_t mType; //!< The LoraMacHeader::MType of uplinks
+    uint8_t rx1DrOffset;
+    uint8_t rx2DataRate;
+    double rx2Frequency; //!< [MHz]
+    double aggregatedDutyCycle;
+    double lastKnownLinkMargin; //!< [dB]
+    int32_t lastKnownGatewayCount;
+    uint8_t waitingAck; //!< Whether a confirmed packet awaits its ack
+    uint8_t retxLeft; //!< The transmissions left for that packet
+    int64_t firstAttempt; //!< When that packet was first sent, as a TimeStep
+    std::vector<uint8_t> retxPacket; //!< That packet, or empty
+    ChannelState channels;
+  };
+
+  /**
+   * The MAC state of a gateway.
+   */
+  struct GatewayState
+  {
+    uint32_t nodeId;
+    ChannelState channels;
+  };
+
+  /**
+   * The next send times of the devices served by an application. Times are
+   * negative if no packet is scheduled.
+   */
+  struct ApplicationState
+  {
+    uint32_t nodeId;
+    uint32_t index; //!< The index of the application in the node
+    std::vector<int64_t> nextSend;
+  };
+
+  /**
+   * The state of a LoraRadioEnergyModel and of its energy source.
+   */
+  struct EnergyState
+  {
+    uint32_t nodeId; //!< The node of the energy source
+    double totalEnergyConsumption; //!< [J]
+    int64_t stateTime[4]; //!< As TimeSteps, by EndDeviceLoraPhy::State
+    double remainingEnergy; //!< [J]
+  };
+
+  /**
+   * The reception of a packet by a gateway, as known by the network server.
+   */
+  struct GatewayReception
+  {
+    std::vector<uint8_t> gwAddress; //!< The serialized Address of the gateway
+    int64_t receivedTime; //!< As a TimeStep
+    double rxPower; //!< [dBm]
+  };
+
+  /**
+   * A packet received by the network server from an end device.
+   */
+  struct ReceivedPacket
+  {
+    std::vector<uint8_t> packet; //!< The bytes of the packet
+    uint8_t sf;
+    double frequency; //!< [MHz]
+    std::vector<GatewayReception> gateways;
+  };
+
+  /**
+   * The EndDeviceStatus of an end device, as kept by the network server.
+   */
+  struct DeviceStatusState
+  {
+    uint32_t address; //!< As returned by LoraDeviceAddress::Get
+    uint8_t rx1Sf;
+    double rx1Frequency; //!< [MHz]
+    uint8_t rx2Offset;
+    double rx2Frequency; //!< [MHz]
+    std::vector<ReceivedPacket> packets;
+  };
+
+  /**
+   * The GatewayStatus of a gateway, as kept by the network server.
+   */
+  struct GatewayStatusState
+  {
+    std::vector<uint8_t> address; //!< The serialized Address of the gateway
+    int64_t nextTransmission; //!< When it can send again, as a TimeStep
+  };
+
+  /**
+   * Read the current state of the network into the members.
+   */
+  void Capture (void);
+
+  /**
+   * Serialize the captured state.
+   */
+  void Write (std::ostream &os) const;
+
+  /**
+   * Deserialize a state into the members.
+   *
+   * \return False if the stream is not a valid checkpoint.
+   */
+  bool Read (std::istream &is);
+
+  /**
+   * Apply the restored state to the network, at the checkpoint time.
+   */
+  void Apply (void);
+
+  /**
+   * Read the duty cycle state of a MAC.
+   */
+  static void CaptureChannels (LogicalLoraChannelHelper &helper,
+                               ChannelState &state);
+
+  /**
+   * Apply a duty cycle state to a MAC.
+   */
+  static void ApplyChannels (const ChannelState &state,
+                             LogicalLoraChannelHelper &helper);
+
+  /**
+   * Serialize a duty cycle state.
+   */
+  static void WriteChannels (std::ostream &os, const ChannelState &state);
+
+  /**
+   * Deserialize a duty cycle state, with vectors of at most maxBytes.
+   */
+  static void ReadChannels (std::istream &is, uint64_t maxBytes,
+                            ChannelState &state);
+
+  /**
+   * Capture and save the state, when a save is scheduled.
+   */
+  void DoScheduledSave (std::string filename);
+
+  NodeContainer m_endDevices;
+  NodeContainer m_gateways;
+  Ptr<Node> m_networkServer;
+  DeviceEnergyModelContainer m_energyModels;
+
+  Time m_time; //!< The time of the checkpoint
+  uint32_t m_rngSeed; //!< The seed of the run that was saved
+  uint64_t m_rngRun; //!< The run number of the run that was saved
+
+  std::vector<EndDeviceState> m_endDeviceStates;
+  std::vector<GatewayState> m_gatewayStates;
+  std::vector<ApplicationState> m_applicationStates;
+  std::vector<EnergyState> m_energyStates;
+  std::vector<DeviceStatusState> m_deviceStatusStates;
+  std::vector<GatewayStatusState> m_gatewayStatusStates;
+
+  std::vector<Time> m_energyUpdateIntervals; //!< Saved while idling to the checkpoint
+};
+
+}
+
+}
+#endif /* LORA_CHECKPOINT_H */
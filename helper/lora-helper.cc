@@ -45,6 +45,47 @@ LoraHelper::Install ( const LoraPhyHelper &phyHelper,
 
   NetDeviceContainer devices;
 
+  // Resolve the kind of device and the tracker callbacks once for all nodes
+  static const TypeId edPhyTypeId = TypeId::LookupByName ("ns3::SimpleEndDeviceLoraPhy");
+  static const TypeId gwPhyTypeId = TypeId::LookupByName ("ns3::SimpleGatewayLoraPhy");
+  TypeId phyTypeId = phyHelper.GetDeviceType ();
+  bool trackEd = m_packetTracker && phyTypeId == edPhyTypeId;
+  bool trackGw = m_packetTracker && phyTypeId == gwPhyTypeId;
+
+  Callback<void, Ptr<Packet const>, uint32_t> transmissionCb;
+  Callback<void, Ptr<Packet const>, uint32_t> receptionCb;
+  Callback<void, Ptr<Packet const>, uint32_t> interferenceCb;
+  Callback<void, Ptr<Packet const>, uint32_t> noMoreReceiversCb;
+  Callback<void, Ptr<Packet const>, uint32_t> underSensitivityCb;
+  Callback<void, Ptr<Packet const>, uint32_t> lostBecauseTxCb;
+  Callback<void, Ptr<Packet const> > macTransmissionCb;
+  Callback<void, uint8_t, bool, Time, Ptr<Packet> > requiredTransmissionsCb;
+  Callback<void, Ptr<Packet const> > macGwReceptionCb;
+  if (trackEd)
+    {
+      transmissionCb = MakeCallback (&LoraPacketTracker::TransmissionCallback,
+                                     m_packetTracker);
+      macTransmissionCb = MakeCallback (&LoraPacketTracker::MacTransmissionCallback,
+                                        m_packetTracker);
+      requiredTransmissionsCb = MakeCallback
+          (&LoraPacketTracker::RequiredTransmissionsCallback, m_packetTracker);
+    }
+  else if (trackGw)
+    {
+      receptionCb = MakeCallback (&LoraPacketTracker::PacketReceptionCallback,
+                                  m_packetTracker);
+      interferenceCb = MakeCallback (&LoraPacketTracker::InterferenceCallback,
+                                     m_packetTracker);
+      noMoreReceiversCb = MakeCallback (&LoraPacketTracker::NoMoreReceiversCallback,
+                                        m_packetTracker);
+      underSensitivityCb = MakeCallback (&LoraPacketTracker::UnderSensitivityCallback,
+                                         m_packetTracker);
+      lostBecauseTxCb = MakeCallback (&LoraPacketTracker::LostBecauseTxCallback,
+                                      m_packetTracker);
+      macGwReceptionCb = MakeCallback (&LoraPacketTracker::MacGwReceptionCallback,
+                                       m_packetTracker);
+    }
+
   // Go over the various nodes in which to install the NetDevice
   for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
     {
@@ -60,40 +101,21 @@ LoraHelper::Install ( const LoraPhyHelper &phyHelper,
       NS_LOG_DEBUG ("Done creating the PHY");
 
       // Connect Trace Sources if necessary
-      if (m_packetTracker)
+      if (trackEd)
         {
-          if (phyHelper.GetDeviceType () ==
-              TypeId::LookupByName ("ns3::SimpleEndDeviceLoraPhy"))
-            {
-              phy->TraceConnectWithoutContext ("StartSending",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::TransmissionCallback,
-                                                 m_packetTracker));
-            }
-          else if (phyHelper.GetDeviceType () ==
-                   TypeId::LookupByName ("ns3::SimpleGatewayLoraPhy"))
-            {
-              phy->TraceConnectWithoutContext ("ReceivedPacket",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::PacketReceptionCallback,
-                                                 m_packetTracker));
-              phy->TraceConnectWithoutContext ("LostPacketBecauseInterference",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::InterferenceCallback,
-                                                 m_packetTracker));
-              phy->TraceConnectWithoutContext ("LostPacketBecauseNoMoreReceivers",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::NoMoreReceiversCallback,
-                                                 m_packetTracker));
-              phy->TraceConnectWithoutContext ("LostPacketBecauseUnderSensitivity",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::UnderSensitivityCallback,
-                                                 m_packetTracker));
-              phy->TraceConnectWithoutContext ("NoReceptionBecauseTransmitting",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::LostBecauseTxCallback,
-                                                 m_packetTracker));
-            }
+          phy->TraceConnectWithoutContext ("StartSending", transmissionCb);
+        }
+      else if (trackGw)
+        {
+          phy->TraceConnectWithoutContext ("ReceivedPacket", receptionCb);
+          phy->TraceConnectWithoutContext ("LostPacketBecauseInterference",
+                                           interferenceCb);
+          phy->TraceConnectWithoutContext ("LostPacketBecauseNoMoreReceivers",
+                                           noMoreReceiversCb);
+          phy->TraceConnectWithoutContext ("LostPacketBecauseUnderSensitivity",
+                                           underSensitivityCb);
+          phy->TraceConnectWithoutContext ("NoReceptionBecauseTransmitting",
+                                           lostBecauseTxCb);
         }
 
       // Create the MAC
@@ -103,29 +125,15 @@ LoraHelper::Install ( const LoraPhyHelper &phyHelper,
       NS_LOG_DEBUG ("Done creating the MAC");
       device->SetMac (mac);
 
-      if (m_packetTracker)
+      if (trackEd)
+        {
+          mac->TraceConnectWithoutContext ("SentNewPacket", macTransmissionCb);
+          mac->TraceConnectWithoutContext ("RequiredTransmissions",
+                                           requiredTransmissionsCb);
+        }
+      else if (trackGw)
         {
-          if (phyHelper.GetDeviceType () ==
-              TypeId::LookupByName ("ns3::SimpleEndDeviceLoraPhy"))
-            {
-              mac->TraceConnectWithoutContext ("SentNewPacket",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::MacTransmissionCallback,
-                                                 m_packetTracker));
-
-              mac->TraceConnectWithoutContext ("RequiredTransmissions",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::RequiredTransmissionsCallback,
-                                                 m_packetTracker));
-            }
-          else if (phyHelper.GetDeviceType () ==
-                   TypeId::LookupByName ("ns3::SimpleGatewayLoraPhy"))
-            {
-              mac->TraceConnectWithoutContext ("ReceivedPacket",
-                                               MakeCallback
-                                                 (&LoraPacketTracker::MacGwReceptionCallback,
-                                                 m_packetTracker));
-            }
+          mac->TraceConnectWithoutContext ("ReceivedPacket", macGwReceptionCb);
         }
 
       node->AddDevice (device);
@@ -0,0 +1,272 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-lifetime-estimator.h"
+#include "ns3/energy-source.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/double.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <fstream>
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraLifetimeEstimator");
+
+LoraLifetimeEstimator::LoraLifetimeEstimator () :
+  m_z (1.96)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LoraLifetimeEstimator::~LoraLifetimeEstimator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LoraLifetimeEstimator::SetConfidence (double z)
+{
+  NS_LOG_FUNCTION (this << z);
+
+  NS_ASSERT (z >= 0);
+  m_z = z;
+}
+
+void
+LoraLifetimeEstimator::Install (DeviceEnergyModelContainer models)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (DeviceEnergyModelContainer::Iterator it = models.Begin ();
+       it != models.End (); ++it)
+    {
+      Ptr<LoraRadioEnergyModel> model = DynamicCast<LoraRadioEnergyModel> (*it);
+      if (model == 0)
+        {
+          continue;
+        }
+
+      TrackedDevice device;
+      device.model = model;
+      device.sampled = false;
+      m_devices.push_back (device);
+    }
+
+  NS_LOG_DEBUG ("Tracking " << m_devices.size () << " radio energy models");
+}
+
+void
+LoraLifetimeEstimator::Start (Time start, Time stop, uint32_t nWindows)
+{
+  NS_LOG_FUNCTION (this << start << stop << nWindows);
+
+  NS_ASSERT (stop > start);
+  NS_ASSERT (nWindows > 0);
+  NS_ASSERT (start >= Simulator::Now ());
+
+  Time window = (stop - start) / nWindows;
+  for (uint32_t i = 0; i <= nWindows; i++)
+    {
+      Time sampleTime = (i == nWindows) ? stop : start + window * i;
+      Simulator::Schedule (sampleTime - Simulator::Now (),
+                           &LoraLifetimeEstimator::Sample, this);
+    }
+}
+
+void
+LoraLifetimeEstimator::Sample (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  Time window = m_sampleTimes.empty () ? Seconds (0) : now - m_sampleTimes.back ();
+
+  for (std::vector<TrackedDevice>::iterator it = m_devices.begin ();
+       it != m_devices.end (); ++it)
+    {
+      bool record = it->sampled && window.IsStrictlyPositive ();
+      if (record)
+        {
+          it->windowSeconds.push_back (window.GetSeconds ());
+        }
+      for (int s = 0; s < 4; s++)
+        {
+          Time duration = it->model->GetStateDuration (EndDeviceLoraPhy::State (s));
+          if (record)
+            {
+              it->windowStateSeconds[s].push_back
+                ((duration - it->lastStateDuration[s]).GetSeconds ());
+            }
+          it->lastStateDuration[s] = duration;
+        }
+      it->sampled = true;
+    }
+
+  m_sampleTimes.push_back (now);
+}
+
+std::vector<LoraLifetimeEstimator::DeviceLifetime>
+LoraLifetimeEstimator::Estimate (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<DeviceLifetime> estimates;
+
+  if (m_sampleTimes.size () < 2)
+    {
+      NS_LOG_WARN ("Not enough samples to estimate the lifetime");
+      return estimates;
+    }
+
+  Time end = m_sampleTimes.back ();
+  double maxSeconds = (Time::Max () - end).GetSeconds ();
+
+  for (std::vector<TrackedDevice>::const_iterator it = m_devices.begin ();
+       it != m_devices.end (); ++it)
+    {
+      uint32_t n = it->windowSeconds.size ();
+      if (n == 0)
+        {
+          NS_LOG_WARN ("Radio energy model " << it->model << " was not observed "
+                       "for any window");
+          continue;
+        }
+
+      DeviceLifetime estimate;
+
+      Ptr<EnergySource> source = it->model->GetEnergySource ();
+      Ptr<Node> node = source != 0 ? source->GetNode () : 0;
+      estimate.nodeId = node != 0 ? node->GetId () : 0;
+      estimate.remainingEnergyJ = source != 0 ? source->GetRemainingEnergy () : 0;
+
+      // BasicEnergySource declares depletion at its low battery threshold
+      double threshold = 0;
+      Ptr<BasicEnergySource> basicSource = DynamicCast<BasicEnergySource> (source);
+      if (basicSource != 0)
+        {
+          DoubleValue lowBatteryThreshold;
+          basicSource->GetAttribute ("BasicEnergySourceLowBatteryThreshold",
+                                     lowBatteryThreshold);
+          threshold = lowBatteryThreshold.Get () * basicSource->GetInitialEnergy ();
+        }
+      estimate.usableEnergyJ = std::max (estimate.remainingEnergyJ - threshold, 0.0);
+
+      double voltage = source != 0 ? source->GetSupplyVoltage () : 0;
+      estimate.statePowerW[EndDeviceLoraPhy::STANDBY] =
+        voltage * it->model->GetStandbyCurrentA ();
+      estimate.statePowerW[EndDeviceLoraPhy::TX] = voltage * it->model->GetTxCurrentA ();
+      estimate.statePowerW[EndDeviceLoraPhy::RX] = voltage * it->model->GetRxCurrentA ();
+      estimate.statePowerW[EndDeviceLoraPhy::SLEEP] =
+        voltage * it->model->GetSleepCurrentA ();
+
+      // Fit the rate of each state over the windows, and build the average
+      // power from the rates
+      double observed = 0;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          observed += it->windowSeconds[i];
+        }
+      double mean = 0;
+      for (int s = 0; s < 4; s++)
+        {
+          double seconds = 0;
+          for (uint32_t i = 0; i < n; i++)
+            {
+              seconds += it->windowStateSeconds[s][i];
+            }
+          estimate.stateFraction[s] = seconds / observed;
+          mean += estimate.stateFraction[s] * estimate.statePowerW[s];
+        }
+
+      // The standard error of the average power, from the power each window
+      // would give
+      double variance = 0;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          double power = 0;
+          for (int s = 0; s < 4; s++)
+            {
+              power += it->windowStateSeconds[s][i] * estimate.statePowerW[s];
+            }
+          power /= it->windowSeconds[i];
+          variance += std::pow (power - mean, 2);
+        }
+      variance = n > 1 ? variance / (n - 1) : 0;
+      estimate.meanPowerW = mean;
+      estimate.powerStdErrW = std::sqrt (variance / n);
+
+      // Extrapolate the depletion time. A non-positive power means the
+      // source is never depleted.
+      double margin = m_z * estimate.powerStdErrW;
+      double powers[3] = {mean, mean + margin, mean - margin};
+      Time depletion[3];
+      for (int i = 0; i < 3; i++)
+        {
+          double seconds = powers[i] > 0 ?
+            estimate.usableEnergyJ / powers[i] : maxSeconds;
+          depletion[i] = seconds < maxSeconds ? end + Seconds (seconds) : Time::Max ();
+        }
+      estimate.depletion = depletion[0];
+      estimate.depletionLow = depletion[1];
+      estimate.depletionHigh = depletion[2];
+
+      NS_LOG_DEBUG ("Node " << estimate.nodeId << ": " << mean << " W, depletion at "
+                            << estimate.depletion.GetDays () << " days");
+
+      estimates.push_back (estimate);
+    }
+
+  return estimates;
+}
+
+void
+LoraLifetimeEstimator::PrintReport (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::vector<DeviceLifetime> estimates = Estimate ();
+
+  std::ofstream outputFile;
+  outputFile.open (filename.c_str (), std::ofstream::out | std::ofstream::trunc);
+
+  for (std::vector<DeviceLifetime>::const_iterator it = estimates.begin ();
+       it != estimates.end (); ++it)
+    {
+      outputFile << it->nodeId << " "
+                 << it->remainingEnergyJ << " "
+                 << it->meanPowerW << " "
+                 << it->powerStdErrW << " "
+                 << it->stateFraction[EndDeviceLoraPhy::SLEEP] << " "
+                 << it->stateFraction[EndDeviceLoraPhy::STANDBY] << " "
+                 << it->stateFraction[EndDeviceLoraPhy::TX] << " "
+                 << it->stateFraction[EndDeviceLoraPhy::RX] << " "
+                 << it->depletion.GetDays () << " "
+                 << it->depletionLow.GetDays () << " "
+                 << it->depletionHigh.GetDays () << std::endl;
+    }
+
+  outputFile.close ();
+}
+
+}
+}
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_LIFETIME_ESTIMATOR_H
+#define LORA_LIFETIME_ESTIMATOR_H
+
+#include "ns3/nstime.h"
+#include "ns3/device-energy-model-container.h"
+#include "ns3/lora-radio-energy-model.h"
+#include <vector>
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * This class can be used to project the battery lifetime of end devices
+ * without simulating them until depletion.
+ *
+ * The estimator samples the LoraRadioEnergyModel of each device at the
+ * boundaries of a number of windows spanning a warm-up period, and records
+ * the time each radio spent in each state during every window. Since these
+ * dwell times are observed on the full stack, they already include the effect
+ * of retransmissions, receive windows and of the duty-cycle back-off of the
+ * EndDeviceLoraMac. The rate of each state, i.e., the fraction of time the
+ * radio spends in it, is fitted over the windows, and the average power is
+ * built from these rates and from the power drawn in each state, given by
+ * the currents of the model and the supply voltage of its source. This power
+ * is then used to extrapolate the time at which the energy left in the
+ * source at the end of the warm-up drops to the depletion threshold of the
+ * source (the BasicEnergySourceLowBatteryThreshold of a BasicEnergySource,
+ * 0 for other sources). The spread of the power of the individual windows
+ * gives a confidence interval on this time.
+ *
+ * The extrapolation assumes the traffic observed during the warm-up is
+ * stationary, and the supply voltage and the state currents at the end of
+ * the warm-up constant. The simulation only needs to run until the end of
+ * the warm-up.
+ */
+class LoraLifetimeEstimator
+{
+public:
+  /**
+   * The lifetime projection for a single device.
+   */
+  struct DeviceLifetime
+  {
+    uint32_t nodeId; //!< The id of the node the radio belongs to
+    double remainingEnergyJ; //!< Energy left at the end of the warm-up
+    double usableEnergyJ; //!< Energy left above the depletion threshold
+    double meanPowerW; //!< Average power drawn by the radio
+    double powerStdErrW; //!< Standard error of the average power
+    double stateFraction[4]; //!< Fitted fraction of time spent in each
+                             //!< state, indexed by EndDeviceLoraPhy::State
+    double statePowerW[4]; //!< Power drawn in each state
+    Time depletion; //!< Projected depletion time
+    Time depletionLow; //!< Lower end of the confidence interval
+    Time depletionHigh; //!< Upper end of the confidence interval
+  };
+
+  LoraLifetimeEstimator ();
+  ~LoraLifetimeEstimator ();
+
+  /**
+   * Set the width of the confidence interval.
+   *
+   * \param z The number of standard errors on each side of the average power
+   * (1.96 by default, i.e., a 95% interval).
+   */
+  void SetConfidence (double z);
+
+  /**
+   * Track the LoraRadioEnergyModel objects in a container. Models of other
+   * types are ignored.
+   *
+   * \param models The container returned by LoraRadioEnergyModelHelper.
+   */
+  void Install (DeviceEnergyModelContainer models);
+
+  /**
+   * Schedule the sampling of the tracked models.
+   *
+   * \param start The beginning of the warm-up period.
+   * \param stop The end of the warm-up period.
+   * \param nWindows The number of windows the warm-up is divided into.
+   */
+  void Start (Time start, Time stop, uint32_t nWindows);
+
+  /**
+   * Compute the lifetime projection of every tracked device. This should be
+   * called after the end of the warm-up period.
+   *
+   * \return One entry for each tracked device that was observed for at
+   * least one window, in installation order.
+   */
+  std::vector<DeviceLifetime> Estimate (void) const;
+
+  /**
+   * Write a per-device lifetime report.
+   *
+   * Each line of the file contains, separated by spaces, the node id, the
+   * remaining energy (J), the average power (W), its standard error, the
+   * fractions of time spent in SLEEP, STANDBY, TX and RX and the projected
+   * depletion time with its confidence interval (days).
+   *
+   * \param filename The file to write to.
+   */
+  void PrintReport (std::string filename) const;
+
+private:
+  /**
+   * Record the state of all tracked models at a window boundary.
+   */
+  void Sample (void);
+
+  /**
+   * Per-device sampling state.
+   */
+  struct TrackedDevice
+  {
+    Ptr<LoraRadioEnergyModel> model; //!< The radio energy model
+    bool sampled; //!< Whether the model was sampled at least once
+    Time lastStateDuration[4]; //!< State durations at the previous sample
+    std::vector<double> windowSeconds; //!< Duration of each window
+    std::vector<double> windowStateSeconds[4]; //!< Time in each state, per window
+  };
+
+  std::vector<TrackedDevice> m_devices; //!< The tracked devices
+  std::vector<Time> m_sampleTimes; //!< The times at which samples were taken
+  double m_z; //!< The number of standard errors in the confidence interval
+};
+
+}
+
+}
+#endif /* LORA_LIFETIME_ESTIMATOR_H */
@@ -23,6 +23,12 @@
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/log.h"
+#include "ns3/lora-propagation-loss-model.h"
+#include "ns3/composite-lora-propagation-loss-model.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
 
 namespace ns3 {
 namespace lorawan {
@@ -393,5 +399,300 @@ LoraMacHelper::SetSpreadingFactorsUp (NodeContainer endDevices, NodeContainer ga
 
 } //  end function
 
+namespace {
+
+/**
+ * A uniform grid of gateway positions, to find the gateways that are closest
+ * to a point without looking at all of them.
+ */
+class GatewayGrid
+{
+public:
+  GatewayGrid (const std::vector<Vector> &gateways)
+    : m_gateways (gateways)
+  {
+    double xMin = gateways[0].x;
+    double xMax = xMin;
+    double yMin = gateways[0].y;
+    double yMax = yMin;
+    for (const Vector &gateway : gateways)
+      {
+        xMin = std::min (xMin, gateway.x);
+        xMax = std::max (xMax, gateway.x);
+        yMin = std::min (yMin, gateway.y);
+        yMax = std::max (yMax, gateway.y);
+      }
+
+    // About one gateway per cell, and no more cells than gateways along an
+    // axis if they are aligned
+    double width = xMax - xMin;
+    double height = yMax - yMin;
+    m_cellSize = std::max (std::sqrt (width * height / gateways.size ()),
+                           std::max (width, height) / gateways.size ());
+    m_cellSize = std::max (1.0, m_cellSize);
+    m_xMin = xMin;
+    m_yMin = yMin;
+    m_nx = int32_t ((xMax - xMin) / m_cellSize) + 1;
+    m_ny = int32_t ((yMax - yMin) / m_cellSize) + 1;
+
+    // Sort the gateways by cell
+    m_cellStart.assign (m_nx * m_ny + 1, 0);
+    for (const Vector &gateway : gateways)
+      {
+        m_cellStart[GetCell (gateway) + 1]++;
+      }
+    for (uint32_t cell = 0; cell < m_nx * m_ny; cell++)
+      {
+        m_cellStart[cell + 1] += m_cellStart[cell];
+      }
+    m_cellGateways.resize (gateways.size ());
+    std::vector<uint32_t> next (m_cellStart.begin (), m_cellStart.end () - 1);
+    for (uint32_t i = 0; i < gateways.size (); i++)
+      {
+        m_cellGateways[next[GetCell (gateways[i])]++] = i;
+      }
+  }
+
+  /**
+   * Find the closest gateways to a point.
+   *
+   * \param point The point.
+   * \param n The number of gateways to find.
+   * \param candidates Filled with the squared distance and index of the
+   * closest gateways, closest first.
+   */
+  void
+  FindClosest (Vector point, uint32_t n,
+               std::vector<std::pair<double, uint32_t> > &candidates) const
+  {
+    candidates.clear ();
+    int32_t cx = int32_t (std::floor ((point.x - m_xMin) / m_cellSize));
+    int32_t cy = int32_t (std::floor ((point.y - m_yMin) / m_cellSize));
+
+    // Rings closer than the grid are empty, and rings farther than its
+    // opposite corner don't exist
+    int32_t first = std::max (std::max (-cx, cx - int32_t (m_nx - 1)),
+                              std::max (-cy, cy - int32_t (m_ny - 1)));
+    first = std::max (first, 0);
+    int32_t last = std::max (std::max (cx, int32_t (m_nx - 1) - cx),
+                             std::max (cy, int32_t (m_ny - 1) - cy));
+
+    for (int32_t ring = first; ring <= last; ring++)
+      {
+        for (int32_t y = cy - ring; y <= cy + ring; y++)
+          {
+            // Only visit the border of the ring
+            int32_t step = (y == cy - ring || y == cy + ring) ? 1 : 2 * ring;
+            for (int32_t x = cx - ring; x <= cx + ring; x += std::max (step, 1))
+              {
+                if (x < 0 || y < 0 || x >= int32_t (m_nx) || y >= int32_t (m_ny))
+                  {
+                    continue;
+                  }
+                uint32_t cell = y * m_nx + x;
+                for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++)
+                  {
+                    const Vector &gateway = m_gateways[m_cellGateways[i]];
+                    double dx = gateway.x - point.x;
+                    double dy = gateway.y - point.y;
+                    candidates.push_back (std::make_pair (dx * dx + dy * dy,
+                                                          m_cellGateways[i]));
+                  }
+              }
+          }
+
+        // Cells in the next rings are at least ring * m_cellSize away
+        if (candidates.size () >= n)
+          {
+            std::nth_element (candidates.begin (), candidates.begin () + n - 1,
+                              candidates.end ());
+            double bound = ring * m_cellSize;
+            if (candidates[n - 1].first <= bound * bound)
+              {
+                break;
+              }
+          }
+      }
+
+    std::sort (candidates.begin (), candidates.end ());
+    if (candidates.size () > n)
+      {
+        candidates.resize (n);
+      }
+  }
+
+private:
+  uint32_t
+  GetCell (const Vector &position) const
+  {
+    uint32_t x = std::min (uint32_t ((position.x - m_xMin) / m_cellSize), m_nx - 1);
+    uint32_t y = std::min (uint32_t ((position.y - m_yMin) / m_cellSize), m_ny - 1);
+    return y * m_nx + x;
+  }
+
+  const std::vector<Vector> &m_gateways;
+  double m_cellSize;
+  double m_xMin;
+  double m_yMin;
+  uint32_t m_nx;
+  uint32_t m_ny;
+  std::vector<uint32_t> m_cellStart; //!< The first gateway of each cell
+  std::vector<uint32_t> m_cellGateways; //!< Gateway indices, sorted by cell
+};
+
+}
+
+std::vector<LoraMacHelper::SpreadingFactorAssignment>
+LoraMacHelper::AssignSpreadingFactors (NodeContainer endDevices,
+                                       NodeContainer gateways,
+                                       Ptr<LoraChannel> channel,
+                                       uint32_t nCandidates, uint32_t nThreads)
+{
+  NS_LOG_FUNCTION (endDevices.GetN () << gateways.GetN () << nCandidates << nThreads);
+  NS_ASSERT (gateways.GetN () > 0);
+
+  uint32_t nDevices = endDevices.GetN ();
+  if (nCandidates == 0 || nCandidates > gateways.GetN ())
+    {
+      nCandidates = gateways.GetN ();
+    }
+  if (nThreads == 0)
+    {
+      nThreads = std::max (1u, std::thread::hardware_concurrency ());
+    }
+
+  // Read the positions on this thread, since aggregated objects can't be
+  // looked up concurrently
+  std::vector<Ptr<MobilityModel> > gatewayMobility;
+  std::vector<Vector> gatewayPositions;
+  for (NodeContainer::Iterator it = gateways.Begin (); it != gateways.End (); ++it)
+    {
+      Ptr<MobilityModel> mobility = (*it)->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      gatewayMobility.push_back (mobility);
+      gatewayPositions.push_back (mobility->GetPosition ());
+    }
+  std::vector<Vector> devicePositions;
+  devicePositions.reserve (nDevices);
+  for (NodeContainer::Iterator it = endDevices.Begin (); it != endDevices.End (); ++it)
+    {
+      Ptr<MobilityModel> mobility = (*it)->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      devicePositions.push_back (mobility->GetPosition ());
+    }
+
+  // Find the candidate gateways of each device, in parallel: each thread only
+  // reads the grid, and writes the candidates of its own devices
+  GatewayGrid grid (gatewayPositions);
+  std::vector<uint32_t> candidates (uint64_t (nDevices) * nCandidates);
+  std::vector<uint32_t> nFound (nDevices);
+  auto findCandidates = [&] (uint32_t begin, uint32_t end)
+    {
+      std::vector<std::pair<double, uint32_t> > closest;
+      for (uint32_t i = begin; i < end; i++)
+        {
+          grid.FindClosest (devicePositions[i], nCandidates, closest);
+          nFound[i] = closest.size ();
+          for (uint32_t c = 0; c < closest.size (); c++)
+            {
+              candidates[uint64_t (i) * nCandidates + c] = closest[c].second;
+            }
+        }
+    };
+  std::vector<std::thread> threads;
+  uint32_t chunk = (nDevices + nThreads - 1) / nThreads;
+  for (uint32_t t = 1; t < nThreads && t * chunk < nDevices; t++)
+    {
+      threads.push_back (std::thread (findCandidates, t * chunk,
+                                      std::min (nDevices, (t + 1) * chunk)));
+    }
+  findCandidates (0, std::min (nDevices, chunk));
+  for (std::thread &thread : threads)
+    {
+      thread.join ();
+    }
+
+  // Evaluate the links to the candidates, and climb the SF ladder
+  PropagationLossModel *loss = PeekPointer (channel->GetPropagationLossModel ());
+  bool sfDependent = dynamic_cast<LoraPropagationLossModel *> (loss) != 0;
+  const double *sensitivity = EndDeviceLoraPhy::sensitivity;
+
+  // A composite loss model evaluates all the candidates of a device at once
+  typedef CompositeLoraPropagationLossModel::Endpoint Endpoint;
+  CompositeLoraPropagationLossModel *composite =
+    dynamic_cast<CompositeLoraPropagationLossModel *> (loss);
+  std::vector<Endpoint> gatewayEndpoints;
+  std::vector<Endpoint> candidateEndpoints;
+  std::vector<double> candidateRxPowers;
+  if (composite != 0)
+    {
+      for (const Ptr<MobilityModel> &gateway : gatewayMobility)
+        {
+          gatewayEndpoints.push_back (composite->GetEndpoint (gateway));
+        }
+    }
+
+  std::vector<SpreadingFactorAssignment> assignments (nDevices);
+  for (uint32_t i = 0; i < nDevices; i++)
+    {
+      Ptr<Node> node = endDevices.Get (i);
+      Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
+      Ptr<LoraNetDevice> loraNetDevice = node->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+      Ptr<EndDeviceLoraMac> mac = loraNetDevice->GetMac ()->GetObject<EndDeviceLoraMac> ();
+      NS_ASSERT (mac != 0);
+
+      // Assume devices transmit at 14 dBm
+      SpreadingFactorAssignment &assignment = assignments[i];
+      assignment.gateway = candidates[uint64_t (i) * nCandidates];
+      assignment.rxPowerDbm = -std::numeric_limits<double>::infinity ();
+      const uint32_t *deviceCandidates = &candidates[uint64_t (i) * nCandidates];
+      if (composite != 0)
+        {
+          candidateEndpoints.clear ();
+          for (uint32_t c = 0; c < nFound[i]; c++)
+            {
+              candidateEndpoints.push_back (gatewayEndpoints[deviceCandidates[c]]);
+            }
+          composite->CalcRxPowers (14, composite->GetEndpoint (mobility),
+                                   candidateEndpoints, candidateRxPowers);
+        }
+      for (uint32_t c = 0; c < nFound[i]; c++)
+        {
+          uint32_t gateway = deviceCandidates[c];
+          double rxPower = composite != 0 ? candidateRxPowers[c] :
+            channel->GetRxPower (14, mobility, gatewayMobility[gateway], 7);
+          if (rxPower > assignment.rxPowerDbm)
+            {
+              assignment.gateway = gateway;
+              assignment.rxPowerDbm = rxPower;
+            }
+        }
+
+      // Pick the lowest SF with a positive margin, or SF12 if none has one
+      assignment.dataRate = 0;
+      assignment.inRange = false;
+      for (uint8_t sf = 7; sf <= 12; sf++)
+        {
+          double rxPower = assignment.rxPowerDbm;
+          if (sfDependent && sf > 7)
+            {
+              rxPower = channel->GetRxPower (14, mobility,
+                                             gatewayMobility[assignment.gateway], sf);
+            }
+          assignment.marginDb = rxPower - sensitivity[sf - 7];
+          if (assignment.marginDb > 0)
+            {
+              assignment.dataRate = 12 - sf;
+              assignment.inRange = true;
+              break;
+            }
+        }
+      mac->SetDataRate (assignment.dataRate);
+    }
+
+  return assignments;
+}
+
 }
 } //end class
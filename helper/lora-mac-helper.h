@@ -114,6 +114,47 @@ public:
                                                  NodeContainer gateways,
                                                  Ptr<LoraChannel> channel);
 
+  /**
+   * The outcome of the data rate assignment of an end device.
+   */
+  struct SpreadingFactorAssignment
+  {
+    uint32_t gateway; //!< The index of the best gateway in the container
+    double rxPowerDbm; //!< The power received by the best gateway at SF7
+    double marginDb; //!< The margin over the sensitivity of the assigned SF
+    uint8_t dataRate; //!< The assigned data rate
+    bool inRange; //!< Whether the best gateway can receive the device
+  };
+
+  /**
+   * Set up the end device's data rates as SetSpreadingFactorsUp does, for
+   * large deployments.
+   *
+   * Gateways are placed in a grid, so that only the nCandidates gateways that
+   * are closest to each end device are evaluated as its best gateway. The
+   * search for candidates runs on nThreads threads. Since propagation loss
+   * models are not thread-safe, links are then evaluated on the calling
+   * thread: once at SF7 for each candidate, and, if the channel's loss model
+   * depends on the SF, once for each SF of the ladder until one has a
+   * positive margin. If the loss model doesn't depend on the SF, the margins
+   * of all SFs are computed from the SF7 evaluation. If the channel's loss
+   * model is a CompositeLoraPropagationLossModel, the candidates of each end
+   * device are evaluated with a single call to CalcRxPowers.
+   *
+   * \param endDevices The end devices to configure.
+   * \param gateways The gateways.
+   * \param channel The channel whose loss models are used.
+   * \param nCandidates The gateways evaluated for each end device, or 0 for
+   * all of them.
+   * \param nThreads The threads of the candidate search, or 0 for one per
+   * hardware thread.
+   * \return The assignment of each end device, in container order.
+   */
+  static std::vector<SpreadingFactorAssignment>
+  AssignSpreadingFactors (NodeContainer endDevices, NodeContainer gateways,
+                          Ptr<LoraChannel> channel, uint32_t nCandidates = 8,
+                          uint32_t nThreads = 0);
+
 private:
   /**
    * Perform region-specific configurations for the 868 MHz EU band.
@@ -79,8 +79,10 @@ LoraPhyHelper::Create (Ptr<Node> node, Ptr<NetDevice> device) const
   phy->SetChannel (m_channel);
 
   // Configuration is different based on the kind of device we have to create
-  std::string typeId = m_phy.GetTypeId ().GetName ();
-  if (typeId == "ns3::SimpleGatewayLoraPhy")
+  static const TypeId gwPhyTypeId = TypeId::LookupByName ("ns3::SimpleGatewayLoraPhy");
+  static const TypeId edPhyTypeId = TypeId::LookupByName ("ns3::SimpleEndDeviceLoraPhy");
+  TypeId typeId = m_phy.GetTypeId ();
+  if (typeId == gwPhyTypeId)
     {
       // Inform the channel of the presence of this PHY
       m_channel->Add (phy);
@@ -115,7 +117,7 @@ LoraPhyHelper::Create (Ptr<Node> node, Ptr<NetDevice> device) const
         }
 
     }
-  else if (typeId == "ns3::SimpleEndDeviceLoraPhy")
+  else if (typeId == edPhyTypeId)
     {
       // The line below can be commented to speed up uplink-only simulations.
       // This implies that the LoraChannel instance will only know about
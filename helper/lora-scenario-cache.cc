@@ -0,0 +1,418 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-scenario-cache.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/end-device-lora-mac.h"
+#include "ns3/log.h"
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraScenarioCache");
+
+static const char g_scenarioCacheMagic[4] = {'L', 'R', 'S', 'C'};
+
+// Spreading factors that get a loss value when the channel loss depends on it
+static const uint8_t g_minSf = 7;
+static const uint8_t g_maxSf = 12;
+
+LoraScenarioCache::LoraScenarioCache ()
+{
+  std::memset (&m_header, 0, sizeof (m_header));
+  std::memset (&m_layout, 0, sizeof (m_layout));
+}
+
+LoraScenarioCache::~LoraScenarioCache ()
+{
+  Unmap ();
+}
+
+LoraScenarioCache::Layout
+LoraScenarioCache::ComputeLayout (uint32_t nEndDevices, uint32_t nGateways,
+                                  uint32_t nSf)
+{
+  uint64_t nEd = nEndDevices;
+  uint64_t nGw = nGateways;
+
+  // Sections are laid out so that each of them is naturally aligned
+  Layout layout;
+  layout.edPositions = sizeof (FileHeader);
+  layout.gwPositions = layout.edPositions + nEd * 3 * sizeof (double);
+  layout.txPowers = layout.gwPositions + nGw * 3 * sizeof (double);
+  layout.addresses = layout.txPowers + nEd * sizeof (double);
+  layout.dataRates = layout.addresses + nEd * sizeof (uint32_t);
+  layout.losses = (layout.dataRates + nEd * sizeof (uint8_t) + 7) & ~uint64_t (7);
+  // One value per link, direction and spreading factor
+  layout.size = layout.losses + nEd * nGw * 2 * nSf * sizeof (float);
+  return layout;
+}
+
+bool
+LoraScenarioCache::Save (std::string filename, NodeContainer endDevices,
+                         NodeContainer gateways, Ptr<LoraChannel> channel,
+                         uint64_t key)
+{
+  NS_LOG_FUNCTION (filename << key);
+
+  NS_ASSERT (gateways.GetN () > 0);
+
+  bool sfDependent = DynamicCast<LoraPropagationLossModel>
+      (channel->GetPropagationLossModel ()) != 0;
+
+  FileHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, g_scenarioCacheMagic, sizeof (header.magic));
+  header.version = VERSION;
+  header.nEndDevices = endDevices.GetN ();
+  header.nGateways = gateways.GetN ();
+  header.key = key;
+  header.nSf = sfDependent ? g_maxSf - g_minSf + 1 : 1;
+
+  Layout layout = ComputeLayout (header.nEndDevices, header.nGateways,
+                                 header.nSf);
+
+  std::ofstream out (filename.c_str (), std::ios::binary | std::ios::trunc);
+  if (!out.is_open ())
+    {
+      NS_LOG_WARN ("Unable to open " << filename << " for writing");
+      return false;
+    }
+
+  out.write (reinterpret_cast<const char *> (&header), sizeof (header));
+
+  std::vector<Ptr<MobilityModel> > edMobility;
+  std::vector<Ptr<EndDeviceLoraMac> > edMacs;
+  for (NodeContainer::Iterator i = endDevices.Begin (); i != endDevices.End (); ++i)
+    {
+      Ptr<MobilityModel> mobility = (*i)->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      Ptr<LoraNetDevice> loraNetDevice = (*i)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+      Ptr<EndDeviceLoraMac> mac = loraNetDevice->GetMac ()->GetObject<EndDeviceLoraMac> ();
+      NS_ASSERT (mac != 0);
+      edMobility.push_back (mobility);
+      edMacs.push_back (mac);
+    }
+
+  std::vector<Ptr<MobilityModel> > gwMobility;
+  for (NodeContainer::Iterator i = gateways.Begin (); i != gateways.End (); ++i)
+    {
+      Ptr<MobilityModel> mobility = (*i)->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      gwMobility.push_back (mobility);
+    }
+
+  // Positions
+  for (uint32_t i = 0; i < edMobility.size (); i++)
+    {
+      Vector position = edMobility[i]->GetPosition ();
+      double coordinates[3] = {position.x, position.y, position.z};
+      out.write (reinterpret_cast<const char *> (coordinates), sizeof (coordinates));
+    }
+  for (uint32_t i = 0; i < gwMobility.size (); i++)
+    {
+      Vector position = gwMobility[i]->GetPosition ();
+      double coordinates[3] = {position.x, position.y, position.z};
+      out.write (reinterpret_cast<const char *> (coordinates), sizeof (coordinates));
+    }
+
+  // End device configuration
+  for (uint32_t i = 0; i < edMacs.size (); i++)
+    {
+      double txPower = edMacs[i]->GetTransmissionPower ();
+      out.write (reinterpret_cast<const char *> (&txPower), sizeof (txPower));
+    }
+  for (uint32_t i = 0; i < edMacs.size (); i++)
+    {
+      uint32_t address = edMacs[i]->GetDeviceAddress ().Get ();
+      out.write (reinterpret_cast<const char *> (&address), sizeof (address));
+    }
+  for (uint32_t i = 0; i < edMacs.size (); i++)
+    {
+      uint8_t dataRate = edMacs[i]->GetDataRate ();
+      out.write (reinterpret_cast<const char *> (&dataRate), sizeof (dataRate));
+    }
+  uint64_t padding = layout.losses - (layout.dataRates + header.nEndDevices);
+  char zeros[8] = {0};
+  out.write (zeros, padding);
+
+  // Link losses, sampled once per end device to limit the memory footprint
+  std::vector<float> losses (header.nGateways * 2 * header.nSf);
+  for (uint32_t ed = 0; ed < edMobility.size (); ed++)
+    {
+      uint32_t index = 0;
+      for (uint32_t gw = 0; gw < gwMobility.size (); gw++)
+        {
+          for (uint32_t direction = 0; direction < 2; direction++)
+            {
+              Ptr<MobilityModel> sender = direction == 0 ? edMobility[ed] : gwMobility[gw];
+              Ptr<MobilityModel> receiver = direction == 0 ? gwMobility[gw] : edMobility[ed];
+              for (uint32_t s = 0; s < header.nSf; s++)
+                {
+                  double rxPower = sfDependent ?
+                    channel->GetRxPower (0, sender, receiver, g_minSf + s) :
+                    channel->GetRxPower (0, sender, receiver);
+                  losses[index++] = -rxPower;
+                }
+            }
+        }
+      out.write (reinterpret_cast<const char *> (losses.data ()),
+                 losses.size () * sizeof (float));
+    }
+
+  out.close ();
+  if (out.fail ())
+    {
+      NS_LOG_WARN ("Error while writing " << filename);
+      return false;
+    }
+
+  NS_LOG_INFO ("Saved scenario with " << header.nEndDevices << " end devices and " <<
+               header.nGateways << " gateways (" << layout.size << " bytes)");
+
+  return true;
+}
+
+bool
+LoraScenarioCache::Load (std::string filename, uint64_t key)
+{
+  NS_LOG_FUNCTION (this << filename << key);
+
+  Unmap ();
+
+  if (!m_mapping.Open (filename, sizeof (FileHeader)))
+    {
+      NS_LOG_INFO ("No usable scenario cache found at " << filename);
+      return false;
+    }
+
+  std::memcpy (&m_header, m_mapping.GetData (), sizeof (m_header));
+
+  if (std::memcmp (m_header.magic, g_scenarioCacheMagic, sizeof (m_header.magic)) != 0
+      || m_header.version != VERSION)
+    {
+      NS_LOG_WARN ("Scenario cache " << filename << " has an unknown format");
+      Unmap ();
+      return false;
+    }
+
+  if (m_header.key != key)
+    {
+      NS_LOG_INFO ("Scenario cache " << filename << " was built with a different key");
+      Unmap ();
+      return false;
+    }
+
+  m_layout = ComputeLayout (m_header.nEndDevices, m_header.nGateways, m_header.nSf);
+  if (m_layout.size != m_mapping.GetSize ())
+    {
+      NS_LOG_WARN ("Scenario cache " << filename << " has an unexpected size");
+      Unmap ();
+      return false;
+    }
+
+  return true;
+}
+
+bool
+LoraScenarioCache::IsLoaded (void) const
+{
+  return m_mapping.IsOpen ();
+}
+
+uint32_t
+LoraScenarioCache::GetNEndDevices (void) const
+{
+  return m_header.nEndDevices;
+}
+
+uint32_t
+LoraScenarioCache::GetNGateways (void) const
+{
+  return m_header.nGateways;
+}
+
+void
+LoraScenarioCache::Apply (NodeContainer endDevices, NodeContainer gateways)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT (IsLoaded ());
+  NS_ASSERT_MSG (endDevices.GetN () == m_header.nEndDevices,
+                 "The number of end devices doesn't match the cache");
+  NS_ASSERT_MSG (gateways.GetN () == m_header.nGateways,
+                 "The number of gateways doesn't match the cache");
+
+  const uint8_t *data = m_mapping.GetData ();
+  const double *edPositions =
+    reinterpret_cast<const double *> (data + m_layout.edPositions);
+  const double *gwPositions =
+    reinterpret_cast<const double *> (data + m_layout.gwPositions);
+  const double *txPowers =
+    reinterpret_cast<const double *> (data + m_layout.txPowers);
+  const uint32_t *addresses =
+    reinterpret_cast<const uint32_t *> (data + m_layout.addresses);
+  const uint8_t *dataRates = data + m_layout.dataRates;
+
+  m_nodes.clear ();
+  m_nodes.reserve (m_header.nEndDevices + m_header.nGateways);
+
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<Node> node = endDevices.Get (i);
+      Ptr<MobilityModel> mobility = node->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      mobility->SetPosition (Vector (edPositions[3 * i],
+                                     edPositions[3 * i + 1],
+                                     edPositions[3 * i + 2]));
+      m_nodes[PeekPointer (mobility)] = std::make_pair (i, false);
+
+      Ptr<LoraNetDevice> loraNetDevice = node->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+      Ptr<EndDeviceLoraMac> mac = loraNetDevice->GetMac ()->GetObject<EndDeviceLoraMac> ();
+      NS_ASSERT (mac != 0);
+      mac->SetDeviceAddress (LoraDeviceAddress (addresses[i]));
+      mac->SetDataRate (dataRates[i]);
+      mac->SetTransmissionPower (txPowers[i]);
+    }
+
+  for (uint32_t i = 0; i < gateways.GetN (); i++)
+    {
+      Ptr<MobilityModel> mobility = gateways.Get (i)->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      mobility->SetPosition (Vector (gwPositions[3 * i],
+                                     gwPositions[3 * i + 1],
+                                     gwPositions[3 * i + 2]));
+      m_nodes[PeekPointer (mobility)] = std::make_pair (i, true);
+    }
+}
+
+bool
+LoraScenarioCache::GetLinkLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b,
+                                uint8_t sf, double &lossDb) const
+{
+  std::unordered_map<const MobilityModel *, std::pair<uint32_t, bool> >::const_iterator itA, itB;
+  itA = m_nodes.find (PeekPointer (a));
+  if (itA == m_nodes.end ())
+    {
+      return false;
+    }
+  itB = m_nodes.find (PeekPointer (b));
+  if (itB == m_nodes.end () || itA->second.second == itB->second.second)
+    {
+      return false;
+    }
+
+  // Direction 0 is the uplink
+  uint32_t direction = itA->second.second ? 1 : 0;
+  uint64_t ed = direction == 0 ? itA->second.first : itB->second.first;
+  uint64_t gw = direction == 0 ? itB->second.first : itA->second.first;
+
+  uint32_t s = 0;
+  if (m_header.nSf > 1)
+    {
+      NS_ASSERT (sf >= g_minSf && sf <= g_maxSf);
+      s = sf - g_minSf;
+    }
+
+  const float *losses = reinterpret_cast<const float *> (m_mapping.GetData () + m_layout.losses);
+  lossDb = losses[((ed * m_header.nGateways + gw) * 2 + direction) * m_header.nSf + s];
+  return true;
+}
+
+void
+LoraScenarioCache::Unmap (void)
+{
+  m_mapping.Close ();
+  m_nodes.clear ();
+}
+
+// ------------------------------------------------------------------------- //
+
+NS_OBJECT_ENSURE_REGISTERED (CachedLoraPropagationLossModel);
+
+TypeId
+CachedLoraPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachedLoraPropagationLossModel")
+    .SetParent<LoraPropagationLossModel> ()
+    .SetGroupName ("LoraPropagation")
+    .AddConstructor<CachedLoraPropagationLossModel> ()
+  ;
+  return tid;
+}
+
+CachedLoraPropagationLossModel::CachedLoraPropagationLossModel ()
+  : LoraPropagationLossModel ()
+{
+}
+
+CachedLoraPropagationLossModel::~CachedLoraPropagationLossModel ()
+{
+}
+
+void
+CachedLoraPropagationLossModel::SetCache (Ptr<LoraScenarioCache> cache)
+{
+  m_cache = cache;
+}
+
+void
+CachedLoraPropagationLossModel::SetFallback (Ptr<PropagationLossModel> fallback)
+{
+  m_fallback = fallback;
+}
+
+double
+CachedLoraPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                               uint8_t txSF,
+                                               Ptr<MobilityModel> a,
+                                               Ptr<MobilityModel> b) const
+{
+  double lossDb;
+  if (m_cache != 0 && m_cache->GetLinkLoss (a, b, txSF, lossDb))
+    {
+      return txPowerDbm - lossDb;
+    }
+
+  NS_ASSERT_MSG (m_fallback != 0, "Link not found in the scenario cache");
+  Ptr<LoraPropagationLossModel> loraFallback =
+    DynamicCast<LoraPropagationLossModel> (m_fallback);
+  if (loraFallback != 0)
+    {
+      loraFallback->SetTxSF (txSF);
+    }
+  return m_fallback->CalcRxPower (txPowerDbm, a, b);
+}
+
+int64_t
+CachedLoraPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  if (m_fallback != 0)
+    {
+      return m_fallback->AssignStreams (stream);
+    }
+  return 0;
+}
+
+}
+}
@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_SCENARIO_CACHE_H
+#define LORA_SCENARIO_CACHE_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-model.h"
+#include "ns3/lora-channel.h"
+#include "ns3/lora-propagation-loss-model.h"
+#include "ns3/lora-file-mapping.h"
+#include <unordered_map>
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * This class stores the deployment of a LoRaWAN scenario in a binary file,
+ * so that later runs can skip its generation.
+ *
+ * The file contains the positions of end devices and gateways, the address,
+ * data rate and transmission power of each end device, and the loss of every
+ * end device - gateway link, in both directions. The link loss is the one
+ * computed by the channel's propagation loss models, so it includes both the
+ * deterministic path loss and the shadowing and building penetration
+ * components. If the channel uses a LoraPropagationLossModel, a loss value
+ * is stored for each spreading factor.
+ *
+ * A saved file is memory-mapped by Load, so that its content is only paged
+ * in when accessed. Apply then configures a new set of nodes as the saved
+ * ones, and a CachedLoraPropagationLossModel can be used in the channel to
+ * look up link losses instead of computing them.
+ *
+ * Files are written in host byte order, and carry a user-defined key (e.g., a
+ * hash of the scenario parameters) that is checked on load.
+ */
+class LoraScenarioCache : public SimpleRefCount<LoraScenarioCache>
+{
+public:
+  static const uint32_t VERSION = 1; //!< Version of the file format
+
+  LoraScenarioCache ();
+  ~LoraScenarioCache ();
+
+  /**
+   * Write the deployment of a scenario to a file.
+   *
+   * This method must be called after the devices have been installed on the
+   * nodes, and after their data rate has been set.
+   *
+   * \param filename The file to write.
+   * \param endDevices The end device nodes.
+   * \param gateways The gateway nodes.
+   * \param channel The channel whose loss models are sampled.
+   * \param key A key identifying the scenario.
+   * \return Whether the file was written successfully.
+   */
+  static bool Save (std::string filename, NodeContainer endDevices,
+                    NodeContainer gateways, Ptr<LoraChannel> channel,
+                    uint64_t key = 0);
+
+  /**
+   * Map a file written by Save.
+   *
+   * \param filename The file to read.
+   * \param key The key the file is expected to carry.
+   * \return False if the file doesn't exist, is malformed, or has a
+   * different version or key.
+   */
+  bool Load (std::string filename, uint64_t key = 0);
+
+  /**
+   * Whether a file is currently mapped.
+   */
+  bool IsLoaded (void) const;
+
+  uint32_t GetNEndDevices (void) const;
+  uint32_t GetNGateways (void) const;
+
+  /**
+   * Configure the nodes as the ones that were saved: set their positions,
+   * and the address, data rate and transmission power of end devices.
+   *
+   * The containers must hold the same number of nodes as the saved ones, and
+   * devices must already be installed on them. Since the NetworkServerHelper
+   * reads device addresses, this method must be called before it is
+   * installed. The mobility models of the nodes are also bound to the saved
+   * links, for use by CachedLoraPropagationLossModel.
+   *
+   * \param endDevices The end device nodes.
+   * \param gateways The gateway nodes.
+   */
+  void Apply (NodeContainer endDevices, NodeContainer gateways);
+
+  /**
+   * Get the loss of a link between two nodes bound by Apply.
+   *
+   * \param a The mobility model of the transmitter.
+   * \param b The mobility model of the receiver.
+   * \param sf The spreading factor of the transmission.
+   * \param lossDb Set to the loss of the link, in dB.
+   * \return False if the two nodes are not an end device - gateway pair.
+   */
+  bool GetLinkLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b, uint8_t sf,
+                    double &lossDb) const;
+
+private:
+  /**
+   * The header at the beginning of each file.
+   */
+  struct FileHeader
+  {
+    char magic[4];
+    uint32_t version;
+    uint32_t nEndDevices;
+    uint32_t nGateways;
+    uint64_t key;
+    uint32_t nSf; //!< Number of loss values per link and direction
+    uint32_t reserved;
+  };
+
+  /**
+   * Offsets of the sections of a file, in bytes.
+   */
+  struct Layout
+  {
+    uint64_t edPositions;
+    uint64_t gwPositions;
+    uint64_t txPowers;
+    uint64_t addresses;
+    uint64_t dataRates;
+    uint64_t losses;
+    uint64_t size;
+  };
+
+  static Layout ComputeLayout (uint32_t nEndDevices, uint32_t nGateways,
+                               uint32_t nSf);
+
+  void Unmap (void);
+
+  LoraFileMapping m_mapping; //!< The mapped file
+  FileHeader m_header;
+  Layout m_layout;
+
+  /**
+   * Position of a bound node: its index, and whether it is a gateway.
+   */
+  std::unordered_map<const MobilityModel *, std::pair<uint32_t, bool> > m_nodes;
+};
+
+/**
+ * A propagation loss model that returns the link losses stored in a
+ * LoraScenarioCache.
+ *
+ * Links that are not in the cache (e.g., between two end devices) are
+ * computed by a fallback model, which should be the one the cache was built
+ * with.
+ */
+class CachedLoraPropagationLossModel : public LoraPropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CachedLoraPropagationLossModel ();
+  virtual ~CachedLoraPropagationLossModel ();
+
+  void SetCache (Ptr<LoraScenarioCache> cache);
+
+  void SetFallback (Ptr<PropagationLossModel> fallback);
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                uint8_t txSF,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  Ptr<LoraScenarioCache> m_cache;
+  Ptr<PropagationLossModel> m_fallback;
+};
+
+}
+
+}
+#endif /* LORA_SCENARIO_CACHE_H */
@@ -149,5 +149,13 @@ PeriodicSenderHelper::SetPacketSize (uint8_t size)
   m_pktSize = size;
 }
 
+int64_t
+PeriodicSenderHelper::AssignStreams (int64_t stream)
+{
+  m_initialDelay->SetStream (stream);
+  m_intervalProb->SetStream (stream + 1);
+  return 2;
+}
+
 }
 } // namespace ns3
@@ -65,6 +65,15 @@ public:
 
   void SetPacketSize (uint8_t size);
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this helper.
+   *
+   * \param stream The first stream index to use.
+   * \return The number of stream indices assigned.
+   */
+  int64_t AssignStreams (int64_t stream);
+
 
 private:
   Ptr<Application> InstallPriv (Ptr<Node> node) const;
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/shadowing-raster-helper.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/log.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("ShadowingRasterHelper");
+
+ShadowingRasterHelper::ShadowingRasterHelper ()
+  : m_box (-1000, 1000, -1000, 1000, 0, 0),
+  m_correlationDistance (110),
+  m_variance (CorrelatedShadowingPropagationLossModel::VARIANCE),
+  m_rng (LoraCounterRng::CORRELATED_SHADOWING)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ShadowingRasterHelper::~ShadowingRasterHelper ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ShadowingRasterHelper::SetBoundingBox (Box box)
+{
+  NS_ASSERT (box.xMin <= box.xMax && box.yMin <= box.yMax);
+
+  m_box = box;
+}
+
+void
+ShadowingRasterHelper::SetCorrelationDistance (double distance)
+{
+  NS_ASSERT (distance > 0);
+
+  m_correlationDistance = distance;
+}
+
+void
+ShadowingRasterHelper::SetVariance (double variance)
+{
+  m_variance = variance;
+}
+
+RasterShadowingPropagationLossModel::RasterHeader
+ShadowingRasterHelper::GetHeader (void) const
+{
+  typedef CorrelatedShadowingPropagationLossModel Model;
+
+  RasterShadowingPropagationLossModel::RasterHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, RasterShadowingPropagationLossModel::MAGIC,
+               sizeof (header.magic));
+  header.version = RasterShadowingPropagationLossModel::VERSION;
+  header.byteOrder = RasterShadowingPropagationLossModel::BYTE_ORDER_MARK;
+  header.correlationDistance = m_correlationDistance;
+  header.minSquareX = Model::GetSquare (m_box.xMin, m_correlationDistance);
+  header.minSquareY = Model::GetSquare (m_box.yMin, m_correlationDistance);
+  header.nSquaresX = Model::GetSquare (m_box.xMax, m_correlationDistance)
+    - header.minSquareX + 1;
+  header.nSquaresY = Model::GetSquare (m_box.yMax, m_correlationDistance)
+    - header.minSquareY + 1;
+  return header;
+}
+
+uint64_t
+ShadowingRasterHelper::GetRasterSize (void) const
+{
+  RasterShadowingPropagationLossModel::RasterHeader header = GetHeader ();
+  return sizeof (header) + sizeof (float) * uint64_t (header.nSquaresX) *
+         header.nSquaresY * (header.nSquaresX + 1) * (header.nSquaresY + 1);
+}
+
+bool
+ShadowingRasterHelper::Write (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  std::ofstream out (filename.c_str (), std::ios::binary);
+  if (!out.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open raster " << filename);
+      return false;
+    }
+
+  RasterShadowingPropagationLossModel::RasterHeader header = GetHeader ();
+  out.write (reinterpret_cast<const char *> (&header), sizeof (header));
+
+  // Write the field of one square at a time
+  uint32_t nCornersX = header.nSquaresX + 1;
+  uint32_t nCornersY = header.nSquaresY + 1;
+  std::vector<float> field (nCornersX * nCornersY);
+  for (uint32_t square = 0; square < header.nSquaresX * header.nSquaresY; square++)
+    {
+      int32_t squareX = header.minSquareX + int32_t (square % header.nSquaresX);
+      int32_t squareY = header.minSquareY + int32_t (square / header.nSquaresX);
+      for (uint32_t corner = 0; corner < field.size (); corner++)
+        {
+          int32_t cornerX = header.minSquareX + int32_t (corner % nCornersX);
+          int32_t cornerY = header.minSquareY + int32_t (corner / nCornersX);
+          field[corner] = CorrelatedShadowingPropagationLossModel::DrawCorner
+              (squareX, squareY, cornerX, cornerY, m_rng, m_variance);
+        }
+      out.write (reinterpret_cast<const char *> (field.data ()),
+                 field.size () * sizeof (float));
+    }
+
+  NS_LOG_DEBUG ("Wrote " << header.nSquaresX << "x" << header.nSquaresY <<
+                " squares to " << filename);
+  return bool (out);
+}
+
+int64_t
+ShadowingRasterHelper::AssignStreams (int64_t stream)
+{
+  m_rng.SetStream (stream);
+  return 1;
+}
+
+}
+}
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SHADOWING_RASTER_HELPER_H
+#define SHADOWING_RASTER_HELPER_H
+
+#include "ns3/raster-shadowing-propagation-loss-model.h"
+#include "ns3/lora-counter-rng.h"
+#include "ns3/box.h"
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * This class draws the correlated shadowing fields of all squares of a
+ * bounding box, and writes them to a raster that
+ * RasterShadowingPropagationLossModel can map.
+ *
+ * The fields have the same structure as the ones of
+ * CorrelatedShadowingPropagationLossModel: each square of side equal to the
+ * correlation distance has its own lattice of independent normal values,
+ * which covers the whole box. Corner values are drawn as the model draws
+ * them, so that a raster only depends on the stream it is drawn from, and
+ * holds the same fields that a CorrelatedShadowingPropagationLossModel with
+ * the same stream and variance computes on the fly.
+ *
+ * The raster holds nSquaresX * nSquaresY * (nSquaresX + 1) * (nSquaresY + 1)
+ * floats, e.g., about 20 MB for a 5 km by 5 km box with the default
+ * correlation distance of 110 m.
+ */
+class ShadowingRasterHelper
+{
+public:
+  ShadowingRasterHelper ();
+  ~ShadowingRasterHelper ();
+
+  /**
+   * Set the box the raster covers. Only the x and y bounds are used.
+   */
+  void SetBoundingBox (Box box);
+
+  /**
+   * Set the correlation distance of the fields.
+   */
+  void SetCorrelationDistance (double distance);
+
+  /**
+   * Set the variance of the shadowing values [dB^2].
+   */
+  void SetVariance (double variance);
+
+  /**
+   * \return The header of the raster for the current parameters.
+   */
+  RasterShadowingPropagationLossModel::RasterHeader GetHeader (void) const;
+
+  /**
+   * \return The size of the raster file for the current parameters [bytes].
+   */
+  uint64_t GetRasterSize (void) const;
+
+  /**
+   * Draw the fields and write them to a file.
+   *
+   * \param filename The file to write.
+   * \return Whether the file was written successfully.
+   */
+  bool Write (std::string filename) const;
+
+  /**
+   * Assign a fixed stream number to the generator used by this helper.
+   *
+   * \param stream First stream index to use.
+   * \return The number of stream indices assigned by this helper.
+   */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  Box m_box; //!< The area covered by the raster
+  double m_correlationDistance; //!< The side of squares and cells
+  double m_variance; //!< The variance of the corner values [dB^2]
+  LoraCounterRng m_rng; //!< Draws the corner values
+};
+
+}
+
+}
+#endif /* SHADOWING_RASTER_HELPER_H */
@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/trace-replay-helper.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("TraceReplayHelper");
+
+TraceReplayHelper::TraceReplayHelper ()
+{
+  m_factory.SetTypeId ("ns3::TraceReplaySender");
+}
+
+TraceReplayHelper::~TraceReplayHelper ()
+{
+}
+
+void
+TraceReplayHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+void
+TraceReplayHelper::SetTraceFile (std::string filename)
+{
+  m_factory.Set ("TraceFile", StringValue (filename));
+}
+
+ApplicationContainer
+TraceReplayHelper::Install (NodeContainer c) const
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT (c.GetN () > 0);
+
+  Ptr<TraceReplaySender> app = m_factory.Create<TraceReplaySender> ();
+
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      app->AddDevice (*i);
+    }
+
+  Ptr<Node> host = c.Get (0);
+  app->SetNode (host);
+  host->AddApplication (app);
+
+  return ApplicationContainer (app);
+}
+
+}
+}
@@ -0,0 +1,67 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_REPLAY_HELPER_H
+#define TRACE_REPLAY_HELPER_H
+
+#include "ns3/object-factory.h"
+#include "ns3/attribute.h"
+#include "ns3/node-container.h"
+#include "ns3/application-container.h"
+#include "ns3/trace-replay-sender.h"
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * This class can be used to install a TraceReplaySender application that
+ * replays a traffic trace on a set of end devices.
+ */
+class TraceReplayHelper
+{
+public:
+  TraceReplayHelper ();
+
+  ~TraceReplayHelper ();
+
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Set the trace file to be replayed.
+   */
+  void SetTraceFile (std::string filename);
+
+  /**
+   * Install a TraceReplaySender on the nodes in the container. The i-th node
+   * of the container is the device with index i in the trace. The
+   * application is aggregated to the first node of the container.
+   *
+   * \param c The end device nodes.
+   * \return A container with the single TraceReplaySender application.
+   */
+  ApplicationContainer Install (NodeContainer c) const;
+
+private:
+  ObjectFactory m_factory;
+};
+
+}
+
+}
+#endif /* TRACE_REPLAY_HELPER_H */
@@ -19,7 +19,10 @@
 #include "ns3/building-penetration-loss.h"
 #include "ns3/mobility-building-info.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/building.h"
 #include "ns3/log.h"
+#include <algorithm>
 #include <cmath>
 
 namespace ns3 {
@@ -29,6 +32,13 @@ NS_LOG_COMPONENT_DEFINE ("BuildingPenetrationLoss");
 
 NS_OBJECT_ENSURE_REGISTERED (BuildingPenetrationLoss);
 
+const uint32_t BuildingPenetrationLoss::UNKNOWN_NODE;
+
+// The identifiers of the draws of LoraCounterRng: links are identified by
+// the ids of their end points, which never have the top bit set
+static const uint64_t NODE_DRAWS = 1ULL << 63;
+static const uint64_t SEQUENTIAL_DRAWS = ~0ULL;
+
 TypeId
 BuildingPenetrationLoss::GetTypeId (void)
 {
@@ -36,16 +46,24 @@ BuildingPenetrationLoss::GetTypeId (void)
     .SetParent<PropagationLossModel> ()
     .SetGroupName ("Lora")
     .AddConstructor<BuildingPenetrationLoss> ()
+    .AddAttribute ("ResamplePerPacket",
+                   "Whether the random components of the loss of links "
+                   "between precomputed nodes are drawn at each packet, "
+                   "instead of once per link",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&BuildingPenetrationLoss::m_resamplePerPacket),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 BuildingPenetrationLoss::BuildingPenetrationLoss ()
+  : m_rng (LoraCounterRng::BUILDING_PENETRATION),
+  m_nDraws (0),
+  m_nSamples (0),
+  m_resamplePerPacket (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
-
-  // Initialize the random variable
-  m_uniformRV = CreateObject<UniformRandomVariable> ();
 }
 
 BuildingPenetrationLoss::~BuildingPenetrationLoss ()
@@ -60,6 +78,17 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
 {
   NS_LOG_FUNCTION (this << txPowerDbm << a << b);
 
+  // Use the stored attributes if both nodes were precomputed
+  if (!m_nodes.empty ())
+    {
+      const uint32_t *aIndex = m_nodeIndices.Find (PeekPointer (a));
+      const uint32_t *bIndex = m_nodeIndices.Find (PeekPointer (b));
+      if (aIndex != 0 && bIndex != 0)
+        {
+          return txPowerDbm - GetLinkLoss (*aIndex, *bIndex);
+        }
+    }
+
   Ptr<MobilityBuildingInfo> a1 = a->GetObject<MobilityBuildingInfo> ();
   Ptr<MobilityBuildingInfo> b1 = b->GetObject<MobilityBuildingInfo> ();
 
@@ -76,7 +105,7 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
 
       externalWallLoss = GetWallLoss (b);     // External wall loss due to b
       tor1 = GetTor1 (b);     // Internal wall loss due to b
-      tor3 = 0.6 * m_uniformRV->GetValue (0, 15);
+      tor3 = 0.6 * GetUniform (0, 15);
       gfh = 0;
 
     }
@@ -87,7 +116,7 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
       // These are the components of the loss due to building penetration
       externalWallLoss = GetWallLoss (a);
       tor1 = GetTor1 (a);
-      tor3 = 0.6 * m_uniformRV->GetValue (0, 15);
+      tor3 = 0.6 * GetUniform (0, 15);
       gfh = 0;
 
     }
@@ -103,7 +132,7 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
           NS_LOG_INFO ("Devices are in the same building");
           // Only internal wall loss
           tor1 = GetTor1 (b);
-          tor3 = 0.6 * m_uniformRV->GetValue (0, 15);
+          tor3 = 0.6 * GetUniform (0, 15);
         }
       // They are in different buildings
       else
@@ -111,7 +140,7 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
           // These are the components of the loss due to building penetration
           externalWallLoss = GetWallLoss (b) + GetWallLoss (a);
           tor1 = GetTor1 (b) + GetTor1 (a);
-          tor3 = 0.6 * m_uniformRV->GetValue (0, 15);
+          tor3 = 0.6 * GetUniform (0, 15);
           gfh = 0;
         }
     }
@@ -133,17 +162,20 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
 int64_t
 BuildingPenetrationLoss::DoAssignStreams (int64_t stream)
 {
-  m_uniformRV->SetStream (stream);
+  m_rng.SetStream (stream);
   return 1;
 }
 
-int
-BuildingPenetrationLoss::GetPValue (void) const
+double
+BuildingPenetrationLoss::GetUniform (double min, double max) const
 {
-  NS_LOG_FUNCTION_NOARGS ();
+  return m_rng.GetUniform (min, max, SEQUENTIAL_DRAWS, m_nDraws++);
+}
 
-  // We need to decide on the p value to return
-  double random = m_uniformRV->GetValue (0.0, 1.0);
+int
+BuildingPenetrationLoss::GetPValue (double random) const
+{
+  NS_LOG_FUNCTION (this << random);
 
   // Distribution is specified in TR 45.820, page 482, first scenario
   if (random < 0.2833)
@@ -165,12 +197,9 @@ BuildingPenetrationLoss::GetPValue (void) const
 }
 
 int
-BuildingPenetrationLoss::GetWallLossValue (void) const
+BuildingPenetrationLoss::GetWallLossValue (double random) const
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // We need to decide on the random value to return
-  double random = m_uniformRV->GetValue (0.0, 1.0);
+  NS_LOG_FUNCTION (this << random);
 
   // Distribution is specified in TR 45.820, page 482, first scenario
   if (random < 0.25)
@@ -199,19 +228,25 @@ BuildingPenetrationLoss::GetWallLoss (Ptr<MobilityModel> b) const
   if (it == m_wallLossMap.end ())
     {
       // Create a random value and insert it on the map
-      m_wallLossMap[b] = GetWallLossValue ();
+      m_wallLossMap[b] = GetWallLossValue (GetUniform (0, 1));
       NS_LOG_DEBUG ("Inserted a new wall loss value: " <<
                     m_wallLossMap.find (b)->second);
     }
 
-  switch (m_wallLossMap.find (b)->second)
+  return SampleWallLoss (m_wallLossMap.find (b)->second, GetUniform (0, 1));
+}
+
+double
+BuildingPenetrationLoss::SampleWallLoss (int wallType, double random) const
+{
+  switch (wallType)
     {
     case 0:
-      return m_uniformRV->GetValue (4, 11);
+      return 4 + 7 * random;
     case 1:
-      return m_uniformRV->GetValue (11, 19);
+      return 11 + 8 * random;
     case 2:
-      return m_uniformRV->GetValue (19, 23);
+      return 19 + 4 * random;
     }
 
   // Case in which something goes wrong
@@ -230,10 +265,141 @@ BuildingPenetrationLoss::GetTor1 (Ptr<MobilityModel> b) const
   if (it == m_pMap.end ())
     {
       // Create a random p value and insert it on the map
-      m_pMap[b] = GetPValue ();
+      m_pMap[b] = GetPValue (GetUniform (0, 1));
       NS_LOG_DEBUG ("Inserted a new p value: " << m_pMap.find (b)->second);
     }
-  return m_uniformRV->GetValue (4, 10) * m_pMap.find (b)->second;
+  return GetUniform (4, 10) * m_pMap.find (b)->second;
+}
+
+void
+BuildingPenetrationLoss::Precompute (NodeContainer nodes)
+{
+  NS_LOG_FUNCTION (this << nodes.GetN ());
+
+  for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); ++it)
+    {
+      Ptr<MobilityModel> mobility = (*it)->GetObject<MobilityModel> ();
+      NS_ASSERT_MSG (mobility != 0, "Node " << (*it)->GetId () << " has no mobility model");
+      Ptr<MobilityBuildingInfo> info = mobility->GetObject<MobilityBuildingInfo> ();
+      NS_ASSERT_MSG (info != 0, "Node " << (*it)->GetId () << " has no building info");
+
+      if (m_nodeIndices.Find (PeekPointer (mobility)) != 0)
+        {
+          continue;
+        }
+
+      NodeInfo node;
+      node.nodeId = (*it)->GetId ();
+      node.indoor = info->IsIndoor ();
+      node.buildingId = node.indoor ? info->GetBuilding ()->GetId () : 0;
+      node.wallType = GetWallLossValue (m_rng.GetUniform (NODE_DRAWS | node.nodeId, 0));
+      node.penetration = GetPValue (m_rng.GetUniform (NODE_DRAWS | node.nodeId, 1));
+
+      m_nodeIndices.Insert (PeekPointer (mobility), m_nodes.size ());
+      m_nodes.push_back (node);
+    }
+}
+
+uint32_t
+BuildingPenetrationLoss::GetNCachedLinks (void) const
+{
+  return m_linkLosses.GetSize ();
+}
+
+uint32_t
+BuildingPenetrationLoss::GetNodeIndex (Ptr<MobilityModel> mobility) const
+{
+  const uint32_t *index = m_nodeIndices.Find (PeekPointer (mobility));
+  return index != 0 ? *index : UNKNOWN_NODE;
+}
+
+double
+BuildingPenetrationLoss::GetBuildingLoss (Ptr<MobilityModel> a,
+                                          Ptr<MobilityModel> b) const
+{
+  return -DoCalcRxPower (0, a, b);
+}
+
+double
+BuildingPenetrationLoss::GetLinkLoss (uint32_t a, uint32_t b) const
+{
+  const NodeInfo &aNode = m_nodes[a];
+  const NodeInfo &bNode = m_nodes[b];
+  if (!aNode.indoor && !bNode.indoor)
+    {
+      return 0;
+    }
+  if (m_resamplePerPacket)
+    {
+      return SampleLinkLoss (aNode, bNode, ++m_nSamples);
+    }
+
+  // The loss is the same in both directions
+  uint64_t link = (uint64_t (std::min (a, b)) << 32) | std::max (a, b);
+  const double *cached = m_linkLosses.Find (link);
+  if (cached != 0)
+    {
+      return *cached;
+    }
+  double loss = SampleLinkLoss (aNode, bNode, 0);
+  m_linkLosses.Insert (link, loss);
+  return loss;
+}
+
+double
+BuildingPenetrationLoss::SampleLinkLoss (NodeInfo a, NodeInfo b, uint64_t sample) const
+{
+  // The loss is symmetric, so the values of a link are drawn with its end
+  // points in a fixed order, whatever the direction
+  if (a.nodeId > b.nodeId)
+    {
+      std::swap (a, b);
+    }
+  uint64_t link = (uint64_t (a.nodeId) << 32) | b.nodeId;
+  uint64_t counter = sample * 5;
+
+  // These are the components of the loss due to building penetration, as in
+  // DoCalcRxPower
+  double externalWallLoss = 0;
+  double tor1 = 0;
+  double tor3 = 0.6 * m_rng.GetUniform (0, 15, link, counter);
+
+  if (a.indoor && b.indoor && a.buildingId == b.buildingId)
+    {
+      // Only internal wall loss
+      tor1 = m_rng.GetUniform (4, 10, link, counter + 1) * b.penetration;
+    }
+  else
+    {
+      if (b.indoor)
+        {
+          externalWallLoss += SampleWallLoss (b.wallType,
+                                              m_rng.GetUniform (link, counter + 1));
+          tor1 += m_rng.GetUniform (4, 10, link, counter + 2) * b.penetration;
+        }
+      if (a.indoor)
+        {
+          externalWallLoss += SampleWallLoss (a.wallType,
+                                              m_rng.GetUniform (link, counter + 3));
+          tor1 += m_rng.GetUniform (4, 10, link, counter + 4) * a.penetration;
+        }
+    }
+
+  double loss = externalWallLoss + std::max (tor1, tor3);
+  NS_LOG_DEBUG ("Building penetration loss: " << loss);
+  return loss;
+}
+
+uint64_t
+BuildingPenetrationLoss::Hash::operator() (uint64_t value) const
+{
+  return LoraHashMix (value);
+}
+
+uint64_t
+BuildingPenetrationLoss::Hash::operator() (const MobilityModel *mobility) const
+{
+  return (*this) (uint64_t (reinterpret_cast<uintptr_t> (mobility)));
 }
 }
 }
@@ -22,7 +22,10 @@
 #include "ns3/propagation-loss-model.h"
 #include "ns3/mobility-model.h"
 #include "ns3/vector.h"
-#include "ns3/random-variable-stream.h"
+#include "ns3/lora-counter-rng.h"
+#include "ns3/node-container.h"
+#include "ns3/lora-flat-hash-map.h"
+#include <vector>
 
 namespace ns3 {
 class MobilityModel;
@@ -31,6 +34,23 @@ namespace lorawan {
 
 /**
  * A class implementing the TR 45.820 model for building losses
+ *
+ * By default, the buildings of the two ends of a link are looked up at each
+ * packet, and all random components of the loss are drawn again, except for
+ * the wall type and penetration class of each node. If the nodes are static,
+ * Precompute can be called once their building information is consistent:
+ * it stores the indoor flag, building, wall type and penetration class of
+ * each node in an array, so that no aggregated object is looked up while
+ * the simulation runs. The random components of the loss of each link are
+ * then drawn once, so that the building loss of a link is the same at each
+ * packet and in both directions, unless the ResamplePerPacket attribute is
+ * set.
+ *
+ * Random values are drawn from a LoraCounterRng. The wall type and
+ * penetration class of a precomputed node are keyed by its node id, and the
+ * loss of a link between precomputed nodes by the ids of its end points, so
+ * that they don't depend on the order in which nodes and links are evaluated.
+ * Other values are keyed by the number of values drawn before them.
  */
 class BuildingPenetrationLoss : public PropagationLossModel
 {
@@ -41,7 +61,68 @@ public:
 
   ~BuildingPenetrationLoss ();
 
+  /**
+   * Store the building attributes of a set of nodes, and draw their wall type
+   * and penetration class. Nodes must have a MobilityBuildingInfo, and must
+   * not move afterwards. Links between stored nodes use the stored
+   * attributes, while other links are computed as usual.
+   *
+   * \param nodes The nodes whose attributes are stored.
+   */
+  void Precompute (NodeContainer nodes);
+
+  /**
+   * \return The number of links whose loss is cached.
+   */
+  uint32_t GetNCachedLinks (void) const;
+
+  static const uint32_t UNKNOWN_NODE = 0xffffffff; //!< A node not precomputed
+
+  /**
+   * \return The index of the stored attributes of a node, or UNKNOWN_NODE if
+   * it was not precomputed.
+   */
+  uint32_t GetNodeIndex (Ptr<MobilityModel> mobility) const;
+
+  /**
+   * Get the loss of a link between two stored nodes, from the cache unless
+   * losses are resampled at each packet.
+   *
+   * \param a The index of the transmitter, as returned by GetNodeIndex.
+   * \param b The index of the receiver.
+   * \return The building loss [dB].
+   */
+  double GetLinkLoss (uint32_t a, uint32_t b) const;
+
+  /**
+   * Get the loss of any link, as applied by CalcRxPower.
+   *
+   * \return The building loss [dB].
+   */
+  double GetBuildingLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+
 private:
+  /**
+   * The static building attributes of a node.
+   */
+  struct NodeInfo
+  {
+    uint32_t nodeId; //!< The id of the node
+    uint32_t buildingId; //!< The building the node is in, if indoor
+    bool indoor; //!< Whether the node is indoor
+    uint8_t wallType; //!< The external wall class, in the 0-2 range
+    uint8_t penetration; //!< The p value, in the 0-3 range
+  };
+
+  /**
+   * Hash function for pointers and link identifiers.
+   */
+  struct Hash
+  {
+    uint64_t operator() (uint64_t value) const;
+    uint64_t operator() (const MobilityModel *mobility) const;
+  };
+
   /**
    * Perform the computation of the received power according to the current
    * model.
@@ -52,19 +133,27 @@ private:
 
   virtual int64_t DoAssignStreams (int64_t stream);
 
+  /**
+   * Draw the next uniform value of the draws that are not keyed by node or
+   * link.
+   */
+  double GetUniform (double min, double max) const;
+
   /**
    * Generate a random p value.
    * The distribution of the returned value is as specified in TR 45.820.
+   * \param random A value uniformly distributed in [0, 1).
    * \returns A value in the 0-3 range.
    */
-  int GetPValue (void) const;
+  int GetPValue (double random) const;
 
   /**
    * Get a value to compute the wall loss.
    * The distribution of the returned value is as specified in TR 45.820.
+   * \param random A value uniformly distributed in [0, 1).
    * \returns A value in the 0-2 range.
    */
-  int GetWallLossValue (void) const;
+  int GetWallLossValue (double random) const;
 
   /**
    * Compute the wall loss associated to this mobility model
@@ -82,7 +171,38 @@ private:
    */
   double GetTor1 (Ptr<MobilityModel> b) const;
 
-  Ptr<UniformRandomVariable> m_uniformRV;     //!< An uniform RV
+  /**
+   * Draw an external wall loss value.
+   * \param wallType The class of the wall.
+   * \param random A value uniformly distributed in [0, 1).
+   * \returns The power loss due to external walls.
+   */
+  double SampleWallLoss (int wallType, double random) const;
+
+  /**
+   * Draw the loss of a link between two stored nodes.
+   * \param sample The index of the sample of the link, which is always 0
+   * unless losses are resampled at each packet.
+   */
+  double SampleLinkLoss (NodeInfo a, NodeInfo b, uint64_t sample) const;
+
+  LoraCounterRng m_rng; //!< The generator of all random values
+  mutable uint64_t m_nDraws; //!< The number of values not keyed by node or link
+  mutable uint64_t m_nSamples; //!< The number of resampled link losses
+
+  bool m_resamplePerPacket; //!< Whether link losses are not cached
+
+  std::vector<NodeInfo> m_nodes; //!< The attributes of the stored nodes
+
+  /**
+   * The index in m_nodes of the mobility model of each stored node.
+   */
+  mutable LoraFlatHashMap<const MobilityModel *, uint32_t, Hash> m_nodeIndices;
+
+  /**
+   * The loss of each link between stored nodes, keyed by the two indices.
+   */
+  mutable LoraFlatHashMap<uint64_t, double, Hash> m_linkLosses;
 
   /**
    * A map linking each mobility model to a p value
@@ -0,0 +1,262 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/composite-lora-propagation-loss-model.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/lora-utils.h"
+#include "ns3/pointer.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("CompositeLoraPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (CompositeLoraPropagationLossModel);
+
+TypeId
+CompositeLoraPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CompositeLoraPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Lora")
+    .AddConstructor<CompositeLoraPropagationLossModel> ()
+    .AddAttribute ("Exponent",
+                   "The exponent of the path loss",
+                   DoubleValue (3.0),
+                   MakeDoubleAccessor (&CompositeLoraPropagationLossModel::m_exponent),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("ReferenceDistance",
+                   "The distance at which the reference loss is calculated [m]",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&CompositeLoraPropagationLossModel::m_referenceDistance),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("ReferenceLoss",
+                   "The reference loss at the reference distance [dB]",
+                   DoubleValue (46.6777),
+                   MakeDoubleAccessor (&CompositeLoraPropagationLossModel::m_referenceLoss),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("FastPowerConversion",
+                   "Whether the path loss is computed with the fast "
+                   "approximation of the logarithm of lora-utils",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CompositeLoraPropagationLossModel::m_fastPowerConversion),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Shadowing",
+                   "The shadowing stage, if any",
+                   PointerValue (),
+                   MakePointerAccessor (&CompositeLoraPropagationLossModel::m_shadowing),
+                   MakePointerChecker<CorrelatedShadowingPropagationLossModel> ())
+    .AddAttribute ("BuildingLoss",
+                   "The building loss stage, if any",
+                   PointerValue (),
+                   MakePointerAccessor (&CompositeLoraPropagationLossModel::m_buildingLoss),
+                   MakePointerChecker<BuildingPenetrationLoss> ());
+  return tid;
+}
+
+CompositeLoraPropagationLossModel::CompositeLoraPropagationLossModel ()
+  : m_exponent (3.0),
+  m_referenceDistance (1.0),
+  m_referenceLoss (46.6777),
+  m_fastPowerConversion (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CompositeLoraPropagationLossModel::~CompositeLoraPropagationLossModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CompositeLoraPropagationLossModel::SetPathLossExponent (double exponent)
+{
+  m_exponent = exponent;
+}
+
+double
+CompositeLoraPropagationLossModel::GetPathLossExponent (void) const
+{
+  return m_exponent;
+}
+
+void
+CompositeLoraPropagationLossModel::SetReference (double referenceDistance,
+                                                 double referenceLoss)
+{
+  m_referenceDistance = referenceDistance;
+  m_referenceLoss = referenceLoss;
+}
+
+void
+CompositeLoraPropagationLossModel::SetShadowing
+  (Ptr<CorrelatedShadowingPropagationLossModel> shadowing)
+{
+  m_shadowing = shadowing;
+}
+
+Ptr<CorrelatedShadowingPropagationLossModel>
+CompositeLoraPropagationLossModel::GetShadowing (void) const
+{
+  return m_shadowing;
+}
+
+void
+CompositeLoraPropagationLossModel::SetBuildingLoss (Ptr<BuildingPenetrationLoss> buildingLoss)
+{
+  m_buildingLoss = buildingLoss;
+}
+
+Ptr<BuildingPenetrationLoss>
+CompositeLoraPropagationLossModel::GetBuildingLoss (void) const
+{
+  return m_buildingLoss;
+}
+
+CompositeLoraPropagationLossModel::Endpoint
+CompositeLoraPropagationLossModel::GetEndpoint (Ptr<MobilityModel> mobility) const
+{
+  return GetEndpoint (mobility, mobility->GetPosition ());
+}
+
+CompositeLoraPropagationLossModel::Endpoint
+CompositeLoraPropagationLossModel::GetEndpoint (Ptr<MobilityModel> mobility,
+                                                const Vector &position) const
+{
+  Endpoint endpoint;
+  endpoint.mobility = mobility;
+  endpoint.position = position;
+  endpoint.building = m_buildingLoss != 0 ?
+    m_buildingLoss->GetNodeIndex (mobility) : BuildingPenetrationLoss::UNKNOWN_NODE;
+  return endpoint;
+}
+
+void
+CompositeLoraPropagationLossModel::CalcRxPowers (double txPowerDbm,
+                                                 const Endpoint &sender,
+                                                 const std::vector<Endpoint> &receivers,
+                                                 std::vector<double> &rxPowers)
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << receivers.size ());
+
+  uint32_t n = receivers.size ();
+  rxPowers.resize (n);
+
+  // The path loss, as LogDistancePropagationLossModel computes it: distances
+  // up to the reference one have no loss beyond the reference loss
+  const Vector &a = sender.position;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      const Vector &b = receivers[i].position;
+      double distance = std::sqrt ((a.x - b.x) * (a.x - b.x) +
+                                   (a.y - b.y) * (a.y - b.y) +
+                                   (a.z - b.z) * (a.z - b.z));
+      rxPowers[i] = std::max (distance, m_referenceDistance) / m_referenceDistance;
+    }
+  RatioToDb (rxPowers.data (), rxPowers.data (), n, m_fastPowerConversion);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      rxPowers[i] = txPowerDbm - m_referenceLoss - m_exponent * rxPowers[i];
+    }
+
+  if (m_shadowing != 0)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          rxPowers[i] -= m_shadowing->GetShadowing (a, receivers[i].position);
+        }
+    }
+
+  if (m_buildingLoss != 0)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          if (sender.building != BuildingPenetrationLoss::UNKNOWN_NODE
+              && receivers[i].building != BuildingPenetrationLoss::UNKNOWN_NODE)
+            {
+              rxPowers[i] -= m_buildingLoss->GetLinkLoss (sender.building,
+                                                          receivers[i].building);
+            }
+          else
+            {
+              rxPowers[i] -= m_buildingLoss->GetBuildingLoss (sender.mobility,
+                                                              receivers[i].mobility);
+            }
+        }
+    }
+
+  Ptr<PropagationLossModel> next = GetNext ();
+  if (next != 0)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          rxPowers[i] = next->CalcRxPower (rxPowers[i], sender.mobility,
+                                           receivers[i].mobility);
+        }
+    }
+}
+
+double
+CompositeLoraPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                                  Ptr<MobilityModel> a,
+                                                  Ptr<MobilityModel> b) const
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << a << b);
+
+  Vector aPosition = a->GetPosition ();
+  Vector bPosition = b->GetPosition ();
+
+  double distance = CalculateDistance (aPosition, bPosition);
+  double rxPowerDbm = txPowerDbm - m_referenceLoss - m_exponent *
+    RatioToDb (std::max (distance, m_referenceDistance) / m_referenceDistance,
+               m_fastPowerConversion);
+
+  if (m_shadowing != 0)
+    {
+      rxPowerDbm -= m_shadowing->GetShadowing (aPosition, bPosition);
+    }
+  if (m_buildingLoss != 0)
+    {
+      rxPowerDbm -= m_buildingLoss->GetBuildingLoss (a, b);
+    }
+
+  NS_LOG_DEBUG ("distance=" << distance << "m, rxPower=" << rxPowerDbm << "dBm");
+  return rxPowerDbm;
+}
+
+int64_t
+CompositeLoraPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  int64_t currentStream = stream;
+  if (m_shadowing != 0)
+    {
+      currentStream += m_shadowing->AssignStreams (currentStream);
+    }
+  if (m_buildingLoss != 0)
+    {
+      currentStream += m_buildingLoss->AssignStreams (currentStream);
+    }
+  return currentStream - stream;
+}
+
+}
+}
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPOSITE_LORA_PROPAGATION_LOSS_MODEL_H
+#define COMPOSITE_LORA_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/building-penetration-loss.h"
+#include "ns3/mobility-model.h"
+#include "ns3/vector.h"
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A propagation loss model that fuses the usual chain of a log distance path
+ * loss, a CorrelatedShadowingPropagationLossModel and a
+ * BuildingPenetrationLoss into a single model.
+ *
+ * The chain computes the same received powers as
+ *
+ *   LogDistancePropagationLossModel -> shadowing -> building loss
+ *
+ * linked with SetNext, where the shadowing and building stages are optional,
+ * but the positions of the end points are read once per link, and the stages
+ * are called directly instead of through the virtual CalcRxPower of each
+ * model. Each stage draws from its own random variable, so the results only
+ * depend on the order in which links are evaluated, as with the chain.
+ *
+ * The fan-out of a transmission can also be computed in a single call to
+ * CalcRxPowers, which evaluates one stage at a time over all receivers: the
+ * path loss of all links is a branchless loop over an array of positions,
+ * and the building loss of nodes that were precomputed by the
+ * BuildingPenetrationLoss is looked up by index. The logarithms of the path
+ * loss are computed by the RatioToDb conversions of lora-utils, in their fast
+ * mode if the FastPowerConversion attribute is set.
+ */
+class CompositeLoraPropagationLossModel : public PropagationLossModel
+{
+public:
+  /**
+   * An end point of a link: its mobility model, its position, and the index
+   * of its building attributes in the building loss model.
+   */
+  struct Endpoint
+  {
+    Ptr<MobilityModel> mobility; //!< The mobility model
+    Vector position; //!< The position of the mobility model
+    uint32_t building; //!< The index of the building record, or UNKNOWN_NODE
+  };
+
+  static TypeId GetTypeId (void);
+
+  CompositeLoraPropagationLossModel ();
+  virtual ~CompositeLoraPropagationLossModel ();
+
+  /**
+   * \param exponent The path loss exponent.
+   */
+  void SetPathLossExponent (double exponent);
+
+  /**
+   * \return The path loss exponent.
+   */
+  double GetPathLossExponent (void) const;
+
+  /**
+   * \param referenceDistance The distance up to which the loss is the
+   * reference loss [m].
+   * \param referenceLoss The loss at the reference distance [dB].
+   */
+  void SetReference (double referenceDistance, double referenceLoss);
+
+  /**
+   * Set the shadowing stage, or 0 for none.
+   */
+  void SetShadowing (Ptr<CorrelatedShadowingPropagationLossModel> shadowing);
+
+  Ptr<CorrelatedShadowingPropagationLossModel> GetShadowing (void) const;
+
+  /**
+   * Set the building loss stage, or 0 for none.
+   */
+  void SetBuildingLoss (Ptr<BuildingPenetrationLoss> buildingLoss);
+
+  Ptr<BuildingPenetrationLoss> GetBuildingLoss (void) const;
+
+  /**
+   * Describe an end point for CalcRxPowers. The building record is only
+   * meaningful as long as the node doesn't move, so endpoints should be
+   * rebuilt for each transmission.
+   */
+  Endpoint GetEndpoint (Ptr<MobilityModel> mobility) const;
+
+  /**
+   * Describe an end point whose position was already read.
+   */
+  Endpoint GetEndpoint (Ptr<MobilityModel> mobility, const Vector &position) const;
+
+  /**
+   * Compute the power received by several receivers of a transmission.
+   *
+   * Models chained after this one with SetNext are applied to each link
+   * after the fused stages, as CalcRxPower does.
+   *
+   * \param txPowerDbm The transmission power [dBm].
+   * \param sender The transmitter.
+   * \param receivers The receivers.
+   * \param rxPowers Filled with the power received by each receiver [dBm].
+   */
+  void CalcRxPowers (double txPowerDbm, const Endpoint &sender,
+                     const std::vector<Endpoint> &receivers,
+                     std::vector<double> &rxPowers);
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  double m_exponent; //!< The path loss exponent
+  double m_referenceDistance; //!< The reference distance [m]
+  double m_referenceLoss; //!< The loss at the reference distance [dB]
+
+  bool m_fastPowerConversion; //!< Whether the path loss uses the fast log10
+  Ptr<CorrelatedShadowingPropagationLossModel> m_shadowing; //!< Or 0
+  Ptr<BuildingPenetrationLoss> m_buildingLoss; //!< Or 0
+};
+
+}
+
+}
+#endif /* COMPOSITE_LORA_PROPAGATION_LOSS_MODEL_H */
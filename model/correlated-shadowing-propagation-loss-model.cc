@@ -18,6 +18,7 @@
 
 #include "ns3/correlated-shadowing-propagation-loss-model.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
 #include "ns3/log.h"
 #include <cmath>
 
@@ -28,6 +29,19 @@ NS_LOG_COMPONENT_DEFINE ("CorrelatedShadowingPropagationLossModel");
 
 NS_OBJECT_ENSURE_REGISTERED (CorrelatedShadowingPropagationLossModel);
 
+const double CorrelatedShadowingPropagationLossModel::RESOLUTION = 0.1;
+const double CorrelatedShadowingPropagationLossModel::VARIANCE = 16.0;
+
+// k^{-1} was computed offline. Since the corners of a square are one
+// correlation distance apart, it doesn't depend on the correlation distance.
+const double CorrelatedShadowingPropagationLossModel::m_kInv[4][4] =
+{
+  {1.27968707244633, -0.366414485833771, -0.0415206295795327, -0.366414485833771},
+  {-0.366414485833771, 1.27968707244633, -0.366414485833771, -0.0415206295795327},
+  {-0.0415206295795327, -0.366414485833771, 1.27968707244633, -0.366414485833771},
+  {-0.366414485833771, -0.0415206295795327, -0.366414485833771, 1.27968707244633}
+};
+
 TypeId
 CorrelatedShadowingPropagationLossModel::GetTypeId (void)
 {
@@ -40,262 +54,246 @@ CorrelatedShadowingPropagationLossModel::GetTypeId (void)
                    "uncorrelated",
                    DoubleValue (110.0),
                    MakeDoubleAccessor
-                     (&CorrelatedShadowingPropagationLossModel::m_correlationDistance),
-                   MakeDoubleChecker<double> ());
+                     (&CorrelatedShadowingPropagationLossModel::SetCorrelationDistance,
+                     &CorrelatedShadowingPropagationLossModel::GetCorrelationDistance),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxCachedValues",
+                   "The maximum number of interpolated shadowing values to "
+                   "keep, evicting the least recently used ones. Zero means "
+                   "no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor
+                     (&CorrelatedShadowingPropagationLossModel::SetMaxCachedValues,
+                     &CorrelatedShadowingPropagationLossModel::GetMaxCachedValues),
+                   MakeUintegerChecker<uint32_t> ());
   return tid;
 }
 
 CorrelatedShadowingPropagationLossModel::CorrelatedShadowingPropagationLossModel ()
+  : m_correlationDistance (110),
+  m_rng (LoraCounterRng::CORRELATED_SHADOWING)
 {
 }
 
-double
-CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
-                                                        Ptr<MobilityModel> a,
-                                                        Ptr<MobilityModel> b) const
+void
+CorrelatedShadowingPropagationLossModel::SetCorrelationDistance (double distance)
 {
-  NS_LOG_FUNCTION (this << txPowerDbm << a << b);
+  NS_LOG_FUNCTION (this << distance);
 
-  /*
-   * Check whether the a MobilityModel is in a grid square that already has
-   * its shadowing map.
-   */
-  Vector position = a->GetPosition ();
-
-  double x = position.x;
-  double y = position.y;
+  m_correlationDistance = distance;
+  m_corners.Clear ();
+  m_values.Clear ();
+}
 
-  // Compute the coordinates of the grid square (i.e., round the raw position)
-  // (x > 0) - (x < 0) is the sign function
-  int xcoord =
-    ((x > 0) - (x < 0)) * ((std::fabs (x) + m_correlationDistance / 2) / m_correlationDistance);
-  int ycoord =
-    ((y > 0) - (y < 0)) * ((std::fabs (y) + m_correlationDistance / 2) / m_correlationDistance);
+double
+CorrelatedShadowingPropagationLossModel::GetCorrelationDistance (void) const
+{
+  return m_correlationDistance;
+}
 
-  // Wrap coordinates up in a pair
-  std::pair<int, int> coordinates (xcoord, ycoord);
+void
+CorrelatedShadowingPropagationLossModel::SetMaxCachedValues (uint32_t maxCachedValues)
+{
+  m_values.SetMaxSize (maxCachedValues);
+}
 
-  NS_LOG_DEBUG ("x " << x << ", y " << y);
-  NS_LOG_DEBUG ("xcoord " << xcoord << ", ycoord " << ycoord);
+uint32_t
+CorrelatedShadowingPropagationLossModel::GetMaxCachedValues (void) const
+{
+  return m_values.GetMaxSize ();
+}
 
-  // Look for the computed coordinates in the shadowingGrid
-  std::map<std::pair<int,int>, Ptr<ShadowingMap> >::const_iterator it;
+uint32_t
+CorrelatedShadowingPropagationLossModel::GetNCorners (void) const
+{
+  return m_corners.GetSize ();
+}
 
-  it = m_shadowingGrid.find (coordinates);
+uint32_t
+CorrelatedShadowingPropagationLossModel::GetNCachedValues (void) const
+{
+  return m_values.GetSize ();
+}
 
-  if (it == m_shadowingGrid.end ())     // Did not find the coordinates
-    {
-      // If this shadowing grid was not found, create it
-      NS_LOG_DEBUG ("Creating a new shadowing map to be used at coordinates "
-                    << coordinates.first << " " << coordinates.second);
+double
+CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                                        Ptr<MobilityModel> a,
+                                                        Ptr<MobilityModel> b) const
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << a << b);
 
-      Ptr<ShadowingMap> shadowingMap =
-        Create<CorrelatedShadowingPropagationLossModel::ShadowingMap> ();
+  return txPowerDbm - GetShadowing (a->GetPosition (), b->GetPosition ());
+}
 
-      m_shadowingGrid[coordinates] = shadowingMap;
-    }
-  else
+double
+CorrelatedShadowingPropagationLossModel::GetShadowing (const Vector &a,
+                                                       const Vector &b) const
+{
+  // The square of a selects the shadowing field
+  Key key;
+  key.squareX = GetSquare (a.x, m_correlationDistance);
+  key.squareY = GetSquare (a.y, m_correlationDistance);
+  key.x = std::llround (b.x / RESOLUTION);
+  key.y = std::llround (b.y / RESOLUTION);
+
+  NS_LOG_DEBUG ("Square " << key.squareX << " " << key.squareY <<
+                ", position " << key.x << " " << key.y);
+
+  double *cached = m_values.Find (key);
+  if (cached != 0)
     {
-      NS_LOG_DEBUG ("This square already has its shadowingMap!");
+      NS_LOG_INFO ("Shadowing loss: " << *cached);
+      return *cached;
     }
 
-  // Place the iterator on the coordinates
-  it = m_shadowingGrid.find (coordinates);
-
-  // Get b's position in a's ShadowingMap
-  CorrelatedShadowingPropagationLossModel::Position bPosition
-    (b->GetPosition ().x, b->GetPosition ().y);
-
-  // Use the map of the a MobilityModel to determine the value of shadowing
-  // that corresponds to the position of the MobilityModel b.
-  double loss = it->second->GetLoss (bPosition);
+  double loss = Interpolate (key.squareX, key.squareY,
+                             key.x * RESOLUTION, key.y * RESOLUTION);
+  m_values.Insert (key, loss);
 
   NS_LOG_INFO ("Shadowing loss: " << loss);
 
-  return txPowerDbm - loss;
+  return loss;
 }
 
 int64_t
 CorrelatedShadowingPropagationLossModel::DoAssignStreams (int64_t stream)
 {
-  return 0;
+  m_rng.SetStream (stream);
+  m_corners.Clear ();
+  m_values.Clear ();
+  return 1;
 }
 
-/*********************************
- *  ShadowingMap implementation  *
- *********************************/
-
-// k^{-1} was computed offline
-const double CorrelatedShadowingPropagationLossModel::ShadowingMap::m_kInv[4][4] =
+int32_t
+CorrelatedShadowingPropagationLossModel::GetSquare (double coordinate,
+                                                    double correlationDistance)
 {
-  {1.27968707244633, -0.366414485833771, -0.0415206295795327, -0.366414485833771},
-  {-0.366414485833771, 1.27968707244633, -0.366414485833771, -0.0415206295795327},
-  {-0.0415206295795327, -0.366414485833771, 1.27968707244633, -0.366414485833771},
-  {-0.366414485833771, -0.0415206295795327, -0.366414485833771, 1.27968707244633}
-};
+  // (c > 0) - (c < 0) is the sign function
+  return ((coordinate > 0) - (coordinate < 0)) *
+         ((std::fabs (coordinate) + correlationDistance / 2) / correlationDistance);
+}
 
-CorrelatedShadowingPropagationLossModel::ShadowingMap::ShadowingMap () :
-  m_correlationDistance (110)
+void
+CorrelatedShadowingPropagationLossModel::GetWeights (double dx, double dy,
+                                                     double correlationDistance,
+                                                     double weights[4])
 {
-  NS_LOG_FUNCTION_NOARGS ();
+  // The c matrix contains the offsets of the 4 vertices
+  double c[2][4] = {{0, correlationDistance, correlationDistance, 0},
+                    {0, 0, correlationDistance, correlationDistance}};
+
+  // For the following procedure, reference:
+  // S. Schlegel et al., "On the Interpolation of Data with Normally
+  // Distributed Uncertainty for Visualization", IEEE Transactions on
+  // Visualization and Computer Graphics, vol. 18, no. 12, Dec. 2012.
+
+  // Compute the phi coefficients
+  for (int i = 0; i < 4; i++)
+    {
+      weights[i] = 0;
+    }
+
+  for (int j = 0; j < 4; j++)
+    {
+      double distance = std::sqrt ((c[0][j] - dx) * (c[0][j] - dx) + (c[1][j] - dy) * (c[1][j] - dy));
 
-  // The generation of new variables and positions along the grid is handled
-  // by the GetLoss function. Here, we only create the normal random variable.
-  m_shadowingValue = CreateObject<NormalRandomVariable> ();
-  m_shadowingValue->SetAttribute ("Mean", DoubleValue (0.0));
-  m_shadowingValue->SetAttribute ("Variance", DoubleValue (16.0));
+      double k = std::exp (-distance / correlationDistance);
+      for (int i = 0; i < 4; i++)
+        {
+          weights[i] += m_kInv[i][j] * k;
+        }
+    }
 }
 
-CorrelatedShadowingPropagationLossModel::ShadowingMap::~ShadowingMap ()
+double
+CorrelatedShadowingPropagationLossModel::GetCorner (int32_t squareX,
+                                                    int32_t squareY,
+                                                    int32_t cornerX,
+                                                    int32_t cornerY) const
 {
-  NS_LOG_FUNCTION_NOARGS ();
+  Key key;
+  key.squareX = squareX;
+  key.squareY = squareY;
+  key.x = cornerX;
+  key.y = cornerY;
+
+  double *corner = m_corners.Find (key);
+  if (corner != 0)
+    {
+      return *corner;
+    }
+
+  double value = DrawCorner (squareX, squareY, cornerX, cornerY, m_rng, VARIANCE);
+  NS_LOG_DEBUG ("New corner " << cornerX << " " << cornerY << ": " << value);
+  m_corners.Insert (key, value);
+  return value;
 }
 
 double
-CorrelatedShadowingPropagationLossModel::ShadowingMap::GetLoss
-  (CorrelatedShadowingPropagationLossModel::Position position)
+CorrelatedShadowingPropagationLossModel::DrawCorner (int32_t squareX,
+                                                     int32_t squareY,
+                                                     int32_t cornerX,
+                                                     int32_t cornerY,
+                                                     const LoraCounterRng &rng,
+                                                     double variance)
 {
-  NS_LOG_FUNCTION (this << position.x << position.y);
-
-  // Verify whether this position is already in the shadowingMap. Since the
-  // Position implementation overloads the == operator, this comparison
-  // between doubles is ok and we can use std::map's find function.
-  std::map<CorrelatedShadowingPropagationLossModel::Position,
-           double>::const_iterator it;
-  it = m_shadowingMap.find (position);
-
-  // If it's not found (i.e, if find returns the end of the map), we need to
-  // generate the value at the specified position.
-  if (it == m_shadowingMap.end ())
-    {
-      // Get the coordinates of the position
-      double x = position.x;
-      double y = position.y;
-      int xcoord =
-        ((x > 0) - (x < 0)) * ((std::fabs (x) + m_correlationDistance / 2) / m_correlationDistance);
-      int ycoord =
-        ((y > 0) - (y < 0)) * ((std::fabs (y) + m_correlationDistance / 2) / m_correlationDistance);
-
-      // Verify whether there already are the 4 surrounding positions in the
-      // map
-      double xmin = xcoord * m_correlationDistance - m_correlationDistance / 2;
-      double xmax = xcoord * m_correlationDistance + m_correlationDistance / 2;
-      double ymin = ycoord * m_correlationDistance - m_correlationDistance / 2;
-      double ymax = ycoord * m_correlationDistance + m_correlationDistance / 2;
-
-      CorrelatedShadowingPropagationLossModel::Position lowerLeft (xmin, ymin);
-      CorrelatedShadowingPropagationLossModel::Position upperLeft (xmin, ymax);
-      CorrelatedShadowingPropagationLossModel::Position lowerRight (xmax, ymin);
-      CorrelatedShadowingPropagationLossModel::Position upperRight (xmax, ymax);
-
-      NS_LOG_DEBUG ("Generating a new shadowing value in the following quadrant:");
-      NS_LOG_DEBUG ("xmin " << xmin << ", xmax " << xmax <<
-                    ", ymin " << ymin << ", ymax " << ymax);
-
-      // Use the map's insert method to insert the coordinates of the 4
-      // surrounding positions (if they are already there, they won't be
-      // substituted thanks to the map's implementation).
-      // TODO: Avoid useless generation of ShadowingMap values. This can be
-      // done by performing some checks (and not leveraging the map
-      // implementation)
-      double q11 = m_shadowingValue->GetValue ();
-      NS_LOG_DEBUG ("Lower left corner: " << q11);
-      m_shadowingMap[lowerLeft] = q11;
-      double q12 = m_shadowingValue->GetValue ();
-      NS_LOG_DEBUG ("Upper left corner: " << q12);
-      m_shadowingMap[upperLeft] = q12;
-      double q21 = m_shadowingValue->GetValue ();
-      NS_LOG_DEBUG ("Lower right corner: " << q21);
-      m_shadowingMap[lowerRight] = q21;
-      double q22 = m_shadowingValue->GetValue ();
-      NS_LOG_DEBUG ("Upper right corner: " << q22);
-      m_shadowingMap[upperRight] = q22;
-
-      NS_LOG_DEBUG (q11 << " " << q12 << " " << q21 << " " << q22 << " ");
-
-      // The c matrix contains the positions of the 4 vertices
-      double c[2][4] = {{xmin, xmax, xmax, xmin}, {ymin, ymin, ymax, ymax}};
-
-      // For the following procedure, reference:
-      // S. Schlegel et al., "On the Interpolation of Data with Normally
-      // Distributed Uncertainty for Visualization", IEEE Transactions on
-      // Visualization and Computer Graphics, vol. 18, no. 12, Dec. 2012.
-
-      // Compute the phi coefficients
-      double phi1 = 0;
-      double phi2 = 0;
-      double phi3 = 0;
-      double phi4 = 0;
-
-      for (int j = 0; j < 4; j++)
-        {
-          double distance = sqrt ((c[0][j] - x) * (c[0][j] - x) + (c[1][j] - y) * (c[1][j] - y));
+  uint64_t square = (uint64_t (uint32_t (squareX)) << 32) | uint32_t (squareY);
+  uint64_t corner = (uint64_t (uint32_t (cornerX)) << 32) | uint32_t (cornerY);
+  return rng.GetNormal (0, variance, square, corner);
+}
 
-          NS_LOG_DEBUG ("Distance: " << distance);
+double
+CorrelatedShadowingPropagationLossModel::Interpolate (int32_t squareX,
+                                                      int32_t squareY,
+                                                      double x,
+                                                      double y) const
+{
+  NS_LOG_FUNCTION (this << squareX << squareY << x << y);
 
-          double k = std::exp (-distance / m_correlationDistance);
-          phi1 = phi1 + m_kInv[0][j] * k;
-          phi2 = phi2 + m_kInv[1][j] * k;
-          phi3 = phi3 + m_kInv[2][j] * k;
-          phi4 = phi4 + m_kInv[3][j] * k;
-        }
+  // Find the lattice cell around the position: corner (i, j) is the lower left
+  // corner of square (i, j)
+  int32_t xcoord = GetSquare (x, m_correlationDistance);
+  int32_t ycoord = GetSquare (y, m_correlationDistance);
 
-      NS_LOG_DEBUG ("Phi: " << phi1 << " " << phi2 << " " << phi3 << " " <<
-                    phi4 << " ");
+  double xmin = xcoord * m_correlationDistance - m_correlationDistance / 2;
+  double ymin = ycoord * m_correlationDistance - m_correlationDistance / 2;
 
-      double shadowing = q11 * phi1 + q21 * phi2 + q22 * phi3 + q12 * phi4;
+  double q11 = GetCorner (squareX, squareY, xcoord, ycoord);
+  double q12 = GetCorner (squareX, squareY, xcoord, ycoord + 1);
+  double q21 = GetCorner (squareX, squareY, xcoord + 1, ycoord);
+  double q22 = GetCorner (squareX, squareY, xcoord + 1, ycoord + 1);
 
-      // Add the newly computed shadowing value to the shadowing map
-      m_shadowingMap[position] = shadowing;
-      NS_LOG_DEBUG ("Created new shadowing map: " << shadowing);
-    }
-  else
-    {
-      NS_LOG_DEBUG ("Shadowing map for this location already exists");
-    }
+  NS_LOG_DEBUG (q11 << " " << q12 << " " << q21 << " " << q22 << " ");
 
-  return m_shadowingMap[position];
-}
+  double phi[4];
+  GetWeights (x - xmin, y - ymin, m_correlationDistance, phi);
 
-/*****************************
- *  Position Implementation  *
- *****************************/
+  NS_LOG_DEBUG ("Phi: " << phi[0] << " " << phi[1] << " " << phi[2] << " " <<
+                phi[3] << " ");
 
-CorrelatedShadowingPropagationLossModel::Position::Position ()
-{
+  return q11 * phi[0] + q21 * phi[1] + q22 * phi[2] + q12 * phi[3];
 }
 
-CorrelatedShadowingPropagationLossModel::Position::Position (double x,
-                                                             double y)
-{
-  this->x = x;
-  this->y = y;
-}
+/************************
+ *  Key implementation  *
+ ************************/
 
-/*
- * Since Position holds two doubles, some tolerance must be taken into
- * account when comparing for equality.
- */
-bool CorrelatedShadowingPropagationLossModel::Position::operator==
-  (const CorrelatedShadowingPropagationLossModel::Position &other) const
+bool
+CorrelatedShadowingPropagationLossModel::Key::operator==
+  (const CorrelatedShadowingPropagationLossModel::Key &other) const
 {
-  double EPSILON = 0.1;     // Arbitrary value for the tolerance, 10 cm.
-  return ((fabs (this->x - other.x) < EPSILON)
-          && (fabs (this->y - other.y) < EPSILON));
+  return squareX == other.squareX && squareY == other.squareY
+         && x == other.x && y == other.y;
 }
 
-/*
- * In order to use Positions as keys in a map, we have to be able to order
- * them correctly.
- */
-bool CorrelatedShadowingPropagationLossModel::Position::operator<
-  (const CorrelatedShadowingPropagationLossModel::Position &other) const
+uint64_t
+CorrelatedShadowingPropagationLossModel::KeyHash::operator()
+  (const CorrelatedShadowingPropagationLossModel::Key &key) const
 {
-  if (this->x != other.x)
-    {
-      return this->x < other.x;
-    }
-  return this->y < other.y;
+  // Mix all the fields, so that nearby keys are spread over the whole table
+  uint64_t hash = (uint64_t (uint32_t (key.squareX)) << 32) | uint32_t (key.squareY);
+  hash = LoraHashCombine (hash, uint64_t (key.x));
+  return LoraHashCombine (hash, uint64_t (key.y));
 }
 }
 }
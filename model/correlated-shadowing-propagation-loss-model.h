@@ -22,91 +22,49 @@
 #include "ns3/propagation-loss-model.h"
 #include "ns3/mobility-model.h"
 #include "ns3/vector.h"
-#include "ns3/random-variable-stream.h"
+#include "ns3/lora-counter-rng.h"
+#include "ns3/lora-flat-hash-map.h"
 
 namespace ns3 {
 class MobilityModel;
 namespace lorawan {
 
+/**
+ * A propagation loss model that adds correlated shadowing to the received
+ * power.
+ *
+ * Space is divided into squares of side m_correlationDistance, and each square
+ * has its own independent shadowing field, that is used by all transmitters
+ * in the square: close nodes transmitting to the same point will thus see the
+ * same shadowing. Each field is defined by independent normal values on a
+ * lattice of corners, one correlation distance apart from each other:
+ *
+ *  o---o---o---o---o
+ *  |   |   |   |   |
+ *  o---o---o---o---o
+ *  |   |   |   |   |
+ *  o---o---o---o---o
+ *
+ * The shadowing at a receiver is interpolated from the 4 corners that
+ * surround it, so that it is "smooth": when transmitting from point a to
+ * points b and c, the shadowing experienced by b and c will be similar if
+ * they are close (ideally, within a correlation distance).
+ *
+ * Corner values are drawn from a LoraCounterRng keyed by the square and the
+ * corner, so that a field only depends on the stream of the model and not on
+ * the order of the lookups. They are computed the first time they are
+ * needed, and are kept for the whole simulation. Interpolated
+ * values are computed at receiver positions quantized to a 10 cm grid and
+ * cached in an open-addressing hash table, so that a repeated lookup costs a
+ * single probe. Since the cached values are a deterministic function of the
+ * corners, the cache can be capped with the MaxCachedValues attribute:
+ * evicted values are recomputed, and are identical to the ones that were
+ * evicted.
+ */
 class CorrelatedShadowingPropagationLossModel : public PropagationLossModel
 {
 
 public:
-  class Position
-  {
-public:
-    Position ();
-    Position (double x, double y);
-    double x;
-    double y;
-
-    bool operator== (const Position &other) const;
-    bool operator< (const Position &other) const;
-  };
-
-  class ShadowingMap : public
-                       SimpleRefCount<CorrelatedShadowingPropagationLossModel::ShadowingMap>
-  {
-public:
-    /**
-     * Constructor.
-     * This initializes the shadowing map with a grid of independent
-     * shadowing values, one m_correlationDistance meters apart from the next
-     * one. The result is something like:
-     *  o---o---o---o---o
-     *  |   |   |   |   |
-     *  o---o---o---o---o
-     *  |   |   |   |   |
-     *  o---o---o---o---o
-     *  |   |   |   |   |
-     *  o---o---o---o---o
-     *  where at each o we have an independently generated shadowing value.
-     *  We can then interpolate the 4 values surrounding any point in space
-     *  in order to get a correlated shadowing value. After generating this
-     *  value, we will add it to the map so that we don't have to compute it
-     *  twice. Also, since interpolation is a deterministic operation, we are
-     *  guaranteed that, as long as the grid doesn't change, also two values
-     *  generated in the same square will be correlated.
-     */
-    ShadowingMap ();
-
-    ~ShadowingMap ();
-
-    /**
-     * Get the loss for a certain position.
-     * If this position is not already in the map, add it by computing the
-     * interpolation of neighboring shadowing values belonging to the grid.
-     */
-    double GetLoss (CorrelatedShadowingPropagationLossModel::Position position);
-
-private:
-    /**
-     * For each Position, this map gives a corresponding loss.
-     * The map contains a basic grid that is initialized at construction
-     * time, and then newly computed values are added as they are created.
-     */
-    std::map<CorrelatedShadowingPropagationLossModel::Position, double>
-    m_shadowingMap;
-
-    /**
-     * The distance after which two samples are to be considered almost
-     * uncorrelated
-     */
-    double m_correlationDistance;
-
-    /**
-     * The normal random variable that is used to obtain shadowing values.
-     */
-    Ptr<NormalRandomVariable> m_shadowingValue;
-
-    /**
-     * The inverted K matrix.
-     * This matrix is used to compute the coefficients to be used when
-     * interpolating the vertices of a grid square.
-     */
-    static const double m_kInv[4][4];
-  };
-
   static TypeId GetTypeId (void);
 
   /**
@@ -115,14 +73,70 @@ private:
   CorrelatedShadowingPropagationLossModel ();
 
   /**
-   * Set the correlation distance for newly created ShadowingMap instances
+   * Set the correlation distance. This changes the squares and the lattice,
+   * so all corner and cached values are discarded.
    */
   void SetCorrelationDistance (double distance);
 
   /**
    * Get the correlation distance that is currently being used.
    */
-  double GetCorrelationDistance (void);
+  double GetCorrelationDistance (void) const;
+
+  /**
+   * \return The coordinate of the square that contains a coordinate, i.e.,
+   * the coordinate rounded to the closest multiple of the correlation
+   * distance.
+   */
+  static int32_t GetSquare (double coordinate, double correlationDistance);
+
+  /**
+   * Compute the interpolation weights of the 4 corners of a lattice cell.
+   *
+   * \param dx The horizontal offset from the lower left corner, in [0, d].
+   * \param dy The vertical offset from the lower left corner, in [0, d].
+   * \param correlationDistance The side d of the cell.
+   * \param weights Set to the weights of the lower left, lower right, upper
+   * right and upper left corners.
+   */
+  static void GetWeights (double dx, double dy, double correlationDistance,
+                          double weights[4]);
+
+  /**
+   * Get the shadowing of a link, as applied by CalcRxPower.
+   *
+   * \param a The position of the transmitter.
+   * \param b The position of the receiver.
+   * \return The shadowing loss [dB].
+   */
+  double GetShadowing (const Vector &a, const Vector &b) const;
+
+  /**
+   * Draw the value of a corner of the field of a square.
+   *
+   * \param squareX The x coordinate of the square.
+   * \param squareY The y coordinate of the square.
+   * \param cornerX The x coordinate of the corner.
+   * \param cornerY The y coordinate of the corner.
+   * \param rng The generator to draw from.
+   * \param variance The variance of the values [dB^2].
+   * \return The shadowing value of the corner [dB].
+   */
+  static double DrawCorner (int32_t squareX, int32_t squareY,
+                            int32_t cornerX, int32_t cornerY,
+                            const LoraCounterRng &rng, double variance);
+
+  static const double VARIANCE; //!< The variance of corner values [dB^2]
+
+  /**
+   * \return The number of corner values drawn so far.
+   */
+  uint32_t GetNCorners (void) const;
+
+  /**
+   * \return The number of interpolated values in the cache.
+   */
+  uint32_t GetNCachedValues (void) const;
 
 private:
   virtual double DoCalcRxPower (double txPowerDbm,
@@ -131,46 +145,89 @@ private:
 
   virtual int64_t DoAssignStreams (int64_t stream);
 
-  double m_correlationDistance;     //!< The correlation distance for the ShadowingMap
-
   /**
-   * Map linking a square to a ShadowingMap.
-   * Each square of the shadowing grid has a corresponding ShadowingMap, and a
-   * square is identified by a pair of coordinates. Coordinates are computed as
-   * such:
+   * A point of a shadowing field: the square of the transmitter, and either
+   * a corner of the lattice or a quantized receiver position.
    *
-   *  o---------o---------o---------o---------o---------o
-   *  |         |         |    '    |         |         |
-   *  |  (-2,2) |  (-1,2) |  (0,2)  |  (1,2)  |  (2,2)  |
-   *  |         |         |    '    |         |         |
-   *  o---------o---------o----+----o---------o---------o
-   *  |         |         |    '    |         |         |
-   *  |  (-2,1) |  (-1,1) |  (0,1)  |  (1,1)  |  (2,1)  |
-   *  |         |         |    '    |         |         |
-   *  o---------o---------o----+----o---------o---------o
-   *  |         |         |    '    |         |         |
-   *  |--(-2,0)-+--(-1,0)-+--(0,0)--+--(1,0)--+--(2,0)--|
-   *  |         |         |    '    |         |         |
-   *  o---------o---------o----+----o---------o---------o
-   *  |         |         |    '    |         |         |
-   *  | (-2,-1) | (-1,-1) | (0,-1)  | (1,-1)  | (2,-1)  |
-   *  |         |         |    '    |         |         |
-   *  o---------o---------o----+----o---------o---------o
-   *  |         |         |    '    |         |         |
-   *  | (-2,-2) | (-1,-2) | (0,-2)  | (1,-2)  | (2,-2)  |
-   *  |         |         |    '    |         |         |
-   *  o---------o---------o---------o---------o---------o
+   * Squares are identified by a pair of coordinates, computed as such:
    *
-   *  For each one of these coordinates, a ShadowingMap is computed. That is,
-   *  each one of the points belonging to the same square sees the same
-   *  shadowing for the points around it. This is one level of correlation for
-   *  the shadowing, i.e. close nodes transmitting to the same point will see
-   *  the same shadowing since they are using the same shadowing map.
-   *  Further, the ShadowingMap will be "smooth": when transmitting from point
-   *  a to points b and c, the shadowing experienced by b and c will be similar
-   *  if they are close (ideally, within a correlation distance).
-   */
-  mutable std::map<std::pair<int, int>, Ptr<ShadowingMap> > m_shadowingGrid;
+   *  o---------o---------o---------o---------o
+   *  |         |         |    '    |         |
+   *  |  (-2,1) |  (-1,1) |  (0,1)  |  (1,1)  |
+   *  |         |         |    '    |         |
+   *  o---------o---------o----+----o---------o
+   *  |         |         |    '    |         |
+   *  |--(-2,0)-+--(-1,0)-+--(0,0)--+--(1,0)--|
+   *  |         |         |    '    |         |
+   *  o---------o---------o----+----o---------o
+   *  |         |         |    '    |         |
+   *  | (-2,-1) | (-1,-1) | (0,-1)  | (1,-1)  |
+   *  |         |         |    '    |         |
+   *  o---------o---------o---------o---------o
+   *
+   * and corner (i, j) is the lower left corner of square (i, j).
+   */
+  struct Key
+  {
+    int32_t squareX;
+    int32_t squareY;
+    int64_t x;
+    int64_t y;
+
+    bool operator== (const Key &other) const;
+  };
+
+  /**
+   * Hash function for Keys.
+   */
+  struct KeyHash
+  {
+    uint64_t operator() (const Key &key) const;
+  };
+
+
+  /**
+   * Get the value of a corner of the field of a square, drawing it if this is
+   * the first time it is needed.
+   */
+  double GetCorner (int32_t squareX, int32_t squareY,
+                    int32_t cornerX, int32_t cornerY) const;
+
+  /**
+   * Interpolate the shadowing of the field of a square at a position.
+   */
+  double Interpolate (int32_t squareX, int32_t squareY,
+                      double x, double y) const;
+
+  void SetMaxCachedValues (uint32_t maxCachedValues);
+  uint32_t GetMaxCachedValues (void) const;
+
+  double m_correlationDistance; //!< The side of squares and lattice cells
+
+  /**
+   * The generator that is used to draw corner values.
+   */
+  LoraCounterRng m_rng;
+
+  /**
+   * The corner values of the fields of all squares.
+   */
+  mutable LoraFlatHashMap<Key, double, KeyHash> m_corners;
+
+  /**
+   * The interpolated values, keyed by receiver positions in units of
+   * RESOLUTION.
+   */
+  mutable LoraFlatHashMap<Key, double, KeyHash> m_values;
+
+  static const double RESOLUTION; //!< The quantization of receiver positions [m]
+
+  /**
+   * The inverted K matrix.
+   * This matrix is used to compute the coefficients to be used when
+   * interpolating the vertices of a grid square.
+   */
+  static const double m_kInv[4][4];
 };
 
 }
@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/counting-scheduler.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("CountingScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (CountingScheduler);
+
+uint64_t CountingScheduler::s_scheduled = 0;
+uint64_t CountingScheduler::s_executed = 0;
+uint64_t CountingScheduler::s_cancelled = 0;
+uint64_t CountingScheduler::s_removed = 0;
+uint64_t CountingScheduler::s_maxPending = 0;
+
+TypeId
+CountingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CountingScheduler")
+    .SetParent<MapScheduler> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<CountingScheduler> ()
+  ;
+  return tid;
+}
+
+CountingScheduler::CountingScheduler ()
+  : m_pending (0)
+{
+  NS_LOG_FUNCTION (this);
+
+  s_scheduled = 0;
+  s_executed = 0;
+  s_cancelled = 0;
+  s_removed = 0;
+  s_maxPending = 0;
+}
+
+CountingScheduler::~CountingScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CountingScheduler::Insert (const Event &ev)
+{
+  MapScheduler::Insert (ev);
+  s_scheduled++;
+  m_pending++;
+  if (m_pending > s_maxPending)
+    {
+      s_maxPending = m_pending;
+    }
+}
+
+Scheduler::Event
+CountingScheduler::RemoveNext (void)
+{
+  Event ev = MapScheduler::RemoveNext ();
+  // Simulator::Cancel only flags the event, which is then skipped by the
+  // simulator when it leaves the scheduler
+  if (ev.impl->IsCancelled ())
+    {
+      s_cancelled++;
+    }
+  else
+    {
+      s_executed++;
+    }
+  m_pending--;
+  return ev;
+}
+
+void
+CountingScheduler::Remove (const Event &ev)
+{
+  MapScheduler::Remove (ev);
+  s_removed++;
+  m_pending--;
+}
+
+uint64_t
+CountingScheduler::GetScheduledEvents (void)
+{
+  return s_scheduled;
+}
+
+uint64_t
+CountingScheduler::GetExecutedEvents (void)
+{
+  return s_executed;
+}
+
+uint64_t
+CountingScheduler::GetCancelledEvents (void)
+{
+  return s_cancelled;
+}
+
+uint64_t
+CountingScheduler::GetRemovedEvents (void)
+{
+  return s_removed;
+}
+
+uint64_t
+CountingScheduler::GetMaxPendingEvents (void)
+{
+  return s_maxPending;
+}
+
+}
+}
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COUNTING_SCHEDULER_H
+#define COUNTING_SCHEDULER_H
+
+#include "ns3/map-scheduler.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A MapScheduler that counts the events that go through it, to measure the
+ * load a scenario puts on the simulator.
+ *
+ * The counters are reset every time a new scheduler is created, so that they
+ * refer to the current simulation. Use it with:
+ *
+ * \code
+ *   ObjectFactory factory;
+ *   factory.SetTypeId ("ns3::CountingScheduler");
+ *   Simulator::SetScheduler (factory);
+ * \endcode
+ */
+class CountingScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CountingScheduler ();
+  virtual ~CountingScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+  /**
+   * \return The number of events scheduled since the scheduler was created.
+   */
+  static uint64_t GetScheduledEvents (void);
+
+  /**
+   * \return The number of events executed since the scheduler was created.
+   * Cancelled events are not counted, even though they leave the scheduler
+   * in the same way when their time comes.
+   */
+  static uint64_t GetExecutedEvents (void);
+
+  /**
+   * \return The number of events that were cancelled with Simulator::Cancel
+   * and reached their time since the scheduler was created.
+   */
+  static uint64_t GetCancelledEvents (void);
+
+  /**
+   * \return The number of events removed with Simulator::Remove since the
+   * scheduler was created.
+   */
+  static uint64_t GetRemovedEvents (void);
+
+  /**
+   * \return The largest number of pending events since the scheduler was
+   * created.
+   */
+  static uint64_t GetMaxPendingEvents (void);
+
+private:
+  uint64_t m_pending; //!< The number of events currently in the scheduler
+
+  static uint64_t s_scheduled; //!< Events inserted
+  static uint64_t s_executed; //!< Events removed to be executed
+  static uint64_t s_cancelled; //!< Cancelled events removed at their time
+  static uint64_t s_removed; //!< Events removed by Simulator::Remove
+  static uint64_t s_maxPending; //!< Peak number of pending events
+};
+
+}
+
+}
+#endif /* COUNTING_SCHEDULER_H */
@@ -19,6 +19,7 @@
  */
 
 #include "ns3/device-status.h"
+#include "ns3/lora-counters.h"
 #include "ns3/log.h"
 #include <algorithm>
 
@@ -153,6 +154,7 @@ DeviceStatus::GetReplyPacket (void)
 
   // Add headers to the packet
   Ptr<Packet> replyPacket = m_reply.packet->Copy ();
+  LORA_COUNTER_INCREMENT (PACKET_COPIES);
   replyPacket->AddHeader (m_reply.frameHeader);
   replyPacket->AddHeader (m_reply.macHeader);
 
@@ -20,8 +20,11 @@
  */
 
 #include "ns3/end-device-lora-mac.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-counters.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/simulator.h"
+#include "ns3/node.h"
 #include "ns3/log.h"
 #include <algorithm>
 
@@ -87,6 +90,8 @@ EndDeviceLoraMac::GetTypeId (void)
 EndDeviceLoraMac::EndDeviceLoraMac ()
   : m_enableDRAdapt (false),
   m_maxNumbTx (8),
+  m_rng (LoraCounterRng::END_DEVICE_MAC),
+  m_nDraws (0),
   m_dataRate (0),
   m_txPower (14),
   m_codingRate (1),
@@ -110,10 +115,6 @@ EndDeviceLoraMac::EndDeviceLoraMac ()
 {
   NS_LOG_FUNCTION (this);
 
-  // Initialize the random variable we'll use to decide which channel to
-  // transmit on.
-  m_uniformRV = CreateObject<UniformRandomVariable> ();
-
   // Void the two receiveWindow events
   m_closeFirstWindow = EventId ();
   m_closeFirstWindow.Cancel ();
@@ -144,6 +145,7 @@ void
 EndDeviceLoraMac::Send (Ptr<Packet> packet)
 {
   NS_LOG_FUNCTION (this << packet);
+  LORA_PROFILE_SCOPE (MAC);
 
   // Check that payload length is below the allowed maximum
   if (packet->GetSize () > m_maxAppPayloadForDataRate.at (m_dataRate))
@@ -163,7 +165,7 @@ EndDeviceLoraMac::Send (Ptr<Packet> packet)
       // Add the ACK_TIMEOUT random delay if it is a retransmission.
       if (m_retxParams.waitingAck)
         {
-          double ack_timeout = m_uniformRV->GetValue (1,3);
+          double ack_timeout = GetUniform (1, 3);
           netxTxDelay = netxTxDelay + Seconds (ack_timeout);
         }
       postponeTransmission (netxTxDelay, packet);
@@ -176,6 +178,7 @@ EndDeviceLoraMac::Send (Ptr<Packet> packet)
     {
       if (!txChannel)
         {
+          LORA_COUNTER_INCREMENT (DUTY_CYCLE_BLOCKED);
           m_cannotSendBecauseDutyCycle (packet);
         }
       else
@@ -197,6 +200,7 @@ void
 EndDeviceLoraMac::postponeTransmission (Time netxTxDelay, Ptr<Packet> packet)
 {
   NS_LOG_FUNCTION (this);
+  LORA_COUNTER_INCREMENT (DUTY_CYCLE_POSTPONEMENTS);
   // Delete previously scheduled transmissions if any.
   Simulator::Cancel (m_nextTx);
   m_nextTx = Simulator::Schedule (netxTxDelay, &EndDeviceLoraMac::DoSend, this, packet);
@@ -209,6 +213,7 @@ void
 EndDeviceLoraMac::DoSend (Ptr<Packet> packet)
 {
   NS_LOG_FUNCTION (this);
+  LORA_PROFILE_SCOPE (MAC);
   // Checking if this is the transmission of a new packet
   if (packet != m_retxParams.packet)
     {
@@ -248,6 +253,7 @@ EndDeviceLoraMac::DoSend (Ptr<Packet> packet)
       if (m_mType == LoraMacHeader::CONFIRMED_DATA_UP)
         {
           m_retxParams.packet = packet->Copy ();
+          LORA_COUNTER_INCREMENT (PACKET_COPIES);
           m_retxParams.retxLeft = m_maxNumbTx;
           m_retxParams.waitingAck = true;
           m_retxParams.firstAttempt = Simulator::Now ();
@@ -352,9 +358,11 @@ void
 EndDeviceLoraMac::Receive (Ptr<Packet const> packet)
 {
   NS_LOG_FUNCTION (this << packet);
+  LORA_PROFILE_SCOPE (MAC);
 
   // Work on a copy of the packet
   Ptr<Packet> packetCopy = packet->Copy ();
+  LORA_COUNTER_INCREMENT (PACKET_COPIES);
 
   // Remove the Mac Header to get some information
   LoraMacHeader mHdr;
@@ -447,6 +455,7 @@ void
 EndDeviceLoraMac::FailedReception (Ptr<Packet const> packet)
 {
   NS_LOG_FUNCTION (this << packet);
+  LORA_PROFILE_SCOPE (MAC);
 
   // Switch to sleep after a failed reception
   m_phy->GetObject<EndDeviceLoraPhy> ()->SwitchToSleep ();
@@ -662,6 +671,7 @@ void
 EndDeviceLoraMac::TxFinished (Ptr<const Packet> packet)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  LORA_PROFILE_SCOPE (MAC);
 
   // Schedule the opening of the first receive window
   Simulator::Schedule (m_receiveDelay1,
@@ -680,6 +690,7 @@ void
 EndDeviceLoraMac::OpenFirstReceiveWindow (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  LORA_PROFILE_SCOPE (MAC);
 
   // Set Phy in Standby mode
   m_phy->GetObject<EndDeviceLoraPhy> ()->SwitchToStandby ();
@@ -698,6 +709,7 @@ void
 EndDeviceLoraMac::CloseFirstReceiveWindow (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  LORA_PROFILE_SCOPE (MAC);
 
   Ptr<EndDeviceLoraPhy> phy = m_phy->GetObject<EndDeviceLoraPhy> ();
 
@@ -729,6 +741,7 @@ void
 EndDeviceLoraMac::OpenSecondReceiveWindow (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  LORA_PROFILE_SCOPE (MAC);
 
   // Check for receiver status: if it's locked on a packet, don't open this
   // window at all.
@@ -765,6 +778,7 @@ void
 EndDeviceLoraMac::CloseSecondReceiveWindow (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  LORA_PROFILE_SCOPE (MAC);
 
   Ptr<EndDeviceLoraPhy> phy = m_phy->GetObject<EndDeviceLoraPhy> ();
 
@@ -915,6 +929,17 @@ EndDeviceLoraMac::GetChannelForTx (void)
 }
 
 
+double
+EndDeviceLoraMac::GetUniform (double min, double max)
+{
+  uint32_t nodeId = 0;
+  if (m_device != 0 && m_device->GetNode () != 0)
+    {
+      nodeId = m_device->GetNode ()->GetId ();
+    }
+  return m_rng.GetUniform (min, max, nodeId, m_nDraws++);
+}
+
 std::vector<Ptr<LogicalLoraChannel> >
 EndDeviceLoraMac::Shuffle (std::vector<Ptr<LogicalLoraChannel> > vector)
 {
@@ -924,7 +949,7 @@ EndDeviceLoraMac::Shuffle (std::vector<Ptr<LogicalLoraChannel> > vector)
 
   for (int i = 0; i < size; ++i)
     {
-      uint16_t random = std::floor (m_uniformRV->GetValue (0, size));
+      uint16_t random = std::floor (GetUniform (0, size));
       Ptr<LogicalLoraChannel> temp = vector.at (random);
       vector.at (random) = vector.at (i);
       vector.at (i) = temp;
@@ -1300,5 +1325,13 @@ EndDeviceLoraMac::GetTransmissionPower (void)
 {
   return m_txPower;
 }
+
+void
+EndDeviceLoraMac::SetTransmissionPower (double txPowerDbm)
+{
+  NS_LOG_FUNCTION (this << txPowerDbm);
+
+  m_txPower = txPowerDbm;
+}
 }
 }
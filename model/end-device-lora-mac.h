@@ -26,6 +26,7 @@
 #include "ns3/lora-mac-header.h"
 #include "ns3/lora-frame-header.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/lora-counter-rng.h"
 #include "ns3/lora-device-address.h"
 #include "ns3/traced-value.h"
 
@@ -373,6 +374,16 @@ public:
 
   uint8_t GetTransmissionPower (void);
 
+  /**
+   * Set the transmission power this end device will use. This value can be
+   * later modified via MAC commands issued by the GW.
+   *
+   * \param txPowerDbm The transmission power in dBm.
+   */
+  void SetTransmissionPower (double txPowerDbm);
+
+  friend class LoraCheckpoint;
+
 private:
   /**
    * Structure representing the parameters that will be used in the
@@ -417,10 +428,19 @@ private:
   Ptr<LogicalLoraChannel> GetChannelForTx (void);
 
   /**
-   * An uniform random variable, used by the Shuffle method to randomly reorder
-   * the channel list.
+   * Draw a value uniformly distributed in [min, max), keyed by the id of the
+   * node and by the number of values this MAC drew before it, so that the
+   * values of a device don't depend on the activity of the others.
    */
-  Ptr<UniformRandomVariable> m_uniformRV;
+  double GetUniform (double min, double max);
+
+  /**
+   * The generator used by the Shuffle method to randomly reorder the channel
+   * list, and to draw the ACK timeout.
+   */
+  LoraCounterRng m_rng;
+
+  uint64_t m_nDraws; //!< The number of values drawn from m_rng
 
 
 /**
@@ -20,9 +20,11 @@
  */
 
 #include "ns3/end-device-status.h"
+#include "ns3/lora-counters.h"
 #include "ns3/simulator.h"
 #include "ns3/lora-mac-header.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-header-view.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
 #include "ns3/command-line.h"
@@ -118,6 +120,7 @@ EndDeviceStatus::GetCompleteReplyPacket (void)
     {
       NS_LOG_DEBUG ("Crafting reply packet from existing payload");
       replyPacket = m_reply.payload->Copy ();
+      LORA_COUNTER_INCREMENT (PACKET_COPIES);
     }
   else     // If no APP data needs to be sent, use an empty payload
     {
@@ -163,6 +166,7 @@ Ptr<Packet>
 EndDeviceStatus::GetReplyPayload (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  LORA_COUNTER_INCREMENT (PACKET_COPIES);
   return m_reply.payload->Copy ();
 }
 
@@ -240,20 +244,12 @@ EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket,
 
   NS_LOG_DEBUG (*this);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = receivedPacket->Copy ();
-
-  // Extract the headers
-  LoraMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
-
-  LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
+  // Read the frame counter
+  uint16_t fCnt = LoraHeaderView (receivedPacket).GetFCnt ();
 
   // Update current parameters
   LoraTag tag;
-  myPacket->RemovePacketTag (tag);
+  receivedPacket->PeekPacketTag (tag);
   SetFirstReceiveWindowSpreadingFactor (tag.GetSpreadingFactor ());
   SetFirstReceiveWindowFrequency (tag.GetFrequency ());
 
@@ -274,19 +270,14 @@ EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket,
     {
       // Get the frame counter of the current packet to compare it with the
       // newly received one
-      Ptr<Packet> packetCopy = ((*it).first)->Copy ();
-      LoraMacHeader currentMacHdr;
-      packetCopy->RemoveHeader (currentMacHdr);
-      LoraFrameHeader currentFrameHdr;
-      frameHdr.SetAsUplink ();
-      packetCopy->RemoveHeader (currentFrameHdr);
+      uint16_t currentFCnt = LoraHeaderView ((*it).first).GetFCnt ();
 
       NS_LOG_DEBUG ("Received packet's frame counter: " <<
-                    unsigned(frameHdr.GetFCnt ()) <<
+                    unsigned(fCnt) <<
                     "\nCurrent packet's frame counter: " <<
-                    unsigned(currentFrameHdr.GetFCnt ()));
+                    unsigned(currentFCnt));
 
-      if (frameHdr.GetFCnt () == currentFrameHdr.GetFCnt ())
+      if (fCnt == currentFCnt)
         {
           NS_LOG_INFO ("Packet was already received by another gateway");
 
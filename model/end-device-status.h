@@ -308,6 +308,8 @@ public:
 
   friend std::ostream& operator<< (std::ostream& os, const EndDeviceStatus& status);
 
+  friend class LoraCheckpoint;
+
 private:
   // Receive window data
   uint8_t m_firstReceiveWindowSpreadingFactor = 0;
@@ -0,0 +1,317 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/fleet-sender.h"
+#include "ns3/lora-packet-pool.h"
+#include "ns3/pointer.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/lora-net-device.h"
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("FleetSender");
+
+NS_OBJECT_ENSURE_REGISTERED (FleetSender);
+
+TypeId
+FleetSender::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FleetSender")
+    .SetParent<Application> ()
+    .AddConstructor<FleetSender> ()
+    .SetGroupName ("lorawan")
+    .AddAttribute ("SlotWidth", "The width of a slot of the timing wheel",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&FleetSender::m_slotWidth),
+                   MakeTimeChecker ())
+    .AddAttribute ("NumberOfSlots", "The number of slots of the timing wheel",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&FleetSender::m_nSlots),
+                   MakeUintegerChecker<uint32_t> (1));
+  return tid;
+}
+
+FleetSender::FleetSender ()
+  : m_nSlots (4096),
+  m_slotWidth (Seconds (1)),
+  m_slotWidthTs (0),
+  m_cursor (0),
+  m_cursorSorted (false),
+  m_nEntries (0),
+  m_seq (0),
+  m_basePktSize (10),
+  m_pktSizeRV (0),
+  m_jitterRV (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+FleetSender::~FleetSender ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+uint32_t
+FleetSender::AddDevice (Ptr<Node> node, Time interval, Time initialDelay)
+{
+  NS_LOG_FUNCTION (this << node << interval << initialDelay);
+
+  NS_ASSERT (interval.IsStrictlyPositive ());
+
+  Device device;
+  device.node = node;
+  device.interval = interval;
+  device.initialDelay = initialDelay;
+  m_devices.push_back (device);
+
+  return m_devices.size () - 1;
+}
+
+uint32_t
+FleetSender::GetNDevices (void) const
+{
+  return m_devices.size ();
+}
+
+void
+FleetSender::SetPacketSize (uint8_t size)
+{
+  m_basePktSize = size;
+}
+
+void
+FleetSender::SetPacketSizeRandomVariable (Ptr <RandomVariableStream> rv)
+{
+  m_pktSizeRV = rv;
+}
+
+void
+FleetSender::SetJitterRandomVariable (Ptr <RandomVariableStream> rv)
+{
+  m_jitterRV = rv;
+}
+
+void
+FleetSender::Insert (uint32_t device, Time time)
+{
+  Entry entry;
+  entry.ts = time.GetTimeStep ();
+  entry.seq = m_seq++;
+  entry.device = device;
+
+  int64_t slot = entry.ts / m_slotWidthTs;
+  NS_ASSERT (slot >= m_cursor);
+
+  if (slot >= m_cursor + m_nSlots)
+    {
+      m_overflow.push (entry);
+      return;
+    }
+
+  std::vector<Entry> &bucket = m_wheel[slot % m_nSlots];
+  if (slot == m_cursor && m_cursorSorted)
+    {
+      // The current slot is sorted in decreasing order, so that the earliest
+      // entry is at the back: keep it that way
+      bucket.insert (std::lower_bound (bucket.begin (), bucket.end (), entry,
+                                       std::greater<Entry> ()),
+                     entry);
+    }
+  else
+    {
+      bucket.push_back (entry);
+    }
+  m_nEntries++;
+}
+
+void
+FleetSender::Migrate (void)
+{
+  while (!m_overflow.empty ()
+         && m_overflow.top ().ts / m_slotWidthTs < m_cursor + m_nSlots)
+    {
+      Entry entry = m_overflow.top ();
+      m_overflow.pop ();
+      m_wheel[(entry.ts / m_slotWidthTs) % m_nSlots].push_back (entry);
+      m_nEntries++;
+    }
+}
+
+bool
+FleetSender::AdvanceToNext (void)
+{
+  while (true)
+    {
+      if (m_nEntries == 0)
+        {
+          if (m_overflow.empty ())
+            {
+              return false;
+            }
+          // Jump directly to the slot of the earliest overflow entry
+          m_cursor = m_overflow.top ().ts / m_slotWidthTs;
+          m_cursorSorted = false;
+          Migrate ();
+        }
+
+      std::vector<Entry> &bucket = m_wheel[m_cursor % m_nSlots];
+      if (!bucket.empty ())
+        {
+          if (!m_cursorSorted)
+            {
+              std::sort (bucket.begin (), bucket.end (), std::greater<Entry> ());
+              m_cursorSorted = true;
+            }
+          return true;
+        }
+
+      m_cursor++;
+      m_cursorSorted = false;
+      Migrate ();
+    }
+}
+
+void
+FleetSender::ScheduleNext (void)
+{
+  if (!AdvanceToNext ())
+    {
+      return;
+    }
+
+  const Entry &next = m_wheel[m_cursor % m_nSlots].back ();
+  Time delay = TimeStep (next.ts) - Simulator::Now ();
+  m_sendEvent = Simulator::ScheduleWithContext (m_devices[next.device].node->GetId (),
+                                                delay, &FleetSender::SendPacket,
+                                                this);
+}
+
+void
+FleetSender::SendPacket (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  bool found = AdvanceToNext ();
+  NS_ASSERT (found);
+  (void) found;
+
+  std::vector<Entry> &bucket = m_wheel[m_cursor % m_nSlots];
+  Entry entry = bucket.back ();
+  bucket.pop_back ();
+  m_nEntries--;
+  NS_ASSERT (entry.ts == Simulator::Now ().GetTimeStep ());
+
+  Device &device = m_devices[entry.device];
+
+  // Create and send a new packet
+  Ptr<Packet> packet;
+  if (m_pktSizeRV)
+    {
+      int randomsize = m_pktSizeRV->GetInteger ();
+      packet = LoraPacketPool::Allocate (m_basePktSize + randomsize);
+    }
+  else
+    {
+      packet = LoraPacketPool::Allocate (m_basePktSize);
+    }
+  device.mac->Send (packet);
+
+  NS_LOG_DEBUG ("Device " << entry.device << " sent a packet of size " <<
+                packet->GetSize ());
+
+  // Set the next send time of this device
+  Time next = Simulator::Now () + device.interval;
+  if (m_jitterRV)
+    {
+      next += Seconds (m_jitterRV->GetValue ());
+      next = Max (next, Simulator::Now ());
+    }
+  Insert (entry.device, next);
+
+  ScheduleNext ();
+}
+
+void
+FleetSender::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT (m_slotWidth.IsStrictlyPositive ());
+
+  // Make sure we have a MAC layer for each device
+  for (std::vector<Device>::iterator it = m_devices.begin ();
+       it != m_devices.end (); ++it)
+    {
+      if (it->mac == 0)
+        {
+          // Assumes there's only one device
+          Ptr<LoraNetDevice> loraNetDevice =
+            it->node->GetDevice (0)->GetObject<LoraNetDevice> ();
+
+          it->mac = loraNetDevice->GetMac ();
+          NS_ASSERT (it->mac != 0);
+        }
+    }
+
+  // Reset the wheel at the current time
+  Simulator::Cancel (m_sendEvent);
+  m_slotWidthTs = m_slotWidth.GetTimeStep ();
+  m_wheel.assign (m_nSlots, std::vector<Entry> ());
+  m_overflow = std::priority_queue<Entry, std::vector<Entry>,
+                                   std::greater<Entry> > ();
+  m_cursor = Simulator::Now ().GetTimeStep () / m_slotWidthTs;
+  m_cursorSorted = false;
+  m_nEntries = 0;
+  m_seq = 0;
+
+  for (uint32_t i = 0; i < m_devices.size (); i++)
+    {
+      Insert (i, Simulator::Now () + m_devices[i].initialDelay);
+    }
+
+  NS_LOG_DEBUG ("Starting up application with " << m_devices.size () <<
+                " devices");
+
+  ScheduleNext ();
+}
+
+void
+FleetSender::StopApplication (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Simulator::Cancel (m_sendEvent);
+}
+
+void
+FleetSender::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_sendEvent);
+  m_devices.clear ();
+  m_pktSizeRV = 0;
+  m_jitterRV = 0;
+  Application::DoDispose ();
+}
+
+}
+}
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLEET_SENDER_H
+#define FLEET_SENDER_H
+
+#include "ns3/application.h"
+#include "ns3/nstime.h"
+#include "ns3/lora-mac.h"
+#include "ns3/attribute.h"
+#include "ns3/random-variable-stream.h"
+#include <vector>
+#include <queue>
+#include <functional>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * An application that generates periodic traffic for a whole fleet of end
+ * devices.
+ *
+ * Instead of having each device keep its own send event in the simulator
+ * scheduler like PeriodicSender, this application keeps the next send time
+ * of all devices in a timing wheel, and only keeps a single pending event in
+ * the simulator, for the earliest of them. Each send is executed in the
+ * context of the node of the device that is sending.
+ *
+ * The wheel is made of NumberOfSlots slots, each SlotWidth wide; devices
+ * whose next send time is beyond the wheel horizon are kept in an overflow
+ * heap and moved to the wheel as it advances. Devices sending at the same
+ * time are served in the order in which their send times were set, which is
+ * the same order the simulator would use for one event per device: with the
+ * same random variable streams, and in absence of jitter, the traffic is the
+ * same as the one generated by a PeriodicSender on each device.
+ */
+class FleetSender : public Application
+{
+public:
+  FleetSender ();
+  ~FleetSender ();
+
+  static TypeId GetTypeId (void);
+
+  /**
+   * Add a device to the fleet.
+   *
+   * \param node The node of the end device. Its first NetDevice must be a
+   * LoraNetDevice.
+   * \param interval The interval between two packets of this device.
+   * \param initialDelay The delay of the first packet from the start of the
+   * application.
+   * \return The index of the device in the fleet.
+   */
+  uint32_t AddDevice (Ptr<Node> node, Time interval, Time initialDelay);
+
+  /**
+   * \return The number of devices in the fleet.
+   */
+  uint32_t GetNDevices (void) const;
+
+  /**
+   * Set the base packet size of all devices.
+   */
+  void SetPacketSize (uint8_t size);
+
+  /**
+   * Set the random variable that adds bytes to the packet size.
+   */
+  void SetPacketSizeRandomVariable (Ptr <RandomVariableStream> rv);
+
+  /**
+   * Set the random variable, in seconds, that is added to the interval
+   * between two packets of a device.
+   */
+  void SetJitterRandomVariable (Ptr <RandomVariableStream> rv);
+
+  /**
+   * Start the application by scheduling the first send event
+   */
+  void StartApplication (void);
+
+  /**
+   * Stop the application
+   */
+  void StopApplication (void);
+
+  friend class LoraCheckpoint;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * An entry of the timing wheel
+   */
+  struct Entry
+  {
+    int64_t ts; //!< The send time, in time steps
+    uint64_t seq; //!< The insertion order, to break ties
+    uint32_t device; //!< The index of the device in the fleet
+
+    bool operator> (const Entry &other) const
+    {
+      return ts > other.ts || (ts == other.ts && seq > other.seq);
+    }
+  };
+
+  /**
+   * A device of the fleet
+   */
+  struct Device
+  {
+    Ptr<Node> node; //!< The node of the device
+    Ptr<LoraMac> mac; //!< The MAC layer of the device
+    Time interval; //!< The interval between two packets
+    Time initialDelay; //!< The delay of the first packet
+  };
+
+  /**
+   * Set the next send time of a device.
+   */
+  void Insert (uint32_t device, Time time);
+
+  /**
+   * Advance the wheel to the earliest entry, sorting its slot if needed.
+   *
+   * \return false if there are no entries.
+   */
+  bool AdvanceToNext (void);
+
+  /**
+   * Move the overflow entries that fall in the wheel horizon to the wheel.
+   */
+  void Migrate (void);
+
+  /**
+   * Schedule the simulator event for the earliest entry.
+   */
+  void ScheduleNext (void);
+
+  /**
+   * Send a packet for the device of the earliest entry, and set its next
+   * send time.
+   */
+  void SendPacket (void);
+
+  std::vector<Device> m_devices; //!< The devices of the fleet
+
+  std::vector<std::vector<Entry> > m_wheel; //!< The slots of the wheel
+  std::priority_queue<Entry, std::vector<Entry>,
+                      std::greater<Entry> > m_overflow; //!< Entries beyond the horizon
+  uint32_t m_nSlots; //!< The number of slots of the wheel
+  Time m_slotWidth; //!< The width of a slot
+  int64_t m_slotWidthTs; //!< The width of a slot, in time steps
+  int64_t m_cursor; //!< The absolute index of the current slot
+  bool m_cursorSorted; //!< Whether the current slot is sorted
+  uint64_t m_nEntries; //!< The number of entries in the wheel
+  uint64_t m_seq; //!< The next insertion sequence number
+
+  EventId m_sendEvent; //!< The only pending send event
+
+  uint8_t m_basePktSize; //!< The packet size
+  Ptr<RandomVariableStream> m_pktSizeRV; //!< Random bytes added to the size
+  Ptr<RandomVariableStream> m_jitterRV; //!< Random seconds added to the interval
+};
+
+}
+
+}
+#endif /* FLEET_SENDER_H */
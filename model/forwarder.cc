@@ -19,6 +19,7 @@
  */
 
 #include "ns3/forwarder.h"
+#include "ns3/lora-counters.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -72,6 +73,7 @@ Forwarder::ReceiveFromLora (Ptr<NetDevice> loraNetDevice, Ptr<const Packet>
   NS_LOG_FUNCTION (this << packet << protocol << sender);
 
   Ptr<Packet> packetCopy = packet->Copy ();
+  LORA_COUNTER_INCREMENT (PACKET_COPIES);
 
   m_pointToPointNetDevice->Send (packetCopy,
                                  m_pointToPointNetDevice->GetBroadcast (),
@@ -88,6 +90,7 @@ Forwarder::ReceiveFromPointToPoint (Ptr<NetDevice> pointToPointNetDevice,
   NS_LOG_FUNCTION (this << packet << protocol << sender);
 
   Ptr<Packet> packetCopy = packet->Copy ();
+  LORA_COUNTER_INCREMENT (PACKET_COPIES);
 
   m_loraNetDevice->Send (packetCopy);
 
@@ -19,9 +19,12 @@
  */
 
 #include "ns3/gateway-lora-mac.h"
+#include "ns3/lora-counters.h"
+#include "ns3/lora-profiler.h"
 #include "ns3/lora-mac-header.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-header-view.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -55,6 +58,7 @@ void
 GatewayLoraMac::Send (Ptr<Packet> packet)
 {
   NS_LOG_FUNCTION (this << packet);
+  LORA_PROFILE_SCOPE (MAC);
 
   // Get DataRate to send this packet with
   LoraTag tag;
@@ -113,21 +117,21 @@ void
 GatewayLoraMac::Receive (Ptr<Packet const> packet)
 {
   NS_LOG_FUNCTION (this << packet);
-
-  // Make a copy of the packet to work on
-  Ptr<Packet> packetCopy = packet->Copy ();
+  LORA_PROFILE_SCOPE (MAC);
 
   // Only forward the packet if it's uplink
-  LoraMacHeader macHdr;
-  packetCopy->PeekHeader (macHdr);
+  LoraHeaderView hdrView (packet);
 
-  if (macHdr.IsUplink ())
+  if (hdrView.IsUplink ())
     {
+      // Make a copy of the packet to hand to the NetDevice
+      Ptr<Packet> packetCopy = packet->Copy ();
+      LORA_COUNTER_INCREMENT (PACKET_COPIES);
       m_device->GetObject<LoraNetDevice> ()->Receive (packetCopy);
 
       NS_LOG_DEBUG ("Received packet: " << packet);
 
-      if (macHdr.IsConfirmed ())    // Only fire the callback if it's confirmed
+      if (hdrView.IsConfirmed ())    // Only fire the callback if it's confirmed
         {
           m_receivedPacket (packet);
         }
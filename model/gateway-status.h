@@ -81,6 +81,8 @@ public:
   void SetNextTransmissionTime (Time nextTransmissionTime);
   // Time GetNextTransmissionTime (void);
 
+  friend class LoraCheckpoint;
+
 private:
   Address m_address;   //!< The Address of the P2PNetDevice of this gateway
 
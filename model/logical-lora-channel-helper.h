@@ -175,6 +175,8 @@ public:
    */
   void DisableChannel (int index);
 
+  friend class LoraCheckpoint;
+
 private:
   /**
    * A list of the SubBands that are currently registered within this helper.
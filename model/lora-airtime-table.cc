@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-airtime-table.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraAirtimeTable");
+
+LoraAirtimeTable::LoraAirtimeTable ()
+{
+  NS_LOG_FUNCTION (this);
+
+  for (uint8_t sf = MIN_SF; sf <= MAX_SF; sf++)
+    {
+      for (int de = 0; de < 2; de++)
+        {
+          for (int h = 0; h < 2; h++)
+            {
+              for (int crc = 0; crc < 2; crc++)
+                {
+                  for (uint32_t pl = 0; pl <= MAX_PAYLOAD_SIZE; pl++)
+                    {
+                      // Same terms of ComputeOnAirTime, in integer arithmetic
+                      int num = 8 * int(pl) - 4 * sf + 28 + 16 * crc - 20 * h;
+                      int den = 4 * (sf - 2 * de);
+                      int ceil = num > 0 ? (num + den - 1) / den : 0;
+                      m_ceil[GetIndex (sf, de, h, crc, pl)] = uint8_t (ceil);
+                    }
+                }
+            }
+        }
+    }
+}
+
+const LoraAirtimeTable &
+LoraAirtimeTable::Get (void)
+{
+  static const LoraAirtimeTable table;
+  return table;
+}
+
+uint32_t
+LoraAirtimeTable::GetIndex (uint8_t sf, bool de, bool h, bool crc,
+                            uint32_t payloadSize)
+{
+  return ((((sf - MIN_SF) * 2 + de) * 2 + h) * 2 + crc)
+         * (MAX_PAYLOAD_SIZE + 1) + payloadSize;
+}
+
+Time
+LoraAirtimeTable::GetOnAirTime (uint32_t payloadSize,
+                                const LoraTxParameters &txParams)
+{
+  NS_LOG_FUNCTION (payloadSize << txParams);
+
+  double bandwidthHz = txParams.bandwidthHz;
+  if (txParams.sf < MIN_SF || txParams.sf > MAX_SF
+      || txParams.codingRate < 1 || txParams.codingRate > 4
+      || payloadSize > MAX_PAYLOAD_SIZE
+      || txParams.nPreamble > MAX_PREAMBLE
+      || bandwidthHz < 1 || bandwidthHz != std::floor (bandwidthHz))
+    {
+      return ComputeOnAirTime (payloadSize, txParams);
+    }
+
+  uint8_t ceil = Get ().m_ceil[GetIndex (txParams.sf,
+                                         txParams.lowDataRateOptimizationEnabled,
+                                         txParams.headerDisabled,
+                                         txParams.crcEnabled,
+                                         payloadSize)];
+  uint64_t payloadSymbNb = 8 + uint64_t (ceil) * (txParams.codingRate + 4);
+
+  // Work in quarters of a symbol to account for the 4.25 symbols of the
+  // preamble, and round to the closest nanosecond:
+  // t = nQuarters * 2^SF / (4 * BW) seconds
+  uint64_t nQuarters = 4 * uint64_t (txParams.nPreamble) + 17 + 4 * payloadSymbNb;
+  uint64_t num = (nQuarters << txParams.sf) * 1000000000ULL;
+  uint64_t den = 4 * uint64_t (bandwidthHz);
+
+  return NanoSeconds ((num + den / 2) / den);
+}
+
+Time
+LoraAirtimeTable::ComputeOnAirTime (uint32_t payloadSize,
+                                    const LoraTxParameters &txParams)
+{
+  NS_LOG_FUNCTION (payloadSize << txParams);
+
+  // The contents of this function are based on [1].
+  // [1] SX1272 LoRa modem designer's guide.
+
+  // Compute the symbol duration
+  // Bandwidth is in Hz
+  double tSym = std::pow (2, int(txParams.sf)) / (txParams.bandwidthHz);
+
+  // Compute the preamble duration
+  double tPreamble = (double(txParams.nPreamble) + 4.25) * tSym;
+
+  // Payload size
+  double pl = payloadSize;      // Size in bytes
+  NS_LOG_DEBUG ("Packet of size " << payloadSize << " bytes");
+
+  // This step is needed since the formula deals with double values.
+  // de = 1 when the low data rate optimization is enabled, 0 otherwise
+  // h = 1 when header is implicit, 0 otherwise
+  double de = txParams.lowDataRateOptimizationEnabled ? 1 : 0;
+  double h = txParams.headerDisabled ? 1 : 0;
+  double crc = txParams.crcEnabled ? 1 : 0;
+
+  // num and den refer to numerator and denominator of the time on air formula
+  double num = 8 * pl - 4 * txParams.sf + 28 + 16 * crc - 20 * h;
+  double den = 4 * (txParams.sf - 2 * de);
+  double payloadSymbNb = 8 + std::max (std::ceil (num / den) *
+                                       (txParams.codingRate + 4), double(0));
+
+  // Time to transmit the payload
+  double tPayload = payloadSymbNb * tSym;
+
+  NS_LOG_DEBUG ("Time computation: num = " << num << ", den = " << den <<
+                ", payloadSymbNb = " << payloadSymbNb << ", tSym = " << tSym);
+  NS_LOG_DEBUG ("tPreamble = " << tPreamble);
+  NS_LOG_DEBUG ("tPayload = " << tPayload);
+  NS_LOG_DEBUG ("Total time = " << tPreamble + tPayload);
+
+  // Compute and return the total packet on-air time
+  return Seconds (tPreamble + tPayload);
+}
+
+std::ostream &operator << (std::ostream &os, const LoraTxParameters &params)
+{
+  os << "SF: " << unsigned(params.sf) <<
+    ", headerDisabled: " << params.headerDisabled <<
+    ", codingRate: " << unsigned(params.codingRate) <<
+    ", bandwidthHz: " << params.bandwidthHz <<
+    ", nPreamble: " << params.nPreamble <<
+    ", crcEnabled: " << params.crcEnabled <<
+    ", lowDataRateOptimizationEnabled: " << params.lowDataRateOptimizationEnabled <<
+    ")";
+
+  return os;
+}
+
+}
+}
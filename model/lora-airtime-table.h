@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_AIRTIME_TABLE_H
+#define LORA_AIRTIME_TABLE_H
+
+#include "ns3/nstime.h"
+#include <ostream>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Structure to collect all parameters that are used to compute the duration of
+ * a packet (excluding payload length).
+ */
+struct LoraTxParameters
+{
+  uint8_t sf = 7;     //!< Spreading Factor
+  bool headerDisabled = 0;     //!< Whether to use implicit header mode
+  uint8_t codingRate = 1;     //!< Code rate (obtained as 4/(codingRate+4))
+  double bandwidthHz = 125000;     //!< Bandwidth in Hz
+  uint32_t nPreamble = 8;     //!< Number of preamble symbols
+  bool crcEnabled = 1;     //!< Whether Cyclic Redundancy Check is enabled
+  bool lowDataRateOptimizationEnabled = 0;     //!< Whether Low Data Rate Optimization is enabled
+};
+
+/**
+ * Allow logging of LoraTxParameters like with any other data type.
+ */
+std::ostream &operator << (std::ostream &os, const LoraTxParameters &params);
+
+/**
+ * \ingroup lorawan
+ *
+ * Precomputed time on air of LoRa packets.
+ *
+ * The time on air of a packet is (nPreamble + 4.25 + nPayload) * tSym, where
+ * tSym = 2^SF / BW and nPayload, the number of payload symbols, only depends
+ * on the SF, the coding rate, the header mode, the CRC, the low data rate
+ * optimization and the payload length. The ceiling term of nPayload is
+ * precomputed for all combinations of these parameters the first time the
+ * table is used, so that a lookup only takes a few integer operations. The
+ * result is computed in integer nanoseconds, and is exact whenever the
+ * bandwidth is an integer number of Hz.
+ *
+ * This class does not depend on any PHY instance, and can be used by tools
+ * that need to plan transmissions without setting up a simulation.
+ */
+class LoraAirtimeTable
+{
+public:
+  /**
+   * Get the time that a packet with certain characteristics will take to be
+   * transmitted.
+   *
+   * Parameter combinations the table does not cover (SF outside [6, 12],
+   * coding rate outside [1, 4], payloads longer than 255 bytes, very long
+   * preambles or non-integer bandwidths) fall back to ComputeOnAirTime.
+   *
+   * \param payloadSize The size of the PHY payload, in bytes.
+   * \param txParams The set of parameters that will be used for transmission.
+   * \return The time necessary to transmit the packet.
+   */
+  static Time GetOnAirTime (uint32_t payloadSize, const LoraTxParameters &txParams);
+
+  /**
+   * Compute the time on air of a packet with the closed-form formula of the
+   * SX1272 LoRa modem designer's guide, without using the table.
+   *
+   * \param payloadSize The size of the PHY payload, in bytes.
+   * \param txParams The set of parameters that will be used for transmission.
+   * \return The time necessary to transmit the packet.
+   */
+  static Time ComputeOnAirTime (uint32_t payloadSize, const LoraTxParameters &txParams);
+
+  static const uint8_t MIN_SF = 6;    //!< Smallest SF covered by the table
+  static const uint8_t MAX_SF = 12;   //!< Largest SF covered by the table
+  static const uint32_t MAX_PAYLOAD_SIZE = 255;   //!< Largest payload covered by the table
+  static const uint32_t MAX_PREAMBLE = 65535;   //!< Longest preamble covered by the table
+
+private:
+  LoraAirtimeTable ();
+
+  /**
+   * Get the instance holding the table, building it on first use.
+   */
+  static const LoraAirtimeTable & Get (void);
+
+  /**
+   * Get the index in m_ceil corresponding to a certain set of parameters.
+   */
+  static uint32_t GetIndex (uint8_t sf, bool de, bool h, bool crc,
+                            uint32_t payloadSize);
+
+  /**
+   * The ceiling term of the number of payload symbols, before multiplication
+   * by (codingRate + 4), indexed by GetIndex.
+   */
+  uint8_t m_ceil[(MAX_SF - MIN_SF + 1) * 2 * 2 * 2 * (MAX_PAYLOAD_SIZE + 1)];
+};
+
+}
+
+}
+#endif /* LORA_AIRTIME_TABLE_H */
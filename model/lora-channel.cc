@@ -19,8 +19,11 @@
  */
 
 #include "ns3/lora-channel.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-counters.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/nstime.h"
 #include "ns3/object-factory.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
@@ -52,6 +55,14 @@ LoraChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&LoraChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("PositionSnapshotInterval",
+                   "How long the position of a PHY is reused by later "
+                   "transmissions before it is read again from its mobility "
+                   "model. Zero means that positions are read at every "
+                   "transmission.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&LoraChannel::m_snapshotInterval),
+                   MakeTimeChecker (Seconds (0)))
     .AddTraceSource ("PacketSent",
                      "Trace source fired whenever a packet goes out on the channel",
                      MakeTraceSourceAccessor (&LoraChannel::m_packetSent),
@@ -60,6 +71,8 @@ LoraChannel::GetTypeId (void)
 }
 
 LoraChannel::LoraChannel ()
+  : m_snapshotInterval (Seconds (0)),
+  m_invalidateScheduled (false)
 {
 }
 
@@ -71,7 +84,9 @@ LoraChannel::~LoraChannel ()
 LoraChannel::LoraChannel (Ptr<PropagationLossModel> loss,
                           Ptr<PropagationDelayModel> delay) :
   m_loss (loss),
-  m_delay (delay)
+  m_delay (delay),
+  m_snapshotInterval (Seconds (0)),
+  m_invalidateScheduled (false)
 {
 }
 
@@ -82,6 +97,11 @@ LoraChannel::Add (Ptr<LoraPhy> phy)
 
   // Add the new phy to the vector
   m_phyList.push_back (phy);
+
+  // Its position is read at the next transmission
+  PositionSnapshot snapshot;
+  snapshot.timeStep = -1;
+  m_positions.push_back (snapshot);
 }
 
 void
@@ -89,8 +109,10 @@ LoraChannel::Remove (Ptr<LoraPhy> phy)
 {
   NS_LOG_FUNCTION (this << phy);
 
-  // Remove the phy from the vector
-  m_phyList.erase (find (m_phyList.begin (), m_phyList.end (), phy));
+  // Remove the phy from the vector, with its position
+  std::vector<Ptr<LoraPhy> >::iterator it = find (m_phyList.begin (), m_phyList.end (), phy);
+  m_positions.erase (m_positions.begin () + (it - m_phyList.begin ()));
+  m_phyList.erase (it);
 }
 
 std::size_t
@@ -112,40 +134,70 @@ LoraChannel::Send (Ptr< LoraPhy > sender, Ptr< Packet > packet,
 {
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << txParams <<
                    duration << frequencyMHz);
+  LORA_PROFILE_SCOPE (CHANNEL_SEND);
+  LORA_COUNTER_INCREMENT (CHANNEL_TRANSMISSIONS);
 
   // Get the mobility model of the sender
-  Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
+  Ptr<MobilityModel> senderMobility = sender->GetMobility ();
 
   NS_ASSERT (senderMobility != 0);     // Make sure it's available
 
+  Vector senderPosition = senderMobility->GetPosition ();
+
   NS_LOG_INFO ("Starting cycle over all " << m_phyList.size () << " PHYs");
-  NS_LOG_INFO ("Sender mobility: " << senderMobility->GetPosition ());
+  NS_LOG_INFO ("Sender mobility: " << senderPosition);
+
+  // A composite loss model computes the power of all receivers at once
+  CompositeLoraPropagationLossModel *composite =
+    dynamic_cast<CompositeLoraPropagationLossModel *> (PeekPointer (m_loss));
+  if (composite != 0)
+    {
+      m_receivers.clear ();
+      for (uint32_t j = 0; j < m_phyList.size (); j++)
+        {
+          if (sender != m_phyList[j])
+            {
+              m_receivers.push_back (GetEndpoint (j, composite));
+            }
+        }
+      composite->CalcRxPowers (txPowerDbm,
+                               composite->GetEndpoint (senderMobility, senderPosition),
+                               m_receivers, m_rxPowers);
+    }
+
+  // A constant speed delay only depends on the distance, which is computed
+  // from the snapshot
+  ConstantSpeedPropagationDelayModel *constantSpeed =
+    dynamic_cast<ConstantSpeedPropagationDelayModel *> (PeekPointer (m_delay));
 
   // Cycle over all registered PHYs
   uint32_t j = 0;
+  uint32_t nReceiveEvents = 0;
   std::vector<Ptr<LoraPhy> >::const_iterator i;
   for (i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
     {
       // Do not deliver to the sender (*i is the current PHY)
       if (sender != (*i))
         {
-          // Get the receiver's mobility model
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->
-            GetObject<MobilityModel> ();
+          // Get the receiver's mobility model and position
+          const CompositeLoraPropagationLossModel::Endpoint &receiver =
+            composite != 0 ? m_receivers[nReceiveEvents] : GetEndpoint (j, 0);
 
-          NS_LOG_INFO ("Receiver mobility: " <<
-                       receiverMobility->GetPosition ());
+          NS_LOG_INFO ("Receiver mobility: " << receiver.position);
 
           // Compute delay using the delay model
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+          Time delay = constantSpeed != 0 ?
+            Seconds (CalculateDistance (senderPosition, receiver.position) /
+                     constantSpeed->GetSpeed ()) :
+            m_delay->GetDelay (senderMobility, receiver.mobility);
 
           // Compute received power using the loss model
-          double rxPowerDbm = GetRxPower (txPowerDbm, senderMobility,
-                                          receiverMobility, txParams.sf);
+          double rxPowerDbm = composite != 0 ? m_rxPowers[nReceiveEvents] :
+            GetRxPower (txPowerDbm, senderMobility, receiver.mobility, txParams.sf);
 
           NS_LOG_DEBUG ("Propagation: txPower=" << txPowerDbm <<
                         "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) <<
+                        "distance=" << CalculateDistance (senderPosition, receiver.position) <<
                         "m, delay=" << delay);
 
           // Get the id of the destination PHY to correctly format the context
@@ -173,11 +225,15 @@ LoraChannel::Send (Ptr< LoraPhy > sender, Ptr< Packet > packet,
           NS_LOG_INFO ("Scheduling reception of the packet");
           Simulator::ScheduleWithContext (dstNode, delay, &LoraChannel::Receive,
                                           this, j, packet, parameters);
+          nReceiveEvents++;
 
           // Fire the trace source for sent packet
           m_packetSent (packet);
         }
     }
+
+  LORA_COUNTER_ADD (CHANNEL_RECEIVE_EVENTS, nReceiveEvents);
+  LORA_HISTOGRAM_RECORD (RECEIVE_EVENTS_PER_TRANSMISSION, nReceiveEvents);
 }
 
 void
@@ -191,6 +247,54 @@ LoraChannel::Receive (uint32_t i, Ptr<Packet> packet,
                               parameters.duration, parameters.frequencyMHz);
 }
 
+const CompositeLoraPropagationLossModel::Endpoint &
+LoraChannel::GetEndpoint (uint32_t i,
+                          const CompositeLoraPropagationLossModel *composite) const
+{
+  // Without a snapshot interval, positions are read at every transmission
+  PositionSnapshot &snapshot = m_positions[i];
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  if (!m_snapshotInterval.IsStrictlyPositive () || snapshot.timeStep < 0
+      || now - snapshot.timeStep > m_snapshotInterval.GetTimeStep ())
+    {
+      Ptr<MobilityModel> mobility = m_phyList[i]->GetMobility ();
+      NS_ASSERT (mobility != 0);
+      if (composite != 0)
+        {
+          snapshot.endpoint = composite->GetEndpoint (mobility, mobility->GetPosition ());
+        }
+      else
+        {
+          snapshot.endpoint.mobility = mobility;
+          snapshot.endpoint.position = mobility->GetPosition ();
+          snapshot.endpoint.building = BuildingPenetrationLoss::UNKNOWN_NODE;
+        }
+      snapshot.timeStep = now;
+
+      // A later run starts again from time zero, and must not see the
+      // positions of this one
+      if (m_snapshotInterval.IsStrictlyPositive () && !m_invalidateScheduled)
+        {
+          Simulator::ScheduleDestroy (&LoraChannel::InvalidatePositions,
+                                      Ptr<const LoraChannel> (this));
+          m_invalidateScheduled = true;
+        }
+    }
+  return snapshot.endpoint;
+}
+
+void
+LoraChannel::InvalidatePositions (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  for (uint32_t i = 0; i < m_positions.size (); i++)
+    {
+      m_positions[i].timeStep = -1;
+    }
+  m_invalidateScheduled = false;
+}
+
 double
 LoraChannel::GetRxPower (double txPowerDbm, Ptr<MobilityModel> senderMobility,
                          Ptr<MobilityModel> receiverMobility) const
@@ -218,6 +322,12 @@ LoraChannel::UpdateLossSF (uint8_t sf) const
   }
 }
 
+Ptr<PropagationLossModel>
+LoraChannel::GetPropagationLossModel (void) const
+{
+  return m_loss;
+}
+
 std::ostream &operator << (std::ostream &os, const LoraChannelParameters &params)
 {
   os << "(rxPowerDbm: " << params.rxPowerDbm << ", SF: " << unsigned(params.sf) <<
@@ -31,6 +31,7 @@
 #include "ns3/net-device.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/lora-propagation-loss-model.h"
+#include "ns3/composite-lora-propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
 #include "ns3/logical-lora-channel.h"
 #include "ns3/packet.h"
@@ -70,6 +71,19 @@ std::ostream &operator << (std::ostream &os, const LoraChannelParameters &params
  * computing the power at every receiver using a PropagationLossModel and
  * notifying them of the reception event after a delay based on some
  * PropagationDelayModel.
+ *
+ * By default, the positions of the connected PHYs are read from their
+ * mobility models at every transmission. If the PositionSnapshotInterval
+ * attribute is positive, they are instead kept in a snapshot, and the
+ * position of a PHY is only read again by the first transmission after the
+ * interval elapsed, so that the transmissions of a busy network don't
+ * integrate the mobility models of all receivers again. This trades the
+ * accuracy of the positions for speed: a PHY that moves within the interval
+ * is seen at its old position. The snapshot is discarded when the simulator
+ * is destroyed, so that a later run reads the positions again.
+ * The positions are used by the
+ * CompositeLoraPropagationLossModel and the ConstantSpeedPropagationDelayModel,
+ * while other models read the positions from the mobility models themselves.
  */
 class LoraChannel : public Channel
 {
@@ -158,6 +172,13 @@ public:
 
   void UpdateLossSF (uint8_t sf) const;
 
+  /**
+   * Get the loss model used by this channel.
+   *
+   * \return The first model of the loss model chain.
+   */
+  Ptr<PropagationLossModel> GetPropagationLossModel (void) const;
+
 private:
   /**
     * Private method that is scheduled by LoraChannel's Send method to happen
@@ -173,6 +194,33 @@ private:
   void Receive (uint32_t i, Ptr<Packet> packet,
                 LoraChannelParameters parameters) const;
 
+  /**
+   * Get the mobility model and the position of a connected PHY, reading them
+   * again if the snapshot is out of date.
+   *
+   * \param i The index of the PHY.
+   * \param composite The loss model, if it is a composite one, which also
+   * fills in the building of the end point.
+   * \return The end point of the PHY.
+   */
+  const CompositeLoraPropagationLossModel::Endpoint &
+  GetEndpoint (uint32_t i, const CompositeLoraPropagationLossModel *composite) const;
+
+  /**
+   * Mark all positions of the snapshot as never read, when the simulator is
+   * destroyed.
+   */
+  void InvalidatePositions (void) const;
+
+  /**
+   * The position of a PHY, as read at some time.
+   */
+  struct PositionSnapshot
+  {
+    CompositeLoraPropagationLossModel::Endpoint endpoint; //!< The PHY's end point
+    int64_t timeStep; //!< When the position was read, or -1 if it never was
+  };
+
   /**
     * The vector containing the PHYs that are currently connected to the
     * channel.
@@ -197,6 +245,34 @@ private:
    */
   TracedCallback<Ptr<const Packet> > m_packetSent;
 
+  /**
+   * The receivers of the transmission being sent, if the loss model is a
+   * CompositeLoraPropagationLossModel.
+   */
+  mutable std::vector<CompositeLoraPropagationLossModel::Endpoint> m_receivers;
+
+  /**
+   * The power received by each of m_receivers.
+   */
+  mutable std::vector<double> m_rxPowers;
+
+  /**
+   * The positions of the PHYs of m_phyList, in the same order.
+   */
+  mutable std::vector<PositionSnapshot> m_positions;
+
+  /**
+   * How long a position is used before it is read again. Zero means that
+   * positions are read at every transmission.
+   */
+  Time m_snapshotInterval;
+
+  /**
+   * Whether InvalidatePositions is scheduled to run when the simulator is
+   * destroyed.
+   */
+  mutable bool m_invalidateScheduled;
+
 };
 
 } /* namespace ns3 */
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-counter-rng.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/lora-flat-hash-map.h"
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+namespace {
+
+/**
+ * The splitmix64 generator, used to mix the inputs of the key.
+ */
+uint64_t
+Mix (uint64_t value)
+{
+  return LoraHashMix (value + 0x9e3779b97f4a7c15ULL);
+}
+
+}
+
+LoraCounterRng::LoraCounterRng (Component component)
+  : m_stream (0),
+  m_component (component)
+{
+  UpdateKey ();
+}
+
+void
+LoraCounterRng::SetStream (int64_t stream)
+{
+  m_stream = stream;
+  UpdateKey ();
+}
+
+int64_t
+LoraCounterRng::GetStream (void) const
+{
+  return m_stream;
+}
+
+void
+LoraCounterRng::UpdateKey (void)
+{
+  uint64_t key = Mix (RngSeedManager::GetSeed ());
+  key = Mix (key ^ RngSeedManager::GetRun ());
+  key = Mix (key ^ m_component);
+  key = Mix (key ^ uint64_t (m_stream));
+  m_key[0] = uint32_t (key);
+  m_key[1] = uint32_t (key >> 32);
+}
+
+void
+LoraCounterRng::Philox (const uint32_t counter[4], const uint32_t key[2],
+                        uint32_t values[4])
+{
+  uint32_t c0 = counter[0];
+  uint32_t c1 = counter[1];
+  uint32_t c2 = counter[2];
+  uint32_t c3 = counter[3];
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+
+  for (int round = 0; round < 10; round++)
+    {
+      uint64_t p0 = uint64_t (0xD2511F53) * c0;
+      uint64_t p1 = uint64_t (0xCD9E8D57) * c2;
+      c0 = uint32_t (p1 >> 32) ^ c1 ^ k0;
+      c1 = uint32_t (p1);
+      c2 = uint32_t (p0 >> 32) ^ c3 ^ k1;
+      c3 = uint32_t (p0);
+
+      // The Weyl sequence of the key schedule
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+
+  values[0] = c0;
+  values[1] = c1;
+  values[2] = c2;
+  values[3] = c3;
+}
+
+void
+LoraCounterRng::Generate (uint64_t id, uint64_t counter, uint32_t values[4]) const
+{
+  uint32_t words[4] = {uint32_t (id), uint32_t (id >> 32),
+                       uint32_t (counter), uint32_t (counter >> 32)};
+  Philox (words, m_key, values);
+}
+
+double
+LoraCounterRng::GetUniform (uint64_t id, uint64_t counter) const
+{
+  uint32_t values[4];
+  Generate (id, counter, values);
+  uint64_t bits = ((uint64_t (values[0]) << 32) | values[1]) >> 11;
+  return bits * (1.0 / 9007199254740992.0); // 2^-53
+}
+
+double
+LoraCounterRng::GetUniform (double min, double max, uint64_t id,
+                            uint64_t counter) const
+{
+  return min + (max - min) * GetUniform (id, counter);
+}
+
+double
+LoraCounterRng::GetNormal (double mean, double variance, uint64_t id,
+                           uint64_t counter) const
+{
+  uint32_t values[4];
+  Generate (id, counter, values);
+  uint64_t bits1 = ((uint64_t (values[0]) << 32) | values[1]) >> 11;
+  uint64_t bits2 = ((uint64_t (values[2]) << 32) | values[3]) >> 11;
+
+  // u1 is in (0, 1], so that its logarithm is finite
+  double u1 = (bits1 + 1) * (1.0 / 9007199254740992.0);
+  double u2 = bits2 * (1.0 / 9007199254740992.0);
+  double z = std::sqrt (-2 * std::log (u1)) * std::cos (2 * M_PI * u2);
+  return mean + std::sqrt (variance) * z;
+}
+
+}
+}
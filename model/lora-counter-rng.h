@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_COUNTER_RNG_H
+#define LORA_COUNTER_RNG_H
+
+#include <stdint.h>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A counter-based random number generator, which computes each value as a
+ * function of a key and a counter instead of advancing a stream.
+ *
+ * Values are computed with the Philox4x32-10 bijection of J. K. Salmon et
+ * al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011, which
+ * scrambles a 128 bit counter into four 32 bit words under a 64 bit key. The
+ * key is derived from the seed and run of RngSeedManager, read when the
+ * generator is created or its stream is set, from the component that draws
+ * the values and from the stream. The counter is made of an identifier,
+ * such as a node id, and an event counter, both chosen by the component.
+ *
+ * A value thus only depends on what it is drawn for, and not on the draws
+ * made before it by the same or other components, so that it can be drawn in
+ * any order, or by several threads, and still be reproduced. A generator
+ * only holds its key, and can be stored by value in each object that needs
+ * one.
+ */
+class LoraCounterRng
+{
+public:
+  /**
+   * The components that draw values. Each has its own key, so that their
+   * values are independent even for the same identifiers and counters.
+   */
+  enum Component
+  {
+    END_DEVICE_MAC = 1,
+    CORRELATED_SHADOWING = 2,
+    BUILDING_PENETRATION = 3
+  };
+
+  /**
+   * Create a generator for a component, on stream 0.
+   */
+  LoraCounterRng (Component component);
+
+  /**
+   * Set the stream, like RandomVariableStream::SetStream. Generators of the
+   * same component and stream draw the same values.
+   */
+  void SetStream (int64_t stream);
+
+  /**
+   * \return The stream.
+   */
+  int64_t GetStream (void) const;
+
+  /**
+   * Compute the four random words of an identifier and a counter.
+   */
+  void Generate (uint64_t id, uint64_t counter, uint32_t values[4]) const;
+
+  /**
+   * \return A value uniformly distributed in [0, 1), with 53 random bits.
+   */
+  double GetUniform (uint64_t id, uint64_t counter) const;
+
+  /**
+   * \return A value uniformly distributed in [min, max).
+   */
+  double GetUniform (double min, double max, uint64_t id, uint64_t counter) const;
+
+  /**
+   * \return A normally distributed value, computed with the Box-Muller
+   * transform from the four words of a single counter.
+   */
+  double GetNormal (double mean, double variance, uint64_t id, uint64_t counter) const;
+
+  /**
+   * Apply the Philox4x32-10 bijection.
+   *
+   * \param counter The counter.
+   * \param key The key.
+   * \param values Set to the random words.
+   */
+  static void Philox (const uint32_t counter[4], const uint32_t key[2],
+                      uint32_t values[4]);
+
+private:
+  /**
+   * Derive the key from the seed, the run, the component and the stream.
+   */
+  void UpdateKey (void);
+
+  uint32_t m_key[2]; //!< The Philox key
+  int64_t m_stream; //!< The stream
+  Component m_component; //!< The component that draws the values
+};
+
+}
+
+}
+#endif /* LORA_COUNTER_RNG_H */
@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-counters.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <fstream>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraCounters");
+
+LoraCounters::Snapshot LoraCounters::s_state = LoraCounters::Snapshot ();
+
+uint64_t
+LoraCounters::Get (Counter counter)
+{
+  return s_state.counters[counter];
+}
+
+uint64_t
+LoraCounters::Get (Histogram histogram, uint32_t bucket)
+{
+  NS_ASSERT (bucket < N_BUCKETS);
+  return s_state.histograms[histogram][bucket];
+}
+
+uint64_t
+LoraCounters::GetBucketLowerBound (uint32_t bucket)
+{
+  NS_ASSERT (bucket < N_BUCKETS);
+  return bucket == 0 ? 0 : uint64_t (1) << (bucket - 1);
+}
+
+LoraCounters::Snapshot
+LoraCounters::GetSnapshot (void)
+{
+  return s_state;
+}
+
+void
+LoraCounters::Reset (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  s_state = Snapshot ();
+}
+
+std::string
+LoraCounters::GetName (Counter counter)
+{
+  switch (counter)
+    {
+    case CHANNEL_TRANSMISSIONS:
+      return "LoraChannel/transmissions";
+    case CHANNEL_RECEIVE_EVENTS:
+      return "LoraChannel/receiveEvents";
+    case INTERFERENCE_CHECKS:
+      return "LoraInterferenceHelper/checks";
+    case GATEWAY_LOCKED_RECEPTIONS:
+      return "SimpleGatewayLoraPhy/lockedReceptions";
+    case GATEWAY_NO_MORE_DEMODULATORS:
+      return "SimpleGatewayLoraPhy/noMoreDemodulators";
+    case HEADER_VIEW_PEEKS:
+      return "LoraHeaderView/peeks";
+    case FRAME_HEADER_DESERIALIZATIONS:
+      return "LoraFrameHeader/deserializations";
+    case NETWORK_SERVER_UPLINKS:
+      return "NetworkServer/uplinks";
+    case DUTY_CYCLE_POSTPONEMENTS:
+      return "EndDeviceLoraMac/dutyCyclePostponements";
+    case DUTY_CYCLE_BLOCKED:
+      return "EndDeviceLoraMac/dutyCycleBlocked";
+    case PACKET_COPIES:
+      return "Packet/copies";
+    default:
+      return "unknown";
+    }
+}
+
+std::string
+LoraCounters::GetName (Histogram histogram)
+{
+  switch (histogram)
+    {
+    case RECEIVE_EVENTS_PER_TRANSMISSION:
+      return "LoraChannel/receiveEventsPerTransmission";
+    case INTERFERENCE_EVENTS:
+      return "LoraInterferenceHelper/events";
+    case DEMODULATOR_OCCUPANCY:
+      return "SimpleGatewayLoraPhy/demodulatorOccupancy";
+    case HEADER_PARSES_PER_UPLINK:
+      return "NetworkServer/headerParsesPerUplink";
+    default:
+      return "unknown";
+    }
+}
+
+bool
+LoraCounters::IsEnabled (void)
+{
+#ifdef NS3_LORA_COUNTERS
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+LoraCounters::Dump (std::ostream &os)
+{
+  for (uint32_t c = 0; c < N_COUNTERS; c++)
+    {
+      os << GetName (Counter (c)) << " " << s_state.counters[c] << std::endl;
+    }
+  for (uint32_t h = 0; h < N_HISTOGRAMS; h++)
+    {
+      os << GetName (Histogram (h));
+      for (uint32_t b = 0; b < N_BUCKETS; b++)
+        {
+          if (s_state.histograms[h][b] > 0)
+            {
+              os << " " << GetBucketLowerBound (b) <<
+                (b == N_BUCKETS - 1 ? "+" : "") << ":" << s_state.histograms[h][b];
+            }
+        }
+      os << std::endl;
+    }
+}
+
+void
+LoraCounters::DumpAtDestroy (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+
+  Simulator::ScheduleDestroy (&LoraCounters::DoDumpToFile, filename);
+}
+
+void
+LoraCounters::DoDumpToFile (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+
+  std::ofstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open file " << filename);
+      return;
+    }
+  Dump (file);
+}
+
+////////////////////////
+// LoraCounterSampler //
+////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (LoraCounterSampler);
+
+TypeId
+LoraCounterSampler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LoraCounterSampler")
+    .SetParent<Object> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<LoraCounterSampler> ()
+    .AddAttribute ("Interval",
+                   "The time between two samples of the counters",
+                   TimeValue (Seconds (60)),
+                   MakeTimeAccessor (&LoraCounterSampler::m_interval),
+                   MakeTimeChecker ())
+    .AddTraceSource ("Sample",
+                     "The values of the LoraCounters, sampled periodically",
+                     MakeTraceSourceAccessor (&LoraCounterSampler::m_sample),
+                     "ns3::LoraCounterSampler::SampleTracedCallback")
+  ;
+  return tid;
+}
+
+LoraCounterSampler::LoraCounterSampler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LoraCounterSampler::~LoraCounterSampler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LoraCounterSampler::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_nextSample);
+  m_nextSample = Simulator::Schedule (m_interval, &LoraCounterSampler::Sample,
+                                      this);
+}
+
+void
+LoraCounterSampler::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_nextSample);
+}
+
+void
+LoraCounterSampler::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Stop ();
+  Object::DoDispose ();
+}
+
+void
+LoraCounterSampler::Sample (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_sample (Simulator::Now (), LoraCounters::GetSnapshot ());
+  m_nextSample = Simulator::Schedule (m_interval, &LoraCounterSampler::Sample,
+                                      this);
+}
+
+}
+}
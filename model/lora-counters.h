@@ -0,0 +1,252 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_COUNTERS_H
+#define LORA_COUNTERS_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+#include <ostream>
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A module-level registry of counters and histograms that describe the work
+ * done in the hot paths of the LoRaWAN stack, so that the runtime of a
+ * simulation can be attributed without an external profiler.
+ *
+ * Counters are plain 64-bit integers, since the simulator is single-threaded.
+ * Histograms have a fixed number of buckets with power-of-two bounds: bucket
+ * 0 holds value 0, bucket k holds values in [2^(k-1), 2^k - 1], and the last
+ * bucket also holds all larger values.
+ *
+ * The module updates the registry through the LORA_COUNTER_* macros, which
+ * are compiled out when the module is configured with
+ * --disable-lora-counters. The registry itself is always available, so that
+ * code reading it builds in both configurations.
+ */
+class LoraCounters
+{
+public:
+  /**
+   * The counters, named after the component that updates them.
+   */
+  enum Counter
+  {
+    CHANNEL_TRANSMISSIONS, //!< Calls to LoraChannel::Send
+    CHANNEL_RECEIVE_EVENTS, //!< LoraChannel::Receive events scheduled
+    INTERFERENCE_CHECKS, //!< Calls to IsDestroyedByInterference
+    GATEWAY_LOCKED_RECEPTIONS, //!< Receptions that locked a demodulator
+    GATEWAY_NO_MORE_DEMODULATORS, //!< Receptions lost for lack of demodulators
+    HEADER_VIEW_PEEKS, //!< Headers read through LoraHeaderView
+    FRAME_HEADER_DESERIALIZATIONS, //!< Calls to LoraFrameHeader::Deserialize
+    NETWORK_SERVER_UPLINKS, //!< Packets received by the NetworkServer
+    DUTY_CYCLE_POSTPONEMENTS, //!< End device transmissions postponed
+    DUTY_CYCLE_BLOCKED, //!< End device transmissions with no free channel
+    PACKET_COPIES, //!< Packets copied by the MAC, forwarder and network server
+    N_COUNTERS
+  };
+
+  /**
+   * The histograms, named after the component that updates them.
+   */
+  enum Histogram
+  {
+    RECEIVE_EVENTS_PER_TRANSMISSION, //!< Receive events of each Send
+    INTERFERENCE_EVENTS, //!< Events stored at each interference check
+    DEMODULATOR_OCCUPANCY, //!< Occupied demodulators after each lock
+    HEADER_PARSES_PER_UPLINK, //!< Header parses of each NetworkServer::Receive
+    N_HISTOGRAMS
+  };
+
+  static const uint32_t N_BUCKETS = 16; //!< Buckets of each histogram
+
+  /**
+   * The values of all counters and histograms at a given time.
+   */
+  struct Snapshot
+  {
+    uint64_t counters[N_COUNTERS];
+    uint64_t histograms[N_HISTOGRAMS][N_BUCKETS];
+  };
+
+  /**
+   * Add to a counter.
+   */
+  static void
+  Increment (Counter counter, uint64_t value = 1)
+  {
+    s_state.counters[counter] += value;
+  }
+
+  /**
+   * Add a value to a histogram.
+   */
+  static void
+  Record (Histogram histogram, uint64_t value)
+  {
+    s_state.histograms[histogram][GetBucket (value)]++;
+  }
+
+  /**
+   * \return The value of a counter.
+   */
+  static uint64_t Get (Counter counter);
+
+  /**
+   * \return The number of values in a bucket of a histogram.
+   */
+  static uint64_t Get (Histogram histogram, uint32_t bucket);
+
+  /**
+   * \return The bucket a value falls in.
+   */
+  static uint32_t
+  GetBucket (uint64_t value)
+  {
+    // The bucket is the number of significant bits of the value
+    uint32_t bucket = 0;
+    while (value > 0 && bucket < N_BUCKETS - 1)
+      {
+        value >>= 1;
+        bucket++;
+      }
+    return bucket;
+  }
+
+  /**
+   * \return The smallest value that falls in a bucket.
+   */
+  static uint64_t GetBucketLowerBound (uint32_t bucket);
+
+  /**
+   * \return The current value of all counters and histograms.
+   */
+  static Snapshot GetSnapshot (void);
+
+  /**
+   * Set all counters and histograms to zero.
+   */
+  static void Reset (void);
+
+  /**
+   * \return The name of a counter, in the Component/counter form.
+   */
+  static std::string GetName (Counter counter);
+
+  /**
+   * \return The name of a histogram, in the Component/histogram form.
+   */
+  static std::string GetName (Histogram histogram);
+
+  /**
+   * \return Whether the module updates the counters, i.e., whether they were
+   * compiled in.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * Print all counters, and the non-empty buckets of all histograms.
+   */
+  static void Dump (std::ostream &os);
+
+  /**
+   * Write the counters to a file when Simulator::Destroy is called.
+   */
+  static void DumpAtDestroy (std::string filename);
+
+private:
+  static void DoDumpToFile (std::string filename);
+
+  static Snapshot s_state; //!< The current values
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * Samples the LoraCounters periodically, and reports their values through a
+ * trace source.
+ */
+class LoraCounterSampler : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LoraCounterSampler ();
+  virtual ~LoraCounterSampler ();
+
+  /**
+   * Start sampling, with the first sample one interval from now.
+   */
+  void Start (void);
+
+  /**
+   * Stop sampling.
+   */
+  void Stop (void);
+
+  /**
+   * TracedCallback signature for counter samples.
+   *
+   * \param [in] now The time of the sample.
+   * \param [in] snapshot The values of the counters.
+   */
+  typedef void (*SampleTracedCallback)(Time now,
+                                       const LoraCounters::Snapshot &snapshot);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void Sample (void);
+
+  Time m_interval; //!< The time between samples
+  EventId m_nextSample; //!< The next sample
+
+  TracedCallback<Time, const LoraCounters::Snapshot &> m_sample;
+};
+
+}
+
+}
+
+/**
+ * Update the LoraCounters, unless they are compiled out. Values are not
+ * evaluated when the counters are disabled, but still count as used, so that
+ * variables that only feed a counter don't cause warnings.
+ */
+#ifdef NS3_LORA_COUNTERS
+#define LORA_COUNTER_INCREMENT(counter) \
+  ns3::lorawan::LoraCounters::Increment (ns3::lorawan::LoraCounters::counter)
+#define LORA_COUNTER_ADD(counter, value) \
+  ns3::lorawan::LoraCounters::Increment (ns3::lorawan::LoraCounters::counter, value)
+#define LORA_HISTOGRAM_RECORD(histogram, value) \
+  ns3::lorawan::LoraCounters::Record (ns3::lorawan::LoraCounters::histogram, value)
+#else
+#define LORA_COUNTER_INCREMENT(counter) do { } while (false)
+#define LORA_COUNTER_ADD(counter, value) do { (void) sizeof (value); } while (false)
+#define LORA_HISTOGRAM_RECORD(histogram, value) do { (void) sizeof (value); } while (false)
+#endif
+
+#endif /* LORA_COUNTERS_H */
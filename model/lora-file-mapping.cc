@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-file-mapping.h"
+#include "ns3/log.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraFileMapping");
+
+LoraFileMapping::LoraFileMapping ()
+  : m_data (0),
+  m_size (0)
+{
+}
+
+LoraFileMapping::~LoraFileMapping ()
+{
+  Close ();
+}
+
+bool
+LoraFileMapping::Open (std::string filename, std::size_t minSize)
+{
+  NS_LOG_FUNCTION (this << filename << minSize);
+
+  Close ();
+
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_INFO ("Can't open " << filename);
+      return false;
+    }
+  struct stat status;
+  if (fstat (fd, &status) != 0 || std::size_t (status.st_size) < minSize
+      || status.st_size == 0)
+    {
+      NS_LOG_INFO (filename << " is too short");
+      close (fd);
+      return false;
+    }
+  std::size_t size = status.st_size;
+  void *data = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the descriptor is closed
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      NS_LOG_INFO ("Can't map " << filename);
+      return false;
+    }
+
+  m_data = data;
+  m_size = size;
+  return true;
+}
+
+void
+LoraFileMapping::Close (void)
+{
+  if (m_data != 0)
+    {
+      munmap (m_data, m_size);
+    }
+  m_data = 0;
+  m_size = 0;
+}
+
+bool
+LoraFileMapping::IsOpen (void) const
+{
+  return m_data != 0;
+}
+
+const uint8_t *
+LoraFileMapping::GetData (void) const
+{
+  return static_cast<const uint8_t *> (m_data);
+}
+
+std::size_t
+LoraFileMapping::GetSize (void) const
+{
+  return m_size;
+}
+
+}
+}
@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_FILE_MAPPING_H
+#define LORA_FILE_MAPPING_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A read-only memory mapping of a whole file, used by the models and helpers
+ * that load precomputed data without copying it.
+ *
+ * The mapping is shared, so that processes that map the same file share its
+ * pages through the page cache. It stays valid until the file is closed or
+ * another one is opened, and is released when the object is destroyed.
+ */
+class LoraFileMapping
+{
+public:
+  LoraFileMapping ();
+  ~LoraFileMapping ();
+
+  /**
+   * Map a file, replacing the current mapping.
+   *
+   * \param filename The file to map.
+   * \param minSize The minimum size of a valid file, e.g., the size of its
+   * header.
+   * \return false, with no file mapped, if the file can't be opened, is
+   * shorter than minSize or can't be mapped.
+   */
+  bool Open (std::string filename, std::size_t minSize);
+
+  /**
+   * Release the mapping, if any.
+   */
+  void Close (void);
+
+  /**
+   * \return Whether a file is mapped.
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * \return The first byte of the mapped file, or 0.
+   */
+  const uint8_t * GetData (void) const;
+
+  /**
+   * \return The size of the mapped file.
+   */
+  std::size_t GetSize (void) const;
+
+private:
+  LoraFileMapping (const LoraFileMapping &);
+  LoraFileMapping & operator= (const LoraFileMapping &);
+
+  void *m_data; //!< The mapping, or 0
+  std::size_t m_size; //!< The size of the mapping
+};
+
+}
+
+}
+#endif /* LORA_FILE_MAPPING_H */
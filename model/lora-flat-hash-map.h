@@ -0,0 +1,386 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_FLAT_HASH_MAP_H
+#define LORA_FLAT_HASH_MAP_H
+
+#include "ns3/assert.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * The finalizer of splitmix64, which spreads every bit of the value over the
+ * whole result. The Hash functors of LoraFlatHashMap are built on it.
+ *
+ * \param value The value to mix.
+ * \return The mixed value.
+ */
+inline uint64_t
+LoraHashMix (uint64_t value)
+{
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * Combine a value into a hash, to hash keys made of several fields.
+ *
+ * \param hash The hash of the previous fields.
+ * \param value The next field.
+ * \return The mixed hash of all the fields.
+ */
+inline uint64_t
+LoraHashCombine (uint64_t hash, uint64_t value)
+{
+  return LoraHashMix (hash ^ (value * 0x9e3779b97f4a7c15ULL));
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * An open-addressing hash map with an optional least-recently-used size cap,
+ * for the caches of the propagation models.
+ *
+ * Entries are stored contiguously and never move, while the table of slots
+ * only holds their indices and is probed linearly. Erasing an entry shifts
+ * the following slots of its probe sequence back, so that no tombstones are
+ * left and lookups stay short at any load. The table is kept at most three
+ * quarters full.
+ *
+ * If a maximum size is set, inserting a new key into a full map evicts the
+ * least recently used entry, where Find and Insert both count as a use.
+ *
+ * The Hash functor maps a Key to a uint64_t, and must mix its bits well,
+ * since the slot of a key is taken from the lowest bits of its hash.
+ */
+template <typename Key, typename Value, typename Hash>
+class LoraFlatHashMap
+{
+public:
+  LoraFlatHashMap ()
+    : m_maxSize (0),
+    m_evictions (0),
+    m_mostRecent (NONE),
+    m_leastRecent (NONE)
+  {
+    m_slots.assign (MIN_SLOTS, NONE);
+  }
+
+  /**
+   * Set the maximum number of entries, evicting the least recently used ones
+   * if the map is larger. Zero means no limit.
+   */
+  void
+  SetMaxSize (uint32_t maxSize)
+  {
+    m_maxSize = maxSize;
+    while (m_maxSize > 0 && GetSize () > m_maxSize)
+      {
+        Evict ();
+      }
+  }
+
+  uint32_t
+  GetMaxSize (void) const
+  {
+    return m_maxSize;
+  }
+
+  /**
+   * \return The number of entries in the map.
+   */
+  uint32_t
+  GetSize (void) const
+  {
+    return m_entries.size () - m_free.size ();
+  }
+
+  /**
+   * \return The number of entries evicted to respect the maximum size.
+   */
+  uint64_t
+  GetEvictions (void) const
+  {
+    return m_evictions;
+  }
+
+  /**
+   * Look up a key.
+   *
+   * \return A pointer to the value of the key, or 0 if the key is not in the
+   * map. The pointer is valid until the next call to Insert, Erase or Clear.
+   */
+  Value *
+  Find (const Key &key)
+  {
+    uint32_t slot = FindSlot (key, Hash () (key));
+    if (m_slots[slot] == NONE)
+      {
+        return 0;
+      }
+    Touch (m_slots[slot]);
+    return &m_entries[m_slots[slot]].value;
+  }
+
+  /**
+   * Insert a key, or replace its value if it is already in the map.
+   *
+   * \return A reference to the stored value, valid until the next call to
+   * Insert, Erase or Clear.
+   */
+  Value &
+  Insert (const Key &key, const Value &value)
+  {
+    uint64_t hash = Hash () (key);
+    uint32_t slot = FindSlot (key, hash);
+    if (m_slots[slot] != NONE)
+      {
+        Entry &entry = m_entries[m_slots[slot]];
+        entry.value = value;
+        Touch (m_slots[slot]);
+        return entry.value;
+      }
+
+    if (m_maxSize > 0 && GetSize () >= m_maxSize)
+      {
+        Evict ();
+        slot = FindSlot (key, hash);
+      }
+    if (4 * (GetSize () + 1) > 3 * m_slots.size ())
+      {
+        Rehash (2 * m_slots.size ());
+        slot = FindSlot (key, hash);
+      }
+
+    uint32_t index;
+    if (m_free.empty ())
+      {
+        index = m_entries.size ();
+        m_entries.push_back (Entry ());
+      }
+    else
+      {
+        index = m_free.back ();
+        m_free.pop_back ();
+      }
+    Entry &entry = m_entries[index];
+    entry.key = key;
+    entry.value = value;
+    entry.hash = hash;
+    entry.previous = NONE;
+    entry.next = NONE;
+    m_slots[slot] = index;
+    LinkFront (index);
+    return entry.value;
+  }
+
+  /**
+   * Remove a key from the map.
+   *
+   * \return Whether the key was in the map.
+   */
+  bool
+  Erase (const Key &key)
+  {
+    uint32_t slot = FindSlot (key, Hash () (key));
+    if (m_slots[slot] == NONE)
+      {
+        return false;
+      }
+    EraseSlot (slot);
+    return true;
+  }
+
+  /**
+   * Remove all entries, and release their memory.
+   */
+  void
+  Clear (void)
+  {
+    std::vector<Entry> ().swap (m_entries);
+    std::vector<uint32_t> ().swap (m_free);
+    m_slots.assign (MIN_SLOTS, NONE);
+    m_mostRecent = NONE;
+    m_leastRecent = NONE;
+  }
+
+private:
+  static const uint32_t NONE = 0xffffffff; //!< An empty slot or list end
+  static const uint32_t MIN_SLOTS = 16; //!< The initial number of slots
+
+  struct Entry
+  {
+    Key key;
+    Value value;
+    uint64_t hash; //!< The hash of the key, kept to avoid recomputing it
+    uint32_t previous; //!< The more recently used entry
+    uint32_t next; //!< The less recently used entry
+  };
+
+  /**
+   * \return The slot holding the key, or the empty slot that ends its probe
+   * sequence.
+   */
+  uint32_t
+  FindSlot (const Key &key, uint64_t hash) const
+  {
+    uint32_t mask = m_slots.size () - 1;
+    uint32_t slot = hash & mask;
+    while (m_slots[slot] != NONE)
+      {
+        const Entry &entry = m_entries[m_slots[slot]];
+        if (entry.hash == hash && entry.key == key)
+          {
+            break;
+          }
+        slot = (slot + 1) & mask;
+      }
+    return slot;
+  }
+
+  void
+  EraseSlot (uint32_t slot)
+  {
+    uint32_t index = m_slots[slot];
+    Unlink (index);
+    m_free.push_back (index);
+
+    // Move back the entries whose probe sequence goes through the hole
+    uint32_t mask = m_slots.size () - 1;
+    uint32_t hole = slot;
+    uint32_t next = (slot + 1) & mask;
+    while (m_slots[next] != NONE)
+      {
+        uint32_t home = m_entries[m_slots[next]].hash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask))
+          {
+            m_slots[hole] = m_slots[next];
+            hole = next;
+          }
+        next = (next + 1) & mask;
+      }
+    m_slots[hole] = NONE;
+  }
+
+  void
+  Evict (void)
+  {
+    NS_ASSERT (m_leastRecent != NONE);
+
+    const Entry &entry = m_entries[m_leastRecent];
+    EraseSlot (FindSlot (entry.key, entry.hash));
+    m_evictions++;
+  }
+
+  void
+  Rehash (uint32_t nSlots)
+  {
+    m_slots.assign (nSlots, NONE);
+    uint32_t mask = nSlots - 1;
+    for (uint32_t index = m_mostRecent; index != NONE;
+         index = m_entries[index].next)
+      {
+        uint32_t slot = m_entries[index].hash & mask;
+        while (m_slots[slot] != NONE)
+          {
+            slot = (slot + 1) & mask;
+          }
+        m_slots[slot] = index;
+      }
+  }
+
+  /**
+   * Mark an entry as the most recently used one. The order is only kept up
+   * to date if the map has a maximum size.
+   */
+  void
+  Touch (uint32_t index)
+  {
+    if (m_maxSize > 0 && index != m_mostRecent)
+      {
+        Unlink (index);
+        LinkFront (index);
+      }
+  }
+
+  void
+  LinkFront (uint32_t index)
+  {
+    Entry &entry = m_entries[index];
+    entry.previous = NONE;
+    entry.next = m_mostRecent;
+    if (m_mostRecent != NONE)
+      {
+        m_entries[m_mostRecent].previous = index;
+      }
+    m_mostRecent = index;
+    if (m_leastRecent == NONE)
+      {
+        m_leastRecent = index;
+      }
+  }
+
+  void
+  Unlink (uint32_t index)
+  {
+    Entry &entry = m_entries[index];
+    if (entry.previous != NONE)
+      {
+        m_entries[entry.previous].next = entry.next;
+      }
+    else
+      {
+        m_mostRecent = entry.next;
+      }
+    if (entry.next != NONE)
+      {
+        m_entries[entry.next].previous = entry.previous;
+      }
+    else
+      {
+        m_leastRecent = entry.previous;
+      }
+  }
+
+  std::vector<Entry> m_entries; //!< The entries, at stable indices
+  std::vector<uint32_t> m_free; //!< Indices of erased entries, to be reused
+  std::vector<uint32_t> m_slots; //!< Entry indices, a power of two of them
+  uint32_t m_maxSize; //!< The maximum number of entries, or 0
+  uint64_t m_evictions; //!< The number of evicted entries
+  uint32_t m_mostRecent; //!< The head of the recency list
+  uint32_t m_leastRecent; //!< The tail of the recency list
+};
+
+template <typename Key, typename Value, typename Hash>
+const uint32_t LoraFlatHashMap<Key, Value, Hash>::NONE;
+
+template <typename Key, typename Value, typename Hash>
+const uint32_t LoraFlatHashMap<Key, Value, Hash>::MIN_SLOTS;
+
+}
+
+}
+#endif /* LORA_FLAT_HASH_MAP_H */
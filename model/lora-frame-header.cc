@@ -19,6 +19,7 @@
  */
 
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-counters.h"
 #include "ns3/log.h"
 #include <bitset>
 
@@ -36,7 +37,9 @@ LoraFrameHeader::LoraFrameHeader () :
   m_ack       (0),
   m_fPending  (0),
   m_fOptsLen  (0),
-  m_fCnt      (0)
+  m_fCnt      (0),
+  m_nMacCommands (0),
+  m_cidMask   (0)
 {
 }
 
@@ -95,10 +98,10 @@ LoraFrameHeader::Serialize (Buffer::Iterator start) const
   start.WriteU16 (m_fCnt);
 
   // FOpts field
-  for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
     {
       NS_LOG_DEBUG ("Serializing a MAC command");
-      (*it)->Serialize (start);
+      m_macCommands[i].Serialize (start);
     }
 
   // FPort
@@ -109,9 +112,11 @@ uint32_t
 LoraFrameHeader::Deserialize (Buffer::Iterator start)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  LORA_COUNTER_INCREMENT (FRAME_HEADER_DESERIALIZATIONS);
 
   // Empty the list of MAC commands
-  m_macCommands.clear ();
+  m_nMacCommands = 0;
+  m_cidMask = 0;
 
   // Read from buffer and save into local variables
   m_address.Set (start.ReadU32 ());
@@ -133,8 +138,11 @@ LoraFrameHeader::Deserialize (Buffer::Iterator start)
   NS_LOG_DEBUG ("fCnt: " << unsigned (m_fCnt));
 
   // Deserialize MAC commands
+  // AddCommand will take care of accumulating the FOptsLen again
   NS_LOG_DEBUG ("Starting deserialization of MAC commands");
-  for (uint8_t byteNumber = 0; byteNumber < m_fOptsLen;)
+  uint8_t fOptsLen = m_fOptsLen;
+  m_fOptsLen = 0;
+  for (uint8_t byteNumber = 0; byteNumber < fOptsLen;)
     {
       uint8_t cid = start.PeekU8 ();
       NS_LOG_DEBUG ("CID: " << unsigned(cid));
@@ -143,168 +151,24 @@ LoraFrameHeader::Deserialize (Buffer::Iterator start)
       // This needs to be done because they have the same CID, and the context
       // about where this message will be Serialized/Deserialized (i.e., at the
       // ED or at the NS) is umportant.
-      if (m_isUplink)
-        {
-          switch (cid)
-            {
-            // In the case of Uplink messages, the NS will deserialize the
-            // request for a link check
-            case (0x02):
-              {
-                NS_LOG_DEBUG ("Creating a LinkCheckReq command");
-                Ptr<LinkCheckReq> command = Create <LinkCheckReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x03):
-              {
-                NS_LOG_DEBUG ("Creating a LinkAdrAns command");
-                Ptr<LinkAdrAns> command = Create <LinkAdrAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x04):
-              {
-                NS_LOG_DEBUG ("Creating a DutyCycleAns command");
-                Ptr<DutyCycleAns> command = Create <DutyCycleAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x05):
-              {
-                NS_LOG_DEBUG ("Creating a RxParamSetupAns command");
-                Ptr<RxParamSetupAns> command = Create <RxParamSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x06):
-              {
-                NS_LOG_DEBUG ("Creating a DevStatusAns command");
-                Ptr<DevStatusAns> command = Create <DevStatusAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x07):
-              {
-                NS_LOG_DEBUG ("Creating a NewChannelAns command");
-                Ptr<NewChannelAns> command = Create <NewChannelAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x08):
-              {
-                NS_LOG_DEBUG ("Creating a RxTimingSetupAns command");
-                Ptr<RxTimingSetupAns> command = Create <RxTimingSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x09):
-              {
-                NS_LOG_DEBUG ("Creating a TxParamSetupAns command");
-                Ptr<TxParamSetupAns> command = Create <TxParamSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x0A):
-              {
-                NS_LOG_DEBUG ("Creating a DlChannelAns command");
-                Ptr<DlChannelAns> command = Create <DlChannelAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            default:
-              {
-                NS_LOG_ERROR ("CID not recognized during deserialization");
-              }
-            }
-        }
-      else
+      InlineMacCommand command (InlineMacCommand::GetMacCommandFromCID
+                                  (cid, m_isUplink));
+
+      if (command.type == INVALID)
         {
-          switch (cid)
-            {
-            // In the case of Downlink messages, the ED will deserialize the
-            // answer to a link check
-            case (0x02):
-              {
-                NS_LOG_DEBUG ("Creating a LinkCheckAns command");
-                Ptr<LinkCheckAns> command = Create <LinkCheckAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x03):
-              {
-                NS_LOG_DEBUG ("Creating a LinkAdrReq command");
-                Ptr<LinkAdrReq> command = Create <LinkAdrReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x04):
-              {
-                NS_LOG_DEBUG ("Creating a DutyCycleReq command");
-                Ptr<DutyCycleReq> command = Create <DutyCycleReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x05):
-              {
-                NS_LOG_DEBUG ("Creating a RxParamSetupReq command");
-                Ptr<RxParamSetupReq> command = Create <RxParamSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x06):
-              {
-                NS_LOG_DEBUG ("Creating a DevStatusReq command");
-                Ptr<DevStatusReq> command = Create <DevStatusReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x07):
-              {
-                NS_LOG_DEBUG ("Creating a NewChannelReq command");
-                Ptr<NewChannelReq> command = Create <NewChannelReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x08):
-              {
-                NS_LOG_DEBUG ("Creating a RxTimingSetupReq command");
-                Ptr<RxTimingSetupReq> command = Create <RxTimingSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x09):
-              {
-                NS_LOG_DEBUG ("Creating a TxParamSetupReq command");
-                Ptr<TxParamSetupReq> command = Create <TxParamSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            default:
-              {
-                NS_LOG_ERROR ("CID not recognized during deserialization");
-              }
-            }
+          // We can't know how long this command is, so skip the rest of FOpts
+          NS_LOG_ERROR ("CID not recognized during deserialization");
+          start.Next (fOptsLen - byteNumber);
+          break;
         }
+
+      byteNumber += command.Deserialize (start);
+      AddCommand (command);
     }
 
+  // Keep the value we read, even if some commands were skipped
+  m_fOptsLen = fOptsLen;
+
   m_fPort = uint8_t (start.ReadU8 ());
 
   return 8 + m_fOptsLen;       // the number of bytes consumed.
@@ -323,9 +187,9 @@ LoraFrameHeader::Print (std::ostream &os) const
   os << "FOptsLen=" << unsigned(m_fOptsLen) << std::endl;
   os << "FCnt=" << unsigned(m_fCnt) << std::endl;
 
-  for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
     {
-      (*it)->Print (os);
+      m_macCommands[i].Print (os);
     }
 
   os << "FPort=" << unsigned(m_fPort) << std::endl;
@@ -422,10 +286,9 @@ LoraFrameHeader::GetFOptsLen (void) const
 {
   // Sum the serialized lenght of all commands in the list
   uint8_t fOptsLen = 0;
-  std::list< Ptr< MacCommand> >::const_iterator it;
-  for (it = m_macCommands.begin (); it != m_macCommands.end (); it++)
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
     {
-      fOptsLen = fOptsLen + (*it)->GetSerializedSize ();
+      fOptsLen = fOptsLen + m_macCommands[i].GetSerializedSize ();
     }
   return fOptsLen;
 }
@@ -447,11 +310,10 @@ LoraFrameHeader::AddLinkCheckReq (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  Ptr<LinkCheckReq> command = Create<LinkCheckReq> ();
-  m_macCommands.push_back (command);
+  InlineMacCommand command (LINK_CHECK_REQ);
+  AddCommand (command);
 
-  NS_LOG_DEBUG ("Command SerializedSize: " << unsigned(command->GetSerializedSize ()));
-  m_fOptsLen += command->GetSerializedSize ();
+  NS_LOG_DEBUG ("Command SerializedSize: " << unsigned(command.GetSerializedSize ()));
 }
 
 void
@@ -459,10 +321,10 @@ LoraFrameHeader::AddLinkCheckAns (uint8_t margin, uint8_t gwCnt)
 {
   NS_LOG_FUNCTION (this << unsigned(margin) << unsigned(gwCnt));
 
-  Ptr<LinkCheckAns> command = Create<LinkCheckAns> (margin, gwCnt);
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  InlineMacCommand command (LINK_CHECK_ANS);
+  command.linkCheckAns.margin = margin;
+  command.linkCheckAns.gwCnt = gwCnt;
+  AddCommand (command);
 }
 
 void
@@ -480,10 +342,13 @@ LoraFrameHeader::AddLinkAdrReq (uint8_t dataRate, uint8_t txPower, std::list<int
 
   // TODO Implement chMaskCntl field
 
-  Ptr<LinkAdrReq> command = Create<LinkAdrReq> (dataRate, txPower, channelMask, 0, repetitions);
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  InlineMacCommand command (LINK_ADR_REQ);
+  command.linkAdrReq.dataRate = dataRate;
+  command.linkAdrReq.txPower = txPower;
+  command.linkAdrReq.channelMask = channelMask;
+  command.linkAdrReq.chMaskCntl = 0;
+  command.linkAdrReq.nbRep = repetitions;
+  AddCommand (command);
 }
 
 void
@@ -491,10 +356,11 @@ LoraFrameHeader::AddLinkAdrAns (bool powerAck, bool dataRateAck, bool channelMas
 {
   NS_LOG_FUNCTION (this << powerAck << dataRateAck << channelMaskAck);
 
-  Ptr<LinkAdrAns> command = Create<LinkAdrAns> (powerAck, dataRateAck, channelMaskAck);
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  InlineMacCommand command (LINK_ADR_ANS);
+  command.linkAdrAns.powerAck = powerAck;
+  command.linkAdrAns.dataRateAck = dataRateAck;
+  command.linkAdrAns.channelMaskAck = channelMaskAck;
+  AddCommand (command);
 }
 
 void
@@ -502,11 +368,9 @@ LoraFrameHeader::AddDutyCycleReq (uint8_t dutyCycle)
 {
   NS_LOG_FUNCTION (this << unsigned (dutyCycle));
 
-  Ptr<DutyCycleReq> command = Create<DutyCycleReq> (dutyCycle);
-
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  InlineMacCommand command (DUTY_CYCLE_REQ);
+  command.dutyCycleReq.maxDCycle = dutyCycle;
+  AddCommand (command);
 }
 
 void
@@ -514,11 +378,7 @@ LoraFrameHeader::AddDutyCycleAns (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<DutyCycleAns> command = Create<DutyCycleAns> ();
-
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (InlineMacCommand (DUTY_CYCLE_ANS));
 }
 
 void
@@ -530,13 +390,11 @@ LoraFrameHeader::AddRxParamSetupReq (uint8_t rx1DrOffset, uint8_t rx2DataRate, d
   // Evaluate whether to eliminate this assert in case new offsets can be defined.
   NS_ASSERT (0 <= rx1DrOffset && rx1DrOffset <= 5);
 
-  Ptr<RxParamSetupReq> command = Create<RxParamSetupReq> (rx1DrOffset,
-                                                          rx2DataRate,
-                                                          frequency);
-
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  InlineMacCommand command (RX_PARAM_SETUP_REQ);
+  command.rxParamSetupReq.rx1DrOffset = rx1DrOffset;
+  command.rxParamSetupReq.rx2DataRate = rx2DataRate;
+  command.rxParamSetupReq.frequency = uint32_t (frequency / 100);
+  AddCommand (command);
 }
 
 void
@@ -544,11 +402,7 @@ LoraFrameHeader::AddRxParamSetupAns (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<RxParamSetupAns> command = Create<RxParamSetupAns> ();
-
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (InlineMacCommand (RX_PARAM_SETUP_ANS));
 }
 
 void
@@ -556,11 +410,7 @@ LoraFrameHeader::AddDevStatusReq (void)
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<DevStatusReq> command = Create<DevStatusReq> ();
-
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  AddCommand (InlineMacCommand (DEV_STATUS_REQ));
 }
 
 void
@@ -569,12 +419,12 @@ LoraFrameHeader::AddNewChannelReq (uint8_t chIndex, double frequency,
 {
   NS_LOG_FUNCTION (this);
 
-  Ptr<NewChannelReq> command = Create<NewChannelReq> (chIndex, frequency,
-                                                      minDataRate, maxDataRate);
-
-  m_macCommands.push_back (command);
-
-  m_fOptsLen += command->GetSerializedSize ();
+  InlineMacCommand command (NEW_CHANNEL_REQ);
+  command.newChannelReq.chIndex = chIndex;
+  command.newChannelReq.frequency = uint32_t (frequency / 100);
+  command.newChannelReq.minDataRate = minDataRate;
+  command.newChannelReq.maxDataRate = maxDataRate;
+  AddCommand (command);
 }
 
 std::list<Ptr<MacCommand> >
@@ -582,7 +432,12 @@ LoraFrameHeader::GetCommands (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  return m_macCommands;
+  std::list<Ptr<MacCommand> > commands;
+  for (uint8_t i = 0; i < m_nMacCommands; i++)
+    {
+      commands.push_back (m_macCommands[i].ToMacCommand ());
+    }
+  return commands;
 }
 
 void
@@ -590,8 +445,56 @@ LoraFrameHeader::AddCommand (Ptr<MacCommand> macCommand)
 {
   NS_LOG_FUNCTION (this << macCommand);
 
-  m_macCommands.push_back (macCommand);
-  m_fOptsLen += macCommand->GetSerializedSize ();
+  AddCommand (InlineMacCommand::FromMacCommand (macCommand));
+}
+
+void
+LoraFrameHeader::AddCommand (const InlineMacCommand &macCommand)
+{
+  NS_LOG_FUNCTION (this << unsigned (macCommand.type));
+
+  NS_ASSERT_MSG (m_nMacCommands < MAX_MAC_COMMANDS,
+                 "Too many MAC commands in this LoraFrameHeader");
+
+  uint8_t cid = MacCommand::GetCIDFromMacCommand (macCommand.type) & 0xf;
+  if (!(m_cidMask & (1 << cid)))
+    {
+      m_cidMask |= 1 << cid;
+      m_cidIndex[cid] = m_nMacCommands;
+    }
+
+  m_macCommands[m_nMacCommands++] = macCommand;
+  m_fOptsLen += macCommand.GetSerializedSize ();
+}
+
+bool
+LoraFrameHeader::HasMacCommand (uint8_t cid) const
+{
+  return cid < 16 && (m_cidMask & (1 << cid));
+}
+
+const InlineMacCommand *
+LoraFrameHeader::GetInlineCommandByCid (uint8_t cid) const
+{
+  if (!HasMacCommand (cid))
+    {
+      return 0;
+    }
+  return &m_macCommands[m_cidIndex[cid]];
+}
+
+uint8_t
+LoraFrameHeader::GetNCommands (void) const
+{
+  return m_nMacCommands;
+}
+
+const InlineMacCommand &
+LoraFrameHeader::GetInlineCommand (uint8_t index) const
+{
+  NS_ASSERT (index < m_nMacCommands);
+
+  return m_macCommands[index];
 }
 
 }
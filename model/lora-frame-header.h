@@ -208,10 +208,44 @@ public:
   /**
    * Return a pointer to a MacCommand, or 0 if the MacCommand does not exist
    * in this header.
+   *
+   * \remark The returned object is a copy of the command stored in this
+   * header: use HasMacCommand and GetInlineCommand to avoid the allocation.
    */
   template<typename T>
   inline Ptr<T> GetMacCommand (void);
 
+  /**
+   * Check whether a command with a certain CID is contained in this header.
+   *
+   * \param cid The CID of the command.
+   * \return True if a command with the specified CID is present.
+   */
+  bool HasMacCommand (uint8_t cid) const;
+
+  /**
+   * Get the first command with a certain CID contained in this header.
+   *
+   * \param cid The CID of the command.
+   * \return A pointer to the command, or 0 if no such command is present.
+   */
+  const InlineMacCommand * GetInlineCommandByCid (uint8_t cid) const;
+
+  /**
+   * Get the number of MAC commands contained in this header.
+   *
+   * \return The number of MAC commands.
+   */
+  uint8_t GetNCommands (void) const;
+
+  /**
+   * Get one of the MAC commands contained in this header.
+   *
+   * \param index The position of the command in the header, starting from 0.
+   * \return A reference to the command.
+   */
+  const InlineMacCommand & GetInlineCommand (uint8_t index) const;
+
   /**
    * Add a LinkCheckReq command.
    */
@@ -287,6 +321,9 @@ public:
 
   /**
    * Return a list of pointers to all the MAC commands saved in this header.
+   *
+   * \remark The returned objects are copies of the commands stored in this
+   * header, so modifying them has no effect on the header.
    */
   std::list<Ptr<MacCommand> > GetCommands (void);
 
@@ -295,6 +332,17 @@ public:
    */
   void AddCommand (Ptr<MacCommand> macCommand);
 
+  /**
+   * Add a predefined command to the list.
+   */
+  void AddCommand (const InlineMacCommand &macCommand);
+
+  /**
+   * The maximum number of MAC commands a header can contain: FOpts is at most
+   * 15 bytes long, and each command takes up at least one byte.
+   */
+  static const uint8_t MAX_MAC_COMMANDS = 15;
+
 private:
   uint8_t m_fPort;
 
@@ -308,13 +356,28 @@ private:
 
   uint16_t m_fCnt;
 
-  Buffer m_fOpts;
+  /**
+   * Array containing all the MAC commands that are contained in this
+   * LoraFrameHeader, in the order in which they are serialized.
+   */
+  InlineMacCommand m_macCommands[MAX_MAC_COMMANDS];
+
+  /**
+   * The number of valid entries in m_macCommands.
+   */
+  uint8_t m_nMacCommands;
 
   /**
-   * List containing all the MacCommand instances that are contained in this
-   * LoraFrameHeader.
+   * Bitmask of the CIDs of the commands contained in this header: bit i is
+   * set if a command with CID i is present.
    */
-  std::list< Ptr< MacCommand> > m_macCommands;
+  uint16_t m_cidMask;
+
+  /**
+   * Position in m_macCommands of the first command with a certain CID. Only
+   * entries whose bit is set in m_cidMask are meaningful.
+   */
+  uint8_t m_cidIndex[16];
 
   bool m_isUplink;
 };
@@ -324,14 +387,13 @@ template<typename T>
 Ptr<T>
 LoraFrameHeader::GetMacCommand ()
 {
-  // Iterate on MAC commands and try casting
-  std::list< Ptr< MacCommand> >::const_iterator it;
-  for (it = m_macCommands.begin (); it != m_macCommands.end (); ++it)
+  // Look up the command by CID, and make sure it is of the requested type
+  const InlineMacCommand *command = GetInlineCommandByCid
+      (MacCommand::GetCIDFromMacCommand (MacCommandTraits<T>::type));
+
+  if (command != 0 && command->type == MacCommandTraits<T>::type)
     {
-      if ((*it)->GetObject<T> () != 0)
-        {
-          return (*it)->GetObject<T> ();
-        }
+      return command->ToMacCommand ()->GetObject<T> ();
     }
 
   // If no command was found, return 0
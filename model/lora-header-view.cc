@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-header-view.h"
+#include "ns3/lora-mac-header.h"
+#include "ns3/lora-counters.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraHeaderView");
+
+LoraHeaderView::LoraHeaderView ()
+{
+  for (uint32_t i = 0; i < SIZE; i++)
+    {
+      m_bytes[i] = 0;
+    }
+}
+
+LoraHeaderView::LoraHeaderView (Ptr<const Packet> packet)
+{
+  Peek (packet);
+}
+
+void
+LoraHeaderView::Peek (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  LORA_COUNTER_INCREMENT (HEADER_VIEW_PEEKS);
+
+  NS_ASSERT_MSG (packet->GetSize () >= SIZE,
+                 "Packet is too short to contain the LoRaWAN headers");
+
+  packet->CopyData (m_bytes, SIZE);
+}
+
+uint8_t
+LoraHeaderView::GetMType (void) const
+{
+  // MHDR: MType is in the three most significant bits
+  return m_bytes[0] >> 5;
+}
+
+uint8_t
+LoraHeaderView::GetMajor (void) const
+{
+  // MHDR: Major is in the two least significant bits
+  return m_bytes[0] & 0b11;
+}
+
+bool
+LoraHeaderView::IsUplink (void) const
+{
+  uint8_t mType = GetMType ();
+
+  return (mType == LoraMacHeader::JOIN_REQUEST)
+         || (mType == LoraMacHeader::UNCONFIRMED_DATA_UP)
+         || (mType == LoraMacHeader::CONFIRMED_DATA_UP);
+}
+
+bool
+LoraHeaderView::IsConfirmed (void) const
+{
+  uint8_t mType = GetMType ();
+
+  return (mType == LoraMacHeader::CONFIRMED_DATA_DOWN)
+         || (mType == LoraMacHeader::CONFIRMED_DATA_UP);
+}
+
+LoraDeviceAddress
+LoraHeaderView::GetAddress (void) const
+{
+  // DevAddr is written with Buffer::Iterator::WriteU32, least significant
+  // byte first
+  uint32_t address = uint32_t (m_bytes[1])
+    | uint32_t (m_bytes[2]) << 8
+    | uint32_t (m_bytes[3]) << 16
+    | uint32_t (m_bytes[4]) << 24;
+
+  return LoraDeviceAddress (address);
+}
+
+bool
+LoraHeaderView::GetAdr (void) const
+{
+  return (m_bytes[5] >> 6) & 0b1;
+}
+
+bool
+LoraHeaderView::GetAdrAckReq (void) const
+{
+  return (m_bytes[5] >> 5) & 0b1;
+}
+
+bool
+LoraHeaderView::GetAck (void) const
+{
+  return (m_bytes[5] >> 4) & 0b1;
+}
+
+bool
+LoraHeaderView::GetFPending (void) const
+{
+  return (m_bytes[5] >> 3) & 0b1;
+}
+
+uint8_t
+LoraHeaderView::GetFOptsLen (void) const
+{
+  return m_bytes[5] & 0b111;
+}
+
+uint16_t
+LoraHeaderView::GetFCnt (void) const
+{
+  // FCnt is written with Buffer::Iterator::WriteU16, least significant byte
+  // first
+  return uint16_t (m_bytes[6]) | uint16_t (m_bytes[7]) << 8;
+}
+
+}
+}
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_HEADER_VIEW_H
+#define LORA_HEADER_VIEW_H
+
+#include "ns3/packet.h"
+#include "ns3/lora-device-address.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Read-only view of the fixed fields of the MAC and frame headers of a LoRaWAN
+ * packet.
+ *
+ * Components that only need the DevAddr, the FCnt, the MType or one of the
+ * FCtrl flags can use this class instead of copying the packet and removing a
+ * LoraMacHeader and a LoraFrameHeader from it: the view only copies the first
+ * bytes of the packet buffer, and never deserializes the MAC commands in FOpts.
+ *
+ * The fields are decoded with the same layout LoraMacHeader and
+ * LoraFrameHeader use for serialization.
+ */
+class LoraHeaderView
+{
+public:
+  /**
+   * The number of bytes this view reads from the start of the packet: MHDR,
+   * DevAddr, FCtrl and FCnt.
+   */
+  static const uint32_t SIZE = 8;
+
+  LoraHeaderView ();
+
+  /**
+   * Create a view on the headers of a packet.
+   *
+   * \param packet A packet starting with a LoraMacHeader and a LoraFrameHeader.
+   */
+  LoraHeaderView (Ptr<const Packet> packet);
+
+  /**
+   * Read the header fields of a packet into this view.
+   *
+   * \param packet A packet starting with a LoraMacHeader and a LoraFrameHeader.
+   */
+  void Peek (Ptr<const Packet> packet);
+
+  /**
+   * Get the message type.
+   *
+   * \return The message type, as in LoraMacHeader::MType.
+   */
+  uint8_t GetMType (void) const;
+
+  /**
+   * Get the major version.
+   *
+   * \return The major version.
+   */
+  uint8_t GetMajor (void) const;
+
+  /**
+   * Check whether the packet is an uplink message.
+   *
+   * \return True if the message is meant to be sent from an ED to a GW.
+   */
+  bool IsUplink (void) const;
+
+  /**
+   * Check whether the packet is a confirmed message.
+   *
+   * \return True if the message is of a confirmed type.
+   */
+  bool IsConfirmed (void) const;
+
+  /**
+   * Get the device address.
+   *
+   * \return The DevAddr of the frame header.
+   */
+  LoraDeviceAddress GetAddress (void) const;
+
+  /**
+   * Get the Adr bit.
+   *
+   * \return True if the ADR bit is set.
+   */
+  bool GetAdr (void) const;
+
+  /**
+   * Get the AdrAckReq bit.
+   *
+   * \return True if the ADRACKReq bit is set.
+   */
+  bool GetAdrAckReq (void) const;
+
+  /**
+   * Get the Ack bit.
+   *
+   * \return True if the ACK bit is set.
+   */
+  bool GetAck (void) const;
+
+  /**
+   * Get the FPending bit.
+   *
+   * \return True if the FPending bit is set.
+   */
+  bool GetFPending (void) const;
+
+  /**
+   * Get the FOptsLen value.
+   *
+   * \return The length of the FOpts field, in bytes.
+   */
+  uint8_t GetFOptsLen (void) const;
+
+  /**
+   * Get the FCnt value.
+   *
+   * \return The frame counter.
+   */
+  uint16_t GetFCnt (void) const;
+
+private:
+  uint8_t m_bytes[SIZE]; //!< The first bytes of the packet
+};
+
+}
+
+}
+#endif
@@ -19,6 +19,9 @@
  */
 
 #include "ns3/lora-interference-helper.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-counters.h"
+#include "ns3/lora-utils.h"
 #include "ns3/log.h"
 #include <limits>
 
@@ -126,6 +129,7 @@ LoraInterferenceHelper::GetTypeId (void)
 }
 
 LoraInterferenceHelper::LoraInterferenceHelper ()
+  : m_fastPowerConversion (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -233,6 +237,9 @@ LoraInterferenceHelper::IsDestroyedByInterference
   (Ptr<LoraInterferenceHelper::Event> event)
 {
   NS_LOG_FUNCTION (this << event);
+  LORA_PROFILE_SCOPE (INTERFERENCE);
+  LORA_COUNTER_INCREMENT (INTERFERENCE_CHECKS);
+  LORA_HISTOGRAM_RECORD (INTERFERENCE_EVENTS, m_events.size ());
 
   NS_LOG_INFO ("Current number of events in LoraInterferenceHelper: " << m_events.size ());
 
@@ -291,17 +298,42 @@ LoraInterferenceHelper::IsDestroyedByInterference
 
       NS_LOG_DEBUG ("The two events overlap for " << overlap.GetSeconds () << " s.");
 
-      // Compute the equivalent energy of the interference
-      // Power [mW] = 10^(Power[dBm]/10)
-      // Power [W] = Power [mW] / 1000
-      double interfererPowerW = pow (10, interfererPower / 10) / 1000;
+      m_interfererPowers.push_back (interfererPower);
+      m_overlaps.push_back (overlap.GetSeconds ());
+      m_interfererSfs.push_back (interfererSf);
+      it++;
+    }
+
+  // Compute the equivalent energy of the interference, converting all the
+  // powers at once
+  // Power [mW] = 10^(Power[dBm]/10)
+  // Power [W] = Power [mW] / 1000
+  DbmToW (m_interfererPowers.data (), m_interfererPowers.data (),
+          m_interfererPowers.size (), m_fastPowerConversion);
+  for (uint32_t i = 0; i < m_interfererPowers.size (); i++)
+    {
       // Energy [J] = Time [s] * Power [W]
-      double interferenceEnergy = overlap.GetSeconds () * interfererPowerW;
-      cumulativeInterferenceEnergy.at (unsigned(interfererSf) - 7) += interferenceEnergy;
-      NS_LOG_DEBUG ("Interferer power in W: " << interfererPowerW);
+      double interferenceEnergy = m_overlaps[i] * m_interfererPowers[i];
+      cumulativeInterferenceEnergy.at (unsigned(m_interfererSfs[i]) - 7) += interferenceEnergy;
+      NS_LOG_DEBUG ("Interferer power in W: " << m_interfererPowers[i]);
       NS_LOG_DEBUG ("Interference energy: " << interferenceEnergy);
-      it++;
     }
+  m_interfererPowers.clear ();
+  m_overlaps.clear ();
+  m_interfererSfs.clear ();
+
+  double signalPowerW = DbmToW (rxPowerDbm, m_fastPowerConversion);
+  double signalEnergy = duration.GetSeconds () * signalPowerW;
+  NS_LOG_DEBUG ("Signal power in W: " << signalPowerW);
+  NS_LOG_DEBUG ("Signal energy: " << signalEnergy);
+
+  // Compute the SNIR against the interference of each SF
+  double snirs[6];
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      snirs[i] = signalEnergy / cumulativeInterferenceEnergy[i];
+    }
+  RatioToDb (snirs, snirs, 6, m_fastPowerConversion);
 
   // For each SF, check if there was destructive interference
   for (uint8_t currentSf = uint8_t (7); currentSf <= uint8_t (12); currentSf++)
@@ -309,18 +341,11 @@ LoraInterferenceHelper::IsDestroyedByInterference
       NS_LOG_DEBUG ("Cumulative Interference Energy: " <<
                     cumulativeInterferenceEnergy.at (unsigned(currentSf) - 7));
 
-      // Use the computed cumulativeInterferenceEnergy to determine whether the
-      // interference with this SF destroys the packet
-      double signalPowerW = pow (10, rxPowerDbm / 10) / 1000;
-      double signalEnergy = duration.GetSeconds () * signalPowerW;
-      NS_LOG_DEBUG ("Signal power in W: " << signalPowerW);
-      NS_LOG_DEBUG ("Signal energy: " << signalEnergy);
-
       // Check whether the packet survives the interference of this SF
       double snirIsolation = collisionSnir [unsigned(sf) - 7][unsigned(currentSf) - 7];
       NS_LOG_DEBUG ("The needed isolation to survive is "
                     << snirIsolation << " dB");
-      double snir = 10 * log10 (signalEnergy / cumulativeInterferenceEnergy.at (unsigned(currentSf) - 7));
+      double snir = snirs[unsigned(currentSf) - 7];
       NS_LOG_DEBUG ("The current SNIR is " << snir << " dB");
 
       if (snir >= snirIsolation)
@@ -343,6 +368,18 @@ LoraInterferenceHelper::IsDestroyedByInterference
   return uint8_t (0);
 }
 
+void
+LoraInterferenceHelper::SetFastPowerConversion (bool fast)
+{
+  m_fastPowerConversion = fast;
+}
+
+bool
+LoraInterferenceHelper::GetFastPowerConversion (void) const
+{
+  return m_fastPowerConversion;
+}
+
 void
 LoraInterferenceHelper::ClearAllEvents (void)
 {
@@ -29,6 +29,7 @@
 #include "ns3/packet.h"
 #include "ns3/logical-lora-channel.h"
 #include <list>
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -195,12 +196,38 @@ private:
    */
   void CleanOldEvents (void);
 
+  /**
+   * Set whether power conversions use the fast mode of the lora-utils
+   * kernels, whose error bounds are documented there.
+   */
+  void SetFastPowerConversion (bool fast);
+
+  bool GetFastPowerConversion (void) const;
+
 private:
   /**
    * A list of the events this LoraInterferenceHelper is keeping track of.
    */
   std::list< Ptr< LoraInterferenceHelper::Event > > m_events;
 
+  bool m_fastPowerConversion; //!< Whether conversions use the fast mode
+
+  /**
+   * The powers of the interferers of the event being checked, first in dBm
+   * and then in W.
+   */
+  std::vector<double> m_interfererPowers;
+
+  /**
+   * The overlap [s] with the event being checked of each interferer.
+   */
+  std::vector<double> m_overlaps;
+
+  /**
+   * The SF of each interferer.
+   */
+  std::vector<uint8_t> m_interfererSfs;
+
   /**
    * The matrix containing information about how packets survive interference.
    */
@@ -210,6 +210,8 @@ public:
    */
   int GetNPreambleSymbols (void);
 
+  friend class LoraCheckpoint;
+
 protected:
   /**
   * The trace source that is fired when a packet cannot be sent because of duty
@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-packet-pool.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraPacketPool");
+
+LoraPacketPool::LoraPacketPool ()
+  : m_maxSize (1024),
+  m_enabled (false),
+  m_clearScheduled (false)
+{
+  m_stats.hits = 0;
+  m_stats.misses = 0;
+}
+
+LoraPacketPool &
+LoraPacketPool::Get (void)
+{
+  static LoraPacketPool pool;
+  return pool;
+}
+
+Ptr<Packet>
+LoraPacketPool::Allocate (uint32_t size)
+{
+  LoraPacketPool &pool = Get ();
+
+  if (!pool.m_enabled)
+    {
+      return Create<Packet> (size);
+    }
+
+  // Look for a packet of which we hold the only reference among the oldest
+  // ones. Packets still in use are moved to the back.
+  uint32_t nScan = std::min<uint32_t> (MAX_SCAN, pool.m_packets.size ());
+  for (uint32_t i = 0; i < nScan; i++)
+    {
+      bool released = pool.m_packets.front ()->GetReferenceCount () == 1;
+      Ptr<Packet> packet = pool.m_packets.front ();
+      pool.m_packets.pop_front ();
+      pool.m_packets.push_back (packet);
+
+      if (released)
+        {
+          // Reset the packet as a new one, with its own uid, while keeping
+          // the Packet object
+          *packet = Packet (size);
+
+          pool.m_stats.hits++;
+          NS_LOG_DEBUG ("Recycled packet " << packet << " with size " << size);
+          return packet;
+        }
+    }
+
+  Ptr<Packet> packet = Create<Packet> (size);
+  if (pool.m_packets.size () < pool.m_maxSize)
+    {
+      pool.m_packets.push_back (packet);
+      if (!pool.m_clearScheduled)
+        {
+          Simulator::ScheduleDestroy (&LoraPacketPool::ClearOnDestroy);
+          pool.m_clearScheduled = true;
+        }
+    }
+  pool.m_stats.misses++;
+  NS_LOG_DEBUG ("Created packet " << packet << " with size " << size);
+  return packet;
+}
+
+void
+LoraPacketPool::SetEnabled (bool enabled)
+{
+  NS_LOG_FUNCTION (enabled);
+
+  LoraPacketPool &pool = Get ();
+  pool.m_enabled = enabled;
+  if (!enabled)
+    {
+      pool.m_packets.clear ();
+    }
+}
+
+bool
+LoraPacketPool::IsEnabled (void)
+{
+  return Get ().m_enabled;
+}
+
+void
+LoraPacketPool::SetMaxSize (uint32_t maxSize)
+{
+  NS_LOG_FUNCTION (maxSize);
+
+  LoraPacketPool &pool = Get ();
+  pool.m_maxSize = maxSize;
+  while (pool.m_packets.size () > maxSize)
+    {
+      pool.m_packets.pop_back ();
+    }
+}
+
+uint32_t
+LoraPacketPool::GetSize (void)
+{
+  return Get ().m_packets.size ();
+}
+
+LoraPacketPool::Stats
+LoraPacketPool::GetStats (void)
+{
+  return Get ().m_stats;
+}
+
+void
+LoraPacketPool::ResetStats (void)
+{
+  LoraPacketPool &pool = Get ();
+  pool.m_stats.hits = 0;
+  pool.m_stats.misses = 0;
+}
+
+void
+LoraPacketPool::Clear (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Get ().m_packets.clear ();
+}
+
+void
+LoraPacketPool::ClearOnDestroy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  LoraPacketPool &pool = Get ();
+  pool.m_packets.clear ();
+  pool.m_clearScheduled = false;
+}
+
+void
+LoraPacketPool::PrintStats (std::ostream &os)
+{
+  Stats stats = GetStats ();
+  uint64_t total = stats.hits + stats.misses;
+  os << "LoraPacketPool: " << stats.hits << " hits, " << stats.misses <<
+    " misses";
+  if (total > 0)
+    {
+      os << " (" << 100.0 * stats.hits / total << "% hit rate)";
+    }
+  os << ", " << GetSize () << " pooled packets" << std::endl;
+}
+
+}
+}
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_PACKET_POOL_H
+#define LORA_PACKET_POOL_H
+
+#include "ns3/packet.h"
+#include <deque>
+#include <ostream>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A module-level pool of packets, used by the LoRaWAN applications to create
+ * the payload of uplink frames.
+ *
+ * The pool keeps a reference to the packets it hands out. A packet is reused
+ * once the pool holds its only reference, i.e., once the MAC and PHY layers,
+ * the interference helper, the gateways, the network server and any tracker
+ * have released it. A reused packet keeps its Packet object, which is reset
+ * as if it was just created: it gets a new uid, a zeroed payload of the
+ * requested size, and no headers, tags or metadata. Its buffer is taken from
+ * the free list of the ns-3 Buffer class, as for any new packet.
+ *
+ * Allocate only looks at a few of the oldest packets of the pool, so that its
+ * cost does not depend on the number of packets in flight. Packets are still
+ * created normally when none of them is free (a miss), and are added to the
+ * pool as long as it holds less than the maximum number of packets.
+ *
+ * The pool is disabled by default. Note that the LoraPacketTracker keeps a
+ * reference to every packet it sees, which are thus never released: with
+ * tracking enabled, the pool never hits, and only adds up to MAX_SCAN checks
+ * to each allocation.
+ *
+ * The pool is cleared when the simulator is destroyed, so that consecutive
+ * runs never share packets. The statistics are kept until they are reset.
+ */
+class LoraPacketPool
+{
+public:
+  /**
+   * Hit and miss statistics of the pool.
+   */
+  struct Stats
+  {
+    uint64_t hits; //!< Packets served by recycling a pooled packet
+    uint64_t misses; //!< Packets that had to be created
+  };
+
+  /**
+   * Get a packet with a payload of the given size, recycling a released
+   * packet of the pool if possible.
+   *
+   * If the pool is disabled, this is equivalent to Create<Packet> (size).
+   *
+   * \param size The size of the payload.
+   * \return The packet.
+   */
+  static Ptr<Packet> Allocate (uint32_t size);
+
+  /**
+   * Enable or disable the pool. Disabling the pool releases all its packets.
+   */
+  static void SetEnabled (bool enabled);
+
+  /**
+   * \return Whether the pool is enabled.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * Set the maximum number of packets the pool keeps track of.
+   */
+  static void SetMaxSize (uint32_t maxSize);
+
+  /**
+   * \return The number of packets currently held by the pool.
+   */
+  static uint32_t GetSize (void);
+
+  /**
+   * \return The hit and miss statistics since the last reset.
+   */
+  static Stats GetStats (void);
+
+  /**
+   * Reset the hit and miss statistics.
+   */
+  static void ResetStats (void);
+
+  /**
+   * Release all the packets held by the pool.
+   */
+  static void Clear (void);
+
+  /**
+   * Print the hit and miss statistics.
+   */
+  static void PrintStats (std::ostream &os);
+
+  /**
+   * The number of pooled packets that Allocate checks before giving up.
+   */
+  static const uint32_t MAX_SCAN = 8;
+
+private:
+  LoraPacketPool ();
+
+  /**
+   * Get the pool instance.
+   */
+  static LoraPacketPool & Get (void);
+
+  /**
+   * Release all the packets held by the pool when the simulator is
+   * destroyed.
+   */
+  static void ClearOnDestroy (void);
+
+  std::deque<Ptr<Packet> > m_packets; //!< Pooled packets, oldest first
+  uint32_t m_maxSize; //!< Maximum number of pooled packets
+  bool m_enabled; //!< Whether the pool is used
+  bool m_clearScheduled; //!< Whether ClearOnDestroy is scheduled
+  Stats m_stats; //!< Hit and miss statistics
+};
+
+}
+
+}
+#endif /* LORA_PACKET_POOL_H */
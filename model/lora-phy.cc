@@ -21,6 +21,7 @@
 #include "ns3/lora-phy.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/boolean.h"
 #include <algorithm>
 
 namespace ns3 {
@@ -69,7 +70,14 @@ LoraPhy::GetTypeId (void)
                      "could not be correctly received because"
                      "its received power is below the sensitivity of the receiver",
                      MakeTraceSourceAccessor (&LoraPhy::m_underSensitivity),
-                     "ns3::Packet::TracedCallback");
+                     "ns3::Packet::TracedCallback")
+    .AddAttribute ("FastPowerConversion",
+                   "Whether the interference computations convert powers "
+                   "with the fast approximations of lora-utils",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LoraPhy::SetFastPowerConversion,
+                                        &LoraPhy::GetFastPowerConversion),
+                   MakeBooleanChecker ());
   return tid;
 }
 
@@ -114,9 +122,10 @@ LoraPhy::GetMobility (void)
     {
       return m_mobility;
     }
-  else     // Else, take it from the node
+  else     // Else, take it from the node, and keep it for the next calls
     {
-      return m_device->GetNode ()->GetObject<MobilityModel> ();
+      m_mobility = m_device->GetNode ()->GetObject<MobilityModel> ();
+      return m_mobility;
     }
 }
 
@@ -128,6 +137,18 @@ LoraPhy::SetMobility (Ptr<MobilityModel> mobility)
   m_mobility = mobility;
 }
 
+void
+LoraPhy::SetFastPowerConversion (bool fast)
+{
+  m_interference.SetFastPowerConversion (fast);
+}
+
+bool
+LoraPhy::GetFastPowerConversion (void) const
+{
+  return m_interference.GetFastPowerConversion ();
+}
+
 void
 LoraPhy::SetChannel (Ptr<LoraChannel> channel)
 {
@@ -158,61 +179,11 @@ LoraPhy::SetTxFinishedCallback (TxFinishedCallback callback)
 Time
 LoraPhy::GetOnAirTime (Ptr<Packet> packet, LoraTxParameters txParams)
 {
-
   NS_LOG_FUNCTION (packet << txParams);
 
-  // The contents of this function are based on [1].
-  // [1] SX1272 LoRa modem designer's guide.
-
-  // Compute the symbol duration
-  // Bandwidth is in Hz
-  double tSym = pow (2, int(txParams.sf)) / (txParams.bandwidthHz);
-
-  // Compute the preamble duration
-  double tPreamble = (double(txParams.nPreamble) + 4.25) * tSym;
-
-  // Payload size
-  uint32_t pl = packet->GetSize ();      // Size in bytes
-  NS_LOG_DEBUG ("Packet of size " << pl << " bytes");
-
-  // This step is needed since the formula deals with double values.
-  // de = 1 when the low data rate optimization is enabled, 0 otherwise
-  // h = 1 when header is implicit, 0 otherwise
-  double de = txParams.lowDataRateOptimizationEnabled ? 1 : 0;
-  double h = txParams.headerDisabled ? 1 : 0;
-  double crc = txParams.crcEnabled ? 1 : 0;
-
-  // num and den refer to numerator and denominator of the time on air formula
-  double num = 8 * pl - 4 * txParams.sf + 28 + 16 * crc - 20 * h;
-  double den = 4 * (txParams.sf - 2 * de);
-  double payloadSymbNb = 8 + std::max (std::ceil (num / den) *
-                                       (txParams.codingRate + 4), double(0));
-
-  // Time to transmit the payload
-  double tPayload = payloadSymbNb * tSym;
-
-  NS_LOG_DEBUG ("Time computation: num = " << num << ", den = " << den <<
-                ", payloadSymbNb = " << payloadSymbNb << ", tSym = " << tSym);
-  NS_LOG_DEBUG ("tPreamble = " << tPreamble);
-  NS_LOG_DEBUG ("tPayload = " << tPayload);
-  NS_LOG_DEBUG ("Total time = " << tPreamble + tPayload);
-
-  // Compute and return the total packet on-air time
-  return Seconds (tPreamble + tPayload);
-}
-
-std::ostream &operator << (std::ostream &os, const LoraTxParameters &params)
-{
-  os << "SF: " << unsigned(params.sf) <<
-    ", headerDisabled: " << params.headerDisabled <<
-    ", codingRate: " << unsigned(params.codingRate) <<
-    ", bandwidthHz: " << params.bandwidthHz <<
-    ", nPreamble: " << params.nPreamble <<
-    ", crcEnabled: " << params.crcEnabled <<
-    ", lowDataRateOptimizationEnabled: " << params.lowDataRateOptimizationEnabled <<
-    ")";
-
-  return os;
+  // The payload size is obtained through GetSize () to account for the
+  // presence of Headers and Trailers, too
+  return LoraAirtimeTable::GetOnAirTime (packet->GetSize (), txParams);
 }
 }
 }
@@ -30,6 +30,7 @@
 #include "ns3/lora-channel.h"
 #include "ns3/net-device.h"
 #include "ns3/lora-interference-helper.h"
+#include "ns3/lora-airtime-table.h"
 #include <list>
 
 namespace ns3 {
@@ -37,26 +38,6 @@ namespace lorawan {
 
 class LoraChannel;
 
-/**
- * Structure to collect all parameters that are used to compute the duration of
- * a packet (excluding payload length).
- */
-struct LoraTxParameters
-{
-  uint8_t sf = 7;     //!< Spreading Factor
-  bool headerDisabled = 0;     //!< Whether to use implicit header mode
-  uint8_t codingRate = 1;     //!< Code rate (obtained as 4/(codingRate+4))
-  double bandwidthHz = 125000;     //!< Bandwidth in Hz
-  uint32_t nPreamble = 8;     //!< Number of preamble symbols
-  bool crcEnabled = 1;     //!< Whether Cyclic Redundancy Check is enabled
-  bool lowDataRateOptimizationEnabled = 0;     //!< Whether Low Data Rate Optimization is enabled
-};
-
-/**
- * Allow logging of LoraTxParameters like with any other data type.
- */
-std::ostream &operator << (std::ostream &os, const LoraTxParameters &params);
-
 /**
  * \ingroup lorawan
  *
@@ -191,6 +172,9 @@ public:
   /**
    * Get the mobility model associated to this PHY.
    *
+   * If none was set with SetMobility, the one aggregated to the node is looked
+   * up on the first call, and kept for the following ones.
+   *
    * \return The MobilityModel associated to this PHY.
    */
   Ptr<MobilityModel> GetMobility ();
@@ -202,6 +186,14 @@ public:
    */
   void SetMobility (Ptr<MobilityModel> mobility);
 
+  /**
+   * Set whether the interference computations use the fast power
+   * conversions of lora-utils.
+   */
+  void SetFastPowerConversion (bool fast);
+
+  bool GetFastPowerConversion (void) const;
+
   /**
    * Set the LoraChannel instance PHY transmits on.
    *
@@ -240,6 +232,9 @@ public:
    * (obtained through a GetSize () call to accout for the presence of Headers
    * and Trailers, too) also influences the packet transmit time.
    *
+   * The time is looked up in LoraAirtimeTable, which can also be used
+   * directly when no packet or PHY instance is available.
+   *
    * \param packet The packet that needs to be transmitted.
    * \param txParams The set of parameters that will be used for transmission.
    * \return The time necessary to transmit the packet.
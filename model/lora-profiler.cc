@@ -0,0 +1,138 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-profiler.h"
+#include "ns3/assert.h"
+#include <chrono>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+bool LoraProfiler::s_enabled = false;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct ProfilerState
+{
+  int64_t ns[LoraProfiler::N_SECTIONS]; //!< Exclusive time of each section
+  uint64_t calls[LoraProfiler::N_SECTIONS]; //!< Entries in each section
+  std::vector<LoraProfiler::Section> stack; //!< Sections being executed
+  Clock::time_point last; //!< When the top of the stack was (re)started
+};
+
+ProfilerState &
+GetState (void)
+{
+  static ProfilerState state = ProfilerState ();
+  return state;
+}
+
+}
+
+void
+LoraProfiler::SetEnabled (bool enabled)
+{
+  // Scopes that are open keep their state, so that they are closed correctly
+  s_enabled = enabled;
+}
+
+bool
+LoraProfiler::IsEnabled (void)
+{
+  return s_enabled;
+}
+
+void
+LoraProfiler::Reset (void)
+{
+  ProfilerState &state = GetState ();
+  for (uint32_t i = 0; i < N_SECTIONS; i++)
+    {
+      state.ns[i] = 0;
+      state.calls[i] = 0;
+    }
+}
+
+double
+LoraProfiler::GetSeconds (Section section)
+{
+  return GetState ().ns[section] * 1e-9;
+}
+
+uint64_t
+LoraProfiler::GetCalls (Section section)
+{
+  return GetState ().calls[section];
+}
+
+std::string
+LoraProfiler::GetSectionName (Section section)
+{
+  switch (section)
+    {
+    case CHANNEL_SEND:
+      return "channelSend";
+    case INTERFERENCE:
+      return "interference";
+    case MAC:
+      return "mac";
+    case NETWORK_SERVER:
+      return "networkServer";
+    default:
+      return "unknown";
+    }
+}
+
+void
+LoraProfiler::Enter (Section section)
+{
+  ProfilerState &state = GetState ();
+  Clock::time_point now = Clock::now ();
+
+  // Pause the enclosing section
+  if (!state.stack.empty ())
+    {
+      state.ns[state.stack.back ()] +=
+        std::chrono::duration_cast<std::chrono::nanoseconds> (now - state.last).count ();
+    }
+
+  state.stack.push_back (section);
+  state.calls[section]++;
+  state.last = now;
+}
+
+void
+LoraProfiler::Exit (void)
+{
+  ProfilerState &state = GetState ();
+  Clock::time_point now = Clock::now ();
+
+  NS_ASSERT (!state.stack.empty ());
+  state.ns[state.stack.back ()] +=
+    std::chrono::duration_cast<std::chrono::nanoseconds> (now - state.last).count ();
+  state.stack.pop_back ();
+
+  // Resume the enclosing section
+  state.last = now;
+}
+
+}
+}
@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_PROFILER_H
+#define LORA_PROFILER_H
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A module-level profiler that measures the wall-clock time spent in the main
+ * sections of the LoRaWAN stack.
+ *
+ * Sections are delimited by LoraProfiler::Scope objects, usually declared
+ * through the LORA_PROFILE_SCOPE macro at the beginning of a function. Times
+ * are exclusive: when a section is entered from within another one (e.g., the
+ * channel is reached from the MAC through the PHY), the outer section is
+ * paused until the inner one is left, so that the times of all sections add up
+ * to at most the total run time.
+ *
+ * The profiler is disabled by default, in which case a scope only costs a
+ * branch.
+ */
+class LoraProfiler
+{
+public:
+  /**
+   * The profiled sections.
+   */
+  enum Section
+  {
+    CHANNEL_SEND, //!< LoraChannel::Send
+    INTERFERENCE, //!< Interference evaluation at the receivers
+    MAC, //!< End device and gateway MAC layers
+    NETWORK_SERVER, //!< Network server, controller and scheduler
+    N_SECTIONS
+  };
+
+  /**
+   * Measures the time spent in a section between its construction and its
+   * destruction.
+   */
+  class Scope
+  {
+  public:
+    Scope (Section section)
+      : m_active (s_enabled)
+    {
+      if (m_active)
+        {
+          Enter (section);
+        }
+    }
+
+    ~Scope ()
+    {
+      if (m_active)
+        {
+          Exit ();
+        }
+    }
+
+  private:
+    bool m_active; //!< Whether the profiler was enabled on construction
+  };
+
+  /**
+   * Enable or disable the profiler.
+   */
+  static void SetEnabled (bool enabled);
+
+  /**
+   * \return Whether the profiler is enabled.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * Reset the time and number of calls of all sections.
+   */
+  static void Reset (void);
+
+  /**
+   * \return The time spent in a section, in seconds.
+   */
+  static double GetSeconds (Section section);
+
+  /**
+   * \return The number of times a section was entered.
+   */
+  static uint64_t GetCalls (Section section);
+
+  /**
+   * \return A short name for a section.
+   */
+  static std::string GetSectionName (Section section);
+
+private:
+  static void Enter (Section section);
+  static void Exit (void);
+
+  static bool s_enabled; //!< Whether the profiler is enabled
+};
+
+}
+
+}
+
+/**
+ * Profile the rest of the enclosing block as part of a LoraProfiler section.
+ * Scopes are compiled out together with the LoraCounters.
+ */
+#ifdef NS3_LORA_COUNTERS
+#define LORA_PROFILE_SCOPE(section) \
+  ns3::lorawan::LoraProfiler::Scope loraProfilerScope (ns3::lorawan::LoraProfiler::section)
+#else
+#define LORA_PROFILE_SCOPE(section) do { } while (false)
+#endif
+
+#endif /* LORA_PROFILER_H */
@@ -26,7 +26,11 @@
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
+#include <algorithm>
 #include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -90,6 +94,9 @@ double LoraPropagationLossModel::DoCalcRxPower (double txPowerDbm,
 
 NS_OBJECT_ENSURE_REGISTERED (RYLRLoraPropagationLossModel);
 
+const uint8_t RYLRLoraPropagationLossModel::MIN_SF;
+const uint8_t RYLRLoraPropagationLossModel::MAX_SF;
+
 TypeId 
 RYLRLoraPropagationLossModel::GetTypeId (void)
 {
@@ -97,6 +104,13 @@ RYLRLoraPropagationLossModel::GetTypeId (void)
     .SetParent<LoraPropagationLossModel> ()
     .SetGroupName ("LoraPropagation")
     .AddConstructor<RYLRLoraPropagationLossModel> ()
+    .AddAttribute ("CalibrationFile",
+                   "A file with the loss coefficients of each SF. If empty, "
+                   "the default coefficients are used.",
+                   StringValue (""),
+                   MakeStringAccessor (&RYLRLoraPropagationLossModel::SetCalibrationFile,
+                                       &RYLRLoraPropagationLossModel::GetCalibrationFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -105,83 +119,186 @@ RYLRLoraPropagationLossModel::RYLRLoraPropagationLossModel ()
   : LoraPropagationLossModel ()
 {
     // Important: SF has to be updated before using the model 
+  for (uint8_t sf = 0; sf <= MAX_SF; sf++)
+    {
+      m_coefficients[sf] = GetDefaultCoefficients (sf);
+    }
 }
 
 RYLRLoraPropagationLossModel::RYLRLoraPropagationLossModel (uint8_t txSF)
   : LoraPropagationLossModel (txSF)
 {
+  for (uint8_t sf = 0; sf <= MAX_SF; sf++)
+    {
+      m_coefficients[sf] = GetDefaultCoefficients (sf);
+    }
 }
 
 RYLRLoraPropagationLossModel::~RYLRLoraPropagationLossModel ()
 {
 }
 
+RYLRLoraPropagationLossModel::Coefficients
+RYLRLoraPropagationLossModel::GetDefaultCoefficients (uint8_t sf)
+{
+  // RYLR experimental RSSI ranged from -49 dBm at 0 m to a minimum at
+  // maxRange, for 14 dBm of transmission power. The offset makes up for the
+  // sensitivity of the RYLR (-106 dBm) being worse than the one of the SX1276.
+  // TODO: Use actual data for SF 7,8,9,10,12 [Miller]
+  // TODO: Verify data of SF 11, whose max range was found to be ~600 m
+  const double minPathLossDb = 49 + 14;
+  const double maxPathLossDb[] = {114 + 14, 112 + 14, 110 + 14, 108 + 14, 106 + 14, 104 + 14};
+  const double antennaLossDb[] = {123 - 114, 126 - 112, 129 - 110, 132 - 108, 134 - 106, 136 - 104};
+  const double maxRange[] = {900, 925, 975, 1025, 1100, 1275};
+
+  if (!(sf >= MIN_SF && sf <= MAX_SF))
+    {
+      sf = MIN_SF;
+    }
+  uint8_t i = sf - MIN_SF;
+
+  // Linear approx
+  Coefficients coefficients;
+  coefficients.constant = minPathLossDb;
+  coefficients.linear = (maxPathLossDb[i] - minPathLossDb) / maxRange[i];
+  coefficients.logarithmic = 0;
+  coefficients.referenceDistance = 1;
+  coefficients.breakpoint = 0;
+  coefficients.piecewise = 0;
+  coefficients.offset = antennaLossDb[i];
+  return coefficients;
+}
+
+void
+RYLRLoraPropagationLossModel::SetCoefficients (uint8_t sf, Coefficients coefficients)
+{
+  NS_ASSERT_MSG (sf >= MIN_SF && sf <= MAX_SF, "SF=" << (int)sf << " is not calibrated");
+  NS_ASSERT_MSG (coefficients.referenceDistance > 0, "The reference distance must be positive");
+
+  m_coefficients[sf] = coefficients;
+  if (sf == MIN_SF)
+    {
+      for (uint8_t lower = 0; lower < MIN_SF; lower++)
+        {
+          m_coefficients[lower] = coefficients;
+        }
+    }
+}
+
+RYLRLoraPropagationLossModel::Coefficients
+RYLRLoraPropagationLossModel::GetCoefficients (uint8_t sf) const
+{
+  return m_coefficients[sf <= MAX_SF ? sf : MIN_SF];
+}
+
+bool
+RYLRLoraPropagationLossModel::LoadCalibration (std::string filename)
+{
+  std::ifstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open calibration file " << filename);
+      return false;
+    }
+
+  // Parse the whole file before changing any coefficient
+  std::vector<std::pair<uint8_t, Coefficients> > entries;
+  std::string line;
+  uint32_t lineNumber = 0;
+  while (std::getline (file, line))
+    {
+      lineNumber++;
+
+      // Skip empty lines and comments
+      std::size_t first = line.find_first_not_of (" \t\r");
+      if (first == std::string::npos || line[first] == '#')
+        {
+          continue;
+        }
+
+      std::istringstream is (line);
+      int sf;
+      Coefficients c;
+      if (!(is >> sf >> c.constant >> c.linear >> c.logarithmic >> c.referenceDistance
+               >> c.breakpoint >> c.piecewise >> c.offset)
+          || sf < MIN_SF || sf > MAX_SF || !(c.referenceDistance > 0))
+        {
+          NS_LOG_ERROR ("Malformed line " << lineNumber << " in " << filename);
+          return false;
+        }
+      entries.push_back (std::make_pair (uint8_t (sf), c));
+    }
+
+  for (auto &entry : entries)
+    {
+      SetCoefficients (entry.first, entry.second);
+    }
+  m_calibrationFile = filename;
+  NS_LOG_DEBUG ("Read the coefficients of " << entries.size () << " SFs from " << filename);
+  return true;
+}
+
+bool
+RYLRLoraPropagationLossModel::SaveCalibration (std::string filename) const
+{
+  std::ofstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open calibration file " << filename);
+      return false;
+    }
+  WriteCalibration (file, m_coefficients);
+  return bool (file);
+}
+
+void
+RYLRLoraPropagationLossModel::WriteCalibration (std::ostream &os,
+                                                const Coefficients coefficients[MAX_SF + 1])
+{
+  os << "# sf constant linear logarithmic referenceDistance breakpoint piecewise offset" << std::endl;
+  os.precision (17);
+  for (uint8_t sf = MIN_SF; sf <= MAX_SF; sf++)
+    {
+      const Coefficients &c = coefficients[sf];
+      os << (int)sf << " " << c.constant << " " << c.linear << " " << c.logarithmic << " "
+         << c.referenceDistance << " " << c.breakpoint << " " << c.piecewise << " "
+         << c.offset << std::endl;
+    }
+}
+
+void
+RYLRLoraPropagationLossModel::SetCalibrationFile (std::string filename)
+{
+  if (!filename.empty () && !LoadCalibration (filename))
+    {
+      NS_FATAL_ERROR ("Unable to read calibration file " << filename);
+    }
+  m_calibrationFile = filename;
+}
+
+std::string
+RYLRLoraPropagationLossModel::GetCalibrationFile (void) const
+{
+  return m_calibrationFile;
+}
+
 double
 RYLRLoraPropagationLossModel::DoCalcRxPower (double txPowerDbm,
                                             uint8_t txSF,
                                             Ptr<MobilityModel> a,
                                             Ptr<MobilityModel> b) const
 {
-
   double distance = a->GetDistanceFrom (b);
-  if (distance < 0)
-    distance = -distance;
-
-  double pathLossDb;
-  double minPathLossDb;
-  double maxPathLossDb;
-  double antennaLossDb;
-  double maxRange;  // in meters
-
-  if (!(txSF >= 7 && txSF <= 12)) {
-    NS_LOG_DEBUG ("SF="<<(int)txSF<<" not supported, using SF 7 to calculate rxPower");
-    txSF = 7;
-  }
-
-// TODO: Use actual data for SF 7,8,9,10,12 [Miller]
-  if (txSF == 7) {
-    minPathLossDb = 49 + 14;       // RYLR experimental max RSSI was -49 for 14 txPowerDbm
-    maxPathLossDb = 114 + 14;      // RYLR experimental min RSSI was -106 for 14 txPowerDbm
-    antennaLossDb = 123 - 114;     // SX1276 sensitivity -134, for RYLR sensitivity -106
-    maxRange = 900;                // RYLR experimental distance for maxPathLossDb
-  }
-  else if (txSF == 8) {
-    minPathLossDb = 49 + 14;       // RYLR experimental max RSSI was -49 for 14 txPowerDbm
-    maxPathLossDb = 112 + 14;      // RYLR experimental min RSSI was -106 for 14 txPowerDbm
-    antennaLossDb = 126 - 112;     // SX1276 sensitivity -134, for RYLR sensitivity -106
-    maxRange = 925;                // RYLR experimental distance for maxPathLossDb
-  }
-  else if (txSF == 9) {
-    minPathLossDb = 49 + 14;       // RYLR experimental max RSSI was -49 for 14 txPowerDbm
-    maxPathLossDb = 110 + 14;      // RYLR experimental min RSSI was -106 for 14 txPowerDbm
-    antennaLossDb = 129 - 110;     // SX1276 sensitivity -134, for RYLR sensitivity -106
-    maxRange = 975;                // RYLR experimental distance for maxPathLossDb
-  }
-  else if (txSF == 10) {
-    minPathLossDb = 49 + 14;       // RYLR experimental max RSSI was -49 for 14 txPowerDbm
-    maxPathLossDb = 108 + 14;      // RYLR experimental min RSSI was -106 for 14 txPowerDbm
-    antennaLossDb = 132 - 108;     // SX1276 sensitivity -134, for RYLR sensitivity -106
-    maxRange = 1025;                // RYLR experimental distance for maxPathLossDb
-  }
-  else if (txSF == 11) {
-    // TODO: Verify data
-    minPathLossDb = 49 + 14;       // RYLR experimental max RSSI was -49 for 14 txPowerDbm
-    maxPathLossDb = 106 + 14;      // RYLR experimental min RSSI was -106 for 14 txPowerDbm
-    antennaLossDb = 134 - 106;     // SX1276 sensitivity -134, for RYLR sensitivity -106
-    maxRange = 1100;                // RYLR experimental distance for maxPathLossDb, was found to be ~600
-  }
-  else if (txSF == 12) {
-    minPathLossDb = 49 + 14;       // RYLR experimental max RSSI was -49 for 14 txPowerDbm
-    maxPathLossDb = 104 + 14;      // RYLR experimental min RSSI was -106 for 14 txPowerDbm
-    antennaLossDb = 136 - 104;     // SX1276 sensitivity -134, for RYLR sensitivity -106
-    maxRange = 1275;                // RYLR experimental distance for maxPathLossDb
-  }
- 
-  // TODO: Find better function to approximate loss with real data [Miller]
-  // Linear approx
-  pathLossDb = (((maxPathLossDb - minPathLossDb)/(maxRange - 0)) * distance) + minPathLossDb;
+
+  // SFs that are not calibrated use the coefficients of SF 7
+  const Coefficients &c = m_coefficients[txSF <= MAX_SF ? txSF : MIN_SF];
+
+  double pathLossDb = c.constant + c.linear * distance
+    + c.logarithmic * std::log10 (std::max (distance, c.referenceDistance))
+    + c.piecewise * std::max (distance - c.breakpoint, 0.0);
+
   // Make up for antenna loss from RYLR to compare with sensitivity values of SX1276 for reception
-  double rxc = - pathLossDb + antennaLossDb;
+  double rxc = - pathLossDb + c.offset;
   NS_LOG_DEBUG ("distance="<<distance<<"m, "<< "attenuation coefficient="<<rxc<<"db, SF="<<(int)txSF);
   return txPowerDbm + rxc;
 }
@@ -25,6 +25,8 @@
 #include "ns3/object.h"
 #include "ns3/random-variable-stream.h"
 #include <map>
+#include <ostream>
+#include <string>
 
 namespace ns3 {
 
@@ -101,11 +103,46 @@ private:
  *
  * \brief The propagation loss follows a probablity distribution based on distance
  * and SF (Spreading Factor) for the RYLR896 using SX1276
+ *
+ * The loss of each SF is described by a set of coefficients, so that it can
+ * follow a linear, log-distance or piecewise linear fit of field measurements:
+ *
+ * loss = constant + linear * d + logarithmic * log10 (max (d, referenceDistance))
+ *        + piecewise * max (d - breakpoint, 0)
+ *
+ * and the received power is txPower - loss + offset, where the offset maps the
+ * sensitivity of the RYLR896 to that of the SX1276 used for reception. The
+ * default coefficients are linear fits of RYLR896 measurements. They can be
+ * replaced by a calibration file, e.g., one written by LoraCalibrationFitter,
+ * with a line for each SF:
+ *
+ * sf constant linear logarithmic referenceDistance breakpoint piecewise offset
+ *
+ * Empty lines and lines starting with '#' are ignored, and SFs that are not in
+ * the file keep their default coefficients. SFs outside [7, 12] use the
+ * coefficients of SF 7.
  */
 
 class RYLRLoraPropagationLossModel : public LoraPropagationLossModel
 {
 public:
+  /**
+   * The coefficients of the loss of a SF.
+   */
+  struct Coefficients
+  {
+    double constant; //!< Loss at zero distance [dB]
+    double linear; //!< Loss per meter [dB/m]
+    double logarithmic; //!< Loss per decade of distance [dB]
+    double referenceDistance; //!< Shortest distance of the logarithmic term [m]
+    double breakpoint; //!< Distance after which the piecewise term applies [m]
+    double piecewise; //!< Additional loss per meter after the breakpoint [dB/m]
+    double offset; //!< Gain added to the received power [dB]
+  };
+
+  static const uint8_t MIN_SF = 7; //!< The smallest calibrated SF
+  static const uint8_t MAX_SF = 12; //!< The largest calibrated SF
+
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -116,6 +153,44 @@ public:
   RYLRLoraPropagationLossModel (uint8_t txSF);
   virtual ~RYLRLoraPropagationLossModel ();
 
+  /**
+   * Get the default coefficients of a SF.
+   */
+  static Coefficients GetDefaultCoefficients (uint8_t sf);
+
+  /**
+   * Set the coefficients of a SF in [MIN_SF, MAX_SF].
+   */
+  void SetCoefficients (uint8_t sf, Coefficients coefficients);
+
+  /**
+   * Get the coefficients used for a SF.
+   */
+  Coefficients GetCoefficients (uint8_t sf) const;
+
+  /**
+   * Read the coefficients from a calibration file.
+   *
+   * \param filename The file to read.
+   * \return False if the file can't be read or is malformed, in which case
+   * the coefficients are left unchanged.
+   */
+  bool LoadCalibration (std::string filename);
+
+  /**
+   * Write the coefficients of all SFs to a calibration file.
+   *
+   * \param filename The file to write.
+   * \return Whether the file was written successfully.
+   */
+  bool SaveCalibration (std::string filename) const;
+
+  /**
+   * Write coefficients in the format of a calibration file.
+   */
+  static void WriteCalibration (std::ostream &os,
+                                const Coefficients coefficients[MAX_SF + 1]);
+
 private:
   /**
    * \brief Copy constructor
@@ -135,6 +210,21 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+
+  /**
+   * Set the calibration file through the CalibrationFile attribute.
+   */
+  void SetCalibrationFile (std::string filename);
+
+  std::string GetCalibrationFile (void) const;
+
+  std::string m_calibrationFile; //!< The last calibration file that was read
+
+  /**
+   * The coefficients of each SF, indexed by SF. SFs below MIN_SF hold the
+   * coefficients of SF 7.
+   */
+  Coefficients m_coefficients[MAX_SF + 1];
 };
 
 /**
@@ -17,6 +17,7 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
 #include "ns3/energy-source.h"
 #include "lora-radio-energy-model.h"
 
@@ -63,6 +64,21 @@ LoraRadioEnergyModel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&LoraRadioEnergyModel::m_txCurrentModel),
                    MakePointerChecker<LoraTxCurrentModel> ())
+    .AddAttribute ("LazyAccounting",
+                   "Whether state changes should only be accumulated as time "
+                   "spent in each state, and converted to energy when the "
+                   "energy source queries the current draw.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LoraRadioEnergyModel::SetLazyAccounting,
+                                        &LoraRadioEnergyModel::GetLazyAccounting),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CheckpointInterval",
+                   "The interval between the periodic checkpoints at which the "
+                   "energy source is updated when lazy accounting is enabled. "
+                   "A zero interval disables checkpoints.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&LoraRadioEnergyModel::m_checkpointInterval),
+                   MakeTimeChecker ())
     .AddTraceSource ("TotalEnergyConsumption",
                      "Total energy consumption of the radio device.",
                      MakeTraceSourceAccessor (&LoraRadioEnergyModel::m_totalEnergyConsumption),
@@ -78,6 +94,14 @@ LoraRadioEnergyModel::LoraRadioEnergyModel ()
   m_lastUpdateTime = Seconds (0.0);
   m_nPendingChangeState = 0;
   m_isSupersededChangeState = false;
+  m_lazyAccounting = false;
+  m_frozenCharge = 0;
+  m_frozenTimeNs = 0;
+  for (int i = 0; i < 4; i++)
+    {
+      m_stateTimeNs[i] = 0;
+      m_totalStateTimeNs[i] = 0;
+    }
   m_energyDepletionCallback.Nullify ();
   m_source = NULL;
   // set callback for EndDeviceLoraPhy listener
@@ -99,13 +123,96 @@ LoraRadioEnergyModel::SetEnergySource (Ptr<EnergySource> source)
   NS_LOG_FUNCTION (this << source);
   NS_ASSERT (source != NULL);
   m_source = source;
+
+  if (m_lazyAccounting && m_checkpointInterval.IsStrictlyPositive ()
+      && !m_checkpointEvent.IsRunning ())
+    {
+      m_checkpointEvent = Simulator::Schedule (m_checkpointInterval,
+                                               &LoraRadioEnergyModel::Checkpoint,
+                                               this);
+    }
+}
+
+Ptr<EnergySource>
+LoraRadioEnergyModel::GetEnergySource (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_source;
 }
 
 double
 LoraRadioEnergyModel::GetTotalEnergyConsumption (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_totalEnergyConsumption;
+
+  if (!m_lazyAccounting || m_source == 0)
+    {
+      return m_totalEnergyConsumption;
+    }
+
+  // Add the energy that was not folded yet, without folding it: the pending
+  // time must still be reported to the energy source at its next update
+  int64_t ongoingNs = (Simulator::Now () - m_lastUpdateTime).GetNanoSeconds ();
+  double charge = GetPendingCharge ()
+    + GetStateCurrentA (m_currentState) * ongoingNs;
+  return m_totalEnergyConsumption
+         + charge * 1e-9 * m_source->GetSupplyVoltage ();
+}
+
+void
+LoraRadioEnergyModel::SetLazyAccounting (bool lazy)
+{
+  NS_LOG_FUNCTION (this << lazy);
+
+  if (lazy == m_lazyAccounting)
+    {
+      return;
+    }
+
+  if (!lazy)
+    {
+      m_checkpointEvent.Cancel ();
+      if (m_source != 0)
+        {
+          // Let the source collect the pending energy with the average
+          // current, before going back to per-transition updates
+          m_source->UpdateEnergySource ();
+          FoldPendingCharge ();
+        }
+    }
+  else if (m_source != 0)
+    {
+      // Settle the time spent in the current state, so that the first lazy
+      // period starts together with the one of the source
+      m_source->UpdateEnergySource ();
+      Time duration = Simulator::Now () - m_lastUpdateTime;
+      m_totalEnergyConsumption += duration.GetSeconds ()
+        * GetStateCurrentA (m_currentState) * m_source->GetSupplyVoltage ();
+      m_totalStateTimeNs[m_currentState] += duration.GetNanoSeconds ();
+      m_lastUpdateTime = Simulator::Now ();
+
+      if (m_checkpointInterval.IsStrictlyPositive () && !m_checkpointEvent.IsRunning ())
+        {
+          m_checkpointEvent = Simulator::Schedule (m_checkpointInterval,
+                                                   &LoraRadioEnergyModel::Checkpoint,
+                                                   this);
+        }
+    }
+
+  m_lazyAccounting = lazy;
+  m_frozenCharge = 0;
+  m_frozenTimeNs = 0;
+  for (int i = 0; i < 4; i++)
+    {
+      m_stateTimeNs[i] = 0;
+    }
+}
+
+bool
+LoraRadioEnergyModel::GetLazyAccounting (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_lazyAccounting;
 }
 
 double
@@ -119,6 +226,10 @@ void
 LoraRadioEnergyModel::SetStandbyCurrentA (double idleCurrentA)
 {
   NS_LOG_FUNCTION (this << idleCurrentA);
+  if (idleCurrentA != m_idleCurrentA)
+    {
+      FreezeStateCharge (EndDeviceLoraPhy::STANDBY);
+    }
   m_idleCurrentA = idleCurrentA;
 }
 
@@ -133,6 +244,10 @@ void
 LoraRadioEnergyModel::SetTxCurrentA (double txCurrentA)
 {
   NS_LOG_FUNCTION (this << txCurrentA);
+  if (txCurrentA != m_txCurrentA)
+    {
+      FreezeStateCharge (EndDeviceLoraPhy::TX);
+    }
   m_txCurrentA = txCurrentA;
 }
 
@@ -147,6 +262,10 @@ void
 LoraRadioEnergyModel::SetRxCurrentA (double rxCurrentA)
 {
   NS_LOG_FUNCTION (this << rxCurrentA);
+  if (rxCurrentA != m_rxCurrentA)
+    {
+      FreezeStateCharge (EndDeviceLoraPhy::RX);
+    }
   m_rxCurrentA = rxCurrentA;
 }
 
@@ -161,6 +280,10 @@ void
 LoraRadioEnergyModel::SetSleepCurrentA (double sleepCurrentA)
 {
   NS_LOG_FUNCTION (this << sleepCurrentA);
+  if (sleepCurrentA != m_sleepCurrentA)
+    {
+      FreezeStateCharge (EndDeviceLoraPhy::SLEEP);
+    }
   m_sleepCurrentA = sleepCurrentA;
 }
 
@@ -171,6 +294,19 @@ LoraRadioEnergyModel::GetCurrentState (void) const
   return m_currentState;
 }
 
+Time
+LoraRadioEnergyModel::GetStateDuration (EndDeviceLoraPhy::State state) const
+{
+  NS_LOG_FUNCTION (this << state);
+
+  int64_t duration = m_totalStateTimeNs[state];
+  if (state == m_currentState)
+    {
+      duration += (Simulator::Now () - m_lastUpdateTime).GetNanoSeconds ();
+    }
+  return NanoSeconds (duration);
+}
+
 void
 LoraRadioEnergyModel::SetEnergyDepletionCallback (
   LoraRadioEnergyDepletionCallback callback)
@@ -206,7 +342,12 @@ LoraRadioEnergyModel::SetTxCurrentFromModel (double txPowerDbm)
 {
   if (m_txCurrentModel)
     {
-      m_txCurrentA = m_txCurrentModel->CalcTxCurrent (txPowerDbm);
+      double txCurrentA = m_txCurrentModel->CalcTxCurrent (txPowerDbm);
+      if (txCurrentA != m_txCurrentA)
+        {
+          FreezeStateCharge (EndDeviceLoraPhy::TX);
+        }
+      m_txCurrentA = txCurrentA;
     }
 }
 
@@ -215,6 +356,15 @@ LoraRadioEnergyModel::ChangeState (int newState)
 {
   NS_LOG_FUNCTION (this << newState);
 
+  if (m_lazyAccounting)
+    {
+      // Only keep track of the time spent in the previous state: energy will
+      // be computed when the energy source asks for the current draw
+      AccumulateStateTime ();
+      SetLoraRadioState ((EndDeviceLoraPhy::State) newState);
+      return;
+    }
+
   Time duration = Simulator::Now () - m_lastUpdateTime;
   NS_ASSERT (duration.GetNanoSeconds () >= 0);     // check if duration is valid
 
@@ -241,6 +391,7 @@ LoraRadioEnergyModel::ChangeState (int newState)
 
   // update total energy consumption
   m_totalEnergyConsumption += energyToDecrease;
+  m_totalStateTimeNs[m_currentState] += duration.GetNanoSeconds ();
 
   // update last update time stamp
   m_lastUpdateTime = Simulator::Now ();
@@ -277,6 +428,7 @@ LoraRadioEnergyModel::HandleEnergyDepletion (void)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_DEBUG ("LoraRadioEnergyModel:Energy is depleted!");
+  FoldPendingCharge ();
   // invoke energy depletion callback, if set.
   if (!m_energyDepletionCallback.IsNull ())
     {
@@ -289,6 +441,7 @@ LoraRadioEnergyModel::HandleEnergyChanged (void)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_DEBUG ("LoraRadioEnergyModel:Energy changed!");
+  FoldPendingCharge ();
 }
 
 void
@@ -296,6 +449,7 @@ LoraRadioEnergyModel::HandleEnergyRecharged (void)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_DEBUG ("LoraRadioEnergyModel:Energy is recharged!");
+  FoldPendingCharge ();
   // invoke energy recharged callback, if set.
   if (!m_energyRechargedCallback.IsNull ())
     {
@@ -318,6 +472,7 @@ void
 LoraRadioEnergyModel::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_checkpointEvent.Cancel ();
   m_source = NULL;
   m_energyDepletionCallback.Nullify ();
 }
@@ -326,7 +481,34 @@ double
 LoraRadioEnergyModel::DoGetCurrentA (void) const
 {
   NS_LOG_FUNCTION (this);
-  switch (m_currentState)
+
+  if (!m_lazyAccounting || m_source == 0)
+    {
+      return GetStateCurrentA (m_currentState);
+    }
+
+  // Report the average current since the last update of the energy source,
+  // including the time spent in the current state. The charge is only folded
+  // once the source notifies the model that it was updated.
+  int64_t ongoingNs = (Simulator::Now () - m_lastUpdateTime).GetNanoSeconds ();
+  int64_t totalNs = m_frozenTimeNs + ongoingNs;
+  for (int i = 0; i < 4; i++)
+    {
+      totalNs += m_stateTimeNs[i];
+    }
+  if (totalNs == 0)
+    {
+      return GetStateCurrentA (m_currentState);
+    }
+
+  double charge = GetPendingCharge () + GetStateCurrentA (m_currentState) * ongoingNs;
+  return charge / totalNs;
+}
+
+double
+LoraRadioEnergyModel::GetStateCurrentA (EndDeviceLoraPhy::State state) const
+{
+  switch (state)
     {
     case EndDeviceLoraPhy::STANDBY:
       return m_idleCurrentA;
@@ -337,7 +519,96 @@ LoraRadioEnergyModel::DoGetCurrentA (void) const
     case EndDeviceLoraPhy::SLEEP:
       return m_sleepCurrentA;
     default:
-      NS_FATAL_ERROR ("LoraRadioEnergyModel:Undefined radio state:" << m_currentState);
+      NS_FATAL_ERROR ("LoraRadioEnergyModel:Undefined radio state:" << state);
+    }
+  return 0;
+}
+
+void
+LoraRadioEnergyModel::AccumulateStateTime (void)
+{
+  Time now = Simulator::Now ();
+  int64_t duration = (now - m_lastUpdateTime).GetNanoSeconds ();
+  NS_ASSERT (duration >= 0);
+  m_stateTimeNs[m_currentState] += duration;
+  m_totalStateTimeNs[m_currentState] += duration;
+  m_lastUpdateTime = now;
+}
+
+void
+LoraRadioEnergyModel::FreezeStateCharge (EndDeviceLoraPhy::State state)
+{
+  if (!m_lazyAccounting)
+    {
+      return;
+    }
+
+  if (state == m_currentState)
+    {
+      AccumulateStateTime ();
+    }
+
+  if (m_stateTimeNs[state] != 0)
+    {
+      m_frozenCharge += GetStateCurrentA (state) * m_stateTimeNs[state];
+      m_frozenTimeNs += m_stateTimeNs[state];
+      m_stateTimeNs[state] = 0;
+    }
+}
+
+double
+LoraRadioEnergyModel::GetPendingCharge (void) const
+{
+  return m_frozenCharge
+         + m_idleCurrentA * m_stateTimeNs[EndDeviceLoraPhy::STANDBY]
+         + m_txCurrentA * m_stateTimeNs[EndDeviceLoraPhy::TX]
+         + m_rxCurrentA * m_stateTimeNs[EndDeviceLoraPhy::RX]
+         + m_sleepCurrentA * m_stateTimeNs[EndDeviceLoraPhy::SLEEP];
+}
+
+void
+LoraRadioEnergyModel::FoldPendingCharge (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_lazyAccounting || m_source == 0)
+    {
+      return;
+    }
+
+  AccumulateStateTime ();
+  double charge = GetPendingCharge ();
+  m_frozenCharge = 0;
+  m_frozenTimeNs = 0;
+  for (int i = 0; i < 4; i++)
+    {
+      m_stateTimeNs[i] = 0;
+    }
+
+  m_totalEnergyConsumption += charge * 1e-9 * m_source->GetSupplyVoltage ();
+
+  NS_LOG_DEBUG ("LoraRadioEnergyModel:Total energy consumption is " <<
+                m_totalEnergyConsumption << "J");
+}
+
+void
+LoraRadioEnergyModel::Checkpoint (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_source != 0)
+    {
+      // The source folds the charge when it notifies the model of the
+      // update; folding again only matters for sources that don't
+      m_source->UpdateEnergySource ();
+      FoldPendingCharge ();
+    }
+
+  if (m_lazyAccounting && m_checkpointInterval.IsStrictlyPositive ())
+    {
+      m_checkpointEvent = Simulator::Schedule (m_checkpointInterval,
+                                               &LoraRadioEnergyModel::Checkpoint,
+                                               this);
     }
 }
 
@@ -19,6 +19,8 @@
 
 #include "ns3/device-energy-model.h"
 #include "ns3/traced-value.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
 #include "end-device-lora-phy.h"
 #include "lora-tx-current-model.h"
 
@@ -123,6 +125,22 @@ private:
  * object. The EnergySource object will query this model for the total current.
  * Then the EnergySource object uses the total current to calculate energy.
  *
+ * Lazy accounting: when the LazyAccounting attribute is set, state changes
+ * only add the integer number of nanoseconds spent in the previous state to a
+ * per-state counter, and the EnergySource is not notified. In this mode, the
+ * current reported to the EnergySource is the average current since its
+ * previous update, i.e., the dot product of these counters with the state
+ * currents divided by the elapsed time, so that the energy it removes matches
+ * the one accumulated by the model. Querying the current has no side effects:
+ * the pending energy is only added to the total once the EnergySource has
+ * updated, when it notifies the model through HandleEnergyChanged,
+ * HandleEnergyDepletion or HandleEnergyRecharged (i.e., on its own periodic
+ * updates, which are also where depletion thresholds are checked), and at the
+ * optional checkpoints set by the CheckpointInterval attribute.
+ * GetTotalEnergyConsumption includes the pending energy. The
+ * TotalEnergyConsumption trace keeps its meaning, but only fires at the
+ * EnergySource updates. Depletion is detected with the granularity of these
+ * updates, and the supply voltage is assumed to be constant between them.
  */
 class LoraRadioEnergyModel : public DeviceEnergyModel
 {
@@ -154,6 +172,11 @@ public:
    */
   void SetEnergySource (Ptr<EnergySource> source);
 
+  /**
+   * \returns Pointer to the EnergySource this model draws from.
+   */
+  Ptr<EnergySource> GetEnergySource (void) const;
+
   /**
    * \returns Total energy consumption of the wifi device.
    *
@@ -161,6 +184,18 @@ public:
    */
   double GetTotalEnergyConsumption (void) const;
 
+  /**
+   * \brief Enable or disable lazy energy accounting.
+   *
+   * \param lazy whether state changes should only be accumulated in per-state
+   * time counters, instead of notifying the energy source each time.
+   */
+  void SetLazyAccounting (bool lazy);
+  /**
+   * \returns whether lazy energy accounting is enabled.
+   */
+  bool GetLazyAccounting (void) const;
+
   // Setter & getters for state power consumption.
   /**
    * \brief Gets idle current.
@@ -216,6 +251,13 @@ public:
    */
   EndDeviceLoraPhy::State GetCurrentState (void) const;
 
+  /**
+   * \param state A radio state.
+   * \returns The total time the radio spent in the given state since the
+   * beginning of the simulation, up to now.
+   */
+  Time GetStateDuration (EndDeviceLoraPhy::State state) const;
+
   /**
    * \param callback Callback function.
    *
@@ -281,6 +323,8 @@ public:
   LoraRadioEnergyModelPhyListener * GetPhyListener (void);
 
 
+  friend class LoraCheckpoint;
+
 private:
   void DoDispose (void);
 
@@ -299,6 +343,45 @@ private:
    */
   void SetLoraRadioState (const EndDeviceLoraPhy::State state);
 
+  /**
+   * \param state A radio state.
+   * \returns The current drawn by the radio in the given state.
+   */
+  double GetStateCurrentA (EndDeviceLoraPhy::State state) const;
+
+  /**
+   * Add the time elapsed since the last update to the counter of the current
+   * state (lazy accounting only).
+   */
+  void AccumulateStateTime (void);
+
+  /**
+   * Convert the time accumulated in a state to charge, before the current
+   * associated to that state is changed (lazy accounting only).
+   *
+   * \param state The state whose current is about to change.
+   */
+  void FreezeStateCharge (EndDeviceLoraPhy::State state);
+
+  /**
+   * \returns The charge (in A*ns) corresponding to the time accumulated in
+   * the per-state counters, including the frozen charge.
+   */
+  double GetPendingCharge (void) const;
+
+  /**
+   * Add the pending charge, up to now, to the total energy consumption and
+   * reset the per-state counters. Called once the energy source has removed
+   * the same energy (lazy accounting only).
+   */
+  void FoldPendingCharge (void);
+
+  /**
+   * Notify the energy source, so that pending energy is accounted for and
+   * depletion is checked, and schedule the next checkpoint.
+   */
+  void Checkpoint (void);
+
   Ptr<EnergySource> m_source; ///< energy source
 
   // Member variables for current draw in different radio modes.
@@ -314,11 +397,21 @@ private:
 
   // State variables.
   EndDeviceLoraPhy::State m_currentState;  ///< current state the radio is in
-  Time m_lastUpdateTime;          ///< time stamp of previous energy update
+  Time m_lastUpdateTime;  ///< time stamp of previous energy update
 
   uint8_t m_nPendingChangeState; ///< pending state change
   bool m_isSupersededChangeState; ///< superseded change state
 
+  // Lazy accounting state
+  bool m_lazyAccounting; ///< whether lazy accounting is enabled
+  int64_t m_stateTimeNs[4]; ///< ns spent in each state since the last fold
+  double m_frozenCharge; ///< charge (A*ns) frozen before a current change
+  int64_t m_frozenTimeNs; ///< time (ns) corresponding to m_frozenCharge
+  Time m_checkpointInterval; ///< interval between checkpoints
+  EventId m_checkpointEvent; ///< the next checkpoint
+
+  int64_t m_totalStateTimeNs[4]; ///< ns spent in each state, never reset
+
   /// Energy depletion callback
   LoraRadioEnergyDepletionCallback m_energyDepletionCallback;
 
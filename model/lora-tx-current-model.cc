@@ -16,6 +16,7 @@
 #include "lora-tx-current-model.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "lora-utils.h"
 
 namespace ns3 {
@@ -68,6 +69,12 @@ LinearLoraTxCurrentModel::GetTypeId (void)
                    MakeDoubleAccessor (&LinearLoraTxCurrentModel::SetStandbyCurrent,
                                        &LinearLoraTxCurrentModel::GetStandbyCurrent),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("FastPowerConversion",
+                   "Whether to convert the transmission power to Watts with "
+                   "the fast approximation of lora-utils",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LinearLoraTxCurrentModel::m_fastPowerConversion),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -125,7 +132,7 @@ double
 LinearLoraTxCurrentModel::CalcTxCurrent (double txPowerDbm) const
 {
   NS_LOG_FUNCTION (this << txPowerDbm);
-  return DbmToW (txPowerDbm) / (m_voltage * m_eta) + m_idleCurrent;
+  return DbmToW (txPowerDbm, m_fastPowerConversion) / (m_voltage * m_eta) + m_idleCurrent;
 }
 
 
@@ -99,6 +99,7 @@ private:
   double m_eta;     //!< ETA
   double m_voltage;     //!< Voltage
   double m_idleCurrent;     //!< Standby current
+  bool m_fastPowerConversion;     //!< Whether to use the fast dBm conversion
 };
 
 class ConstantLoraTxCurrentModel : public LoraTxCurrentModel
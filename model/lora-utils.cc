@@ -14,7 +14,10 @@
  */
 
 #include "lora-utils.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <stdint.h>
 
 namespace ns3 {
 namespace lorawan {
@@ -45,5 +48,144 @@ RatioToDb (double ratio)
   return 10.0 * std::log10 (ratio);
 }
 
+const double FAST_CONVERSION_MAX_RELATIVE_ERROR = 1e-6;
+const double FAST_CONVERSION_MAX_DB_ERROR = 1e-6;
+
+namespace {
+
+const double LN2 = 0.69314718055994530942;
+const double LOG2_10_OVER_10 = 0.33219280948873623479; //!< log2 (10) / 10
+const double TEN_OVER_LN10 = 4.34294481903251827651; //!< 10 / ln (10)
+const double SQRT2 = 1.41421356237309504880;
+
+/**
+ * Compute 10^(db / 10) as 2^n * 2^f, where n is the integer closest to
+ * log2 (10) * db / 10 and f is in [-0.5, 0.5]. 2^n is built directly as a
+ * floating point number, and 2^f = e^(f ln 2) is approximated by its Taylor
+ * polynomial of degree 6, whose relative error is below 2e-7.
+ */
+inline double
+FastDbToRatio (double db)
+{
+  double y = std::min (std::max (db * LOG2_10_OVER_10, -1022.0), 1023.0);
+  double n = std::floor (y + 0.5);
+  double x = (y - n) * LN2;
+  double p = 1 + x * (1 + x * (1.0 / 2 + x * (1.0 / 6 + x * (1.0 / 24 + x *
+                                                               (1.0 / 120 + x / 720)))));
+  uint64_t bits = uint64_t (int64_t (n) + 1023) << 52;
+  double scale;
+  std::memcpy (&scale, &bits, sizeof (scale));
+  return p * scale;
+}
+
+/**
+ * Compute 10 log10 (ratio) from ratio = m * 2^e, where m is brought into
+ * [sqrt (2) / 2, sqrt (2)), as 10 / ln (10) * (e ln 2 + ln m). ln m is
+ * computed as 2 atanh (s) with s = (m - 1) / (m + 1), whose series is
+ * truncated after the s^9 term, with an absolute error below 1e-9.
+ */
+inline double
+FastRatioToDb (double ratio)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &ratio, sizeof (bits));
+  double e = double (int64_t ((bits >> 52) & 0x7ff) - 1023);
+  bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+  double m;
+  std::memcpy (&m, &bits, sizeof (m));
+  double large = m > SQRT2 ? 1 : 0;
+  m *= 1 - 0.5 * large;
+  e += large;
+
+  double s = (m - 1) / (m + 1);
+  double s2 = s * s;
+  double lnM = 2 * s * (1 + s2 * (1.0 / 3 + s2 * (1.0 / 5 + s2 * (1.0 / 7 + s2 / 9))));
+  return TEN_OVER_LN10 * (e * LN2 + lnM);
+}
+
+}
+
+void
+DbToRatio (const double *db, double *ratio, std::size_t n, bool fast)
+{
+  if (fast)
+    {
+      for (std::size_t i = 0; i < n; i++)
+        {
+          ratio[i] = FastDbToRatio (db[i]);
+        }
+    }
+  else
+    {
+      for (std::size_t i = 0; i < n; i++)
+        {
+          ratio[i] = std::pow (10.0, db[i] / 10.0);
+        }
+    }
+}
+
+void
+DbmToW (const double *dbm, double *w, std::size_t n, bool fast)
+{
+  DbToRatio (dbm, w, n, fast);
+  for (std::size_t i = 0; i < n; i++)
+    {
+      w[i] /= 1000.0;
+    }
+}
+
+void
+WToDbm (const double *w, double *dbm, std::size_t n, bool fast)
+{
+  for (std::size_t i = 0; i < n; i++)
+    {
+      dbm[i] = w[i] * 1000.0;
+    }
+  RatioToDb (dbm, dbm, n, fast);
+}
+
+void
+RatioToDb (const double *ratio, double *db, std::size_t n, bool fast)
+{
+  if (fast)
+    {
+      for (std::size_t i = 0; i < n; i++)
+        {
+          db[i] = FastRatioToDb (ratio[i]);
+        }
+    }
+  else
+    {
+      for (std::size_t i = 0; i < n; i++)
+        {
+          db[i] = 10.0 * std::log10 (ratio[i]);
+        }
+    }
+}
+
+double
+DbToRatio (double db, bool fast)
+{
+  return fast ? FastDbToRatio (db) : DbToRatio (db);
+}
+
+double
+DbmToW (double dbm, bool fast)
+{
+  return fast ? FastDbToRatio (dbm) / 1000.0 : DbmToW (dbm);
+}
+
+double
+WToDbm (double w, bool fast)
+{
+  return fast ? FastRatioToDb (w * 1000.0) : WToDbm (w);
+}
+
+double
+RatioToDb (double ratio, bool fast)
+{
+  return fast ? FastRatioToDb (ratio) : RatioToDb (ratio);
+}
+
 }
 } //namespace ns3
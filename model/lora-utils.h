@@ -18,6 +18,7 @@
 
 #include "ns3/nstime.h"
 #include "ns3/uinteger.h"
+#include <cstddef>
 
 namespace ns3 {
 namespace lorawan {
@@ -55,6 +56,90 @@ double WToDbm (double w);
  */
 double RatioToDb (double ratio);
 
+/**
+ * The largest relative error of the fast conversions from dB or dBm to
+ * linear values.
+ */
+extern const double FAST_CONVERSION_MAX_RELATIVE_ERROR;
+
+/**
+ * The largest absolute error [dB] of the fast conversions from linear
+ * values to dB or dBm.
+ */
+extern const double FAST_CONVERSION_MAX_DB_ERROR;
+
+/**
+ * Convert an array of values from dB to ratios.
+ *
+ * The fast mode replaces std::pow with a polynomial approximation, whose
+ * relative error is below FAST_CONVERSION_MAX_RELATIVE_ERROR for inputs
+ * between -3000 and +3000 dB. Neither mode has data-dependent branches, so
+ * that the loops can be vectorized by the compiler.
+ *
+ * \param db The values in dB.
+ * \param ratio The array to fill with the ratios, which can be db itself.
+ * \param n The number of values.
+ * \param fast Whether to use the fast mode.
+ */
+void DbToRatio (const double *db, double *ratio, std::size_t n, bool fast = false);
+
+/**
+ * Convert an array of powers from dBm to Watts, as DbToRatio does.
+ *
+ * \param dbm The powers in dBm.
+ * \param w The array to fill with the powers in Watts, which can be dbm itself.
+ * \param n The number of values.
+ * \param fast Whether to use the fast mode.
+ */
+void DbmToW (const double *dbm, double *w, std::size_t n, bool fast = false);
+
+/**
+ * Convert an array of powers from Watts to dBm, as RatioToDb does.
+ *
+ * \param w The powers in Watts.
+ * \param dbm The array to fill with the powers in dBm, which can be w itself.
+ * \param n The number of values.
+ * \param fast Whether to use the fast mode.
+ */
+void WToDbm (const double *w, double *dbm, std::size_t n, bool fast = false);
+
+/**
+ * Convert an array of ratios to dB.
+ *
+ * The fast mode replaces std::log10 with a decomposition of the floating
+ * point representation and a polynomial approximation, whose absolute error
+ * is below FAST_CONVERSION_MAX_DB_ERROR for positive, normal inputs. Zero
+ * and infinite inputs give values below -3000 dB and above +3000 dB
+ * respectively, while the result of negative inputs is meaningless.
+ *
+ * \param ratio The ratios.
+ * \param db The array to fill with the values in dB, which can be ratio
+ * itself.
+ * \param n The number of values.
+ * \param fast Whether to use the fast mode.
+ */
+void RatioToDb (const double *ratio, double *db, std::size_t n, bool fast = false);
+
+/**
+ * Convert a value from dB to a ratio, with the fast mode if requested.
+ */
+double DbToRatio (double db, bool fast);
+
+/**
+ * Convert a power from dBm to Watts, with the fast mode if requested.
+ */
+double DbmToW (double dbm, bool fast);
+
+/**
+ * Convert a power from Watts to dBm, with the fast mode if requested.
+ */
+double WToDbm (double w, bool fast);
+
+/**
+ * Convert a ratio to dB, with the fast mode if requested.
+ */
+double RatioToDb (double ratio, bool fast);
+
 }   // namespace ns3
 
 }
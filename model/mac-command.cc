@@ -886,7 +886,8 @@ NewChannelReq::Deserialize (Buffer::Iterator &start)
   // Read the data
   m_chIndex = start.ReadU8 ();
   uint32_t encodedFrequency = 0;
-  encodedFrequency |= uint32_t (start.ReadU16 ()) << 8;
+  encodedFrequency |= uint32_t (start.ReadU8 ()) << 16;
+  encodedFrequency |= uint32_t (start.ReadU8 ()) << 8;
   encodedFrequency |= uint32_t (start.ReadU8 ());
   m_frequency = double (encodedFrequency) * 100;
   uint8_t dataRateByte = start.ReadU8 ();
@@ -1068,7 +1069,7 @@ RxTimingSetupAns::RxTimingSetupAns ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_commandType = DEV_STATUS_REQ;
+  m_commandType = RX_TIMING_SETUP_ANS;
   m_serializedSize = 1;
 }
 
@@ -1108,7 +1109,7 @@ DlChannelAns::DlChannelAns ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_commandType = DEV_STATUS_REQ;
+  m_commandType = DL_CHANNEL_ANS;
   m_serializedSize = 1;
 }
 
@@ -1148,7 +1149,7 @@ TxParamSetupReq::TxParamSetupReq ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_commandType = DEV_STATUS_REQ;
+  m_commandType = TX_PARAM_SETUP_REQ;
   m_serializedSize = 1;
 }
 
@@ -1188,7 +1189,7 @@ TxParamSetupAns::TxParamSetupAns ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_commandType = DEV_STATUS_REQ;
+  m_commandType = TX_PARAM_SETUP_ANS;
   m_serializedSize = 1;
 }
 
@@ -1220,5 +1221,374 @@ TxParamSetupAns::Print (std::ostream &os) const
   os << "TxParamSetupAns" << std::endl;
 }
 
+//////////////////////
+// InlineMacCommand //
+//////////////////////
+
+InlineMacCommand::InlineMacCommand () :
+  type (INVALID)
+{
+  newChannelReq.frequency = 0;
+  newChannelReq.chIndex = 0;
+  newChannelReq.minDataRate = 0;
+  newChannelReq.maxDataRate = 0;
+}
+
+InlineMacCommand::InlineMacCommand (enum MacCommandType commandType) :
+  type (commandType)
+{
+  // The largest member of the union spans all of its bytes
+  newChannelReq.frequency = 0;
+  newChannelReq.chIndex = 0;
+  newChannelReq.minDataRate = 0;
+  newChannelReq.maxDataRate = 0;
+}
+
+uint8_t
+InlineMacCommand::GetSerializedSize (enum MacCommandType commandType)
+{
+  // Sizes include the CID, and follow the ones used by the MacCommand classes
+  switch (commandType)
+    {
+    case (LINK_CHECK_ANS):
+    case (DEV_STATUS_ANS):
+      {
+        return 3;
+      }
+    case (LINK_ADR_REQ):
+    case (RX_PARAM_SETUP_REQ):
+      {
+        return 5;
+      }
+    case (NEW_CHANNEL_REQ):
+      {
+        return 6;
+      }
+    case (LINK_ADR_ANS):
+    case (DUTY_CYCLE_REQ):
+    case (RX_PARAM_SETUP_ANS):
+    case (NEW_CHANNEL_ANS):
+    case (RX_TIMING_SETUP_REQ):
+      {
+        return 2;
+      }
+    case (INVALID):
+      {
+        return 0;
+      }
+    default:
+      {
+        return 1;
+      }
+    }
+}
+
+enum MacCommandType
+InlineMacCommand::GetMacCommandFromCID (uint8_t cid, bool isUplink)
+{
+  // Uplink messages carry the LinkCheckReq and the answers of the device,
+  // downlink messages carry the LinkCheckAns and the requests of the server.
+  static const enum MacCommandType uplinkTypes[] = {
+    INVALID, INVALID, LINK_CHECK_REQ, LINK_ADR_ANS, DUTY_CYCLE_ANS,
+    RX_PARAM_SETUP_ANS, DEV_STATUS_ANS, NEW_CHANNEL_ANS, RX_TIMING_SETUP_ANS,
+    TX_PARAM_SETUP_ANS, DL_CHANNEL_ANS
+  };
+  static const enum MacCommandType downlinkTypes[] = {
+    INVALID, INVALID, LINK_CHECK_ANS, LINK_ADR_REQ, DUTY_CYCLE_REQ,
+    RX_PARAM_SETUP_REQ, DEV_STATUS_REQ, NEW_CHANNEL_REQ, RX_TIMING_SETUP_REQ,
+    TX_PARAM_SETUP_REQ, INVALID
+  };
+
+  if (cid > 0x0A)
+    {
+      return INVALID;
+    }
+  return isUplink ? uplinkTypes[cid] : downlinkTypes[cid];
+}
+
+uint8_t
+InlineMacCommand::GetSerializedSize (void) const
+{
+  return GetSerializedSize (type);
+}
+
+void
+InlineMacCommand::Serialize (Buffer::Iterator &start) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  // Write the CID
+  start.WriteU8 (MacCommand::GetCIDFromMacCommand (type));
+
+  // Write the data, if any
+  switch (type)
+    {
+    case (LINK_CHECK_ANS):
+      {
+        start.WriteU8 (linkCheckAns.margin);
+        start.WriteU8 (linkCheckAns.gwCnt);
+        break;
+      }
+    case (LINK_ADR_REQ):
+      {
+        start.WriteU8 (linkAdrReq.dataRate << 4 | (linkAdrReq.txPower & 0b1111));
+        start.WriteU16 (linkAdrReq.channelMask);
+        start.WriteU8 (linkAdrReq.chMaskCntl << 4 | (linkAdrReq.nbRep & 0b1111));
+        break;
+      }
+    case (LINK_ADR_ANS):
+      {
+        start.WriteU8 ((uint8_t (linkAdrAns.powerAck) << 2) |
+                       (uint8_t (linkAdrAns.dataRateAck) << 1) |
+                       uint8_t (linkAdrAns.channelMaskAck));
+        break;
+      }
+    case (DUTY_CYCLE_REQ):
+      {
+        start.WriteU8 (dutyCycleReq.maxDCycle);
+        break;
+      }
+    case (RX_PARAM_SETUP_REQ):
+      {
+        start.WriteU8 ((rxParamSetupReq.rx1DrOffset & 0b111) << 4 |
+                       (rxParamSetupReq.rx2DataRate & 0b1111));
+        start.WriteU8 ((rxParamSetupReq.frequency & 0xff0000) >> 16);
+        start.WriteU8 ((rxParamSetupReq.frequency & 0xff00) >> 8);
+        start.WriteU8 (rxParamSetupReq.frequency & 0xff);
+        break;
+      }
+    case (RX_PARAM_SETUP_ANS):
+      {
+        start.WriteU8 (uint8_t (rxParamSetupAns.rx1DrOffsetAck) << 2 |
+                       uint8_t (rxParamSetupAns.rx2DataRateAck) << 1 |
+                       uint8_t (rxParamSetupAns.channelAck));
+        break;
+      }
+    case (DEV_STATUS_ANS):
+      {
+        start.WriteU8 (devStatusAns.battery);
+        start.WriteU8 (devStatusAns.margin);
+        break;
+      }
+    case (NEW_CHANNEL_REQ):
+      {
+        start.WriteU8 (newChannelReq.chIndex);
+        start.WriteU8 ((newChannelReq.frequency & 0xff0000) >> 16);
+        start.WriteU8 ((newChannelReq.frequency & 0xff00) >> 8);
+        start.WriteU8 (newChannelReq.frequency & 0xff);
+        start.WriteU8 ((newChannelReq.maxDataRate << 4) |
+                       (newChannelReq.minDataRate & 0xf));
+        break;
+      }
+    case (NEW_CHANNEL_ANS):
+      {
+        start.WriteU8 ((uint8_t (newChannelAns.dataRateRangeOk) << 1) |
+                       uint8_t (newChannelAns.channelFrequencyOk));
+        break;
+      }
+    case (RX_TIMING_SETUP_REQ):
+      {
+        start.WriteU8 (rxTimingSetupReq.delay & 0xf);
+        break;
+      }
+    default:
+      {
+        // The command only consists in the CID
+        break;
+      }
+    }
+}
+
+uint8_t
+InlineMacCommand::Deserialize (Buffer::Iterator &start)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  // Consume the CID
+  start.ReadU8 ();
+
+  // Read the data, if any
+  switch (type)
+    {
+    case (LINK_CHECK_ANS):
+      {
+        linkCheckAns.margin = start.ReadU8 ();
+        linkCheckAns.gwCnt = start.ReadU8 ();
+        break;
+      }
+    case (LINK_ADR_REQ):
+      {
+        uint8_t firstByte = start.ReadU8 ();
+        linkAdrReq.dataRate = firstByte >> 4;
+        linkAdrReq.txPower = firstByte & 0b1111;
+        linkAdrReq.channelMask = start.ReadU16 ();
+        uint8_t fourthByte = start.ReadU8 ();
+        linkAdrReq.chMaskCntl = fourthByte >> 4;
+        linkAdrReq.nbRep = fourthByte & 0b1111;
+        break;
+      }
+    case (LINK_ADR_ANS):
+      {
+        uint8_t byte = start.ReadU8 ();
+        linkAdrAns.powerAck = byte & 0b100;
+        linkAdrAns.dataRateAck = byte & 0b10;
+        linkAdrAns.channelMaskAck = byte & 0b1;
+        break;
+      }
+    case (DUTY_CYCLE_REQ):
+      {
+        dutyCycleReq.maxDCycle = start.ReadU8 ();
+        break;
+      }
+    case (RX_PARAM_SETUP_REQ):
+      {
+        uint8_t firstByte = start.ReadU8 ();
+        rxParamSetupReq.rx1DrOffset = (firstByte & 0b1110000) >> 4;
+        rxParamSetupReq.rx2DataRate = firstByte & 0b1111;
+        uint32_t encodedFrequency = uint32_t (start.ReadU8 ()) << 16;
+        encodedFrequency |= uint32_t (start.ReadU8 ()) << 8;
+        encodedFrequency |= uint32_t (start.ReadU8 ());
+        rxParamSetupReq.frequency = encodedFrequency;
+        break;
+      }
+    case (RX_PARAM_SETUP_ANS):
+      {
+        uint8_t byte = start.ReadU8 ();
+        rxParamSetupAns.rx1DrOffsetAck = (byte & 0b100) >> 2;
+        rxParamSetupAns.rx2DataRateAck = (byte & 0b10) >> 1;
+        rxParamSetupAns.channelAck = byte & 0b1;
+        break;
+      }
+    case (DEV_STATUS_ANS):
+      {
+        devStatusAns.battery = start.ReadU8 ();
+        devStatusAns.margin = start.ReadU8 () & 0b111111;
+        break;
+      }
+    case (NEW_CHANNEL_REQ):
+      {
+        newChannelReq.chIndex = start.ReadU8 ();
+        uint32_t encodedFrequency = uint32_t (start.ReadU8 ()) << 16;
+        encodedFrequency |= uint32_t (start.ReadU8 ()) << 8;
+        encodedFrequency |= uint32_t (start.ReadU8 ());
+        newChannelReq.frequency = encodedFrequency;
+        uint8_t dataRateByte = start.ReadU8 ();
+        newChannelReq.maxDataRate = dataRateByte >> 4;
+        newChannelReq.minDataRate = dataRateByte & 0xf;
+        break;
+      }
+    case (NEW_CHANNEL_ANS):
+      {
+        uint8_t byte = start.ReadU8 ();
+        newChannelAns.dataRateRangeOk = (byte & 0b10) >> 1;
+        newChannelAns.channelFrequencyOk = byte & 0b1;
+        break;
+      }
+    case (RX_TIMING_SETUP_REQ):
+      {
+        rxTimingSetupReq.delay = start.ReadU8 () & 0xf;
+        break;
+      }
+    default:
+      {
+        // The command only consists in the CID
+        break;
+      }
+    }
+
+  return GetSerializedSize ();
+}
+
+void
+InlineMacCommand::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Ptr<MacCommand> command = ToMacCommand ();
+  if (command)
+    {
+      command->Print (os);
+    }
+  else
+    {
+      os << "Unknown MAC command" << std::endl;
+    }
+}
+
+Ptr<MacCommand>
+InlineMacCommand::ToMacCommand (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  switch (type)
+    {
+    case (LINK_CHECK_REQ):
+      return Create<LinkCheckReq> ();
+    case (LINK_CHECK_ANS):
+      return Create<LinkCheckAns> (linkCheckAns.margin, linkCheckAns.gwCnt);
+    case (LINK_ADR_REQ):
+      return Create<LinkAdrReq> (linkAdrReq.dataRate, linkAdrReq.txPower,
+                                 linkAdrReq.channelMask, linkAdrReq.chMaskCntl,
+                                 linkAdrReq.nbRep);
+    case (LINK_ADR_ANS):
+      return Create<LinkAdrAns> (linkAdrAns.powerAck, linkAdrAns.dataRateAck,
+                                 linkAdrAns.channelMaskAck);
+    case (DUTY_CYCLE_REQ):
+      return Create<DutyCycleReq> (dutyCycleReq.maxDCycle);
+    case (DUTY_CYCLE_ANS):
+      return Create<DutyCycleAns> ();
+    case (RX_PARAM_SETUP_REQ):
+      return Create<RxParamSetupReq> (rxParamSetupReq.rx1DrOffset,
+                                      rxParamSetupReq.rx2DataRate,
+                                      double (rxParamSetupReq.frequency) * 100);
+    case (RX_PARAM_SETUP_ANS):
+      return Create<RxParamSetupAns> (rxParamSetupAns.rx1DrOffsetAck,
+                                      rxParamSetupAns.rx2DataRateAck,
+                                      rxParamSetupAns.channelAck);
+    case (DEV_STATUS_REQ):
+      return Create<DevStatusReq> ();
+    case (DEV_STATUS_ANS):
+      return Create<DevStatusAns> (devStatusAns.battery, devStatusAns.margin);
+    case (NEW_CHANNEL_REQ):
+      return Create<NewChannelReq> (newChannelReq.chIndex,
+                                    double (newChannelReq.frequency) * 100,
+                                    newChannelReq.minDataRate,
+                                    newChannelReq.maxDataRate);
+    case (NEW_CHANNEL_ANS):
+      return Create<NewChannelAns> (newChannelAns.dataRateRangeOk,
+                                    newChannelAns.channelFrequencyOk);
+    case (RX_TIMING_SETUP_REQ):
+      return Create<RxTimingSetupReq> (rxTimingSetupReq.delay);
+    case (RX_TIMING_SETUP_ANS):
+      return Create<RxTimingSetupAns> ();
+    case (TX_PARAM_SETUP_REQ):
+      return Create<TxParamSetupReq> ();
+    case (TX_PARAM_SETUP_ANS):
+      return Create<TxParamSetupAns> ();
+    case (DL_CHANNEL_ANS):
+      return Create<DlChannelAns> ();
+    default:
+      return 0;
+    }
+}
+
+InlineMacCommand
+InlineMacCommand::FromMacCommand (Ptr<MacCommand> command)
+{
+  NS_LOG_FUNCTION (command);
+
+  // Go through the wire format, which every MacCommand class knows how to
+  // produce, instead of requiring accessors for all parameters.
+  InlineMacCommand inlineCommand (command->GetCommandType ());
+  Buffer buffer;
+  buffer.AddAtStart (command->GetSerializedSize ());
+  Buffer::Iterator it = buffer.Begin ();
+  command->Serialize (it);
+  it = buffer.Begin ();
+  inlineCommand.Deserialize (it);
+
+  return inlineCommand;
+}
+
 }
 }
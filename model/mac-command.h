@@ -609,6 +609,188 @@ public:
 
 private:
 };
+
+/**
+ * Compact, allocation-free representation of a MAC command.
+ *
+ * This is a tagged union over the MAC commands defined above: the type field
+ * selects which member of the union holds the command's parameters, which are
+ * kept in the same encoding that is used on the air. Since FOpts is at most 15
+ * bytes long, a whole set of commands fits in a small fixed-size array, and
+ * LoraFrameHeader uses this representation to store its commands inline.
+ *
+ * Conversion to and from the Ptr<MacCommand> classes above is provided for
+ * code that still relies on the object-based API.
+ */
+struct InlineMacCommand
+{
+  InlineMacCommand ();
+
+  /**
+   * Create a command of the specified type, with all parameters set to 0.
+   *
+   * \param commandType The type of MAC command to represent.
+   */
+  InlineMacCommand (enum MacCommandType commandType);
+
+  /**
+   * Serialize this command, CID included, according to the LoRaWAN standard.
+   *
+   * \param start A pointer to the buffer into which to serialize the command.
+   */
+  void Serialize (Buffer::Iterator &start) const;
+
+  /**
+   * Deserialize the buffer into this command.
+   *
+   * The type of this command needs to be set before calling this method.
+   *
+   * \param start A pointer to the buffer that contains the serialized command.
+   * \return The number of bytes that were consumed.
+   */
+  uint8_t Deserialize (Buffer::Iterator &start);
+
+  /**
+   * Print the contents of this MAC command in human-readable format.
+   *
+   * \param os The std::ostream instance on which to print the MAC command.
+   */
+  void Print (std::ostream &os) const;
+
+  /**
+   * Get serialized length of this MAC command.
+   *
+   * \return The number of bytes the MAC command takes up.
+   */
+  uint8_t GetSerializedSize (void) const;
+
+  /**
+   * Create a MacCommand object holding the same parameters as this command.
+   *
+   * \return A new MacCommand instance, or 0 if this type of command has no
+   * corresponding class.
+   */
+  Ptr<MacCommand> ToMacCommand (void) const;
+
+  /**
+   * Create the inline representation of a MacCommand object.
+   *
+   * \param command The MAC command to convert.
+   * \return The inline representation of the command.
+   */
+  static InlineMacCommand FromMacCommand (Ptr<MacCommand> command);
+
+  /**
+   * Get the serialized length of a certain type of MAC command.
+   *
+   * \param commandType The type of MAC command.
+   * \return The number of bytes the MAC command takes up.
+   */
+  static uint8_t GetSerializedSize (enum MacCommandType commandType);
+
+  /**
+   * Get the type of MAC command identified by a CID.
+   *
+   * Requests and answers share the same CID, so the direction of the message
+   * carrying the command is needed to tell them apart.
+   *
+   * \param cid The CID of the command.
+   * \param isUplink Whether the command is carried by an uplink message.
+   * \return The type of the command, or INVALID if the CID is not recognized.
+   */
+  static enum MacCommandType GetMacCommandFromCID (uint8_t cid, bool isUplink);
+
+  enum MacCommandType type;   //!< The type of this command
+
+  /**
+   * The parameters of this command. Only the member corresponding to type is
+   * meaningful, commands without parameters don't use any.
+   */
+  union
+  {
+    struct
+    {
+      uint8_t margin;
+      uint8_t gwCnt;
+    } linkCheckAns;
+    struct
+    {
+      uint8_t dataRate;
+      uint8_t txPower;
+      uint16_t channelMask;
+      uint8_t chMaskCntl;
+      uint8_t nbRep;
+    } linkAdrReq;
+    struct
+    {
+      bool powerAck;
+      bool dataRateAck;
+      bool channelMaskAck;
+    } linkAdrAns;
+    struct
+    {
+      uint8_t maxDCycle;
+    } dutyCycleReq;
+    struct
+    {
+      uint32_t frequency;     //!< The frequency in units of 100 Hz
+      uint8_t rx1DrOffset;
+      uint8_t rx2DataRate;
+    } rxParamSetupReq;
+    struct
+    {
+      bool rx1DrOffsetAck;
+      bool rx2DataRateAck;
+      bool channelAck;
+    } rxParamSetupAns;
+    struct
+    {
+      uint8_t battery;
+      uint8_t margin;
+    } devStatusAns;
+    struct
+    {
+      uint32_t frequency;     //!< The frequency in units of 100 Hz
+      uint8_t chIndex;
+      uint8_t minDataRate;
+      uint8_t maxDataRate;
+    } newChannelReq;
+    struct
+    {
+      bool dataRateRangeOk;
+      bool channelFrequencyOk;
+    } newChannelAns;
+    struct
+    {
+      uint8_t delay;
+    } rxTimingSetupReq;
+  };
+};
+
+/**
+ * Map each MacCommand class to the MacCommandType it represents, so that
+ * commands of a certain class can be looked up without instantiating it.
+ */
+template<typename T>
+struct MacCommandTraits;
+
+template<> struct MacCommandTraits<LinkCheckReq> { static const MacCommandType type = LINK_CHECK_REQ; };
+template<> struct MacCommandTraits<LinkCheckAns> { static const MacCommandType type = LINK_CHECK_ANS; };
+template<> struct MacCommandTraits<LinkAdrReq> { static const MacCommandType type = LINK_ADR_REQ; };
+template<> struct MacCommandTraits<LinkAdrAns> { static const MacCommandType type = LINK_ADR_ANS; };
+template<> struct MacCommandTraits<DutyCycleReq> { static const MacCommandType type = DUTY_CYCLE_REQ; };
+template<> struct MacCommandTraits<DutyCycleAns> { static const MacCommandType type = DUTY_CYCLE_ANS; };
+template<> struct MacCommandTraits<RxParamSetupReq> { static const MacCommandType type = RX_PARAM_SETUP_REQ; };
+template<> struct MacCommandTraits<RxParamSetupAns> { static const MacCommandType type = RX_PARAM_SETUP_ANS; };
+template<> struct MacCommandTraits<DevStatusReq> { static const MacCommandType type = DEV_STATUS_REQ; };
+template<> struct MacCommandTraits<DevStatusAns> { static const MacCommandType type = DEV_STATUS_ANS; };
+template<> struct MacCommandTraits<NewChannelReq> { static const MacCommandType type = NEW_CHANNEL_REQ; };
+template<> struct MacCommandTraits<NewChannelAns> { static const MacCommandType type = NEW_CHANNEL_ANS; };
+template<> struct MacCommandTraits<RxTimingSetupReq> { static const MacCommandType type = RX_TIMING_SETUP_REQ; };
+template<> struct MacCommandTraits<RxTimingSetupAns> { static const MacCommandType type = RX_TIMING_SETUP_ANS; };
+template<> struct MacCommandTraits<TxParamSetupReq> { static const MacCommandType type = TX_PARAM_SETUP_REQ; };
+template<> struct MacCommandTraits<TxParamSetupAns> { static const MacCommandType type = TX_PARAM_SETUP_ANS; };
+template<> struct MacCommandTraits<DlChannelAns> { static const MacCommandType type = DL_CHANNEL_ANS; };
 }
 
 }
@@ -19,6 +19,8 @@
  */
 
 #include "ns3/network-controller-components.h"
+#include "ns3/lora-counters.h"
+#include "ns3/lora-header-view.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -73,24 +75,19 @@ ConfirmedMessagesComponent::OnReceivedPacket (Ptr<const Packet> packet,
   NS_LOG_FUNCTION (this->GetTypeId () << packet << networkStatus);
 
   // Check whether the received packet requires an acknowledgment.
-  LoraMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  LoraHeaderView hdrView (packet);
 
-  NS_LOG_INFO ("Received packet Mac Header: " << mHdr);
-  NS_LOG_INFO ("Received packet Frame Header: " << fHdr);
+  NS_LOG_INFO ("Received packet MType: " << unsigned (hdrView.GetMType ()));
+  NS_LOG_INFO ("Received packet address: " << hdrView.GetAddress ());
 
-  if (mHdr.GetMType () == LoraMacHeader::CONFIRMED_DATA_UP)
+  if (hdrView.GetMType () == LoraMacHeader::CONFIRMED_DATA_UP)
     {
       NS_LOG_INFO ("Packet requires confirmation");
 
       // Set up the ACK bit on the reply
       status->m_reply.frameHeader.SetAsDownlink ();
       status->m_reply.frameHeader.SetAck (true);
-      status->m_reply.frameHeader.SetAddress (fHdr.GetAddress ());
+      status->m_reply.frameHeader.SetAddress (hdrView.GetAddress ());
       status->m_reply.macHeader.SetMType (LoraMacHeader::UNCONFIRMED_DATA_DOWN);
       status->m_reply.needsReply = true;
 
@@ -160,16 +157,15 @@ LinkCheckComponent::BeforeSendingReply (Ptr<EndDeviceStatus> status,
   NS_LOG_FUNCTION (this << status << networkStatus);
 
   Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
+  LORA_COUNTER_INCREMENT (PACKET_COPIES);
   LoraMacHeader mHdr;
   LoraFrameHeader fHdr;
   fHdr.SetAsUplink ();
   myPacket->RemoveHeader (mHdr);
   myPacket->RemoveHeader (fHdr);
 
-  Ptr<LinkCheckReq> command = fHdr.GetMacCommand<LinkCheckReq> ();
-
-  // GetMacCommand returns 0 if no command is found
-  if (command)
+  // Only check for presence, the LinkCheckReq holds no variables
+  if (fHdr.HasMacCommand (MacCommand::GetCIDFromMacCommand (LINK_CHECK_REQ)))
     {
       status->m_reply.needsReply = true;
 
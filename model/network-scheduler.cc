@@ -1,4 +1,6 @@
 #include "network-scheduler.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-header-view.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -40,19 +42,13 @@ void
 NetworkScheduler::OnReceivedPacket (Ptr<const Packet> packet)
 {
   NS_LOG_FUNCTION (packet);
-
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
+  LORA_PROFILE_SCOPE (NETWORK_SERVER);
 
   // TODO Check if this packet is a duplicate:
   // It's possible that we already received the same packet from another
   // gateway.
   // - Extract the address
-  LoraMacHeader macHeader;
-  LoraFrameHeader frameHeader;
-  myPacket->RemoveHeader (macHeader);
-  myPacket->RemoveHeader (frameHeader);
-  LoraDeviceAddress deviceAddress = frameHeader.GetAddress ();
+  LoraDeviceAddress deviceAddress = LoraHeaderView (packet).GetAddress ();
 
   // Schedule OnReceiveWindowOpportunity event
   Simulator::Schedule (Seconds (1),
@@ -66,6 +62,7 @@ void
 NetworkScheduler::OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, int window)
 {
   NS_LOG_FUNCTION (deviceAddress);
+  LORA_PROFILE_SCOPE (NETWORK_SERVER);
 
   NS_LOG_DEBUG ("Opening receive window nubmer " << window << " for device "
                                                  << deviceAddress);
@@ -20,6 +20,8 @@
  */
 
 #include "ns3/network-server.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-counters.h"
 #include "ns3/net-device.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/packet.h"
@@ -154,9 +156,14 @@ NetworkServer::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
                         uint16_t protocol, const Address& address)
 {
   NS_LOG_FUNCTION (this << packet << protocol << address);
+  LORA_PROFILE_SCOPE (NETWORK_SERVER);
+  LORA_COUNTER_INCREMENT (NETWORK_SERVER_UPLINKS);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
+#ifdef NS3_LORA_COUNTERS
+  uint64_t parsesBefore =
+    LoraCounters::Get (LoraCounters::HEADER_VIEW_PEEKS) +
+    LoraCounters::Get (LoraCounters::FRAME_HEADER_DESERIALIZATIONS);
+#endif
 
   // Fire the trace source
   m_receivedPacket (packet);
@@ -170,6 +177,13 @@ NetworkServer::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
   // Inform the controller of the newly arrived packet
   m_controller->OnNewPacket (packet);
 
+#ifdef NS3_LORA_COUNTERS
+  LORA_HISTOGRAM_RECORD (HEADER_PARSES_PER_UPLINK,
+                         LoraCounters::Get (LoraCounters::HEADER_VIEW_PEEKS) +
+                         LoraCounters::Get (LoraCounters::FRAME_HEADER_DESERIALIZATIONS) -
+                         parsesBefore);
+#endif
+
   return true;
 }
 
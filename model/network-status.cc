@@ -26,6 +26,7 @@
 #include "ns3/net-device.h"
 #include "ns3/packet.h"
 #include "ns3/lora-device-address.h"
+#include "ns3/lora-header-view.h"
 #include "ns3/node-container.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
@@ -100,18 +101,8 @@ NetworkStatus::OnReceivedPacket (Ptr<const Packet> packet,
 {
   NS_LOG_FUNCTION (this << packet << gwAddress);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
-
-  // Extract the headers
-  LoraMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
-  LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
-
   // Update the correct EndDeviceStatus object
-  LoraDeviceAddress edAddr = frameHdr.GetAddress ();
+  LoraDeviceAddress edAddr = LoraHeaderView (packet).GetAddress ();
   NS_LOG_DEBUG ("Node address: " << edAddr);
   m_endDeviceStatuses.at (edAddr)->InsertReceivedPacket (packet, gwAddress);
 }
@@ -179,12 +170,7 @@ NetworkStatus::GetEndDeviceStatus (Ptr<Packet const> packet)
   NS_LOG_FUNCTION (this << packet);
 
   // Get the address
-  LoraMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
-  auto it = m_endDeviceStatuses.find (fHdr.GetAddress ());
+  auto it = m_endDeviceStatuses.find (LoraHeaderView (packet).GetAddress ());
   if (it != m_endDeviceStatuses.end ())
     {
       return (*it).second;
@@ -19,6 +19,7 @@
  */
 
 #include "ns3/one-shot-sender.h"
+#include "ns3/lora-packet-pool.h"
 #include "ns3/end-device-lora-mac.h"
 #include "ns3/pointer.h"
 #include "ns3/log.h"
@@ -73,7 +74,7 @@ OneShotSender::SendPacket (void)
   NS_LOG_FUNCTION (this);
 
   // Create and send a new packet
-  Ptr<Packet> packet = Create<Packet> (10);
+  Ptr<Packet> packet = LoraPacketPool::Allocate (10);
   m_mac->Send (packet);
 }
 
@@ -19,6 +19,7 @@
  */
 
 #include "ns3/periodic-sender.h"
+#include "ns3/lora-packet-pool.h"
 #include "ns3/pointer.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
@@ -112,11 +113,11 @@ PeriodicSender::SendPacket (void)
   if (m_pktSizeRV)
     {
       int randomsize = m_pktSizeRV->GetInteger ();
-      packet = Create<Packet> (m_basePktSize + randomsize);
+      packet = LoraPacketPool::Allocate (m_basePktSize + randomsize);
     }
   else
     {
-      packet = Create<Packet> (m_basePktSize);
+      packet = LoraPacketPool::Allocate (m_basePktSize);
     }
   m_mac->Send (packet);
 
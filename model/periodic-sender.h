@@ -79,6 +79,8 @@ public:
    */
   void StopApplication (void);
 
+  friend class LoraCheckpoint;
+
 private:
   /**
    * The interval between to consecutive send events
@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/raster-shadowing-propagation-loss-model.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("RasterShadowingPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (RasterShadowingPropagationLossModel);
+
+const uint32_t RasterShadowingPropagationLossModel::VERSION;
+const uint32_t RasterShadowingPropagationLossModel::BYTE_ORDER_MARK;
+const char RasterShadowingPropagationLossModel::MAGIC[8] =
+{'L', 'O', 'R', 'A', 'S', 'H', 'A', 'D'};
+
+TypeId
+RasterShadowingPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RasterShadowingPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Lora")
+    .AddConstructor<RasterShadowingPropagationLossModel> ()
+    .AddAttribute ("RasterFile",
+                   "The shadowing raster to map, as written by "
+                   "ShadowingRasterHelper",
+                   StringValue (""),
+                   MakeStringAccessor (&RasterShadowingPropagationLossModel::SetRasterFile,
+                                       &RasterShadowingPropagationLossModel::GetRasterFile),
+                   MakeStringChecker ())
+    .AddAttribute ("Resolution",
+                   "The resolution of the table of interpolation weights [m]. "
+                   "It must be strictly positive.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&RasterShadowingPropagationLossModel::SetResolution,
+                                       &RasterShadowingPropagationLossModel::GetResolution),
+                   MakeDoubleChecker<double> (std::numeric_limits<double>::min ()));
+  return tid;
+}
+
+RasterShadowingPropagationLossModel::RasterShadowingPropagationLossModel ()
+  : m_resolution (1.0),
+  m_values (0),
+  m_nSteps (0)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::memset (&m_header, 0, sizeof (m_header));
+}
+
+RasterShadowingPropagationLossModel::~RasterShadowingPropagationLossModel ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+}
+
+void
+RasterShadowingPropagationLossModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+  PropagationLossModel::DoDispose ();
+}
+
+bool
+RasterShadowingPropagationLossModel::Open (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Close ();
+
+  if (!m_mapping.Open (filename, sizeof (RasterHeader)))
+    {
+      NS_LOG_ERROR ("Can't map raster " << filename);
+      return false;
+    }
+
+  RasterHeader header;
+  std::memcpy (&header, m_mapping.GetData (), sizeof (header));
+  uint64_t nValues = uint64_t (header.nSquaresX) * header.nSquaresY *
+    (header.nSquaresX + 1) * (header.nSquaresY + 1);
+  if (std::memcmp (header.magic, MAGIC, sizeof (MAGIC)) != 0
+      || header.version != VERSION
+      || header.byteOrder != BYTE_ORDER_MARK
+      || !(header.correlationDistance > 0)
+      || m_mapping.GetSize () != sizeof (RasterHeader) + nValues * sizeof (float))
+    {
+      NS_LOG_ERROR ("Raster " << filename << " is not a valid raster, or was "
+                    "written on a machine with a different byte order");
+      m_mapping.Close ();
+      return false;
+    }
+
+  m_header = header;
+  m_values = reinterpret_cast<const float *> (m_mapping.GetData () + sizeof (RasterHeader));
+  m_rasterFile = filename;
+  ComputeWeights ();
+
+  NS_LOG_DEBUG ("Mapped " << header.nSquaresX << "x" << header.nSquaresY <<
+                " squares from " << filename);
+  return true;
+}
+
+bool
+RasterShadowingPropagationLossModel::IsOpen (void) const
+{
+  return m_values != 0;
+}
+
+RasterShadowingPropagationLossModel::RasterHeader
+RasterShadowingPropagationLossModel::GetHeader (void) const
+{
+  return m_header;
+}
+
+void
+RasterShadowingPropagationLossModel::Close (void)
+{
+  m_mapping.Close ();
+  m_values = 0;
+  m_rasterFile = "";
+  std::memset (&m_header, 0, sizeof (m_header));
+}
+
+double
+RasterShadowingPropagationLossModel::GetCorner (int32_t squareX, int32_t squareY,
+                                                int32_t cornerX, int32_t cornerY) const
+{
+  // Unsigned offsets make coordinates below the first square out of range
+  uint32_t sx = squareX - m_header.minSquareX;
+  uint32_t sy = squareY - m_header.minSquareY;
+  uint32_t cx = cornerX - m_header.minSquareX;
+  uint32_t cy = cornerY - m_header.minSquareY;
+  if (m_values == 0 || sx >= m_header.nSquaresX || sy >= m_header.nSquaresY
+      || cx > m_header.nSquaresX || cy > m_header.nSquaresY)
+    {
+      return 0;
+    }
+  uint64_t nCornersX = m_header.nSquaresX + 1;
+  uint64_t nCornersY = m_header.nSquaresY + 1;
+  return m_values[((uint64_t (sy) * m_header.nSquaresX + sx) * nCornersY + cy) *
+                  nCornersX + cx];
+}
+
+double
+RasterShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                                    Ptr<MobilityModel> a,
+                                                    Ptr<MobilityModel> b) const
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << a << b);
+
+  if (m_values == 0)
+    {
+      NS_LOG_WARN ("No raster was mapped, not applying shadowing");
+      return txPowerDbm;
+    }
+
+  double d = m_header.correlationDistance;
+  Vector aPosition = a->GetPosition ();
+  Vector bPosition = b->GetPosition ();
+
+  int32_t squareX = CorrelatedShadowingPropagationLossModel::GetSquare (aPosition.x, d);
+  int32_t squareY = CorrelatedShadowingPropagationLossModel::GetSquare (aPosition.y, d);
+  int32_t cellX = CorrelatedShadowingPropagationLossModel::GetSquare (bPosition.x, d);
+  int32_t cellY = CorrelatedShadowingPropagationLossModel::GetSquare (bPosition.y, d);
+
+  uint32_t sx = squareX - m_header.minSquareX;
+  uint32_t sy = squareY - m_header.minSquareY;
+  uint32_t cx = cellX - m_header.minSquareX;
+  uint32_t cy = cellY - m_header.minSquareY;
+  if (sx >= m_header.nSquaresX || sy >= m_header.nSquaresY
+      || cx >= m_header.nSquaresX || cy >= m_header.nSquaresY)
+    {
+      NS_LOG_WARN ("Link outside the raster, not applying shadowing");
+      return txPowerDbm;
+    }
+
+  // Look up the weights of the closest point of the table
+  double step = d / m_nSteps;
+  double dx = bPosition.x - (cellX * d - d / 2);
+  double dy = bPosition.y - (cellY * d - d / 2);
+  uint32_t ix = std::min<double> (std::max (std::floor (dx / step + 0.5), 0.0), m_nSteps);
+  uint32_t iy = std::min<double> (std::max (std::floor (dy / step + 0.5), 0.0), m_nSteps);
+  const double *w = &m_weights[4 * (iy * (m_nSteps + 1) + ix)];
+
+  uint64_t nCornersX = m_header.nSquaresX + 1;
+  uint64_t nCornersY = m_header.nSquaresY + 1;
+  const float *lowerLeft = m_values +
+    ((uint64_t (sy) * m_header.nSquaresX + sx) * nCornersY + cy) * nCornersX + cx;
+  const float *upperLeft = lowerLeft + nCornersX;
+
+  double loss = lowerLeft[0] * w[0] + lowerLeft[1] * w[1] +
+    upperLeft[1] * w[2] + upperLeft[0] * w[3];
+
+  NS_LOG_INFO ("Shadowing loss: " << loss);
+
+  return txPowerDbm - loss;
+}
+
+int64_t
+RasterShadowingPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  // The raster was drawn offline
+  return 0;
+}
+
+void
+RasterShadowingPropagationLossModel::SetRasterFile (std::string filename)
+{
+  if (filename.empty ())
+    {
+      Close ();
+    }
+  else if (!Open (filename))
+    {
+      NS_FATAL_ERROR ("Unable to map shadowing raster " << filename);
+    }
+}
+
+std::string
+RasterShadowingPropagationLossModel::GetRasterFile (void) const
+{
+  return m_rasterFile;
+}
+
+void
+RasterShadowingPropagationLossModel::SetResolution (double resolution)
+{
+  NS_ASSERT_MSG (resolution > 0, "The resolution must be strictly positive");
+
+  m_resolution = resolution;
+  ComputeWeights ();
+}
+
+double
+RasterShadowingPropagationLossModel::GetResolution (void) const
+{
+  return m_resolution;
+}
+
+void
+RasterShadowingPropagationLossModel::ComputeWeights (void)
+{
+  if (m_values == 0)
+    {
+      return;
+    }
+
+  // Use a whole number of steps per cell, so that the table covers it exactly
+  double d = m_header.correlationDistance;
+  m_nSteps = std::max (1.0, std::ceil (d / m_resolution));
+  double step = d / m_nSteps;
+
+  m_weights.resize (4 * (m_nSteps + 1) * (m_nSteps + 1));
+  for (uint32_t iy = 0; iy <= m_nSteps; iy++)
+    {
+      for (uint32_t ix = 0; ix <= m_nSteps; ix++)
+        {
+          CorrelatedShadowingPropagationLossModel::GetWeights
+            (ix * step, iy * step, d, &m_weights[4 * (iy * (m_nSteps + 1) + ix)]);
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RASTER_SHADOWING_PROPAGATION_LOSS_MODEL_H
+#define RASTER_SHADOWING_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/mobility-model.h"
+#include "ns3/lora-file-mapping.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A variant of CorrelatedShadowingPropagationLossModel that reads the
+ * shadowing fields from a precomputed raster, instead of drawing them while
+ * the simulation runs.
+ *
+ * The raster is written offline by ShadowingRasterHelper for a bounding box,
+ * and holds the corner values of the field of every square in the box, so
+ * that the shadowing doesn't depend on the order in which links are
+ * evaluated, and is the same across runs and processes. The file is memory
+ * mapped read-only: loading it costs no generation and no copy, and jobs
+ * that use the same raster share its pages through the page cache.
+ *
+ * The shadowing at a receiver is interpolated from the corners of its cell
+ * with the same weights as CorrelatedShadowingPropagationLossModel. Weights
+ * are tabulated over the cell, with the resolution given by the Resolution
+ * attribute, so that a lookup costs no exponential. Links whose transmitter
+ * or receiver is outside the box of the raster have no shadowing.
+ */
+class RasterShadowingPropagationLossModel : public PropagationLossModel
+{
+public:
+  /**
+   * The header of a raster file. It is followed by the corner values, as
+   * floats in the byte order of the machine that wrote the file, indexed by
+   * [square y][square x][corner y][corner x], where there is one more corner
+   * than squares along each axis.
+   */
+  struct RasterHeader
+  {
+    char magic[8]; //!< "LORASHAD"
+    uint32_t version; //!< The version of the format
+    uint32_t byteOrder; //!< BYTE_ORDER_MARK, as written by the machine
+    double correlationDistance; //!< The side of squares and cells [m]
+    int32_t minSquareX; //!< The first square along the x axis
+    int32_t minSquareY; //!< The first square along the y axis
+    uint32_t nSquaresX; //!< The number of squares along the x axis
+    uint32_t nSquaresY; //!< The number of squares along the y axis
+  };
+
+  static const uint32_t VERSION = 1; //!< The current raster format
+  static const uint32_t BYTE_ORDER_MARK = 0x01020304; //!< Detects byte swaps
+  static const char MAGIC[8]; //!< The magic string of raster files
+
+  static TypeId GetTypeId (void);
+
+  RasterShadowingPropagationLossModel ();
+  virtual ~RasterShadowingPropagationLossModel ();
+
+  /**
+   * Map a raster file, releasing the one that was mapped before.
+   *
+   * \param filename The raster to map.
+   * \return False if the file can't be mapped or is not a valid raster, in
+   * which case no raster is mapped.
+   */
+  bool Open (std::string filename);
+
+  /**
+   * \return Whether a raster is mapped.
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * \return The header of the mapped raster.
+   */
+  RasterHeader GetHeader (void) const;
+
+  /**
+   * Get a corner value of the field of a square.
+   *
+   * \param squareX The x coordinate of the square of the transmitter.
+   * \param squareY The y coordinate of the square of the transmitter.
+   * \param cornerX The x index of the corner, the one at the lower left of
+   * square cornerX.
+   * \param cornerY The y index of the corner.
+   * \return The corner value [dB], or 0 if it is outside the raster.
+   */
+  double GetCorner (int32_t squareX, int32_t squareY,
+                    int32_t cornerX, int32_t cornerY) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  void SetRasterFile (std::string filename);
+  std::string GetRasterFile (void) const;
+
+  void SetResolution (double resolution);
+  double GetResolution (void) const;
+
+  /**
+   * Release the mapping of the raster, if any.
+   */
+  void Close (void);
+
+  /**
+   * Tabulate the interpolation weights for the current correlation distance
+   * and resolution.
+   */
+  void ComputeWeights (void);
+
+  std::string m_rasterFile; //!< The mapped file
+  double m_resolution; //!< The resolution of the weight table [m]
+
+  LoraFileMapping m_mapping; //!< The mapped file
+  RasterHeader m_header; //!< The header of the mapped raster
+  const float *m_values; //!< The corner values, inside the mapping
+
+  uint32_t m_nSteps; //!< The number of weight table steps along a cell side
+  std::vector<double> m_weights; //!< Four weights per table point
+};
+
+}
+
+}
+#endif /* RASTER_SHADOWING_PROPAGATION_LOSS_MODEL_H */
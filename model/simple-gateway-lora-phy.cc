@@ -19,6 +19,7 @@
  */
 
 #include "ns3/simple-gateway-lora-phy.h"
+#include "ns3/lora-counters.h"
 #include "ns3/lora-tag.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
@@ -195,6 +196,9 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
               // Block this resource
               currentPath->LockOnEvent (event);
               m_occupiedReceptionPaths++;
+              LORA_COUNTER_INCREMENT (GATEWAY_LOCKED_RECEPTIONS);
+              LORA_HISTOGRAM_RECORD (DEMODULATOR_OCCUPANCY,
+                                     m_occupiedReceptionPaths.Get ());
 
               // Schedule the end of the reception of the packet
               EventId endReceiveEventId = Simulator::Schedule (duration,
@@ -213,6 +217,7 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
   NS_LOG_INFO ("Dropping packet reception of packet with sf = "
                << unsigned(sf) <<
                " because no suitable demodulator was found");
+  LORA_COUNTER_INCREMENT (GATEWAY_NO_MORE_DEMODULATORS);
 
   // Fire the trace source
   if (m_device)
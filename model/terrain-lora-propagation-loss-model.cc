@@ -0,0 +1,468 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/terrain-lora-propagation-loss-model.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("TerrainLoraPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TerrainLoraPropagationLossModel);
+
+const uint32_t TerrainLoraPropagationLossModel::VERSION;
+const uint32_t TerrainLoraPropagationLossModel::BYTE_ORDER_MARK;
+const char TerrainLoraPropagationLossModel::MAGIC[8] =
+{'L', 'O', 'R', 'A', 'D', 'E', 'M', '\0'};
+
+namespace {
+
+const double SPEED_OF_LIGHT = 299792458; //!< [m/s]
+const double EARTH_RADIUS = 6371e3; //!< The mean radius of the earth [m]
+const uint32_t BLOCK_SIZE = 64; //!< The profile samples processed at once
+
+bool
+SamePosition (const Vector &a, const Vector &b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+bool
+PositionLess (const Vector &a, const Vector &b)
+{
+  if (a.x != b.x)
+    {
+      return a.x < b.x;
+    }
+  if (a.y != b.y)
+    {
+      return a.y < b.y;
+    }
+  return a.z < b.z;
+}
+
+}
+
+TypeId
+TerrainLoraPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TerrainLoraPropagationLossModel")
+    .SetParent<LoraPropagationLossModel> ()
+    .SetGroupName ("LoraPropagation")
+    .AddConstructor<TerrainLoraPropagationLossModel> ()
+    .AddAttribute ("ElevationFile",
+                   "The elevation file to map, in the format described by "
+                   "TerrainLoraPropagationLossModel::ElevationHeader",
+                   StringValue (""),
+                   MakeStringAccessor (&TerrainLoraPropagationLossModel::SetElevationFile,
+                                       &TerrainLoraPropagationLossModel::GetElevationFile),
+                   MakeStringChecker ())
+    .AddAttribute ("Frequency",
+                   "The carrier frequency [Hz]",
+                   DoubleValue (868e6),
+                   MakeDoubleAccessor (&TerrainLoraPropagationLossModel::m_frequency),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("ProfileResolution",
+                   "The spacing of the samples of link profiles [m]. Zero "
+                   "means the spacing of the elevation grid.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&TerrainLoraPropagationLossModel::m_profileResolution),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("EarthRadiusFactor",
+                   "The ratio of the effective radius of the earth to the "
+                   "actual one, to account for atmospheric refraction",
+                   DoubleValue (4.0 / 3),
+                   MakeDoubleAccessor (&TerrainLoraPropagationLossModel::m_earthRadiusFactor),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxCachedLinks",
+                   "The maximum number of link losses to keep, evicting the "
+                   "least recently used ones. Zero means no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TerrainLoraPropagationLossModel::SetMaxCachedLinks,
+                                         &TerrainLoraPropagationLossModel::GetMaxCachedLinks),
+                   MakeUintegerChecker<uint32_t> ());
+  return tid;
+}
+
+TerrainLoraPropagationLossModel::TerrainLoraPropagationLossModel ()
+  : m_frequency (868e6),
+  m_profileResolution (0),
+  m_earthRadiusFactor (4.0 / 3),
+  m_heights (0)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::memset (&m_header, 0, sizeof (m_header));
+}
+
+TerrainLoraPropagationLossModel::~TerrainLoraPropagationLossModel ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+}
+
+void
+TerrainLoraPropagationLossModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+  LoraPropagationLossModel::DoDispose ();
+}
+
+bool
+TerrainLoraPropagationLossModel::Open (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+
+  Close ();
+
+  if (!m_mapping.Open (filename, sizeof (ElevationHeader)))
+    {
+      NS_LOG_ERROR ("Can't map elevation file " << filename);
+      return false;
+    }
+
+  ElevationHeader header;
+  std::memcpy (&header, m_mapping.GetData (), sizeof (header));
+  uint64_t nHeights = uint64_t (header.nX) * header.nY;
+  if (std::memcmp (header.magic, MAGIC, sizeof (MAGIC)) != 0
+      || header.version != VERSION
+      || header.byteOrder != BYTE_ORDER_MARK
+      || !(header.resolution > 0)
+      || header.nX < 2 || header.nY < 2
+      || m_mapping.GetSize () != sizeof (ElevationHeader) + nHeights * sizeof (float))
+    {
+      NS_LOG_ERROR ("Elevation file " << filename << " is not valid, or was "
+                    "written on a machine with a different byte order");
+      m_mapping.Close ();
+      return false;
+    }
+
+  m_header = header;
+  m_heights = reinterpret_cast<const float *>
+    (m_mapping.GetData () + sizeof (ElevationHeader));
+  m_elevationFile = filename;
+
+  NS_LOG_DEBUG ("Mapped a " << header.nX << "x" << header.nY <<
+                " elevation grid from " << filename);
+  return true;
+}
+
+bool
+TerrainLoraPropagationLossModel::IsOpen (void) const
+{
+  return m_heights != 0;
+}
+
+TerrainLoraPropagationLossModel::ElevationHeader
+TerrainLoraPropagationLossModel::GetHeader (void) const
+{
+  return m_header;
+}
+
+void
+TerrainLoraPropagationLossModel::Close (void)
+{
+  m_mapping.Close ();
+  m_heights = 0;
+  m_elevationFile = "";
+  std::memset (&m_header, 0, sizeof (m_header));
+  m_linkLosses.Clear ();
+}
+
+double
+TerrainLoraPropagationLossModel::Interpolate (double gx, double gy) const
+{
+  // Use the last cell for points on the upper edges of the grid
+  uint32_t x = std::min (uint32_t (gx), m_header.nX - 2);
+  uint32_t y = std::min (uint32_t (gy), m_header.nY - 2);
+  double fx = gx - x;
+  double fy = gy - y;
+
+  const float *lower = m_heights + uint64_t (y) * m_header.nX + x;
+  const float *upper = lower + m_header.nX;
+  return (1 - fy) * ((1 - fx) * lower[0] + fx * lower[1]) +
+         fy * ((1 - fx) * upper[0] + fx * upper[1]);
+}
+
+double
+TerrainLoraPropagationLossModel::GetElevation (double x, double y) const
+{
+  if (m_heights == 0)
+    {
+      return 0;
+    }
+
+  double gx = (x - m_header.originX) / m_header.resolution;
+  double gy = (y - m_header.originY) / m_header.resolution;
+  if (!(gx >= 0 && gy >= 0 && gx <= m_header.nX - 1 && gy <= m_header.nY - 1))
+    {
+      return 0;
+    }
+  return Interpolate (gx, gy);
+}
+
+double
+TerrainLoraPropagationLossModel::GetTerrainLoss (Vector a, Vector b) const
+{
+  NS_LOG_FUNCTION (this << a << b);
+
+  if (m_heights == 0)
+    {
+      return 0;
+    }
+
+  // Work in grid units, where the grid covers [0, nX - 1] x [0, nY - 1]
+  double ax = (a.x - m_header.originX) / m_header.resolution;
+  double ay = (a.y - m_header.originY) / m_header.resolution;
+  double bx = (b.x - m_header.originX) / m_header.resolution;
+  double by = (b.y - m_header.originY) / m_header.resolution;
+  double maxX = m_header.nX - 1;
+  double maxY = m_header.nY - 1;
+  if (!(ax >= 0 && ay >= 0 && ax <= maxX && ay <= maxY
+        && bx >= 0 && by >= 0 && bx <= maxX && by <= maxY))
+    {
+      NS_LOG_DEBUG ("Link outside the elevation grid, no terrain loss");
+      return 0;
+    }
+
+  double distance = std::sqrt ((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+  double step = m_profileResolution > 0 ? m_profileResolution : m_header.resolution;
+  uint32_t nSamples = std::max (std::ceil (distance / step) - 1, 0.0);
+  if (nSamples == 0)
+    {
+      return 0;
+    }
+
+  double heightA = Interpolate (ax, ay) + a.z;
+  double heightB = Interpolate (bx, by) + b.z;
+  double wavelength = SPEED_OF_LIGHT / m_frequency;
+  double effectiveRadius = m_earthRadiusFactor * EARTH_RADIUS;
+
+  // The samples are at fractions t = i / (nSamples + 1) of the link. Each
+  // block first computes where its samples are, then gathers their heights,
+  // and finally computes their Fresnel parameters, so that the first and
+  // last loops have no dependencies between iterations.
+  double gx[BLOCK_SIZE];
+  double gy[BLOCK_SIZE];
+  double t[BLOCK_SIZE];
+  double ground[BLOCK_SIZE];
+  double v[BLOCK_SIZE];
+  double dt = 1.0 / (nSamples + 1);
+  double maxV = -std::numeric_limits<double>::infinity ();
+  for (uint32_t first = 0; first < nSamples; first += BLOCK_SIZE)
+    {
+      uint32_t n = std::min (BLOCK_SIZE, nSamples - first);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          t[i] = (first + i + 1) * dt;
+          gx[i] = ax + t[i] * (bx - ax);
+          gy[i] = ay + t[i] * (by - ay);
+        }
+      for (uint32_t i = 0; i < n; i++)
+        {
+          ground[i] = Interpolate (gx[i], gy[i]);
+        }
+      for (uint32_t i = 0; i < n; i++)
+        {
+          // The height of the terrain above the line of sight, raised by
+          // the bulge of the earth, scaled by the first Fresnel radius
+          double d1 = t[i] * distance;
+          double d2 = distance - d1;
+          double lineOfSight = heightA + t[i] * (heightB - heightA);
+          double obstruction = ground[i] + d1 * d2 / (2 * effectiveRadius) - lineOfSight;
+          v[i] = obstruction * std::sqrt (2 * distance / (wavelength * d1 * d2));
+        }
+      for (uint32_t i = 0; i < n; i++)
+        {
+          maxV = std::max (maxV, v[i]);
+        }
+    }
+
+  // ITU-R P.526 approximation of the knife-edge loss, which is negligible
+  // below v = -0.78
+  double loss = 0;
+  if (maxV > -0.78)
+    {
+      loss = 6.9 + 20 * std::log10 (std::sqrt ((maxV - 0.1) * (maxV - 0.1) + 1) +
+                                    maxV - 0.1);
+    }
+
+  NS_LOG_DEBUG ("Link of " << distance << " m with " << nSamples <<
+                " samples: v=" << maxV << ", loss=" << loss << " dB");
+  return loss;
+}
+
+uint32_t
+TerrainLoraPropagationLossModel::GetNCachedLinks (void) const
+{
+  return m_linkLosses.GetSize ();
+}
+
+bool
+TerrainLoraPropagationLossModel::WriteElevation (std::string filename,
+                                                 double originX, double originY,
+                                                 double resolution, uint32_t nX,
+                                                 uint32_t nY,
+                                                 const std::vector<float> &heights)
+{
+  NS_LOG_FUNCTION (filename << originX << originY << resolution << nX << nY);
+  NS_ASSERT (heights.size () == uint64_t (nX) * nY);
+
+  std::ofstream out (filename.c_str (), std::ios::binary);
+  if (!out.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open elevation file " << filename);
+      return false;
+    }
+
+  ElevationHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, MAGIC, sizeof (MAGIC));
+  header.version = VERSION;
+  header.byteOrder = BYTE_ORDER_MARK;
+  header.originX = originX;
+  header.originY = originY;
+  header.resolution = resolution;
+  header.nX = nX;
+  header.nY = nY;
+  out.write (reinterpret_cast<const char *> (&header), sizeof (header));
+  out.write (reinterpret_cast<const char *> (heights.data ()),
+             heights.size () * sizeof (float));
+
+  return bool (out);
+}
+
+double
+TerrainLoraPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                                uint8_t txSF,
+                                                Ptr<MobilityModel> a,
+                                                Ptr<MobilityModel> b) const
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << unsigned (txSF) << a << b);
+
+  if (m_heights == 0)
+    {
+      NS_LOG_WARN ("No elevation file was mapped, not applying terrain loss");
+      return txPowerDbm;
+    }
+
+  // The loss is symmetric, so links are stored with their end points in
+  // address order. The address order only picks the cache entry.
+  LinkKey key = {PeekPointer (a), PeekPointer (b)};
+  Vector aPosition = a->GetPosition ();
+  Vector bPosition = b->GetPosition ();
+  if (key.b < key.a)
+    {
+      std::swap (key.a, key.b);
+      std::swap (aPosition, bPosition);
+    }
+
+  // Reuse the cached loss if neither end point moved
+  const LinkLoss *cached = m_linkLosses.Find (key);
+  double loss;
+  if (cached != 0 && SamePosition (cached->a, aPosition)
+      && SamePosition (cached->b, bPosition))
+    {
+      loss = cached->loss;
+    }
+  else
+    {
+      // The profile is always walked from the end point with the lowest
+      // position, since the two directions round differently and the address
+      // order changes with the heap layout
+      if (PositionLess (bPosition, aPosition))
+        {
+          loss = GetTerrainLoss (bPosition, aPosition);
+        }
+      else
+        {
+          loss = GetTerrainLoss (aPosition, bPosition);
+        }
+      LinkLoss value = {aPosition, bPosition, loss};
+      m_linkLosses.Insert (key, value);
+    }
+
+  NS_LOG_INFO ("Terrain loss: " << loss);
+
+  return txPowerDbm - loss;
+}
+
+int64_t
+TerrainLoraPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  // The terrain is deterministic
+  return 0;
+}
+
+void
+TerrainLoraPropagationLossModel::SetElevationFile (std::string filename)
+{
+  if (filename.empty ())
+    {
+      Close ();
+    }
+  else if (!Open (filename))
+    {
+      NS_FATAL_ERROR ("Unable to map elevation file " << filename);
+    }
+}
+
+std::string
+TerrainLoraPropagationLossModel::GetElevationFile (void) const
+{
+  return m_elevationFile;
+}
+
+void
+TerrainLoraPropagationLossModel::SetMaxCachedLinks (uint32_t maxCachedLinks)
+{
+  m_linkLosses.SetMaxSize (maxCachedLinks);
+}
+
+uint32_t
+TerrainLoraPropagationLossModel::GetMaxCachedLinks (void) const
+{
+  return m_linkLosses.GetMaxSize ();
+}
+
+bool
+TerrainLoraPropagationLossModel::LinkKey::operator== (const LinkKey &other) const
+{
+  return a == other.a && b == other.b;
+}
+
+uint64_t
+TerrainLoraPropagationLossModel::LinkHash::operator() (const LinkKey &key) const
+{
+  return LoraHashCombine (uint64_t (reinterpret_cast<uintptr_t> (key.a)),
+                          uint64_t (reinterpret_cast<uintptr_t> (key.b)));
+}
+}
+}
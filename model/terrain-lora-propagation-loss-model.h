@@ -0,0 +1,224 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TERRAIN_LORA_PROPAGATION_LOSS_MODEL_H
+#define TERRAIN_LORA_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/lora-propagation-loss-model.h"
+#include "ns3/lora-flat-hash-map.h"
+#include "ns3/lora-file-mapping.h"
+#include "ns3/mobility-model.h"
+#include "ns3/vector.h"
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * \ingroup lorawan
+ *
+ * A propagation loss model that adds the diffraction loss of the terrain
+ * between the end points of a link. It is meant to be chained after a path
+ * loss model, such as RYLRLoraPropagationLossModel.
+ *
+ * The terrain is described by a digital elevation model, a grid of heights
+ * stored in a binary file that is memory mapped read-only. The height of a
+ * point is interpolated bilinearly from the four grid points around it, and
+ * the z coordinate of a node is its height above the terrain.
+ *
+ * The profile of a link is sampled every ProfileResolution meters, and the
+ * curvature of the earth is accounted for with an effective radius of
+ * EarthRadiusFactor times the actual one. The loss is the single knife-edge
+ * diffraction loss of ITU-R P.526 for the sample that obstructs the first
+ * Fresnel zone the most, so that links in line of sight with a clear
+ * Fresnel zone have no loss. Profiles are processed in fixed-size blocks of
+ * independent samples, so that the compiler can vectorize the computation
+ * of the sample positions and of the Fresnel parameters.
+ *
+ * Since the loss of a link only depends on the positions of its end points,
+ * it is cached, and reused as long as neither end point moves. The cache is
+ * cleared when another elevation file is mapped, so the other attributes
+ * should be set before links are evaluated. Links with an end point outside
+ * the grid have no terrain loss.
+ */
+class TerrainLoraPropagationLossModel : public LoraPropagationLossModel
+{
+public:
+  /**
+   * The header of an elevation file. It is followed by the heights of the
+   * grid points, as floats in meters in the byte order of the machine that
+   * wrote the file, indexed by [y][x]. Grid point (x, y) is at
+   * (originX + x * resolution, originY + y * resolution).
+   */
+  struct ElevationHeader
+  {
+    char magic[8]; //!< "LORADEM"
+    uint32_t version; //!< The version of the format
+    uint32_t byteOrder; //!< BYTE_ORDER_MARK, as written by the machine
+    double originX; //!< The x coordinate of the first grid point [m]
+    double originY; //!< The y coordinate of the first grid point [m]
+    double resolution; //!< The spacing of grid points [m]
+    uint32_t nX; //!< The number of grid points along the x axis
+    uint32_t nY; //!< The number of grid points along the y axis
+  };
+
+  static const uint32_t VERSION = 1; //!< The current elevation format
+  static const uint32_t BYTE_ORDER_MARK = 0x01020304; //!< Detects byte swaps
+  static const char MAGIC[8]; //!< The magic string of elevation files
+
+  static TypeId GetTypeId (void);
+
+  TerrainLoraPropagationLossModel ();
+  virtual ~TerrainLoraPropagationLossModel ();
+
+  /**
+   * Map an elevation file, releasing the one that was mapped before.
+   *
+   * \param filename The file to map.
+   * \return False if the file can't be mapped or is not a valid elevation
+   * file, in which case no file is mapped.
+   */
+  bool Open (std::string filename);
+
+  /**
+   * \return Whether an elevation file is mapped.
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * \return The header of the mapped elevation file.
+   */
+  ElevationHeader GetHeader (void) const;
+
+  /**
+   * Get the height of the terrain at a point.
+   *
+   * \param x The x coordinate of the point.
+   * \param y The y coordinate of the point.
+   * \return The height [m], or 0 if the point is outside the grid.
+   */
+  double GetElevation (double x, double y) const;
+
+  /**
+   * Compute the terrain loss of a link, without using the cache.
+   *
+   * \param a The position of one end point.
+   * \param b The position of the other end point.
+   * \return The diffraction loss [dB].
+   */
+  double GetTerrainLoss (Vector a, Vector b) const;
+
+  /**
+   * \return The number of links whose loss is cached.
+   */
+  uint32_t GetNCachedLinks (void) const;
+
+  /**
+   * Write an elevation file.
+   *
+   * \param filename The file to write.
+   * \param originX The x coordinate of the first grid point.
+   * \param originY The y coordinate of the first grid point.
+   * \param resolution The spacing of grid points.
+   * \param nX The number of grid points along the x axis.
+   * \param nY The number of grid points along the y axis.
+   * \param heights The nX * nY heights, indexed by [y][x].
+   * \return Whether the file was written successfully.
+   */
+  static bool WriteElevation (std::string filename, double originX,
+                              double originY, double resolution, uint32_t nX,
+                              uint32_t nY, const std::vector<float> &heights);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * The end points of a cached link, in increasing address order. The
+   * order only identifies the link: the loss itself is computed in position
+   * order, so that it doesn't depend on the heap layout.
+   */
+  struct LinkKey
+  {
+    const MobilityModel *a; //!< The first end point
+    const MobilityModel *b; //!< The second end point
+
+    bool operator== (const LinkKey &other) const;
+  };
+
+  /**
+   * Hash function for LinkKeys.
+   */
+  struct LinkHash
+  {
+    uint64_t operator() (const LinkKey &key) const;
+  };
+
+  /**
+   * A cached loss, with the positions it was computed for.
+   */
+  struct LinkLoss
+  {
+    Vector a; //!< The position of the first end point
+    Vector b; //!< The position of the second end point
+    double loss; //!< The terrain loss [dB]
+  };
+
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                uint8_t txSF,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  void SetElevationFile (std::string filename);
+  std::string GetElevationFile (void) const;
+
+  void SetMaxCachedLinks (uint32_t maxCachedLinks);
+  uint32_t GetMaxCachedLinks (void) const;
+
+  /**
+   * Release the mapping of the elevation file, if any.
+   */
+  void Close (void);
+
+  /**
+   * Interpolate the height of the terrain at a point, in grid units.
+   */
+  double Interpolate (double gx, double gy) const;
+
+  std::string m_elevationFile; //!< The mapped file
+  double m_frequency; //!< The carrier frequency [Hz]
+  double m_profileResolution; //!< The spacing of profile samples [m], or 0
+  double m_earthRadiusFactor; //!< The k factor of the effective earth radius
+
+  LoraFileMapping m_mapping; //!< The mapped file
+  ElevationHeader m_header; //!< The header of the mapped file
+  const float *m_heights; //!< The heights, inside the mapping
+
+  /**
+   * The loss of each link, keyed by its end points.
+   */
+  mutable LoraFlatHashMap<LinkKey, LinkLoss, LinkHash> m_linkLosses;
+};
+
+}
+
+}
+#endif /* TERRAIN_LORA_PROPAGATION_LOSS_MODEL_H */
@@ -0,0 +1,382 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/trace-replay-sender.h"
+#include "ns3/lora-packet-pool.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <sstream>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("TraceReplaySender");
+
+NS_OBJECT_ENSURE_REGISTERED (TraceReplaySender);
+
+namespace {
+
+const char BINARY_MAGIC[4] = {'L', 'R', 'T', 'R'};
+const uint32_t BINARY_VERSION = 1;
+const uint32_t BINARY_RECORD_SIZE = 14;
+
+uint64_t
+ReadLittleEndian (const uint8_t *buffer, uint8_t nBytes)
+{
+  uint64_t value = 0;
+  for (int i = nBytes - 1; i >= 0; i--)
+    {
+      value = (value << 8) | buffer[i];
+    }
+  return value;
+}
+
+void
+WriteLittleEndian (std::ostream &os, uint64_t value, uint8_t nBytes)
+{
+  for (uint8_t i = 0; i < nBytes; i++)
+    {
+      os.put (static_cast<char> (value & 0xff));
+      value >>= 8;
+    }
+}
+
+}
+
+TypeId
+TraceReplaySender::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TraceReplaySender")
+    .SetParent<Application> ()
+    .AddConstructor<TraceReplaySender> ()
+    .SetGroupName ("lorawan")
+    .AddAttribute ("TraceFile", "The trace file to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&TraceReplaySender::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("ChunkSize", "The number of records read from the trace at a time",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&TraceReplaySender::m_chunkSize),
+                   MakeUintegerChecker<uint32_t> (1));
+  return tid;
+}
+
+TraceReplaySender::TraceReplaySender ()
+  : m_chunkSize (4096),
+  m_binary (false),
+  m_lineNumber (0),
+  m_chunkIndex (0),
+  m_nSent (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+TraceReplaySender::~TraceReplaySender ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+TraceReplaySender::SetTraceFile (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  m_traceFile = filename;
+}
+
+uint32_t
+TraceReplaySender::AddDevice (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  m_nodes.push_back (node);
+  return m_nodes.size () - 1;
+}
+
+uint32_t
+TraceReplaySender::GetNDevices (void) const
+{
+  return m_nodes.size ();
+}
+
+uint64_t
+TraceReplaySender::GetNSentPackets (void) const
+{
+  return m_nSent;
+}
+
+void
+TraceReplaySender::WriteBinaryHeader (std::ostream &os)
+{
+  os.write (BINARY_MAGIC, 4);
+  WriteLittleEndian (os, BINARY_VERSION, 4);
+}
+
+void
+TraceReplaySender::WriteBinaryRecord (std::ostream &os,
+                                      const TraceReplayRecord &record)
+{
+  NS_ASSERT (!record.timestamp.IsNegative ());
+
+  WriteLittleEndian (os, record.device, 4);
+  WriteLittleEndian (os, record.timestamp.GetNanoSeconds (), 8);
+  WriteLittleEndian (os, record.size, 1);
+  WriteLittleEndian (os, record.confirmed ? 1 : 0, 1);
+}
+
+bool
+TraceReplaySender::ReadCsvRecord (TraceReplayRecord &record)
+{
+  std::string line;
+  while (std::getline (m_file, line))
+    {
+      m_lineNumber++;
+
+      // Skip empty lines and comments
+      std::string::size_type first = line.find_first_not_of (" \t\r");
+      if (first == std::string::npos || line[first] == '#')
+        {
+          continue;
+        }
+
+      std::replace (line.begin (), line.end (), ',', ' ');
+      std::istringstream fields (line);
+      uint32_t device;
+      double seconds;
+      uint32_t size;
+      uint32_t confirmed;
+      if (!(fields >> device >> seconds >> size >> confirmed) || size > 255
+          || confirmed > 1)
+        {
+          NS_FATAL_ERROR ("Malformed record at line " << m_lineNumber <<
+                          " of " << m_traceFile);
+        }
+
+      record.device = device;
+      record.timestamp = Seconds (seconds);
+      record.size = size;
+      record.confirmed = confirmed;
+      return true;
+    }
+  return false;
+}
+
+bool
+TraceReplaySender::ReadChunk (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_chunk.clear ();
+  m_chunkIndex = 0;
+
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+
+  if (m_binary)
+    {
+      std::vector<uint8_t> buffer (m_chunkSize * BINARY_RECORD_SIZE);
+      m_file.read (reinterpret_cast<char *> (&buffer[0]), buffer.size ());
+      std::streamsize nBytes = m_file.gcount ();
+      if (nBytes % BINARY_RECORD_SIZE != 0)
+        {
+          NS_FATAL_ERROR ("Truncated record in " << m_traceFile);
+        }
+
+      for (std::streamsize offset = 0; offset < nBytes;
+           offset += BINARY_RECORD_SIZE)
+        {
+          const uint8_t *data = &buffer[offset];
+          TraceReplayRecord record;
+          record.device = ReadLittleEndian (data, 4);
+          record.timestamp = NanoSeconds (ReadLittleEndian (data + 4, 8));
+          record.size = data[12];
+          record.confirmed = data[13] & 0x01;
+          m_chunk.push_back (record);
+        }
+    }
+  else
+    {
+      TraceReplayRecord record;
+      while (m_chunk.size () < m_chunkSize && ReadCsvRecord (record))
+        {
+          m_chunk.push_back (record);
+        }
+    }
+
+  for (std::vector<TraceReplayRecord>::const_iterator it = m_chunk.begin ();
+       it != m_chunk.end (); ++it)
+    {
+      if (it->timestamp < m_lastTimestamp)
+        {
+          NS_FATAL_ERROR ("Records of " << m_traceFile <<
+                          " are not sorted by timestamp");
+        }
+      m_lastTimestamp = it->timestamp;
+    }
+
+  NS_LOG_DEBUG ("Read " << m_chunk.size () << " records");
+
+  if (m_chunk.empty ())
+    {
+      m_file.close ();
+      return false;
+    }
+  return true;
+}
+
+void
+TraceReplaySender::ScheduleNext (void)
+{
+  while (true)
+    {
+      if (m_chunkIndex >= m_chunk.size () && !ReadChunk ())
+        {
+          NS_LOG_INFO ("Trace finished after " << m_nSent << " packets");
+          return;
+        }
+
+      const TraceReplayRecord &record = m_chunk[m_chunkIndex];
+      if (record.device < m_nodes.size ())
+        {
+          Time delay = m_replayStart + record.timestamp - Simulator::Now ();
+          m_sendEvent = Simulator::ScheduleWithContext (m_nodes[record.device]->GetId (),
+                                                        delay,
+                                                        &TraceReplaySender::SendPacket,
+                                                        this);
+          return;
+        }
+
+      NS_LOG_WARN ("Skipping record for unknown device " << record.device);
+      m_chunkIndex++;
+    }
+}
+
+void
+TraceReplaySender::SendPacket (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  TraceReplayRecord record = m_chunk[m_chunkIndex++];
+  Ptr<EndDeviceLoraMac> mac = m_macs[record.device];
+
+  // The message type is a property of the MAC: set it before each packet
+  mac->SetMType (record.confirmed ? LoraMacHeader::CONFIRMED_DATA_UP :
+                 LoraMacHeader::UNCONFIRMED_DATA_UP);
+
+  Ptr<Packet> packet = LoraPacketPool::Allocate (record.size);
+  mac->Send (packet);
+  m_nSent++;
+
+  NS_LOG_DEBUG ("Device " << record.device << " sent a packet of size " <<
+                packet->GetSize ());
+
+  ScheduleNext ();
+}
+
+void
+TraceReplaySender::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Make sure we have a MAC layer for each device
+  m_macs.clear ();
+  for (std::vector<Ptr<Node> >::iterator it = m_nodes.begin ();
+       it != m_nodes.end (); ++it)
+    {
+      // Assumes there's only one device
+      Ptr<LoraNetDevice> loraNetDevice = (*it)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      Ptr<EndDeviceLoraMac> mac = loraNetDevice->GetMac ()->GetObject<EndDeviceLoraMac> ();
+      NS_ASSERT (mac != 0);
+      m_macs.push_back (mac);
+    }
+
+  Simulator::Cancel (m_sendEvent);
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  m_file.clear ();
+  m_file.open (m_traceFile.c_str (), std::ios::in | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      NS_FATAL_ERROR ("Could not open trace file " << m_traceFile);
+    }
+
+  // Detect the format from the magic
+  char magic[4];
+  m_file.read (magic, 4);
+  m_binary = m_file.gcount () == 4 && std::equal (magic, magic + 4, BINARY_MAGIC);
+  if (m_binary)
+    {
+      uint8_t version[4];
+      m_file.read (reinterpret_cast<char *> (version), 4);
+      if (m_file.gcount () != 4 || ReadLittleEndian (version, 4) != BINARY_VERSION)
+        {
+          NS_FATAL_ERROR ("Unsupported version of trace file " << m_traceFile);
+        }
+    }
+  else
+    {
+      m_file.clear ();
+      m_file.seekg (0);
+    }
+
+  m_chunk.clear ();
+  m_chunkIndex = 0;
+  m_lineNumber = 0;
+  m_lastTimestamp = Seconds (0);
+  m_replayStart = Simulator::Now ();
+
+  NS_LOG_DEBUG ("Replaying " << (m_binary ? "binary" : "CSV") << " trace " <<
+                m_traceFile << " on " << m_nodes.size () << " devices");
+
+  ScheduleNext ();
+}
+
+void
+TraceReplaySender::StopApplication (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Simulator::Cancel (m_sendEvent);
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+}
+
+void
+TraceReplaySender::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_sendEvent);
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  m_nodes.clear ();
+  m_macs.clear ();
+  Application::DoDispose ();
+}
+
+}
+}
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_REPLAY_SENDER_H
+#define TRACE_REPLAY_SENDER_H
+
+#include "ns3/application.h"
+#include "ns3/nstime.h"
+#include "ns3/end-device-lora-mac.h"
+#include "ns3/attribute.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A packet generation event read from a traffic trace.
+ */
+struct TraceReplayRecord
+{
+  uint32_t device; //!< The index of the device in the replayed set
+  Time timestamp; //!< The send time, from the start of the application
+  uint8_t size; //!< The application payload size
+  bool confirmed; //!< Whether the packet is sent as confirmed
+};
+
+/**
+ * An application that replays a recorded uplink traffic trace on a set of
+ * end devices.
+ *
+ * Records are read sequentially from the trace file, ChunkSize at a time, so
+ * that the trace is never loaded in memory as a whole. A single simulator
+ * event is pending at any time, for the next record, and it is executed in
+ * the context of the node of the device that has to send. Records must be
+ * sorted by timestamp.
+ *
+ * Two trace formats are supported, and detected automatically:
+ *  - CSV: one record per line, as "device,timestamp,size,confirmed", where
+ *    the timestamp is in seconds and confirmed is either 0 or 1. Empty lines
+ *    and lines starting with '#' are ignored.
+ *  - Binary: the "LRTR" magic and a 32 bit version, followed by fixed-size
+ *    little-endian records of a 32 bit device index, a 64 bit timestamp in
+ *    nanoseconds, an 8 bit size and an 8 bit flags field (bit 0 is the
+ *    confirmed flag). WriteBinaryHeader and WriteBinaryRecord produce this
+ *    format.
+ */
+class TraceReplaySender : public Application
+{
+public:
+  TraceReplaySender ();
+  ~TraceReplaySender ();
+
+  static TypeId GetTypeId (void);
+
+  /**
+   * Set the trace file to replay.
+   */
+  void SetTraceFile (std::string filename);
+
+  /**
+   * Add a device to the replayed set. Devices are referred to by records
+   * through the order in which they are added.
+   *
+   * \param node The node of the end device. Its first NetDevice must be a
+   * LoraNetDevice.
+   * \return The index of the device.
+   */
+  uint32_t AddDevice (Ptr<Node> node);
+
+  /**
+   * \return The number of devices in the replayed set.
+   */
+  uint32_t GetNDevices (void) const;
+
+  /**
+   * \return The number of packets replayed so far.
+   */
+  uint64_t GetNSentPackets (void) const;
+
+  /**
+   * Write the header of a binary trace.
+   */
+  static void WriteBinaryHeader (std::ostream &os);
+
+  /**
+   * Append a record to a binary trace.
+   */
+  static void WriteBinaryRecord (std::ostream &os,
+                                 const TraceReplayRecord &record);
+
+  /**
+   * Start the application by opening the trace and scheduling the first
+   * record.
+   */
+  void StartApplication (void);
+
+  /**
+   * Stop the application.
+   */
+  void StopApplication (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * Refill the chunk of records from the trace file.
+   *
+   * \return false if the trace has no more records.
+   */
+  bool ReadChunk (void);
+
+  /**
+   * Parse the next record of a CSV trace.
+   *
+   * \return false if the trace has no more records.
+   */
+  bool ReadCsvRecord (TraceReplayRecord &record);
+
+  /**
+   * Schedule the simulator event for the next record.
+   */
+  void ScheduleNext (void);
+
+  /**
+   * Send the packet of the current record.
+   */
+  void SendPacket (void);
+
+  std::string m_traceFile; //!< The trace file name
+  uint32_t m_chunkSize; //!< The number of records read at a time
+  std::ifstream m_file; //!< The open trace
+  bool m_binary; //!< Whether the trace is in the binary format
+  uint64_t m_lineNumber; //!< The current line, for CSV error messages
+
+  std::vector<TraceReplayRecord> m_chunk; //!< The records read in advance
+  uint32_t m_chunkIndex; //!< The next record in the chunk
+  Time m_lastTimestamp; //!< The timestamp of the last record read
+
+  std::vector<Ptr<Node> > m_nodes; //!< The nodes of the devices
+  std::vector<Ptr<EndDeviceLoraMac> > m_macs; //!< The MAC layers of the devices
+
+  Time m_replayStart; //!< The time the replay was started
+  EventId m_sendEvent; //!< The only pending send event
+  uint64_t m_nSent; //!< The number of packets replayed
+};
+
+}
+
+}
+#endif /* TRACE_REPLAY_SENDER_H */
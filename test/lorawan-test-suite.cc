@@ -8,6 +8,44 @@
 #include "ns3/mobility-helper.h"
 #include "ns3/one-shot-sender-helper.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/lora-header-view.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/fleet-sender-helper.h"
+#include "ns3/trace-replay-helper.h"
+#include "ns3/lora-packet-pool.h"
+#include "ns3/lora-scenario-cache.h"
+#include "ns3/lora-checkpoint.h"
+#include "ns3/lora-counters.h"
+#include "ns3/counting-scheduler.h"
+#include "ns3/lora-calibration-fitter.h"
+#include "ns3/lora-propagation-loss-model.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/shadowing-raster-helper.h"
+#include "ns3/terrain-lora-propagation-loss-model.h"
+#include "ns3/composite-lora-propagation-loss-model.h"
+#include "ns3/building-penetration-loss.h"
+#include "ns3/buildings-helper.h"
+#include "ns3/building.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/lora-tag.h"
+#include "ns3/lora-utils.h"
+#include "ns3/lora-counter-rng.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/lora-lifetime-estimator.h"
+#include "ns3/config.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include <sstream>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "utilities.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -343,6 +381,90 @@ HeaderTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((frameHdr1.GetAddress () == frameHdr.GetAddress ()),true, "Removed header contents don't match");
   NS_TEST_EXPECT_MSG_EQ (linkCheckAns->GetMargin (), 10, "Removed header's MAC command contents don't match");
   NS_TEST_EXPECT_MSG_EQ (linkCheckAns->GetGwCnt (), 1, "Removed header's MAC command contents don't match");
+
+  /////////////////////////////////////
+  // Test the LoraHeaderView class //
+  /////////////////////////////////////
+  LoraFrameHeader viewFrameHdr;
+  viewFrameHdr.SetAsUplink ();
+  viewFrameHdr.SetAddress (LoraDeviceAddress (12, 345678));
+  viewFrameHdr.SetAck (true);
+  viewFrameHdr.SetAdrAckReq (true);
+  viewFrameHdr.SetFCnt (54321);
+  viewFrameHdr.AddLinkCheckReq ();
+  LoraMacHeader viewMacHdr;
+  viewMacHdr.SetMType (LoraMacHeader::CONFIRMED_DATA_UP);
+  viewMacHdr.SetMajor (1);
+
+  Ptr<Packet> viewPkt = Create<Packet> (10);
+  viewPkt->AddHeader (viewFrameHdr);
+  viewPkt->AddHeader (viewMacHdr);
+
+  LoraHeaderView view (viewPkt);
+  NS_TEST_EXPECT_MSG_EQ (view.GetMType (), viewMacHdr.GetMType (), "View's MType doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (view.GetMajor (), viewMacHdr.GetMajor (), "View's Major doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (view.IsUplink (), true, "View's direction doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (view.IsConfirmed (), true, "View's confirmed flag doesn't match");
+  NS_TEST_EXPECT_MSG_EQ ((view.GetAddress () == viewFrameHdr.GetAddress ()), true, "View's address doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (view.GetAck (), true, "View's Ack doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (view.GetAdr (), false, "View's Adr doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (view.GetAdrAckReq (), true, "View's AdrAckReq doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFCnt (), 54321, "View's FCnt doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (view.GetFOptsLen ()), 1, "View's FOptsLen doesn't match");
+  NS_TEST_EXPECT_MSG_EQ (viewPkt->GetSize (), 10 + 1 + 9, "Peeking modified the packet");
+
+  //////////////////////////////////////////////
+  // Test the inline storage of MAC commands //
+  //////////////////////////////////////////////
+  LoraFrameHeader uplinkHdr;
+  uplinkHdr.SetAsUplink ();
+  uplinkHdr.AddCommand (Create<LinkAdrAns> (true, false, true));
+  uplinkHdr.AddCommand (Create<DevStatusAns> (200, 20));
+  uplinkHdr.AddDutyCycleAns ();
+
+  NS_TEST_EXPECT_MSG_EQ (unsigned (uplinkHdr.GetFOptsLen ()), 6, "Wrong FOptsLen");
+
+  Ptr<Packet> uplinkPkt = Create<Packet> (10);
+  uplinkPkt->AddHeader (uplinkHdr);
+  LoraFrameHeader uplinkHdr1;
+  uplinkHdr1.SetAsUplink ();
+  uplinkPkt->RemoveHeader (uplinkHdr1);
+
+  NS_TEST_EXPECT_MSG_EQ (unsigned (uplinkHdr1.GetNCommands ()), 3, "Wrong number of deserialized MAC commands");
+  NS_TEST_EXPECT_MSG_EQ (uplinkHdr1.HasMacCommand (0x06), true, "DevStatusAns not found");
+  NS_TEST_EXPECT_MSG_EQ (uplinkHdr1.HasMacCommand (0x05), false, "Found a MAC command that was never added");
+  NS_TEST_EXPECT_MSG_EQ (uplinkHdr1.GetInlineCommand (0).type, LINK_ADR_ANS, "MAC commands were reordered");
+  NS_TEST_EXPECT_MSG_EQ (uplinkHdr1.GetInlineCommand (0).linkAdrAns.dataRateAck, false, "LinkAdrAns contents don't match");
+  NS_TEST_EXPECT_MSG_EQ (uplinkHdr1.GetInlineCommand (0).linkAdrAns.channelMaskAck, true, "LinkAdrAns contents don't match");
+
+  Ptr<DevStatusAns> devStatusAns = uplinkHdr1.GetMacCommand<DevStatusAns> ();
+  NS_TEST_ASSERT_MSG_NE (devStatusAns, 0, "GetMacCommand didn't find the DevStatusAns");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (devStatusAns->GetBattery ()), 200, "DevStatusAns contents don't match");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (devStatusAns->GetMargin ()), 20, "DevStatusAns contents don't match");
+  NS_TEST_EXPECT_MSG_EQ (uplinkHdr1.GetMacCommand<DevStatusReq> (), 0, "GetMacCommand returned a command of the wrong direction");
+
+  LoraFrameHeader downlinkHdr;
+  downlinkHdr.SetAsDownlink ();
+  downlinkHdr.AddDutyCycleReq (4);
+  downlinkHdr.AddRxParamSetupReq (2, 3, 869525000);
+
+  Ptr<Packet> downlinkPkt = Create<Packet> (10);
+  downlinkPkt->AddHeader (downlinkHdr);
+  LoraFrameHeader downlinkHdr1;
+  downlinkHdr1.SetAsDownlink ();
+  downlinkPkt->RemoveHeader (downlinkHdr1);
+
+  const InlineMacCommand *rxParamSetupReq = downlinkHdr1.GetInlineCommandByCid (0x05);
+  NS_TEST_ASSERT_MSG_NE (rxParamSetupReq, 0, "RxParamSetupReq not found");
+  NS_TEST_EXPECT_MSG_EQ (rxParamSetupReq->type, RX_PARAM_SETUP_REQ, "Wrong MAC command type");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (rxParamSetupReq->rxParamSetupReq.rx1DrOffset), 2, "RxParamSetupReq contents don't match");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (rxParamSetupReq->rxParamSetupReq.rx2DataRate), 3, "RxParamSetupReq contents don't match");
+  NS_TEST_EXPECT_MSG_EQ (rxParamSetupReq->rxParamSetupReq.frequency, 8695250, "RxParamSetupReq contents don't match");
+
+  std::list<Ptr<MacCommand> > commands = downlinkHdr1.GetCommands ();
+  NS_TEST_EXPECT_MSG_EQ (commands.size (), 2, "Wrong number of MAC commands from the adapter");
+  Ptr<DutyCycleReq> dutyCycleReq = (*commands.begin ())->GetObject<DutyCycleReq> ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (dutyCycleReq->GetMaximumAllowedDutyCycle (), 1.0 / 16, 1e-9, "DutyCycleReq contents don't match");
 }
 
 /*******************
@@ -923,6 +1045,100 @@ TimeOnAirTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ_TOL (duration.GetSeconds (), 2.301952, 0.0001, "Unexpected duration");
 }
 
+/*********************
+ * AirtimeTableTest *
+ *********************/
+
+class AirtimeTableTest : public TestCase
+{
+public:
+  AirtimeTableTest ();
+  virtual ~AirtimeTableTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+AirtimeTableTest::AirtimeTableTest ()
+  : TestCase ("Verify that the time on air table matches the closed-form formula")
+{
+}
+
+// Reminder that the test case should clean up after itself
+AirtimeTableTest::~AirtimeTableTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+AirtimeTableTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("AirtimeTableTest");
+
+  double bandwidths[] = {125000, 250000, 500000};
+  uint32_t preambles[] = {6, 8, 12, 65535};
+
+  // Compare the table with the formula for all valid combinations
+  uint32_t mismatches = 0;
+  LoraTxParameters txParams;
+  for (uint8_t sf = 6; sf <= 12; sf++)
+    {
+      txParams.sf = sf;
+      for (double bandwidth : bandwidths)
+        {
+          txParams.bandwidthHz = bandwidth;
+          for (uint8_t codingRate = 1; codingRate <= 4; codingRate++)
+            {
+              txParams.codingRate = codingRate;
+              for (uint32_t nPreamble : preambles)
+                {
+                  txParams.nPreamble = nPreamble;
+                  for (int flags = 0; flags < 8; flags++)
+                    {
+                      txParams.headerDisabled = flags & 0b1;
+                      txParams.crcEnabled = flags & 0b10;
+                      txParams.lowDataRateOptimizationEnabled = flags & 0b100;
+                      for (uint32_t pl = 0; pl <= 255; pl++)
+                        {
+                          if (LoraAirtimeTable::GetOnAirTime (pl, txParams)
+                              != LoraAirtimeTable::ComputeOnAirTime (pl, txParams))
+                            {
+                              NS_LOG_DEBUG ("Mismatch for " << txParams <<
+                                            ", payload size " << pl);
+                              mismatches++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (mismatches, 0, "Table and formula disagree");
+
+  // Combinations not covered by the table fall back to the formula
+  txParams.sf = 12;
+  txParams.bandwidthHz = 7812.5;
+  NS_TEST_EXPECT_MSG_EQ (LoraAirtimeTable::GetOnAirTime (20, txParams),
+                         LoraAirtimeTable::ComputeOnAirTime (20, txParams),
+                         "Unexpected duration for a non-integer bandwidth");
+  txParams.bandwidthHz = 125000;
+  NS_TEST_EXPECT_MSG_EQ (LoraAirtimeTable::GetOnAirTime (300, txParams),
+                         LoraAirtimeTable::ComputeOnAirTime (300, txParams),
+                         "Unexpected duration for an oversized payload");
+
+  // The result is a whole number of nanoseconds
+  txParams.sf = 7;
+  txParams.codingRate = 1;
+  txParams.nPreamble = 8;
+  txParams.headerDisabled = false;
+  txParams.crcEnabled = true;
+  txParams.lowDataRateOptimizationEnabled = false;
+  NS_TEST_EXPECT_MSG_EQ (LoraAirtimeTable::GetOnAirTime (10, txParams),
+                         NanoSeconds (41216000), "Unexpected duration");
+}
+
 /**************************
  * PhyConnectivityTest *
  **************************/
@@ -1291,6 +1507,2227 @@ PhyConnectivityTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (edPhy2->GetState (), SimpleEndDeviceLoraPhy::STANDBY, "State didn't switch to STANDBY as expected");
 }
 
+/******************
+ * LazyEnergyTest *
+ *****************/
+
+class LazyEnergyTest : public TestCase
+{
+public:
+  LazyEnergyTest ();
+  virtual ~LazyEnergyTest ();
+
+  void RemainingEnergy (double oldValue, double newValue);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Drive a radio energy model through a fixed sequence of states, and
+   * record its total consumption and the remaining energy of its source at
+   * the end.
+   *
+   * \param lazy Whether lazy accounting is used.
+   * \param late Whether lazy accounting is only enabled after the source is
+   * attached, with checkpoints and a source that updates rarely.
+   */
+  void Run (bool lazy, bool late);
+
+  /**
+   * Query the current draw, as a tracer would.
+   */
+  void QueryCurrent (Ptr<LoraRadioEnergyModel> model);
+
+  void Record (Ptr<LoraRadioEnergyModel> model, Ptr<BasicEnergySource> source);
+
+  double m_totalEnergy;
+  double m_remainingEnergy;
+  int m_sourceUpdates;
+};
+
+// Add some help text to this case to describe what it is intended to test
+LazyEnergyTest::LazyEnergyTest ()
+  : TestCase ("Verify that lazy energy accounting matches the eager one")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LazyEnergyTest::~LazyEnergyTest ()
+{
+}
+
+void
+LazyEnergyTest::RemainingEnergy (double oldValue, double newValue)
+{
+  m_sourceUpdates++;
+}
+
+void
+LazyEnergyTest::QueryCurrent (Ptr<LoraRadioEnergyModel> model)
+{
+  model->GetCurrentA ();
+}
+
+void
+LazyEnergyTest::Record (Ptr<LoraRadioEnergyModel> model, Ptr<BasicEnergySource> source)
+{
+  m_totalEnergy = model->GetTotalEnergyConsumption ();
+  m_remainingEnergy = source->GetRemainingEnergy ();
+}
+
+void
+LazyEnergyTest::Run (bool lazy, bool late)
+{
+  m_sourceUpdates = 0;
+
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<BasicEnergySource> source = CreateObject<BasicEnergySource> ();
+  source->SetInitialEnergy (100);
+  source->SetSupplyVoltage (3.3);
+  source->SetEnergyUpdateInterval (late ? Seconds (100) : Seconds (0.7));
+  source->SetNode (node);
+  source->TraceConnectWithoutContext
+    ("RemainingEnergy", MakeCallback (&LazyEnergyTest::RemainingEnergy, this));
+
+  Ptr<LoraRadioEnergyModel> model = CreateObject<LoraRadioEnergyModel> ();
+  model->SetAttribute ("CheckpointInterval", TimeValue (Seconds (0.5)));
+  model->SetLazyAccounting (lazy && !late);
+  model->SetEnergySource (source);
+  source->AppendDeviceEnergyModel (model);
+  source->Initialize ();
+
+  if (lazy && late)
+    {
+      Simulator::Schedule (Seconds (0.25), &LoraRadioEnergyModel::SetLazyAccounting,
+                           model, true);
+    }
+  Simulator::Schedule (Seconds (1), &LoraRadioEnergyModel::ChangeState, model,
+                       EndDeviceLoraPhy::STANDBY);
+  Simulator::Schedule (Seconds (2), &LoraRadioEnergyModel::ChangeState, model,
+                       EndDeviceLoraPhy::TX);
+  Simulator::Schedule (Seconds (2.5), &LazyEnergyTest::QueryCurrent, this, model);
+  Simulator::Schedule (Seconds (3.5), &LoraRadioEnergyModel::ChangeState, model,
+                       EndDeviceLoraPhy::STANDBY);
+  Simulator::Schedule (Seconds (4), &LoraRadioEnergyModel::SetTxCurrentA, model, 0.05);
+  Simulator::Schedule (Seconds (5), &LoraRadioEnergyModel::ChangeState, model,
+                       EndDeviceLoraPhy::RX);
+  Simulator::Schedule (Seconds (5.2), &LazyEnergyTest::QueryCurrent, this, model);
+  Simulator::Schedule (Seconds (5.3), &LoraRadioEnergyModel::ChangeState, model,
+                       EndDeviceLoraPhy::TX);
+  Simulator::Schedule (Seconds (6.1), &LoraRadioEnergyModel::ChangeState, model,
+                       EndDeviceLoraPhy::SLEEP);
+  Simulator::Schedule (Seconds (7), &LoraRadioEnergyModel::ChangeState, model,
+                       EndDeviceLoraPhy::STANDBY);
+  Simulator::Schedule (Seconds (7), &LazyEnergyTest::Record, this, model, source);
+
+  Simulator::Stop (Seconds (8));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LazyEnergyTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LazyEnergyTest");
+
+  Run (false, false);
+  double totalEnergy = m_totalEnergy;
+  double remainingEnergy = m_remainingEnergy;
+  NS_TEST_EXPECT_MSG_GT (totalEnergy, 0, "No energy was consumed");
+  NS_TEST_EXPECT_MSG_EQ_TOL (remainingEnergy, 100 - totalEnergy, 1e-9,
+                             "The source and the model disagree");
+
+  // Queries of the current in between the updates of the source don't
+  // change the result
+  Run (true, false);
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_totalEnergy, totalEnergy, 1e-9,
+                             "Lazy accounting changed the total energy");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_remainingEnergy, remainingEnergy, 1e-9,
+                             "Lazy accounting changed the remaining energy");
+
+  // Enabling lazy accounting after the source is attached arms checkpoints
+  Run (true, true);
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_totalEnergy, totalEnergy, 1e-9,
+                             "Lazy accounting changed the total energy");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_remainingEnergy, remainingEnergy, 1e-9,
+                             "Lazy accounting changed the remaining energy");
+  NS_TEST_EXPECT_MSG_GT (m_sourceUpdates, 10, "Checkpoints were not scheduled");
+}
+
+/*************************
+ * LifetimeEstimatorTest *
+ ************************/
+
+class LifetimeEstimatorTest : public TestCase
+{
+public:
+  LifetimeEstimatorTest ();
+  virtual ~LifetimeEstimatorTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+LifetimeEstimatorTest::LifetimeEstimatorTest ()
+  : TestCase ("Verify the lifetime projection of a periodic device")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LifetimeEstimatorTest::~LifetimeEstimatorTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LifetimeEstimatorTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LifetimeEstimatorTest");
+
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<BasicEnergySource> source = CreateObject<BasicEnergySource> ();
+  source->SetInitialEnergy (100);
+  source->SetSupplyVoltage (3);
+  source->SetAttribute ("BasicEnergySourceLowBatteryThreshold", DoubleValue (0.1));
+  source->SetNode (node);
+
+  Ptr<LoraRadioEnergyModel> model = CreateObject<LoraRadioEnergyModel> ();
+  model->SetTxCurrentA (0.028);
+  model->SetStandbyCurrentA (0.0014);
+  model->SetRxCurrentA (0.0112);
+  model->SetSleepCurrentA (0.0000015);
+  model->SetEnergySource (source);
+  source->AppendDeviceEnergyModel (model);
+  source->Initialize ();
+
+  LoraLifetimeEstimator estimator;
+  estimator.Install (DeviceEnergyModelContainer (model));
+  estimator.Start (Seconds (0), Seconds (100), 10);
+
+  // Every 10 seconds, transmit for 1 second, stay in STANDBY for 2 seconds
+  // and sleep for the remaining 7
+  for (int i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (Seconds (10 * i), &LoraRadioEnergyModel::ChangeState,
+                           model, EndDeviceLoraPhy::TX);
+      Simulator::Schedule (Seconds (10 * i + 1), &LoraRadioEnergyModel::ChangeState,
+                           model, EndDeviceLoraPhy::STANDBY);
+      Simulator::Schedule (Seconds (10 * i + 3), &LoraRadioEnergyModel::ChangeState,
+                           model, EndDeviceLoraPhy::SLEEP);
+    }
+
+  Simulator::Stop (Seconds (100));
+  Simulator::Run ();
+
+  std::vector<LoraLifetimeEstimator::DeviceLifetime> estimates = estimator.Estimate ();
+
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (estimates.size (), 1, "Wrong number of estimates");
+  LoraLifetimeEstimator::DeviceLifetime estimate = estimates[0];
+
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.stateFraction[EndDeviceLoraPhy::TX], 0.1, 1e-9,
+                             "Wrong TX rate");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.stateFraction[EndDeviceLoraPhy::STANDBY], 0.2, 1e-9,
+                             "Wrong STANDBY rate");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.stateFraction[EndDeviceLoraPhy::SLEEP], 0.7, 1e-9,
+                             "Wrong SLEEP rate");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.stateFraction[EndDeviceLoraPhy::RX], 0, 1e-9,
+                             "Wrong RX rate");
+
+  // The source is depleted once 90 J have been drawn at a constant power
+  double power = 3 * (0.1 * 0.028 + 0.2 * 0.0014 + 0.7 * 0.0000015);
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.meanPowerW, power, 1e-12, "Wrong average power");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.remainingEnergyJ, 100 - 100 * power, 1e-9,
+                             "Wrong remaining energy");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.usableEnergyJ, 90 - 100 * power, 1e-9,
+                             "Wrong usable energy");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.depletion.GetSeconds (), 90 / power, 1e-3,
+                             "Wrong depletion time");
+
+  // All windows draw the same power
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.powerStdErrW, 0, 1e-12, "Unexpected spread");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.depletionLow.GetSeconds (), 90 / power, 1e-3,
+                             "Wrong confidence interval");
+  NS_TEST_EXPECT_MSG_EQ_TOL (estimate.depletionHigh.GetSeconds (), 90 / power, 1e-3,
+                             "Wrong confidence interval");
+}
+
+/*******************
+ * FleetSenderTest *
+ *******************/
+
+class FleetSenderTest : public TestCase
+{
+public:
+  FleetSenderTest ();
+  virtual ~FleetSenderTest ();
+
+  void StartSending (std::string context, Ptr<const Packet> packet,
+                     uint32_t nodeId);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Simulate a small network with either traffic generator, and return the
+   * list of packets that were sent by the end devices.
+   */
+  std::vector<std::string> RunScenario (bool fleet);
+
+  std::vector<std::string> m_sent;
+};
+
+// Add some help text to this case to describe what it is intended to test
+FleetSenderTest::FleetSenderTest ()
+  : TestCase ("Verify that the FleetSender generates the same traffic as PeriodicSender")
+{
+}
+
+// Reminder that the test case should clean up after itself
+FleetSenderTest::~FleetSenderTest ()
+{
+}
+
+void
+FleetSenderTest::StartSending (std::string context, Ptr<const Packet> packet,
+                               uint32_t nodeId)
+{
+  std::ostringstream entry;
+  entry << Simulator::Now ().GetTimeStep () << " " << nodeId << " " <<
+    packet->GetSize ();
+  m_sent.push_back (entry.str ());
+}
+
+std::vector<std::string>
+FleetSenderTest::RunScenario (bool fleet)
+{
+  m_sent.clear ();
+
+  NetworkComponents components = InitializeNetwork (20, 1);
+
+  Ptr<UniformRandomVariable> sizeRV = CreateObject<UniformRandomVariable> ();
+  sizeRV->SetAttribute ("Min", DoubleValue (0));
+  sizeRV->SetAttribute ("Max", DoubleValue (10));
+  sizeRV->SetStream (100);
+
+  if (fleet)
+    {
+      FleetSenderHelper helper;
+      helper.AssignStreams (200);
+      helper.SetPeriod (Seconds (600));
+      helper.SetPacketSizeRandomVariable (sizeRV);
+      // Use a small wheel, so that devices also go through the overflow heap
+      helper.SetAttribute ("NumberOfSlots", UintegerValue (16));
+      helper.SetAttribute ("SlotWidth", TimeValue (Seconds (10)));
+      helper.Install (components.endDevices);
+    }
+  else
+    {
+      PeriodicSenderHelper helper;
+      helper.AssignStreams (200);
+      helper.SetPeriod (Seconds (600));
+      helper.SetPacketSizeRandomVariable (sizeRV);
+      helper.Install (components.endDevices);
+    }
+
+  Config::Connect ("/NodeList/*/DeviceList/0/$ns3::LoraNetDevice/Phy/StartSending",
+                   MakeCallback (&FleetSenderTest::StartSending, this));
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  return m_sent;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+FleetSenderTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("FleetSenderTest");
+
+  std::vector<std::string> periodic = RunScenario (false);
+  std::vector<std::string> fleet = RunScenario (true);
+
+  // 20 devices sending every 10 minutes for 2 hours
+  NS_TEST_EXPECT_MSG_EQ (periodic.size (), 240, "Unexpected number of packets");
+  NS_TEST_ASSERT_MSG_EQ (fleet.size (), periodic.size (),
+                         "Different number of packets");
+  for (uint32_t i = 0; i < periodic.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (fleet[i], periodic[i], "Different packet " << i);
+    }
+}
+
+/*******************
+ * TraceReplayTest *
+ *******************/
+
+class TraceReplayTest : public TestCase
+{
+public:
+  TraceReplayTest ();
+  virtual ~TraceReplayTest ();
+
+  void StartSending (std::string context, Ptr<const Packet> packet,
+                     uint32_t nodeId);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Replay a trace on a small network, and check the resulting transmissions.
+   */
+  void RunScenario (std::string filename);
+
+  std::vector<std::pair<Time, uint32_t> > m_sent;
+};
+
+// Add some help text to this case to describe what it is intended to test
+TraceReplayTest::TraceReplayTest ()
+  : TestCase ("Verify that the TraceReplaySender replays CSV and binary traces")
+{
+}
+
+// Reminder that the test case should clean up after itself
+TraceReplayTest::~TraceReplayTest ()
+{
+}
+
+void
+TraceReplayTest::StartSending (std::string context, Ptr<const Packet> packet,
+                               uint32_t nodeId)
+{
+  m_sent.push_back (std::make_pair (Simulator::Now (), nodeId));
+}
+
+void
+TraceReplayTest::RunScenario (std::string filename)
+{
+  m_sent.clear ();
+
+  NetworkComponents components = InitializeNetwork (3, 1);
+
+  TraceReplayHelper helper;
+  helper.SetTraceFile (filename);
+  // Make sure records are read in more than one chunk
+  helper.SetAttribute ("ChunkSize", UintegerValue (2));
+  ApplicationContainer apps = helper.Install (components.endDevices);
+
+  Config::Connect ("/NodeList/*/DeviceList/0/$ns3::LoraNetDevice/Phy/StartSending",
+                   MakeCallback (&TraceReplayTest::StartSending, this));
+
+  // Stop before the confirmed packet can be retransmitted
+  Simulator::Stop (Seconds (101));
+  Simulator::Run ();
+
+  Ptr<TraceReplaySender> app = DynamicCast<TraceReplaySender> (apps.Get (0));
+  NS_TEST_EXPECT_MSG_EQ (app->GetNSentPackets (), 4, "Unexpected number of replayed packets");
+
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 4, "Unexpected number of transmissions");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[0].first, Seconds (10), "Wrong transmission time");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[0].second, components.endDevices.Get (0)->GetId (),
+                         "Wrong transmitting device");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[1].first, Seconds (10), "Wrong transmission time");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[1].second, components.endDevices.Get (1)->GetId (),
+                         "Wrong transmitting device");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[2].first, Seconds (30.5), "Wrong transmission time");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[2].second, components.endDevices.Get (2)->GetId (),
+                         "Wrong transmitting device");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[3].first, Seconds (100), "Wrong transmission time");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[3].second, components.endDevices.Get (1)->GetId (),
+                         "Wrong transmitting device");
+
+  // The last packet was confirmed
+  Ptr<EndDeviceLoraMac> mac =
+    GetMacLayerFromNode<EndDeviceLoraMac> (components.endDevices.Get (1));
+  NS_TEST_EXPECT_MSG_EQ (mac->GetMType (), LoraMacHeader::CONFIRMED_DATA_UP,
+                         "The confirmed flag was not applied");
+
+  // Disposing the application releases the nodes it replays on
+  Ptr<Node> node = components.endDevices.Get (2);
+  uint32_t references = node->GetReferenceCount ();
+  app->Dispose ();
+  NS_TEST_EXPECT_MSG_EQ (app->GetNDevices (), 0, "The devices were not released");
+  NS_TEST_EXPECT_MSG_EQ (node->GetReferenceCount (), references - 1,
+                         "The node was not released");
+
+  Simulator::Destroy ();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+TraceReplayTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("TraceReplayTest");
+
+  TraceReplayRecord records[] = {
+    {0, Seconds (10), 20, false},
+    {1, Seconds (10), 15, false},
+    {2, Seconds (30.5), 5, false},
+    {7, Seconds (40), 10, false},       // Unknown device, skipped
+    {1, Seconds (100), 30, true}
+  };
+
+  std::string csvFile = CreateTempDirFilename ("replay.csv");
+  std::ofstream csv (csvFile.c_str ());
+  csv << "# device,timestamp,size,confirmed" << std::endl;
+  for (const auto &record : records)
+    {
+      csv << record.device << "," << record.timestamp.GetSeconds () << "," <<
+        unsigned (record.size) << "," << record.confirmed << std::endl;
+    }
+  csv.close ();
+
+  std::string binaryFile = CreateTempDirFilename ("replay.bin");
+  std::ofstream binary (binaryFile.c_str (), std::ios::binary);
+  TraceReplaySender::WriteBinaryHeader (binary);
+  for (const auto &record : records)
+    {
+      TraceReplaySender::WriteBinaryRecord (binary, record);
+    }
+  binary.close ();
+
+  RunScenario (csvFile);
+  RunScenario (binaryFile);
+}
+
+/******************
+ * PacketPoolTest *
+ ******************/
+
+class PacketPoolTest : public TestCase
+{
+public:
+  PacketPoolTest ();
+  virtual ~PacketPoolTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+PacketPoolTest::PacketPoolTest ()
+  : TestCase ("Verify that the packet pool recycles released packets")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PacketPoolTest::~PacketPoolTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PacketPoolTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PacketPoolTest");
+
+  LoraPacketPool::SetEnabled (true);
+  LoraPacketPool::ResetStats ();
+
+  // A new pool can only miss
+  Ptr<Packet> first = LoraPacketPool::Allocate (10);
+  NS_TEST_EXPECT_MSG_EQ (first->GetSize (), 10, "Wrong packet size");
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetStats ().misses, 1, "Expected a miss");
+
+  // Packets still referenced elsewhere are not reused
+  Ptr<Packet> second = LoraPacketPool::Allocate (20);
+  NS_TEST_EXPECT_MSG_NE (first, second, "A packet in use was recycled");
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetStats ().misses, 2, "Expected a miss");
+
+  // Simulate what the MAC does to the packet, then release it
+  LoraFrameHeader frameHdr;
+  first->AddHeader (frameHdr);
+  LoraTag tag;
+  first->AddPacketTag (tag);
+  Packet *firstPointer = PeekPointer (first);
+  uint64_t firstUid = first->GetUid ();
+  first = 0;
+
+  Ptr<Packet> recycled = LoraPacketPool::Allocate (15);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (recycled), firstPointer,
+                         "The released packet was not recycled");
+  NS_TEST_EXPECT_MSG_EQ (recycled->GetSize (), 15, "Wrong recycled packet size");
+  NS_TEST_EXPECT_MSG_EQ (recycled->PeekPacketTag (tag), false,
+                         "Tags of the recycled packet were not removed");
+  NS_TEST_EXPECT_MSG_NE (recycled->GetUid (), firstUid,
+                         "The recycled packet kept the uid of the released one");
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetStats ().hits, 1, "Expected a hit");
+
+  // The recycled packet can be used as a new one
+  recycled->AddHeader (frameHdr);
+  LoraFrameHeader readHdr;
+  recycled->RemoveHeader (readHdr);
+  NS_TEST_EXPECT_MSG_EQ (recycled->GetSize (), 15, "Wrong size after header removal");
+
+  // Destroying the simulator releases the packets of the run
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetSize (), 0, "The pool outlived the run");
+  Ptr<Packet> next = LoraPacketPool::Allocate (15);
+  NS_TEST_EXPECT_MSG_NE (next, recycled, "A packet of the previous run was reused");
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetSize (), 1, "The new packet was not pooled");
+  next = 0;
+
+  // Disabling the pool releases its packets
+  LoraPacketPool::SetEnabled (false);
+  NS_TEST_EXPECT_MSG_EQ (LoraPacketPool::GetSize (), 0, "The pool was not cleared");
+  NS_TEST_EXPECT_MSG_EQ (recycled->GetReferenceCount (), 1, "Unexpected reference count");
+}
+
+/*********************
+ * ScenarioCacheTest *
+ *********************/
+
+class ScenarioCacheTest : public TestCase
+{
+public:
+  ScenarioCacheTest ();
+  virtual ~ScenarioCacheTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+ScenarioCacheTest::ScenarioCacheTest ()
+  : TestCase ("Verify that a cached scenario is restored with the same links")
+{
+}
+
+// Reminder that the test case should clean up after itself
+ScenarioCacheTest::~ScenarioCacheTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ScenarioCacheTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ScenarioCacheTest");
+
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+
+  // Build a scenario whose losses depend on the spreading factor
+  Ptr<LoraChannel> channel =
+    CreateObject<LoraChannel> (CreateObject<RYLRLoraPropagationLossModel> (), delay);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                 "rho", DoubleValue (1000),
+                                 "X", DoubleValue (0.0),
+                                 "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  NodeContainer endDevices = CreateEndDevices (3, mobility, channel);
+  NodeContainer gateways = CreateGateways (2, mobility, channel);
+
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<EndDeviceLoraMac> mac = GetMacLayerFromNode<EndDeviceLoraMac> (endDevices.Get (i));
+      mac->SetDataRate (i + 1);
+      mac->SetDeviceAddress (LoraDeviceAddress (100 + i));
+      mac->SetTransmissionPower (2 + 2 * i);
+    }
+
+  std::string filename = CreateTempDirFilename ("scenario.cache");
+  NS_TEST_ASSERT_MSG_EQ (LoraScenarioCache::Save (filename, endDevices, gateways,
+                                                  channel, 42),
+                         true, "Unable to save the scenario");
+
+  Ptr<LoraScenarioCache> cache = Create<LoraScenarioCache> ();
+  NS_TEST_EXPECT_MSG_EQ (cache->Load (filename, 43), false,
+                         "A cache with a different key was loaded");
+  NS_TEST_ASSERT_MSG_EQ (cache->Load (filename, 42), true,
+                         "Unable to load the scenario");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetNEndDevices (), 3, "Wrong number of end devices");
+  NS_TEST_EXPECT_MSG_EQ (cache->GetNGateways (), 2, "Wrong number of gateways");
+
+  // Restore it on a new set of nodes, all placed at the origin
+  Ptr<CachedLoraPropagationLossModel> cachedLoss =
+    CreateObject<CachedLoraPropagationLossModel> ();
+  cachedLoss->SetCache (cache);
+  cachedLoss->SetFallback (CreateObject<RYLRLoraPropagationLossModel> ());
+  Ptr<LoraChannel> cachedChannel = CreateObject<LoraChannel> (cachedLoss, delay);
+
+  MobilityHelper origin;
+  origin.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  NodeContainer cachedEndDevices = CreateEndDevices (3, origin, cachedChannel);
+  NodeContainer cachedGateways = CreateGateways (2, origin, cachedChannel);
+
+  cache->Apply (cachedEndDevices, cachedGateways);
+
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<MobilityModel> original = endDevices.Get (i)->GetObject<MobilityModel> ();
+      Ptr<MobilityModel> cached = cachedEndDevices.Get (i)->GetObject<MobilityModel> ();
+      NS_TEST_EXPECT_MSG_EQ (cached->GetDistanceFrom (original), 0,
+                             "End device position not restored");
+
+      Ptr<EndDeviceLoraMac> mac =
+        GetMacLayerFromNode<EndDeviceLoraMac> (cachedEndDevices.Get (i));
+      NS_TEST_EXPECT_MSG_EQ (unsigned (mac->GetDataRate ()), i + 1,
+                             "Data rate not restored");
+      NS_TEST_EXPECT_MSG_EQ (mac->GetDeviceAddress ().Get (), 100 + i,
+                             "Address not restored");
+      NS_TEST_EXPECT_MSG_EQ (unsigned (mac->GetTransmissionPower ()), 2 + 2 * i,
+                             "Transmission power not restored");
+
+      for (uint32_t j = 0; j < gateways.GetN (); j++)
+        {
+          Ptr<MobilityModel> gw = gateways.Get (j)->GetObject<MobilityModel> ();
+          Ptr<MobilityModel> cachedGw = cachedGateways.Get (j)->GetObject<MobilityModel> ();
+          for (uint8_t sf = 7; sf <= 12; sf += 5)
+            {
+              NS_TEST_EXPECT_MSG_EQ_TOL (cachedChannel->GetRxPower (14, cached, cachedGw, sf),
+                                         channel->GetRxPower (14, original, gw, sf),
+                                         1e-3, "Wrong cached uplink loss");
+              NS_TEST_EXPECT_MSG_EQ_TOL (cachedChannel->GetRxPower (14, cachedGw, cached, sf),
+                                         channel->GetRxPower (14, gw, original, sf),
+                                         1e-3, "Wrong cached downlink loss");
+            }
+        }
+    }
+
+  // Links that are not in the cache use the fallback model
+  NS_TEST_EXPECT_MSG_EQ_TOL (cachedChannel->GetRxPower (14,
+                                                        cachedEndDevices.Get (0)->GetObject<MobilityModel> (),
+                                                        cachedEndDevices.Get (1)->GetObject<MobilityModel> (),
+                                                        9),
+                             channel->GetRxPower (14,
+                                                  endDevices.Get (0)->GetObject<MobilityModel> (),
+                                                  endDevices.Get (1)->GetObject<MobilityModel> (),
+                                                  9),
+                             1e-9, "Wrong fallback loss");
+
+  Simulator::Destroy ();
+}
+
+/******************
+ * CheckpointTest *
+ ******************/
+
+class CheckpointTest : public TestCase
+{
+public:
+  CheckpointTest ();
+  virtual ~CheckpointTest ();
+
+  void StartSending (std::string context, Ptr<const Packet> packet,
+                     uint32_t nodeId);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Build a network with a single periodic sender, and either save a
+   * checkpoint or restore it.
+   */
+  void RunScenario (std::string filename, bool restore);
+
+  std::vector<Time> m_sent;
+};
+
+// Add some help text to this case to describe what it is intended to test
+CheckpointTest::CheckpointTest ()
+  : TestCase ("Verify that a restored checkpoint resumes the saved network")
+{
+}
+
+// Reminder that the test case should clean up after itself
+CheckpointTest::~CheckpointTest ()
+{
+}
+
+void
+CheckpointTest::StartSending (std::string context, Ptr<const Packet> packet,
+                              uint32_t nodeId)
+{
+  m_sent.push_back (Simulator::Now ());
+}
+
+void
+CheckpointTest::RunScenario (std::string filename, bool restore)
+{
+  m_sent.clear ();
+
+  NetworkComponents components = InitializeNetwork (1, 1);
+  Ptr<Node> endDevice = components.endDevices.Get (0);
+  Ptr<EndDeviceLoraMac> mac = GetMacLayerFromNode<EndDeviceLoraMac> (endDevice);
+
+  Ptr<PeriodicSender> app = CreateObject<PeriodicSender> ();
+  app->SetInterval (Seconds (100));
+  endDevice->AddApplication (app);
+
+  LoraCheckpoint checkpoint;
+  checkpoint.SetEndDevices (components.endDevices);
+  checkpoint.SetGateways (components.gateways);
+  checkpoint.SetNetworkServer (components.nsNode);
+
+  if (restore)
+    {
+      // Start from a different configuration, that the checkpoint overrides
+      app->SetInitialDelay (Seconds (50));
+      mac->SetDataRate (0);
+      NS_TEST_ASSERT_MSG_EQ (checkpoint.Restore (filename), true,
+                             "Unable to restore the checkpoint");
+      NS_TEST_EXPECT_MSG_EQ (checkpoint.GetCheckpointTime (), Seconds (150),
+                             "Wrong checkpoint time");
+    }
+  else
+    {
+      app->SetInitialDelay (Seconds (10));
+      mac->SetDataRate (5);
+      checkpoint.ScheduleSave (Seconds (150), filename);
+    }
+
+  Config::Connect ("/NodeList/*/DeviceList/0/$ns3::LoraNetDevice/Phy/StartSending",
+                   MakeCallback (&CheckpointTest::StartSending, this));
+
+  Simulator::Stop (Seconds (400));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (unsigned (mac->GetDataRate ()), 5,
+                         "The data rate was not restored");
+
+  Simulator::Destroy ();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+CheckpointTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("CheckpointTest");
+
+  std::string filename = CreateTempDirFilename ("network.checkpoint");
+
+  RunScenario (filename, false);
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 4, "Unexpected number of transmissions");
+  std::vector<Time> saved = m_sent;
+
+  // Only the transmissions after the checkpoint are repeated
+  RunScenario (filename, true);
+  NS_TEST_ASSERT_MSG_EQ (m_sent.size (), 2, "Unexpected number of transmissions");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[0], saved[2], "Wrong transmission time");
+  NS_TEST_EXPECT_MSG_EQ (m_sent[1], saved[3], "Wrong transmission time");
+
+  // A corrupt count of end devices is rejected before anything is allocated
+  std::string corruptFilename = CreateTempDirFilename ("corrupt.checkpoint");
+  {
+    std::ifstream in (filename.c_str (), std::ios::binary);
+    std::ofstream out (corruptFilename.c_str (), std::ios::binary);
+    out << in.rdbuf ();
+    // After the magic, the version, the time, the seed and the run
+    out.seekp (4 + 4 + 8 + 4 + 8);
+    uint32_t count = std::numeric_limits<uint32_t>::max ();
+    out.write (reinterpret_cast<const char *> (&count), sizeof (count));
+  }
+  NetworkComponents components = InitializeNetwork (1, 1);
+  LoraCheckpoint checkpoint;
+  checkpoint.SetEndDevices (components.endDevices);
+  checkpoint.SetGateways (components.gateways);
+  NS_TEST_EXPECT_MSG_EQ (checkpoint.Restore (corruptFilename), false,
+                         "A corrupt checkpoint was restored");
+  Simulator::Destroy ();
+}
+
+/****************
+ * CountersTest *
+ ****************/
+
+class CountersTest : public TestCase
+{
+public:
+  CountersTest ();
+  virtual ~CountersTest ();
+
+  void Sample (Time now, const LoraCounters::Snapshot &snapshot);
+
+private:
+  virtual void DoRun (void);
+
+  std::vector<uint64_t> m_sampledTransmissions;
+};
+
+// Add some help text to this case to describe what it is intended to test
+CountersTest::CountersTest ()
+  : TestCase ("Verify that the performance counters track the hot paths")
+{
+}
+
+// Reminder that the test case should clean up after itself
+CountersTest::~CountersTest ()
+{
+}
+
+void
+CountersTest::Sample (Time now, const LoraCounters::Snapshot &snapshot)
+{
+  m_sampledTransmissions.push_back
+    (snapshot.counters[LoraCounters::CHANNEL_TRANSMISSIONS]);
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+CountersTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("CountersTest");
+
+  // Histogram buckets have power-of-two bounds
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::GetBucket (0), 0, "Wrong bucket");
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::GetBucket (1), 1, "Wrong bucket");
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::GetBucket (3), 2, "Wrong bucket");
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::GetBucket (4), 3, "Wrong bucket");
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::GetBucket (uint64_t (1) << 40),
+                         LoraCounters::N_BUCKETS - 1,
+                         "Large values must fall in the last bucket");
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::GetBucketLowerBound (3), 4,
+                         "Wrong bucket bound");
+
+  LoraCounters::Reset ();
+  LoraCounters::Record (LoraCounters::INTERFERENCE_EVENTS, 5);
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::Get (LoraCounters::INTERFERENCE_EVENTS, 3), 1,
+                         "The value was not recorded");
+  LoraCounters::Reset ();
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::Get (LoraCounters::INTERFERENCE_EVENTS, 3), 0,
+                         "The histogram was not reset");
+
+  if (!LoraCounters::IsEnabled ())
+    {
+      return;
+    }
+
+  // Each transmission of the end device only reaches the gateway
+  NetworkComponents components = InitializeNetwork (1, 1);
+  Ptr<PeriodicSender> app = CreateObject<PeriodicSender> ();
+  app->SetInterval (Seconds (100));
+  app->SetInitialDelay (Seconds (10));
+  components.endDevices.Get (0)->AddApplication (app);
+
+  Ptr<LoraCounterSampler> sampler = CreateObject<LoraCounterSampler> ();
+  sampler->SetAttribute ("Interval", TimeValue (Seconds (50)));
+  sampler->TraceConnectWithoutContext ("Sample",
+                                       MakeCallback (&CountersTest::Sample, this));
+  sampler->Start ();
+
+  Simulator::Stop (Seconds (160));
+  Simulator::Run ();
+
+  uint64_t transmissions = LoraCounters::Get (LoraCounters::CHANNEL_TRANSMISSIONS);
+  NS_TEST_EXPECT_MSG_GT (transmissions, 1, "Missing transmissions");
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::Get (LoraCounters::CHANNEL_RECEIVE_EVENTS),
+                         transmissions,
+                         "Each transmission should schedule one reception");
+  NS_TEST_EXPECT_MSG_EQ (LoraCounters::Get
+                           (LoraCounters::RECEIVE_EVENTS_PER_TRANSMISSION, 1),
+                         transmissions, "Wrong receive events histogram");
+
+  NS_TEST_ASSERT_MSG_EQ (m_sampledTransmissions.size (), 3, "Wrong number of samples");
+  NS_TEST_EXPECT_MSG_EQ (m_sampledTransmissions[0], 1, "Wrong sampled value");
+  NS_TEST_EXPECT_MSG_GT (m_sampledTransmissions[2], 1, "Wrong sampled value");
+
+  Simulator::Destroy ();
+}
+
+/*************************
+ * PerformanceBudgetTest *
+ *************************/
+
+class PerformanceBudgetTest : public TestCase
+{
+public:
+  PerformanceBudgetTest (uint32_t nDevices, uint32_t nGateways);
+  virtual ~PerformanceBudgetTest ();
+
+  void StartSending (std::string context, Ptr<const Packet> packet,
+                     uint32_t nodeId);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_nDevices;
+  uint32_t m_nGateways;
+  uint64_t m_transmissions;
+};
+
+// Add some help text to this case to describe what it is intended to test
+PerformanceBudgetTest::PerformanceBudgetTest (uint32_t nDevices,
+                                              uint32_t nGateways)
+  : TestCase ("Verify that a network of " + std::to_string (nDevices) +
+              " devices and " + std::to_string (nGateways) +
+              " gateways stays within its event budgets"),
+    m_nDevices (nDevices),
+    m_nGateways (nGateways),
+    m_transmissions (0)
+{
+}
+
+// Reminder that the test case should clean up after itself
+PerformanceBudgetTest::~PerformanceBudgetTest ()
+{
+}
+
+void
+PerformanceBudgetTest::StartSending (std::string context,
+                                     Ptr<const Packet> packet, uint32_t nodeId)
+{
+  m_transmissions++;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PerformanceBudgetTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PerformanceBudgetTest");
+
+  // The budgets are linear in the number of transmissions, with a slack that
+  // covers the current implementation. They don't depend on the machine, but
+  // catch per-transmission work that grows with the size of the network.
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  ObjectFactory scheduler;
+  scheduler.SetTypeId ("ns3::CountingScheduler");
+  Simulator::SetScheduler (scheduler);
+
+  LoraCounters::Reset ();
+  m_transmissions = 0;
+
+  NetworkComponents components = InitializeNetwork (m_nDevices, m_nGateways);
+
+  // Make one device out of five send confirmed packets, so that the network
+  // server also replies
+  for (uint32_t i = 0; i < m_nDevices; i += 5)
+    {
+      GetMacLayerFromNode<EndDeviceLoraMac> (components.endDevices.Get (i))->
+        SetMType (LoraMacHeader::CONFIRMED_DATA_UP);
+    }
+
+  PeriodicSenderHelper appHelper;
+  appHelper.SetPeriod (Seconds (30));
+  ApplicationContainer apps = appHelper.Install (components.endDevices);
+  apps.Start (Seconds (0));
+  apps.Stop (Seconds (1200));
+
+  Config::Connect ("/NodeList/*/DeviceList/0/$ns3::LoraNetDevice/Phy/StartSending",
+                   MakeCallback (&PerformanceBudgetTest::StartSending, this));
+
+  Simulator::Stop (Seconds (1200));
+  Simulator::Run ();
+
+  uint64_t nPhys = m_nDevices + m_nGateways;
+  uint64_t nNodes = nPhys + 1;
+  NS_TEST_EXPECT_MSG_GT (m_transmissions, m_nDevices, "Too few transmissions");
+
+  // Each transmission schedules a reception at each other PHY, plus a few
+  // events at the sender, at the gateways and at the network server
+  uint64_t eventBudget = m_transmissions * (nPhys + 5 * m_nGateways + 20) +
+    10 * nNodes;
+  NS_TEST_EXPECT_MSG_LT (CountingScheduler::GetScheduledEvents (),
+                         eventBudget, "Scheduled events over budget");
+
+  Simulator::Destroy ();
+
+  if (!LoraCounters::IsEnabled ())
+    {
+      return;
+    }
+
+  // Events older than a couple of seconds are cleaned once the interference
+  // helper stores more than 100 of them
+  for (uint32_t b = LoraCounters::GetBucket (256); b < LoraCounters::N_BUCKETS; b++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (LoraCounters::Get (LoraCounters::INTERFERENCE_EVENTS, b),
+                             0, "Too many interference events stored");
+    }
+
+  // Uplinks are copied by the gateway MAC and by the forwarder, replies by a
+  // few components along the way back
+  uint64_t uplinks = LoraCounters::Get (LoraCounters::NETWORK_SERVER_UPLINKS);
+  NS_TEST_EXPECT_MSG_GT (uplinks, 0, "No packet reached the network server");
+  NS_TEST_EXPECT_MSG_LT (LoraCounters::Get (LoraCounters::PACKET_COPIES),
+                         3 * uplinks + 8 * m_transmissions,
+                         "Packet copies over budget");
+
+  // Frame headers are only deserialized to build replies and by the end
+  // devices that receive them
+  NS_TEST_EXPECT_MSG_LT
+    (LoraCounters::Get (LoraCounters::FRAME_HEADER_DESERIALIZATIONS),
+    3 * uplinks, "Header deserializations over budget");
+}
+
+/***********************
+ * RylrCalibrationTest *
+ **********************/
+
+class RylrCalibrationTest : public TestCase
+{
+public:
+  RylrCalibrationTest ();
+  virtual ~RylrCalibrationTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Compute the received power of a 14 dBm transmission over a distance.
+   */
+  double GetRxPower (Ptr<RYLRLoraPropagationLossModel> loss, uint8_t sf,
+                     double distance);
+};
+
+// Add some help text to this case to describe what it is intended to test
+RylrCalibrationTest::RylrCalibrationTest ()
+  : TestCase ("Verify the calibration of the RYLR propagation loss model")
+{
+}
+
+// Reminder that the test case should clean up after itself
+RylrCalibrationTest::~RylrCalibrationTest ()
+{
+}
+
+double
+RylrCalibrationTest::GetRxPower (Ptr<RYLRLoraPropagationLossModel> loss,
+                                 uint8_t sf, double distance)
+{
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 0));
+  b->SetPosition (Vector (distance, 0, 0));
+  loss->SetTxSF (sf);
+  return loss->CalcRxPower (14, a, b);
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+RylrCalibrationTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("RylrCalibrationTest");
+
+  // The default coefficients follow the original linear approximation
+  Ptr<RYLRLoraPropagationLossModel> loss = CreateObject<RYLRLoraPropagationLossModel> ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetRxPower (loss, 7, 450),
+                             14 - (63 + 65.0 / 900 * 450) + 9, 1e-9,
+                             "Wrong SF7 default");
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetRxPower (loss, 12, 1000),
+                             14 - (63 + 55.0 / 1275 * 1000) + 32, 1e-9,
+                             "Wrong SF12 default");
+
+  // SFs that are not calibrated use SF7
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetRxPower (loss, 5, 300), GetRxPower (loss, 7, 300),
+                             1e-9, "SF5 should use the coefficients of SF7");
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetRxPower (loss, 13, 300), GetRxPower (loss, 7, 300),
+                             1e-9, "SF13 should use the coefficients of SF7");
+
+  // Save and load a calibration
+  RYLRLoraPropagationLossModel::Coefficients c =
+    RYLRLoraPropagationLossModel::GetDefaultCoefficients (9);
+  c.constant = 40;
+  c.linear = 0.01;
+  c.logarithmic = 20;
+  c.referenceDistance = 10;
+  c.breakpoint = 500;
+  c.piecewise = 0.05;
+  loss->SetCoefficients (9, c);
+  double expected = GetRxPower (loss, 9, 800);
+  NS_TEST_EXPECT_MSG_EQ_TOL (expected,
+                             14 - (40 + 8 + 20 * std::log10 (800.0) + 15) + c.offset,
+                             1e-9, "Wrong received power with custom coefficients");
+
+  std::string filename = CreateTempDirFilename ("rylr.calibration");
+  NS_TEST_ASSERT_MSG_EQ (loss->SaveCalibration (filename), true,
+                         "Unable to save the calibration");
+  Ptr<RYLRLoraPropagationLossModel> loaded = CreateObject<RYLRLoraPropagationLossModel> ();
+  loaded->SetAttribute ("CalibrationFile", StringValue (filename));
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetRxPower (loaded, 9, 800), expected, 1e-9,
+                             "The calibration was not restored");
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetRxPower (loaded, 10, 800), GetRxPower (loss, 10, 800),
+                             1e-9, "The calibration was not restored");
+  NS_TEST_EXPECT_MSG_EQ (loaded->LoadCalibration (CreateTempDirFilename ("missing")),
+                         false, "A missing file should not be loaded");
+
+  // The fitter recovers the coefficients of synthetic measurements
+  LoraCalibrationFitter fitter;
+  for (double d = 20; d <= 1200; d += 20)
+    {
+      fitter.AddSample (d, 7, 14 - (60 + 0.07 * d));
+      fitter.AddSample (d, 8, 14 - (30 + 25 * std::log10 (d)));
+      fitter.AddSample (d, 9, 14 - (65 + 0.02 * d + 0.06 * std::max (d - 600, 0.0)));
+    }
+  NS_TEST_EXPECT_MSG_EQ (fitter.GetNSamples (7), 60, "Wrong number of samples");
+
+  RYLRLoraPropagationLossModel::Coefficients linear =
+    fitter.Fit (7, LoraCalibrationFitter::LINEAR);
+  NS_TEST_EXPECT_MSG_EQ_TOL (linear.constant, 60, 1e-6, "Wrong linear fit");
+  NS_TEST_EXPECT_MSG_EQ_TOL (linear.linear, 0.07, 1e-8, "Wrong linear fit");
+  NS_TEST_EXPECT_MSG_EQ_TOL (fitter.GetRmse (7, linear), 0, 1e-6, "Wrong linear fit");
+  NS_TEST_EXPECT_MSG_EQ_TOL (linear.offset,
+                             RYLRLoraPropagationLossModel::GetDefaultCoefficients (7).offset,
+                             1e-9, "The offset should not be fitted");
+
+  RYLRLoraPropagationLossModel::Coefficients logDistance =
+    fitter.Fit (8, LoraCalibrationFitter::LOG_DISTANCE);
+  NS_TEST_EXPECT_MSG_EQ_TOL (logDistance.constant, 30, 1e-6, "Wrong log-distance fit");
+  NS_TEST_EXPECT_MSG_EQ_TOL (logDistance.logarithmic, 25, 1e-6, "Wrong log-distance fit");
+
+  RYLRLoraPropagationLossModel::Coefficients piecewise =
+    fitter.Fit (9, LoraCalibrationFitter::PIECEWISE_LINEAR);
+  NS_TEST_EXPECT_MSG_EQ_TOL (piecewise.breakpoint, 600, 1e-6, "Wrong piecewise fit");
+  NS_TEST_EXPECT_MSG_EQ_TOL (piecewise.piecewise, 0.06, 1e-6, "Wrong piecewise fit");
+  NS_TEST_EXPECT_MSG_EQ_TOL (fitter.GetRmse (9, piecewise), 0, 1e-6, "Wrong piecewise fit");
+
+  // SFs without samples keep the default coefficients
+  RYLRLoraPropagationLossModel::Coefficients missing =
+    fitter.Fit (12, LoraCalibrationFitter::LINEAR);
+  NS_TEST_EXPECT_MSG_EQ_TOL (missing.linear,
+                             RYLRLoraPropagationLossModel::GetDefaultCoefficients (12).linear,
+                             1e-12, "SF12 should keep the default coefficients");
+
+  // A written calibration can be loaded by the model
+  std::string fitted = CreateTempDirFilename ("rylr.fitted");
+  NS_TEST_ASSERT_MSG_EQ (fitter.WriteCalibration (fitted, LoraCalibrationFitter::LINEAR),
+                         true, "Unable to write the calibration");
+  NS_TEST_ASSERT_MSG_EQ (loaded->LoadCalibration (fitted), true,
+                         "Unable to load the fitted calibration");
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetRxPower (loaded, 7, 1000), 14 - 130 + linear.offset, 1e-6,
+                             "Wrong received power with the fitted calibration");
+}
+
+/**********************
+ * ShadowingCacheTest *
+ *********************/
+
+class ShadowingCacheTest : public TestCase
+{
+public:
+  ShadowingCacheTest ();
+  virtual ~ShadowingCacheTest ();
+
+private:
+  virtual void DoRun (void);
+
+  Ptr<MobilityModel> CreatePosition (double x, double y);
+};
+
+// Add some help text to this case to describe what it is intended to test
+ShadowingCacheTest::ShadowingCacheTest ()
+  : TestCase ("Verify that the correlated shadowing stays consistent when cached")
+{
+}
+
+// Reminder that the test case should clean up after itself
+ShadowingCacheTest::~ShadowingCacheTest ()
+{
+}
+
+Ptr<MobilityModel>
+ShadowingCacheTest::CreatePosition (double x, double y)
+{
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (Vector (x, y, 0));
+  return mobility;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ShadowingCacheTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ShadowingCacheTest");
+
+  Ptr<CorrelatedShadowingPropagationLossModel> unbounded =
+    CreateObject<CorrelatedShadowingPropagationLossModel> ();
+  Ptr<CorrelatedShadowingPropagationLossModel> capped =
+    CreateObject<CorrelatedShadowingPropagationLossModel> ();
+  capped->SetAttribute ("MaxCachedValues", UintegerValue (4));
+  unbounded->AssignStreams (10);
+  capped->AssignStreams (10);
+
+  // Receivers in the same lattice cell share its 4 corners
+  Ptr<MobilityModel> transmitter = CreatePosition (10, 10);
+  double first = unbounded->CalcRxPower (14, transmitter, CreatePosition (30, 20));
+  unbounded->CalcRxPower (14, transmitter, CreatePosition (40, -30));
+  NS_TEST_EXPECT_MSG_EQ (unbounded->GetNCorners (), 4, "Corners were not shared");
+  NS_TEST_EXPECT_MSG_EQ (unbounded->GetNCachedValues (), 2, "Wrong number of values");
+
+  // The same position, and positions within the quantization, get the same
+  // value
+  NS_TEST_EXPECT_MSG_EQ (unbounded->CalcRxPower (14, transmitter, CreatePosition (30, 20)),
+                         first, "The shadowing changed");
+  NS_TEST_EXPECT_MSG_EQ (unbounded->CalcRxPower (14, transmitter, CreatePosition (30.02, 19.99)),
+                         first, "The shadowing changed within the quantization");
+  NS_TEST_EXPECT_MSG_EQ (unbounded->CalcRxPower (14, CreatePosition (20, -5),
+                                                 CreatePosition (30, 20)),
+                         first, "Transmitters in the same square should share the field");
+
+  // Evicted values are recomputed identically
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  uniform->SetStream (1);
+  std::vector<std::pair<Ptr<MobilityModel>, Ptr<MobilityModel> > > links;
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      links.push_back (std::make_pair
+                         (CreatePosition (uniform->GetValue (-300, 300),
+                                          uniform->GetValue (-300, 300)),
+                         CreatePosition (uniform->GetValue (-1000, 1000),
+                                         uniform->GetValue (-1000, 1000))));
+    }
+  capped->CalcRxPower (14, transmitter, CreatePosition (30, 20));
+  capped->CalcRxPower (14, transmitter, CreatePosition (40, -30));
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      for (auto &link : links)
+        {
+          NS_TEST_EXPECT_MSG_EQ (capped->CalcRxPower (14, link.first, link.second),
+                                 unbounded->CalcRxPower (14, link.first, link.second),
+                                 "The capped cache changed the shadowing");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (capped->GetNCachedValues (), 4, "The cache exceeds its cap");
+  NS_TEST_EXPECT_MSG_EQ (capped->GetNCorners (), unbounded->GetNCorners (),
+                         "Corners should never be evicted");
+}
+
+/***********************
+ * RasterShadowingTest *
+ **********************/
+
+class RasterShadowingTest : public TestCase
+{
+public:
+  RasterShadowingTest ();
+  virtual ~RasterShadowingTest ();
+
+private:
+  virtual void DoRun (void);
+
+  Ptr<MobilityModel> CreatePosition (double x, double y);
+
+  /**
+   * Compute the shadowing loss of a link.
+   */
+  double GetLoss (Ptr<PropagationLossModel> model, double ax, double ay,
+                  double bx, double by);
+};
+
+// Add some help text to this case to describe what it is intended to test
+RasterShadowingTest::RasterShadowingTest ()
+  : TestCase ("Verify that shadowing rasters are reproducible and interpolated correctly")
+{
+}
+
+// Reminder that the test case should clean up after itself
+RasterShadowingTest::~RasterShadowingTest ()
+{
+}
+
+Ptr<MobilityModel>
+RasterShadowingTest::CreatePosition (double x, double y)
+{
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (Vector (x, y, 0));
+  return mobility;
+}
+
+double
+RasterShadowingTest::GetLoss (Ptr<PropagationLossModel> model, double ax,
+                              double ay, double bx, double by)
+{
+  return 14 - model->CalcRxPower (14, CreatePosition (ax, ay), CreatePosition (bx, by));
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+RasterShadowingTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("RasterShadowingTest");
+
+  // Write the same raster twice
+  std::string first = CreateTempDirFilename ("first.raster");
+  std::string second = CreateTempDirFilename ("second.raster");
+  for (std::string filename : {first, second})
+    {
+      ShadowingRasterHelper helper;
+      helper.SetBoundingBox (Box (-300, 300, -300, 300, 0, 0));
+      helper.AssignStreams (5);
+      NS_TEST_ASSERT_MSG_EQ (helper.Write (filename), true, "Unable to write the raster");
+      NS_TEST_EXPECT_MSG_EQ (helper.GetRasterSize (),
+                             sizeof (RasterShadowingPropagationLossModel::RasterHeader) +
+                             4 * 7 * 7 * 8 * 8, "Unexpected raster size");
+    }
+
+  Ptr<RasterShadowingPropagationLossModel> a =
+    CreateObject<RasterShadowingPropagationLossModel> ();
+  Ptr<RasterShadowingPropagationLossModel> b =
+    CreateObject<RasterShadowingPropagationLossModel> ();
+  NS_TEST_ASSERT_MSG_EQ (a->Open (first), true, "Unable to map the raster");
+  b->SetAttribute ("RasterFile", StringValue (second));
+  NS_TEST_ASSERT_MSG_EQ (b->IsOpen (), true, "Unable to map the raster");
+  NS_TEST_EXPECT_MSG_EQ (a->GetHeader ().minSquareX, -3, "Wrong raster bounds");
+  NS_TEST_EXPECT_MSG_EQ (a->GetHeader ().nSquaresY, 7, "Wrong raster bounds");
+
+  // The fields don't depend on the order of the lookups
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  uniform->SetStream (1);
+  std::vector<std::vector<double> > links;
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      std::vector<double> link;
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          link.push_back (uniform->GetValue (-300, 300));
+        }
+      links.push_back (link);
+    }
+  std::vector<double> losses;
+  for (auto &link : links)
+    {
+      losses.push_back (GetLoss (a, link[0], link[1], link[2], link[3]));
+    }
+  for (uint32_t i = links.size (); i-- > 0; )
+    {
+      NS_TEST_EXPECT_MSG_EQ (GetLoss (b, links[i][0], links[i][1], links[i][2], links[i][3]),
+                             losses[i], "The shadowing depends on the order of lookups");
+    }
+
+  // Values at a corner are the corner value
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetLoss (a, 10, 10, 55, 55), a->GetCorner (0, 0, 1, 1), 1e-9,
+                             "Wrong value at a corner");
+
+  // Values at the points of the weight table match the exact interpolation
+  double weights[4];
+  CorrelatedShadowingPropagationLossModel::GetWeights (75, 15, 110, weights);
+  double expected = a->GetCorner (0, 0, 0, 0) * weights[0] + a->GetCorner (0, 0, 1, 0) * weights[1] +
+    a->GetCorner (0, 0, 1, 1) * weights[2] + a->GetCorner (0, 0, 0, 1) * weights[3];
+  NS_TEST_EXPECT_MSG_EQ_TOL (GetLoss (a, 10, 10, 20, -40), expected, 1e-9,
+                             "Wrong interpolation");
+
+  // Links outside the raster have no shadowing
+  NS_TEST_EXPECT_MSG_EQ (GetLoss (a, 1000, 0, 0, 0), 0, "Unexpected shadowing");
+  NS_TEST_EXPECT_MSG_EQ (GetLoss (a, 0, 0, 0, -1000), 0, "Unexpected shadowing");
+
+  // Files that are not rasters are rejected
+  std::string invalid = CreateTempDirFilename ("invalid.raster");
+  std::ofstream file (invalid.c_str ());
+  file << "Not a raster, but long enough to hold a header" << std::endl;
+  file.close ();
+  NS_TEST_EXPECT_MSG_EQ (a->Open (invalid), false, "An invalid raster was mapped");
+  NS_TEST_EXPECT_MSG_EQ (a->IsOpen (), false, "An invalid raster was mapped");
+}
+
+/*************************
+ * BuildingLossCacheTest *
+ ************************/
+
+class BuildingLossCacheTest : public TestCase
+{
+public:
+  BuildingLossCacheTest ();
+  virtual ~BuildingLossCacheTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Compute the building loss from a node to another.
+   */
+  double GetLoss (Ptr<BuildingPenetrationLoss> loss, Ptr<Node> a, Ptr<Node> b);
+};
+
+// Add some help text to this case to describe what it is intended to test
+BuildingLossCacheTest::BuildingLossCacheTest ()
+  : TestCase ("Verify that precomputed building losses are reproducible per link")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BuildingLossCacheTest::~BuildingLossCacheTest ()
+{
+}
+
+double
+BuildingLossCacheTest::GetLoss (Ptr<BuildingPenetrationLoss> loss, Ptr<Node> a,
+                                Ptr<Node> b)
+{
+  return 14 - loss->CalcRxPower (14, a->GetObject<MobilityModel> (),
+                                 b->GetObject<MobilityModel> ());
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BuildingLossCacheTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BuildingLossCacheTest");
+
+  // Two indoor nodes in the same building, and two outdoor ones
+  Ptr<Building> building = CreateObject<Building> ();
+  building->SetBoundaries (Box (0, 100, 0, 100, 0, 10));
+
+  NodeContainer nodes;
+  nodes.Create (4);
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  positions->Add (Vector (10, 10, 1));
+  positions->Add (Vector (90, 90, 1));
+  positions->Add (Vector (500, 0, 1));
+  positions->Add (Vector (0, 500, 1));
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+  BuildingsHelper::Install (nodes);
+  BuildingsHelper::MakeMobilityModelConsistent ();
+
+  Ptr<BuildingPenetrationLoss> loss = CreateObject<BuildingPenetrationLoss> ();
+  loss->AssignStreams (1);
+  loss->Precompute (nodes);
+
+  // Links between outdoor nodes have no loss, and are not cached
+  NS_TEST_EXPECT_MSG_EQ (GetLoss (loss, nodes.Get (2), nodes.Get (3)), 0,
+                         "Unexpected loss between outdoor nodes");
+  NS_TEST_EXPECT_MSG_EQ (loss->GetNCachedLinks (), 0, "Outdoor links were cached");
+
+  // The loss of a link is drawn once, and is the same in both directions
+  double indoorOutdoor = GetLoss (loss, nodes.Get (0), nodes.Get (2));
+  NS_TEST_EXPECT_MSG_GT (indoorOutdoor, 0, "Missing building loss");
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (GetLoss (loss, nodes.Get (0), nodes.Get (2)), indoorOutdoor,
+                             "The loss of the link changed");
+      NS_TEST_EXPECT_MSG_EQ (GetLoss (loss, nodes.Get (2), nodes.Get (0)), indoorOutdoor,
+                             "The loss of the link is not symmetric");
+    }
+  double sameBuilding = GetLoss (loss, nodes.Get (0), nodes.Get (1));
+  NS_TEST_EXPECT_MSG_EQ (GetLoss (loss, nodes.Get (0), nodes.Get (1)), sameBuilding,
+                         "The loss of the link changed");
+  NS_TEST_EXPECT_MSG_EQ (loss->GetNCachedLinks (), 2, "Wrong number of cached links");
+
+  // Links can also be resampled at each packet
+  loss->SetAttribute ("ResamplePerPacket", BooleanValue (true));
+  bool changed = false;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      changed |= GetLoss (loss, nodes.Get (0), nodes.Get (2)) != indoorOutdoor;
+    }
+  NS_TEST_EXPECT_MSG_EQ (changed, true, "The loss was not resampled");
+
+  Simulator::Destroy ();
+}
+
+/******************************
+ * AssignSpreadingFactorsTest *
+ *****************************/
+class AssignSpreadingFactorsTest : public TestCase
+{
+public:
+  AssignSpreadingFactorsTest ();
+  virtual ~AssignSpreadingFactorsTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+AssignSpreadingFactorsTest::AssignSpreadingFactorsTest ()
+  : TestCase ("Verify that the gateway-indexed SF assignment matches the exhaustive one")
+{
+}
+
+// Reminder that the test case should clean up after itself
+AssignSpreadingFactorsTest::~AssignSpreadingFactorsTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+AssignSpreadingFactorsTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("AssignSpreadingFactorsTest");
+
+  // The network is set up with SetSpreadingFactorsUp
+  NetworkComponents components = InitializeNetwork (100, 5);
+  NodeContainer endDevices = components.endDevices;
+  NodeContainer gateways = components.gateways;
+  Ptr<LoraChannel> channel = components.channel;
+
+  std::vector<uint8_t> dataRates;
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<EndDeviceLoraMac> mac = GetMacLayerFromNode<EndDeviceLoraMac> (endDevices.Get (i));
+      dataRates.push_back (mac->GetDataRate ());
+      mac->SetDataRate (0);
+    }
+
+  // Only consider the two closest gateways, which include the best one of
+  // the log distance model
+  std::vector<LoraMacHelper::SpreadingFactorAssignment> assignments =
+    LoraMacHelper::AssignSpreadingFactors (endDevices, gateways, channel, 2, 4);
+  NS_TEST_ASSERT_MSG_EQ (assignments.size (), endDevices.GetN (),
+                         "Wrong number of assignments");
+
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<Node> endDevice = endDevices.Get (i);
+      Ptr<EndDeviceLoraMac> mac = GetMacLayerFromNode<EndDeviceLoraMac> (endDevice);
+      NS_TEST_EXPECT_MSG_EQ (unsigned (mac->GetDataRate ()), unsigned (dataRates[i]),
+                             "Device " << i << " got a different data rate");
+      NS_TEST_EXPECT_MSG_EQ (unsigned (assignments[i].dataRate), unsigned (dataRates[i]),
+                             "Device " << i << " reported a different data rate");
+
+      double highestRxPower = -std::numeric_limits<double>::infinity ();
+      for (uint32_t g = 0; g < gateways.GetN (); g++)
+        {
+          highestRxPower = std::max (highestRxPower, channel->GetRxPower
+                                       (14, endDevice->GetObject<MobilityModel> (),
+                                       gateways.Get (g)->GetObject<MobilityModel> (), 7));
+        }
+      NS_TEST_EXPECT_MSG_EQ_TOL (assignments[i].rxPowerDbm, highestRxPower, 1e-9,
+                                 "Device " << i << " didn't find its best gateway");
+      if (assignments[i].inRange)
+        {
+          NS_TEST_EXPECT_MSG_GT (assignments[i].marginDb, 0,
+                                 "Device " << i << " has a negative margin");
+        }
+      else
+        {
+          NS_TEST_EXPECT_MSG_EQ (unsigned (assignments[i].dataRate), 0,
+                                 "Device " << i << " is out of range but not at SF12");
+        }
+    }
+
+  Simulator::Destroy ();
+}
+
+/*******************
+ * TerrainLossTest *
+ ******************/
+class TerrainLossTest : public TestCase
+{
+public:
+  TerrainLossTest ();
+  virtual ~TerrainLossTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+TerrainLossTest::TerrainLossTest ()
+  : TestCase ("Verify that the terrain model computes and caches diffraction losses")
+{
+}
+
+// Reminder that the test case should clean up after itself
+TerrainLossTest::~TerrainLossTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+TerrainLossTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("TerrainLossTest");
+
+  // A flat 1 km square with a 100 m high ridge along x = 500
+  std::string filename = CreateTempDirFilename ("terrain.dem");
+  std::vector<float> heights (11 * 11, 0.0f);
+  for (uint32_t y = 0; y < 11; y++)
+    {
+      heights[y * 11 + 5] = 100;
+    }
+  NS_TEST_ASSERT_MSG_EQ (TerrainLoraPropagationLossModel::WriteElevation
+                           (filename, 0, 0, 100, 11, 11, heights),
+                         true, "Unable to write the elevation file");
+
+  Ptr<TerrainLoraPropagationLossModel> terrain =
+    CreateObject<TerrainLoraPropagationLossModel> ();
+  terrain->SetAttribute ("ElevationFile", StringValue (filename));
+  NS_TEST_ASSERT_MSG_EQ (terrain->IsOpen (), true, "The elevation file was not mapped");
+  NS_TEST_EXPECT_MSG_EQ_TOL (terrain->GetElevation (550, 300), 50, 1e-6,
+                             "Wrong interpolated elevation");
+  NS_TEST_EXPECT_MSG_EQ (terrain->GetElevation (-1, 0), 0,
+                         "Wrong elevation outside of the grid");
+
+  // Links that don't cross the ridge, or that clear it, have no loss
+  NS_TEST_EXPECT_MSG_EQ (terrain->GetTerrainLoss (Vector (0, 100, 10), Vector (400, 100, 10)),
+                         0, "Loss over flat terrain");
+  NS_TEST_EXPECT_MSG_EQ (terrain->GetTerrainLoss (Vector (0, 100, 200), Vector (1000, 100, 200)),
+                         0, "Loss over a cleared ridge");
+  NS_TEST_EXPECT_MSG_EQ (terrain->GetTerrainLoss (Vector (0, 100, 10), Vector (1100, 100, 10)),
+                         0, "Loss of a link that leaves the grid");
+
+  // Links across the ridge are obstructed, in both directions
+  double loss = terrain->GetTerrainLoss (Vector (0, 100, 10), Vector (1000, 100, 10));
+  NS_TEST_EXPECT_MSG_GT (loss, 20, "The ridge doesn't obstruct the link");
+  NS_TEST_EXPECT_MSG_EQ_TOL (terrain->GetTerrainLoss (Vector (1000, 100, 10),
+                                                      Vector (0, 100, 10)),
+                             loss, 1e-9, "The loss is not symmetric");
+
+  // The loss of a link is cached until one of its end points moves
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 100, 10));
+  b->SetPosition (Vector (1000, 100, 10));
+  NS_TEST_EXPECT_MSG_EQ_TOL (terrain->CalcRxPower (14, a, b), 14 - loss, 1e-9,
+                             "Wrong received power");
+  NS_TEST_EXPECT_MSG_EQ_TOL (terrain->CalcRxPower (14, b, a), 14 - loss, 1e-9,
+                             "Wrong received power in the reverse direction");
+  NS_TEST_EXPECT_MSG_EQ (terrain->GetNCachedLinks (), 1, "Wrong number of cached links");
+  b->SetPosition (Vector (400, 100, 10));
+  NS_TEST_EXPECT_MSG_EQ (terrain->CalcRxPower (14, a, b), 14,
+                         "The cached loss was used after a node moved");
+  NS_TEST_EXPECT_MSG_EQ (terrain->GetNCachedLinks (), 1, "Wrong number of cached links");
+}
+
+/*********************
+ * CompositeLossTest *
+ ********************/
+class CompositeLossTest : public TestCase
+{
+public:
+  CompositeLossTest ();
+  virtual ~CompositeLossTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+CompositeLossTest::CompositeLossTest ()
+  : TestCase ("Verify that the composite loss model matches the chain it fuses")
+{
+}
+
+// Reminder that the test case should clean up after itself
+CompositeLossTest::~CompositeLossTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+CompositeLossTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("CompositeLossTest");
+
+  // A transmitter and some receivers, a few of which are in a building
+  Ptr<Building> building = CreateObject<Building> ();
+  building->SetBoundaries (Box (100, 200, 100, 200, 0, 10));
+
+  NodeContainer nodes;
+  nodes.Create (11);
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  positions->Add (Vector (0, 0, 1));
+  for (uint32_t i = 1; i < nodes.GetN (); i++)
+    {
+      positions->Add (Vector (30.0 * i, 25.0 * i, 1));
+    }
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+  BuildingsHelper::Install (nodes);
+  BuildingsHelper::MakeMobilityModelConsistent ();
+
+  // The chain, and the composite model with stages drawing from the same
+  // streams
+  Ptr<LogDistancePropagationLossModel> chain = CreateObject<LogDistancePropagationLossModel> ();
+  chain->SetPathLossExponent (3.76);
+  chain->SetReference (1, 7.7);
+  Ptr<CorrelatedShadowingPropagationLossModel> chainShadowing =
+    CreateObject<CorrelatedShadowingPropagationLossModel> ();
+  Ptr<BuildingPenetrationLoss> chainBuildings = CreateObject<BuildingPenetrationLoss> ();
+  chain->SetNext (chainShadowing);
+  chainShadowing->SetNext (chainBuildings);
+  chainShadowing->AssignStreams (1);
+  chainBuildings->AssignStreams (2);
+  chainBuildings->Precompute (nodes);
+
+  Ptr<CompositeLoraPropagationLossModel> composite =
+    CreateObject<CompositeLoraPropagationLossModel> ();
+  composite->SetPathLossExponent (3.76);
+  composite->SetReference (1, 7.7);
+  Ptr<CorrelatedShadowingPropagationLossModel> shadowing =
+    CreateObject<CorrelatedShadowingPropagationLossModel> ();
+  Ptr<BuildingPenetrationLoss> buildings = CreateObject<BuildingPenetrationLoss> ();
+  composite->SetShadowing (shadowing);
+  composite->SetBuildingLoss (buildings);
+  shadowing->AssignStreams (1);
+  buildings->AssignStreams (2);
+  buildings->Precompute (nodes);
+
+  // The batch computes the same powers as the chain
+  Ptr<MobilityModel> sender = nodes.Get (0)->GetObject<MobilityModel> ();
+  std::vector<CompositeLoraPropagationLossModel::Endpoint> receivers;
+  for (uint32_t i = 1; i < nodes.GetN (); i++)
+    {
+      receivers.push_back (composite->GetEndpoint (nodes.Get (i)->GetObject<MobilityModel> ()));
+    }
+  std::vector<double> rxPowers;
+  composite->CalcRxPowers (14, composite->GetEndpoint (sender), receivers, rxPowers);
+  NS_TEST_ASSERT_MSG_EQ (rxPowers.size (), receivers.size (), "Wrong number of powers");
+
+  for (uint32_t i = 0; i < receivers.size (); i++)
+    {
+      double expected = chain->CalcRxPower (14, sender, receivers[i].mobility);
+      NS_TEST_EXPECT_MSG_EQ_TOL (rxPowers[i], expected, 1e-9,
+                                 "Receiver " << i << " has a different power");
+      NS_TEST_EXPECT_MSG_EQ_TOL (composite->CalcRxPower (14, sender, receivers[i].mobility),
+                                 expected, 1e-9,
+                                 "Receiver " << i << " has a different power per link");
+    }
+
+  Simulator::Destroy ();
+}
+
+/***********************
+ * PowerConversionTest *
+ **********************/
+class PowerConversionTest : public TestCase
+{
+public:
+  PowerConversionTest ();
+  virtual ~PowerConversionTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+PowerConversionTest::PowerConversionTest ()
+  : TestCase ("Verify the accuracy of the array and fast power conversions")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PowerConversionTest::~PowerConversionTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PowerConversionTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PowerConversionTest");
+
+  // Sweep the range of powers a receiver can see, from -150 to +30 dBm
+  std::vector<double> dbm;
+  for (uint32_t i = 0; i <= 18000; i++)
+    {
+      dbm.push_back (-150 + 0.01 * i);
+    }
+  uint32_t n = dbm.size ();
+
+  std::vector<double> exactW (n);
+  std::vector<double> fastW (n);
+  DbmToW (dbm.data (), exactW.data (), n);
+  DbmToW (dbm.data (), fastW.data (), n, true);
+
+  std::vector<double> exactDbm (n);
+  std::vector<double> fastDbm (n);
+  WToDbm (exactW.data (), exactDbm.data (), n);
+  WToDbm (exactW.data (), fastDbm.data (), n, true);
+
+  std::vector<double> ratios (dbm);
+  DbToRatio (ratios.data (), ratios.data (), n, true);
+  RatioToDb (ratios.data (), ratios.data (), n, true);
+
+  uint32_t errors = 0;
+  double maxRelativeError = 0;
+  double maxDbError = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // The exact mode is the scalar conversion
+      if (exactW[i] != DbmToW (dbm[i]) || exactDbm[i] != WToDbm (exactW[i]))
+        {
+          errors++;
+        }
+      // Scalar and array conversions agree in both modes
+      if (fastW[i] != DbmToW (dbm[i], true) || fastDbm[i] != WToDbm (exactW[i], true))
+        {
+          errors++;
+        }
+      maxRelativeError = std::max (maxRelativeError,
+                                   std::abs (fastW[i] - exactW[i]) / exactW[i]);
+      maxDbError = std::max (maxDbError, std::abs (fastDbm[i] - exactDbm[i]));
+      maxDbError = std::max (maxDbError, std::abs (ratios[i] - dbm[i]));
+    }
+  NS_LOG_DEBUG ("Relative error " << maxRelativeError << ", dB error " << maxDbError);
+
+  NS_TEST_EXPECT_MSG_EQ (errors, 0, "Array and scalar conversions differ");
+  NS_TEST_EXPECT_MSG_LT (maxRelativeError, FAST_CONVERSION_MAX_RELATIVE_ERROR,
+                         "The fast conversion to Watts is not accurate enough");
+  NS_TEST_EXPECT_MSG_LT (maxDbError, FAST_CONVERSION_MAX_DB_ERROR,
+                         "The fast conversion to dBm is not accurate enough");
+
+  // Out of range inputs saturate instead of wrapping around
+  NS_TEST_EXPECT_MSG_LT (RatioToDb (0, true), -3000, "Zero is not below -3000 dB");
+  NS_TEST_EXPECT_MSG_GT (DbToRatio (5000, true), 1e300, "+5000 dB did not saturate");
+  NS_TEST_EXPECT_MSG_LT (DbToRatio (-5000, true), 1e-300, "-5000 dB did not saturate");
+}
+
+/******************
+ * CounterRngTest *
+ *****************/
+class CounterRngTest : public TestCase
+{
+public:
+  CounterRngTest ();
+  virtual ~CounterRngTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+CounterRngTest::CounterRngTest ()
+  : TestCase ("Verify that counter-based random values are reproducible in any order")
+{
+}
+
+// Reminder that the test case should clean up after itself
+CounterRngTest::~CounterRngTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+CounterRngTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("CounterRngTest");
+
+  // The known answers of the reference implementation of Philox4x32-10
+  uint32_t counters[3][4] = {{0, 0, 0, 0},
+                             {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                             {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+  uint32_t keys[3][2] = {{0, 0}, {0xffffffff, 0xffffffff}, {0xa4093822, 0x299f31d0}};
+  uint32_t answers[3][4] = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+                            {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+                            {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      uint32_t values[4];
+      LoraCounterRng::Philox (counters[i], keys[i], values);
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (values[j], answers[i][j], "Wrong Philox output " << i);
+        }
+    }
+
+  // Values only depend on the component, the stream, the identifier and the
+  // counter
+  LoraCounterRng rng (LoraCounterRng::END_DEVICE_MAC);
+  LoraCounterRng same (LoraCounterRng::END_DEVICE_MAC);
+  LoraCounterRng other (LoraCounterRng::BUILDING_PENETRATION);
+  NS_TEST_EXPECT_MSG_EQ (rng.GetUniform (3, 7), same.GetUniform (3, 7),
+                         "The same draw gave different values");
+  NS_TEST_EXPECT_MSG_NE (rng.GetUniform (3, 7), rng.GetUniform (3, 8),
+                         "Different counters gave the same value");
+  NS_TEST_EXPECT_MSG_NE (rng.GetUniform (3, 7), other.GetUniform (3, 7),
+                         "Different components gave the same value");
+  same.SetStream (1);
+  NS_TEST_EXPECT_MSG_NE (rng.GetUniform (3, 7), same.GetUniform (3, 7),
+                         "Different streams gave the same value");
+
+  double sum = 0;
+  for (uint32_t i = 0; i < 10000; i++)
+    {
+      double value = rng.GetUniform (2, 4, 1, i);
+      NS_TEST_EXPECT_MSG_EQ ((value >= 2 && value < 4), true, "Value out of range");
+      sum += value;
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (sum / 10000, 3, 0.05, "Wrong mean of uniform values");
+
+  // A raster holds the fields of the model with the same stream
+  std::string filename = CreateTempDirFilename ("counter.raster");
+  ShadowingRasterHelper helper;
+  helper.SetBoundingBox (Box (-200, 200, -200, 200, 0, 0));
+  helper.AssignStreams (5);
+  NS_TEST_ASSERT_MSG_EQ (helper.Write (filename), true, "Unable to write the raster");
+  Ptr<RasterShadowingPropagationLossModel> raster =
+    CreateObject<RasterShadowingPropagationLossModel> ();
+  NS_TEST_ASSERT_MSG_EQ (raster->Open (filename), true, "Unable to map the raster");
+  LoraCounterRng shadowing (LoraCounterRng::CORRELATED_SHADOWING);
+  shadowing.SetStream (5);
+  for (int32_t square = -1; square <= 1; square++)
+    {
+      for (int32_t corner = -2; corner <= 2; corner++)
+        {
+          double expected = CorrelatedShadowingPropagationLossModel::DrawCorner
+              (square, -square, corner, corner + 1, shadowing,
+              CorrelatedShadowingPropagationLossModel::VARIANCE);
+          NS_TEST_EXPECT_MSG_EQ (raster->GetCorner (square, -square, corner, corner + 1),
+                                 float (expected), "The raster differs from the model");
+        }
+    }
+
+  // Building losses don't depend on the order of nodes and links
+  Ptr<Building> building = CreateObject<Building> ();
+  building->SetBoundaries (Box (0, 100, 0, 100, 0, 10));
+  NodeContainer nodes;
+  nodes.Create (6);
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      positions->Add (Vector (10 + 40.0 * i, 50, 1));
+    }
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+  BuildingsHelper::Install (nodes);
+  BuildingsHelper::MakeMobilityModelConsistent ();
+
+  NodeContainer reversed;
+  for (uint32_t i = nodes.GetN (); i-- > 0; )
+    {
+      reversed.Add (nodes.Get (i));
+    }
+  Ptr<BuildingPenetrationLoss> forward = CreateObject<BuildingPenetrationLoss> ();
+  Ptr<BuildingPenetrationLoss> backward = CreateObject<BuildingPenetrationLoss> ();
+  forward->AssignStreams (3);
+  backward->AssignStreams (3);
+  forward->Precompute (nodes);
+  backward->Precompute (reversed);
+
+  std::vector<double> losses;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      for (uint32_t j = 0; j < nodes.GetN (); j++)
+        {
+          losses.push_back (forward->GetBuildingLoss (nodes.Get (i)->GetObject<MobilityModel> (),
+                                                      nodes.Get (j)->GetObject<MobilityModel> ()));
+        }
+    }
+  for (uint32_t k = losses.size (); k-- > 0; )
+    {
+      uint32_t i = k / nodes.GetN ();
+      uint32_t j = k % nodes.GetN ();
+      NS_TEST_EXPECT_MSG_EQ (backward->GetBuildingLoss (nodes.Get (j)->GetObject<MobilityModel> (),
+                                                        nodes.Get (i)->GetObject<MobilityModel> ()),
+                             losses[k], "The loss of link " << i << "-" << j <<
+                             " depends on the order of evaluation");
+    }
+
+  Simulator::Destroy ();
+}
+
+/************************
+ * PositionSnapshotTest *
+ ***********************/
+class PositionSnapshotTest : public TestCase
+{
+public:
+  PositionSnapshotTest ();
+  virtual ~PositionSnapshotTest ();
+
+  void ReceivedPacket (Ptr<const Packet> packet, uint32_t node);
+  void UnderSensitivity (Ptr<const Packet> packet, uint32_t node);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Send a packet at 1 s and at 20 s from a PHY at the origin to one that
+   * moves away at 500 m/s, and which is out of range at 20 s.
+   */
+  void Run (Time snapshotInterval);
+
+  /**
+   * Send a packet at 1 s in two runs of the simulator on the same channel,
+   * moving the receiver out of range between them.
+   */
+  void Rerun (Time snapshotInterval);
+
+  int m_receivedPacketCalls;
+  int m_underSensitivityCalls;
+};
+
+// Add some help text to this case to describe what it is intended to test
+PositionSnapshotTest::PositionSnapshotTest ()
+  : TestCase ("Verify that the channel reads positions again when time advances")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PositionSnapshotTest::~PositionSnapshotTest ()
+{
+}
+
+void
+PositionSnapshotTest::ReceivedPacket (Ptr<const Packet> packet, uint32_t node)
+{
+  m_receivedPacketCalls++;
+}
+
+void
+PositionSnapshotTest::UnderSensitivity (Ptr<const Packet> packet, uint32_t node)
+{
+  m_underSensitivityCalls++;
+}
+
+void
+PositionSnapshotTest::Run (Time snapshotInterval)
+{
+  m_receivedPacketCalls = 0;
+  m_underSensitivityCalls = 0;
+
+  Ptr<LogDistancePropagationLossModel> loss =
+    CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<LoraChannel> channel =
+    CreateObject<LoraChannel> (loss, CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetAttribute ("PositionSnapshotInterval", TimeValue (snapshotInterval));
+
+  Ptr<SimpleEndDeviceLoraPhy> sender = CreateObject<SimpleEndDeviceLoraPhy> ();
+  Ptr<SimpleEndDeviceLoraPhy> receiver = CreateObject<SimpleEndDeviceLoraPhy> ();
+  Ptr<ConstantPositionMobilityModel> senderMobility =
+    CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantVelocityMobilityModel> receiverMobility =
+    CreateObject<ConstantVelocityMobilityModel> ();
+  senderMobility->SetPosition (Vector (0, 0, 0));
+  receiverMobility->SetPosition (Vector (10, 0, 0));
+  receiverMobility->SetVelocity (Vector (500, 0, 0));
+  sender->SetMobility (senderMobility);
+  receiver->SetMobility (receiverMobility);
+
+  sender->SwitchToStandby ();
+  receiver->SwitchToStandby ();
+  sender->SetFrequency (868.1);
+  receiver->SetFrequency (868.1);
+  sender->SetSpreadingFactor (12);
+  receiver->SetSpreadingFactor (12);
+  sender->SetChannel (channel);
+  receiver->SetChannel (channel);
+  channel->Add (sender);
+  channel->Add (receiver);
+  receiver->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&PositionSnapshotTest::ReceivedPacket, this));
+  receiver->TraceConnectWithoutContext
+    ("LostPacketBecauseUnderSensitivity",
+    MakeCallback (&PositionSnapshotTest::UnderSensitivity, this));
+
+  LoraTxParameters txParams;
+  txParams.sf = 12;
+  uint8_t buffer[10] = {0,0,0,0,0,0,0,0,0,0};
+  Ptr<Packet> packet = Create<Packet> (buffer, 10);
+  Simulator::Schedule (Seconds (1), &SimpleEndDeviceLoraPhy::Send, sender, packet,
+                       txParams, 868.1, 14);
+  Simulator::Schedule (Seconds (20), &SimpleEndDeviceLoraPhy::Send, sender, packet,
+                       txParams, 868.1, 14);
+
+  Simulator::Stop (Seconds (30));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+PositionSnapshotTest::Rerun (Time snapshotInterval)
+{
+  m_receivedPacketCalls = 0;
+  m_underSensitivityCalls = 0;
+
+  Ptr<LogDistancePropagationLossModel> loss =
+    CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<LoraChannel> channel =
+    CreateObject<LoraChannel> (loss, CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetAttribute ("PositionSnapshotInterval", TimeValue (snapshotInterval));
+
+  Ptr<SimpleEndDeviceLoraPhy> sender = CreateObject<SimpleEndDeviceLoraPhy> ();
+  Ptr<SimpleEndDeviceLoraPhy> receiver = CreateObject<SimpleEndDeviceLoraPhy> ();
+  Ptr<ConstantPositionMobilityModel> senderMobility =
+    CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> receiverMobility =
+    CreateObject<ConstantPositionMobilityModel> ();
+  senderMobility->SetPosition (Vector (0, 0, 0));
+  receiverMobility->SetPosition (Vector (10, 0, 0));
+  sender->SetMobility (senderMobility);
+  receiver->SetMobility (receiverMobility);
+
+  sender->SwitchToStandby ();
+  receiver->SwitchToStandby ();
+  sender->SetFrequency (868.1);
+  receiver->SetFrequency (868.1);
+  sender->SetSpreadingFactor (12);
+  receiver->SetSpreadingFactor (12);
+  sender->SetChannel (channel);
+  receiver->SetChannel (channel);
+  channel->Add (sender);
+  channel->Add (receiver);
+  receiver->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&PositionSnapshotTest::ReceivedPacket, this));
+  receiver->TraceConnectWithoutContext
+    ("LostPacketBecauseUnderSensitivity",
+    MakeCallback (&PositionSnapshotTest::UnderSensitivity, this));
+
+  LoraTxParameters txParams;
+  txParams.sf = 12;
+  uint8_t buffer[10] = {0,0,0,0,0,0,0,0,0,0};
+  Ptr<Packet> packet = Create<Packet> (buffer, 10);
+  Simulator::Schedule (Seconds (1), &SimpleEndDeviceLoraPhy::Send, sender, packet,
+                       txParams, 868.1, 14);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  receiverMobility->SetPosition (Vector (10000, 0, 0));
+  Simulator::Schedule (Seconds (1), &SimpleEndDeviceLoraPhy::Send, sender, packet,
+                       txParams, 868.1, 14);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PositionSnapshotTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PositionSnapshotTest");
+
+  // The second transmission sees the receiver 10 km away
+  Run (Seconds (0));
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 1, "Wrong number of received packets");
+  NS_TEST_EXPECT_MSG_EQ (m_underSensitivityCalls, 1,
+                         "The position of the receiver was not read again");
+
+  // Unless the snapshot is kept longer than the time between transmissions
+  Run (Seconds (60));
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 2, "The snapshot was not reused");
+  NS_TEST_EXPECT_MSG_EQ (m_underSensitivityCalls, 0, "The snapshot was not reused");
+
+  // A second run of the simulator reads the positions again, even at the
+  // same time as the last read of the first run
+  Rerun (Seconds (0));
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 1, "Wrong number of received packets");
+  NS_TEST_EXPECT_MSG_EQ (m_underSensitivityCalls, 1,
+                         "The position of the receiver was not read again");
+  Rerun (Seconds (60));
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 1, "Wrong number of received packets");
+  NS_TEST_EXPECT_MSG_EQ (m_underSensitivityCalls, 1,
+                         "The snapshot survived the destruction of the simulator");
+}
+
 /*****************
  * LoraMacTest *
  *****************/
@@ -1350,7 +3787,28 @@ LorawanTestSuite::LorawanTestSuite ()
   AddTestCase (new ReceivePathTest, TestCase::QUICK);
   AddTestCase (new LogicalLoraChannelTest, TestCase::QUICK);
   AddTestCase (new TimeOnAirTest, TestCase::QUICK);
+  AddTestCase (new AirtimeTableTest, TestCase::QUICK);
   AddTestCase (new PhyConnectivityTest, TestCase::QUICK);
+  AddTestCase (new LazyEnergyTest, TestCase::QUICK);
+  AddTestCase (new LifetimeEstimatorTest, TestCase::QUICK);
+  AddTestCase (new FleetSenderTest, TestCase::QUICK);
+  AddTestCase (new TraceReplayTest, TestCase::QUICK);
+  AddTestCase (new PacketPoolTest, TestCase::QUICK);
+  AddTestCase (new ScenarioCacheTest, TestCase::QUICK);
+  AddTestCase (new CheckpointTest, TestCase::QUICK);
+  AddTestCase (new CountersTest, TestCase::QUICK);
+  AddTestCase (new PerformanceBudgetTest (20, 1), TestCase::QUICK);
+  AddTestCase (new PerformanceBudgetTest (50, 2), TestCase::QUICK);
+  AddTestCase (new RylrCalibrationTest, TestCase::QUICK);
+  AddTestCase (new ShadowingCacheTest, TestCase::QUICK);
+  AddTestCase (new RasterShadowingTest, TestCase::QUICK);
+  AddTestCase (new BuildingLossCacheTest, TestCase::QUICK);
+  AddTestCase (new AssignSpreadingFactorsTest, TestCase::QUICK);
+  AddTestCase (new TerrainLossTest, TestCase::QUICK);
+  AddTestCase (new CompositeLossTest, TestCase::QUICK);
+  AddTestCase (new PowerConversionTest, TestCase::QUICK);
+  AddTestCase (new CounterRngTest, TestCase::QUICK);
+  AddTestCase (new PositionSnapshotTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite